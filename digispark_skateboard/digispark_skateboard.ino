@@ -13,16 +13,17 @@
 // mode10 details are specified as r1, g1, b1, r2, g2, b2, speed
 // mode12 details are specified as saturation, value, speed
 
-
-
-uint8_t specification0[] = {BRIGHTNESS, BRIGHTNESS, BRIGHTNESS};    // mode1
-uint8_t specification1[] = {BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 0, 2}; // mode4
-uint8_t specification2[] = {0, BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 2}; // mode4
-uint8_t specification3[] = {0, 0, BRIGHTNESS, BRIGHTNESS, 0, 0, 2}; // mode4
-uint8_t specification4[] = {BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 0, 2}; // mode10
-uint8_t specification5[] = {0, BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 2}; // mode10
-uint8_t specification6[] = {0, 0, BRIGHTNESS, BRIGHTNESS, 0, 0, 2}; // mode10
-uint8_t specification7[] = {220, BRIGHTNESS, 1};                    // mode12
+// the specifications are stored in flash memory, since there is only 512 bytes of RAM
+const specification_t specification[8] PROGMEM = {
+  {1,  {BRIGHTNESS, BRIGHTNESS, BRIGHTNESS}},
+  {4,  {BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 0, 2}},
+  {4,  {0, BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 2}},
+  {4,  {0, 0, BRIGHTNESS, BRIGHTNESS, 0, 0, 2}},
+  {10, {BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 0, 2}},
+  {10, {0, BRIGHTNESS, 0, 0, 0, BRIGHTNESS, 2}},
+  {10, {0, 0, BRIGHTNESS, BRIGHTNESS, 0, 0, 2}},
+  {12, {220, BRIGHTNESS, 1}},
+};
 
 unsigned long previous = 0, now;
 
@@ -46,30 +47,5 @@ void loop() {
   uint8_t mode = (digitalRead(BUTTON0) << 0) | (digitalRead(BUTTON1) << 1) | (digitalRead(BUTTON2) << 2);
 
   // update the Neopixel LED strip according to the current mode
-  switch (mode) {
-    case 0:
-      mode1(specification0);
-      break;
-    case 1:
-      mode4(specification1);
-      break;
-    case 2:
-      mode4(specification2);
-      break;
-    case 3:
-      mode4(specification3);
-      break;
-    case 4:
-      mode10(specification4);
-      break;
-    case 5:
-      mode10(specification5);
-      break;
-    case 6:
-      mode10(specification6);
-      break;
-    case 7:
-      mode12(specification7);
-      break;
-  }
+  runSpecification(&specification[mode]);
 } // loop
@@ -3,31 +3,29 @@
     https://github.com/robertoostenveld/arduino/tree/master/esp8266_artnet_neopixel
 
     The functions have the same name and more or less similar functionality, but have been
-    simplified to save memory.
+    simplified to save memory. All computations are done with integers, angles are expressed
+    from 0 to 255 rather than from 0 to 360 degrees, since the ATtiny85 has no floating point
+    hardware and the floating point library would not fit in flash.
 */
 
 #include "neopixel_mode.h"
-#include "colorspace.h"
 
 Adafruit_NeoPixel strip = Adafruit_NeoPixel(NUMPIXELS, PIN, NEO_GRB);
 
-#define ENABLE_MODE1
-#define ENABLE_MODE4
-#define ENABLE_MODE10
-#define ENABLE_MODE12
+/************************************************************************************/
+
+// determine the current phase in the temporal cycle, between 0 and 255
+static uint8_t getPhase(uint8_t speed) {
+  // the full seconds correspond to complete cycles and can be ignored
+  return ((uint32_t)CONFIG_SPEED * speed * (millis() % 1000) * 256 / 1000) & 0xFF;
+}
 
 /************************************************************************************/
 
 void mode1(uint8_t * data) {
 #ifdef ENABLE_MODE1
-  int r, g, b;
-
-  r = data[0];
-  g = data[1];
-  b = data[2];
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++)
-    strip.setPixelColor(pixel, r, g, b);
+  for (uint16_t pixel = 0; pixel < strip.numPixels(); pixel++)
+    strip.setPixelColor(pixel, data[0], data[1], data[2]);
   strip.show();
 #endif
 }
@@ -36,26 +34,11 @@ void mode1(uint8_t * data) {
 
 void mode4(uint8_t * data) {
 #ifdef ENABLE_MODE4
-  int r, g, b;
-
-  // determine the current phase in the temporal cycle
-  float phase = CONFIG_SPEED * data[6] * millis() * 0.360;
-  phase = WRAP360(phase);
-
   // pick between the two colors
-  if (phase < 180) {
-    r = data[0];
-    g = data[1];
-    b = data[2];
-  }
-  else {
-    r = data[3];
-    g = data[4];
-    b = data[5];
-  }
+  uint8_t *color = (getPhase(data[6]) < 128 ? data : data + 3);
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++)
-    strip.setPixelColor(pixel, r, g, b);
+  for (uint16_t pixel = 0; pixel < strip.numPixels(); pixel++)
+    strip.setPixelColor(pixel, color[0], color[1], color[2]);
   strip.show();
 #endif
 }
@@ -64,27 +47,12 @@ void mode4(uint8_t * data) {
 
 void mode10(uint8_t * data) {
 #ifdef ENABLE_MODE10
-  int r, g, b;
-
-  // determine the current phase in the temporal cycle
-  float phase = CONFIG_SPEED * data[6] * millis() * 0.360;
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    float position = (360. * pixel / (strip.numPixels() - 1)) * CONFIG_SPLIT - phase;
-    position = WRAP360(position);
-
-    if (position < 180) {
-      r = data[0];
-      g = data[1];
-      b = data[2];
-    }
-    else {
-      r = data[3];
-      g = data[4];
-      b = data[5];
-    }
+  uint8_t phase = getPhase(data[6]);
 
-    strip.setPixelColor(pixel, r, g, b);
+  for (uint16_t pixel = 0; pixel < strip.numPixels(); pixel++) {
+    uint8_t position = (256UL * pixel * CONFIG_SPLIT / (strip.numPixels() - 1)) - phase;
+    uint8_t *color = (position < 128 ? data : data + 3);
+    strip.setPixelColor(pixel, color[0], color[1], color[2]);
   }
   strip.show();
 #endif
@@ -94,23 +62,13 @@ void mode10(uint8_t * data) {
 
 void mode12(uint8_t * data) {
 #ifdef ENABLE_MODE12
+  uint8_t phase = getPhase(data[2]);
 
-  float saturation = 1. * data[0];
-  float value      = 1. * data[1] ;
-  float speed      = CONFIG_SPEED * data[2];
-
-  // determine the current phase in the temporal cycle
-  float phase = (speed * millis()) * 0.360;
-
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    float hue = (360. * pixel / strip.numPixels()) * CONFIG_SPLIT - phase;
-    hue = WRAP360(hue);
-
-    int r = hue;             // hue, between 0-360
-    int g = saturation;      // saturation, between 0-255
-    int b = value;           // value, between 0-255
+  for (uint16_t pixel = 0; pixel < strip.numPixels(); pixel++) {
+    uint8_t r = (256UL * pixel * CONFIG_SPLIT / strip.numPixels()) - phase; // hue, between 0-255
+    uint8_t g = data[0];                                                    // saturation, between 0-255
+    uint8_t b = data[1];                                                    // value, between 0-255
     map_hsv_to_rgb(&r, &g, &b);
-
     strip.setPixelColor(pixel, r, g, b);
   }
   strip.show();
@@ -119,14 +77,66 @@ void mode12(uint8_t * data) {
 
 /************************************************************************************/
 
-void map_hsv_to_rgb(int *r, int *g, int *b) {
-  hsv in;
-  rgb out;
-  in.h = 360. * (*r) / 256.;
-  in.s =   1. * (*g) / 255.;
-  in.v =   1. * (*b) / 255.;
-  out = hsv2rgb(in);
-  (*r) = out.r * 255;
-  (*g) = out.g * 255;
-  (*b) = out.b * 255;
+void runSpecification(const specification_t *specification) {
+  // copy the specification from flash memory
+  specification_t local;
+  memcpy_P(&local, specification, sizeof(specification_t));
+
+  switch (local.mode) {
+#ifdef ENABLE_MODE1
+    case 1:
+      mode1(local.data);
+      break;
+#endif
+#ifdef ENABLE_MODE4
+    case 4:
+      mode4(local.data);
+      break;
+#endif
+#ifdef ENABLE_MODE10
+    case 10:
+      mode10(local.data);
+      break;
+#endif
+#ifdef ENABLE_MODE12
+    case 12:
+      mode12(local.data);
+      break;
+#endif
+  }
+}
+
+/************************************************************************************/
+
+#ifdef ENABLE_MODE12
+void map_hsv_to_rgb(uint8_t *r, uint8_t *g, uint8_t *b) {
+  // the hue is divided in six regions of 43 steps each
+  uint8_t h = *r, s = *g, v = *b;
+  uint8_t region = h / 43;
+  uint8_t remainder = (h - region * 43) * 6;
+  uint8_t p = ((uint16_t)v * (255 - s)) >> 8;
+  uint8_t q = ((uint16_t)v * (255 - (((uint16_t)s * remainder) >> 8))) >> 8;
+  uint8_t t = ((uint16_t)v * (255 - (((uint16_t)s * (255 - remainder)) >> 8))) >> 8;
+
+  switch (region) {
+    case 0:
+      *r = v; *g = t; *b = p;
+      break;
+    case 1:
+      *r = q; *g = v; *b = p;
+      break;
+    case 2:
+      *r = p; *g = v; *b = t;
+      break;
+    case 3:
+      *r = p; *g = q; *b = v;
+      break;
+    case 4:
+      *r = t; *g = p; *b = v;
+      break;
+    default:
+      *r = v; *g = p; *b = q;
+      break;
+  }
 }
+#endif
@@ -7,16 +7,23 @@
 #define NUMPIXELS      60
 
 // in the original version these can be configured dynamically
-#define CONFIG_SPEED   1.0
+#define CONFIG_SPEED   1
 #define CONFIG_SPLIT   1
 
-#define ROUND(x)   (int(x + 0.5))
-#define ABS(x)     (x * (x < 0 ? -1 : 1))
-#define MIN(x, y)  (x < y ? x : y)
-#define MAX(x, y)  (x > y ? x : y)
-#define WRAP360(x) (x > 0 ? (x - int((x)/360)*360) : (x - int((x)/360 - 1)*360))  // between    0 and 360
-#define WRAP180(x) (WRAP360(x) < 180 ? WRAP360(x) : WRAP360(x) - 360)             // between -180 and 180
-#define BALANCE(l, x1, x2)  ((x1) * (1. - l) + (x2) * l)
+// each mode costs flash memory, disable the ones that are not used
+#define ENABLE_MODE1
+#define ENABLE_MODE4
+#define ENABLE_MODE10
+#define ENABLE_MODE12
+
+// the largest number of bytes needed to specify any of the modes
+#define SPECIFICATION_SIZE 7
+
+// a specification is stored in flash memory as the mode number followed by its details
+typedef struct {
+  uint8_t mode;
+  uint8_t data[SPECIFICATION_SIZE];
+} specification_t;
 
 extern Adafruit_NeoPixel strip;
 
@@ -25,7 +32,8 @@ void mode1(uint8_t *);
 void mode4(uint8_t *);
 void mode10(uint8_t *);
 void mode12(uint8_t *);
+void runSpecification(const specification_t *);
 
-void map_hsv_to_rgb(int *, int *, int *);
+void map_hsv_to_rgb(uint8_t *, uint8_t *, uint8_t *);
 
 #endif
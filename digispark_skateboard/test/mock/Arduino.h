@@ -0,0 +1,28 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the Arduino core for the host tests, it only
+// provides what this sketch uses.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define memcpy_P memcpy
+
+#define INPUT  0
+#define OUTPUT 1
+#define LOW    0
+#define HIGH   1
+
+// the time and the buttons are set by the test
+extern unsigned long mockMillis;
+extern int mockPin[8];
+
+inline unsigned long millis() { return mockMillis; }
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t pin) { return mockPin[pin]; }
+inline void digitalWrite(uint8_t pin, int value) { mockPin[pin] = value; }
+
+#endif // _ARDUINO_H_
@@ -0,0 +1,80 @@
+// Host test that renders every specification of the sketch and compares the frames to golden.txt
+//
+// After an intended change of the modes, the golden frames are written again with "make golden".
+
+#include "check.h"
+#include "../digispark_skateboard.ino"
+
+unsigned long mockMillis = 0;
+int mockPin[8] = {0};
+
+#define GOLDEN "golden.txt"
+
+// the frames are rendered at a number of moments within the one-second cycle
+static const unsigned long moment[] = {0, 125, 250, 333, 500, 750, 999};
+
+static void render(FILE *fp, uint8_t buttons, unsigned long time) {
+  mockPin[BUTTON0] = (buttons >> 0) & 0x01;
+  mockPin[BUTTON1] = (buttons >> 1) & 0x01;
+  mockPin[BUTTON2] = (buttons >> 2) & 0x01;
+  mockMillis = time;
+  loop();
+  if (!fp)
+    return;
+  fprintf(fp, "%u %lu", buttons, time);
+  for (uint16_t pixel = 0; pixel < strip.numPixels(); pixel++)
+    fprintf(fp, " %06x", strip.getPixelColor(pixel));
+  fprintf(fp, "\n");
+}
+
+int main(int argc, char *argv[]) {
+  setup();
+
+  if (argc > 1 && strcmp(argv[1], "--write") == 0) {
+    FILE *fp = fopen(GOLDEN, "w");
+    for (uint8_t buttons = 0; buttons < 8; buttons++)
+      for (unsigned int i = 0; i < sizeof(moment) / sizeof(moment[0]); i++)
+        render(fp, buttons, moment[i]);
+    fclose(fp);
+    printf("test_modes: wrote %s\n", GOLDEN);
+    return 0;
+  }
+
+  FILE *golden = fopen(GOLDEN, "r");
+  CHECK(golden != NULL);
+  if (!golden)
+    return report("test_modes");
+
+  char expected[4096], actual[4096];
+  for (uint8_t buttons = 0; buttons < 8; buttons++)
+    for (unsigned int i = 0; i < sizeof(moment) / sizeof(moment[0]); i++) {
+      FILE *fp = fmemopen(actual, sizeof(actual), "w");
+      render(fp, buttons, moment[i]);
+      fclose(fp);
+      if (!fgets(expected, sizeof(expected), golden))
+        expected[0] = 0;
+      if (strcmp(expected, actual) != 0) {
+        printf("frame of specification %u at %lu ms differs from the golden frame\n", buttons, moment[i]);
+        failures++;
+      }
+    }
+  fclose(golden);
+
+  // every iteration of the main loop updates the strip once
+  CHECK_EQUAL(strip.shown, 8 * sizeof(moment) / sizeof(moment[0]));
+
+  // some of the golden frames can also be determined by hand
+  render(NULL, 0, 0);
+  CHECK_EQUAL(strip.getPixelColor(0), 0x808080);
+  render(NULL, 1, 0);
+  CHECK_EQUAL(strip.getPixelColor(0), 0x800000);
+  render(NULL, 1, 250);  // half a cycle at 2 Hz
+  CHECK_EQUAL(strip.getPixelColor(0), 0x008000);
+  render(NULL, 4, 0);    // the first half of the strip has the first color
+  CHECK_EQUAL(strip.getPixelColor(0), 0x800000);
+  CHECK_EQUAL(strip.getPixelColor(NUMPIXELS / 2), 0x008000);
+  render(NULL, 7, 0);    // the hue of the first pixel is red
+  CHECK_EQUAL(strip.getPixelColor(0), 0x801211);
+
+  return report("test_modes");
+}
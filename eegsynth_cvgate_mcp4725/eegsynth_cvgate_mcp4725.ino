@@ -10,6 +10,9 @@
 *   *c1v1024#  control 1 voltage 5*1024/4095 = 1.25 V
 *   *g1v1#     gate 1 value ON
 *
+* Besides these ASCII commands, it accepts binary frames that update
+* all control voltages and gates at once, see protocol.h
+*
 * This work is licensed under a Creative Commons Attribution-ShareAlike 4.0 International License.
 * See http://creativecommons.org/licenses/by-sa/4.0/
 *
@@ -17,6 +20,8 @@
 */
 
 #include <Wire.h>//Include the Wire library to talk I2C
+#include "protocol.h"
+#include "mcp4725.h"
 
 #define voltage1pin    2      // the pin controlling the voltage output
 #define voltage2pin    3      // the pin controlling the voltage output
@@ -27,41 +32,54 @@
 #define gate3pin A2      // the pin controlling the digital gate
 #define gate4pin A3      // the pin controlling the digital gate
 
-#define MCP4726_CMD_WRITEDAC            (0x40)  // Writes data to the DAC
-#define MCP4726_CMD_WRITEDACEEPROM      (0x60)  // Writes data to the DAC and the EEPROM (persisting the assigned value after reset)
-
-#define NONE    0
-#define VOLTAGE 1
-#define GATE    2
-
-#define OK    1
-#define ERROR 2
+// the MCP4725 supports fast mode, which is also the fastest that the Arduino Nano supports
+#define WIRE_CLOCK   400000
 
 //This is the I2C Address of the MCP4725, by default (A0 pulled to GND).
 //Please note that this breakout is for the MCP4725A0.
 //For devices with A0 pulled HIGH, use 0x61
 #define MCP4725_ADDR 0x60
 
+#define NUMCHANNEL 4
+
+const byte voltagepin[NUMCHANNEL] = {voltage1pin, voltage2pin, voltage3pin, voltage4pin};
+const byte gatepin[NUMCHANNEL]    = {gate1pin, gate2pin, gate3pin, gate4pin};
+
 // these remember the state of all CV and gate outputs
-int voltage1 = 0, voltage2 = 0, voltage3 = 0, voltage4 = 0;
-int gate1 = 0, gate2 = 0, gate3 = 0, gate4 = 0;
-int enable1 = 1, enable2 = 0, enable3 = 0, enable4 = 0;
+int voltage[NUMCHANNEL] = {0, 0, 0, 0};
+int gate[NUMCHANNEL] = {0, 0, 0, 0};
+const byte enable = 0x01;     // bit N is set if channel N+1 is enabled
+
+parser_t parser;
+command_t command;
+mcp4725_t dac;
 
 void sampleAndHold(int pin, uint16_t value) {
-  uint8_t msb, lsb;
-  msb = (value / 16);
-  lsb = (value % 16) << 4;
-  Wire.beginTransmission(MCP4725_ADDR);
-  Wire.write(MCP4726_CMD_WRITEDAC);   // cmd to update the DAC
-  Wire.write(msb);                    // the 8 most significant bits...
-  Wire.write(lsb);                    // the 4 least significant bits...
-  Wire.endTransmission();
+  // the DAC is shared by all channels, it is only written if it has another value
+  mcp4725Update(&dac, value);
+  // the sample-and-hold is refreshed anyway, since its capacitor slowly discharges
   digitalWrite(pin, HIGH);
   delay(1);                           // give it some time to Sample and Hold
   digitalWrite(pin, LOW);
   return;
 }
 
+byte applyCommand(const command_t *command) {
+  if (command->type != FRAME_SET)
+    return STATUS_ERROR;
+  // update the internal state of all output channels
+  for (byte i = 0; i < NUMCHANNEL; i++) {
+    if (command->cvmask & (1 << i))
+      voltage[i] = command->cv[i];
+    if (command->gatemask & (1 << i))
+      gate[i] = (command->gates >> i) & 1;
+  }
+  // it is an error to address a channel that does not exist or that is not enabled
+  if ((command->cvmask & ~enable) || (command->gatemask >> NUMCHANNEL))
+    return STATUS_ERROR;
+  return STATUS_OK;
+}
+
 void setup() {
   // initialize the serial communication:
   Serial.begin(115200);
@@ -70,9 +88,10 @@ void setup() {
   Serial.print(" / ");
   Serial.print(__TIME__);
   Serial.println("]");
-  Serial.setTimeout(1000);
 
   Wire.begin();
+  Wire.setClock(WIRE_CLOCK);
+  mcp4725Begin(&dac, MCP4725_ADDR);
 
   // initialize the gate pins as output:
   pinMode(gate1pin, OUTPUT);
@@ -85,117 +104,36 @@ void setup() {
   pinMode(voltage2pin, OUTPUT);
   pinMode(voltage3pin, OUTPUT);
   pinMode(voltage4pin, OUTPUT);
+
+  protocolReset(&parser);
 }
 
 void loop() {
-  byte b, channel = 0, command = NONE, status = OK;
-  int value = 0;
-
-  if (Serial.available()) {
-
-    // parse the input over the serial connection
-    b = Serial.read();
-    if (b == '*') {
-      Serial.readBytes(&b, 1);
-      if (b == 'c') {
-        command = VOLTAGE;
-        value = 0;
-        Serial.readBytes(&b, 1); channel = b - 48; // character '1' is ascii value 49
-        Serial.readBytes(&b, 1); // 'v'
-        Serial.readBytes(&b, 1); value  = (b - 48) * 1000;
-        Serial.readBytes(&b, 1); value += (b - 48) * 100;
-        Serial.readBytes(&b, 1); value += (b - 48) * 10;
-        Serial.readBytes(&b, 1); value += (b - 48) * 1;
-        Serial.readBytes(&b, 1); command = (b == '#' ? command : NONE);
-      }
-      else if (b == 'g') {
-        command = GATE;
-        Serial.readBytes(&b, 1); channel = b - 48; // character '1' is ascii value 49
-        Serial.readBytes(&b, 1); // 'v'
-        Serial.readBytes(&b, 1); value  = (b == '1');
-        Serial.readBytes(&b, 1); command = (b == '#' ? command : NONE);
-      }
-      else {
-        command = NONE;
-      }
-    }
-    else {
-      command = NONE;
+  byte buf[8], status;
+  int result;
+
+  // parse the input over the serial connection, this does not wait for incomplete commands
+  while (Serial.available()) {
+    result = protocolParse(&parser, Serial.read(), &command);
+    if (result == PARSE_ASCII) {
+      status = applyCommand(&command);
+      Serial.println(status == STATUS_OK ? "ok" : "error");
     }
-
-    // update the internal state of all output channels
-    if (command == VOLTAGE) {
-      switch (channel) {
-        case 1:
-          voltage1 = value;
-          status = (enable1 ? OK : ERROR);
-          break;
-        case 2:
-          voltage2 = value;
-          status = (enable2 ? OK : ERROR);
-          break;
-        case 3:
-          voltage3 = value;
-          status = (enable3 ? OK : ERROR);
-          break;
-        case 4:
-          voltage4 = value;
-          status = (enable4 ? OK : ERROR);
-          break;
-        default:
-          status = ERROR;
-      }
-
-    }
-    else if (command == GATE) {
-      switch (channel) {
-        case 1:
-          gate1 = (value != 0);
-          status = OK;
-          break;
-        case 2:
-          gate2 = (value != 0);
-          status = OK;
-          break;
-        case 3:
-          gate3 = (value != 0);
-          status = OK;
-          break;
-        case 4:
-          gate4 = (value != 0);
-          status = OK;
-          break;
-        default:
-          status = ERROR;
-      }
+    else if (result == PARSE_FRAME) {
+      status = applyCommand(&command);
+      if (command.ack)
+        Serial.write(buf, protocolAck(buf, command.type, status));
     }
-    else {
-      status = ERROR;
-    }
-    if (status == OK)
-      Serial.println("ok");
-    else if (status == ERROR)
+    else if (result == PARSE_ERROR) {
       Serial.println("error");
-  }
-  else {
-    // refresh all enabled output channels
-    if (enable1) {
-      sampleAndHold(voltage1pin, voltage1);
-      digitalWrite(gate1pin, gate1);
-    }
-    if (enable2) {
-      sampleAndHold(voltage2pin, voltage2);
-      digitalWrite(gate2pin, gate2);
     }
-    if (enable3) {
-      sampleAndHold(voltage3pin, voltage3);
-      digitalWrite(gate3pin, gate3);
-    }
-    if (enable4) {
-      sampleAndHold(voltage4pin, voltage4);
-      digitalWrite(gate4pin, gate4);
+  }
+
+  // refresh all enabled output channels
+  for (byte i = 0; i < NUMCHANNEL; i++) {
+    if (enable & (1 << i)) {
+      sampleAndHold(voltagepin[i], voltage[i]);
+      digitalWrite(gatepin[i], gate[i]);
     }
   }
 } //main
-
-
@@ -0,0 +1,28 @@
+#ifndef _MCP4725_H_
+#define _MCP4725_H_
+
+#include <Arduino.h>
+
+/*
+  This writes to an MCP4725 12-bit DAC over I2C. After the address, the fast-write
+  command takes two bytes and the write-DAC commands take three, i.e. 29 instead of
+  38 bit times on the bus including the acknowledgements, start and stop.
+
+  A DAC is only written when its value changed. The value is only remembered once
+  the DAC acknowledged it, hence a write that failed is repeated on the next update.
+*/
+
+#define MCP4726_CMD_FASTWRITE           (0x00)  // Writes data to the DAC in two bytes, with the power-down bits cleared
+#define MCP4726_CMD_WRITEDAC            (0x40)  // Writes data to the DAC
+#define MCP4726_CMD_WRITEDACEEPROM      (0x60)  // Writes data to the DAC and the EEPROM (persisting the assigned value after reset)
+
+typedef struct {
+  uint8_t address;
+  int written;      // the value that the DAC holds, or -1 if not known
+} mcp4725_t;
+
+void mcp4725Begin(mcp4725_t *, uint8_t address);
+bool mcp4725Update(mcp4725_t *, uint16_t value);
+bool mcp4725Write(uint8_t address, uint8_t cmd, uint16_t value);
+
+#endif // _MCP4725_H_
@@ -0,0 +1,222 @@
+#include <string.h>
+#include "protocol.h"
+
+// these are the states of the parser
+#define STATE_IDLE      0
+#define STATE_ASCII     1
+#define STATE_TYPE      2
+#define STATE_LENGTH    3
+#define STATE_PAYLOAD   4
+#define STATE_CRC       5
+
+/***************************************************************************/
+
+uint8_t protocolCRC(uint8_t crc, uint8_t b) {
+  // this is computed bitwise, a lookup table would take too much RAM on the Arduino Nano
+  crc ^= b;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  return crc;
+}
+
+static uint8_t countBits(uint8_t mask) {
+  uint8_t n = 0;
+  for (; mask; mask >>= 1)
+    n += (mask & 1);
+  return n;
+}
+
+static int parseASCII(const uint8_t *buf, uint8_t len, command_t *command) {
+  // the buffer contains the characters between '*' and '#'
+  memset(command, 0, sizeof(command_t));
+  if (len < 4 || buf[2] != 'v' || buf[1] < '1' || buf[1] > '0' + PROTOCOL_CHANNELS)
+    return PARSE_ERROR;
+  uint8_t channel = buf[1] - '1';
+  uint16_t value = 0;
+  for (uint8_t i = 3; i < len; i++) {
+    if (buf[i] < '0' || buf[i] > '9' || value > 999)
+      return PARSE_ERROR;
+    value = value * 10 + (buf[i] - '0');
+  }
+  if (buf[0] == 'c') {
+    command->type = FRAME_SET;
+    command->cvmask = (1 << channel);
+    command->cv[channel] = (value > PROTOCOL_MAXVALUE ? PROTOCOL_MAXVALUE : value);
+    return PARSE_ASCII;
+  }
+  else if (buf[0] == 'g' && len == 4) {
+    command->type = FRAME_SET;
+    command->gatemask = (1 << channel);
+    command->gates = (value != 0) << channel;
+    return PARSE_ASCII;
+  }
+  return PARSE_ERROR;
+}
+
+static uint32_t decodeTime(const uint8_t *p) {
+  return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int decodeSet(const uint8_t *p, uint8_t length, command_t *command) {
+  if (length < 3)
+    return PARSE_INVALID;
+  command->cvmask = p[0];
+  command->gatemask = p[1];
+  command->gates = p[2] & p[1];
+  uint8_t n = countBits(command->cvmask);
+  if (length != 3 + (3 * n + 1) / 2)
+    return PARSE_INVALID;
+
+  p += 3;
+  uint8_t k = 0;
+  for (uint8_t channel = 0; channel < PROTOCOL_CHANNELS; channel++) {
+    if (!(command->cvmask & (1 << channel)))
+      continue;
+    if ((k & 1) == 0) {
+      command->cv[channel] = p[0] | ((uint16_t)(p[1] & 0x0F) << 8);
+    }
+    else {
+      command->cv[channel] = (p[1] >> 4) | ((uint16_t)p[2] << 4);
+      p += 3;
+    }
+    k++;
+  }
+  return PARSE_FRAME;
+}
+
+static int parseFrame(const parser_t *parser, command_t *command) {
+  memset(command, 0, sizeof(command_t));
+  command->type = parser->type & ~FRAME_ACKREQUEST;
+  command->ack = (parser->type & FRAME_ACKREQUEST) != 0;
+  command->length = parser->length;
+  command->payload = parser->buffer;
+
+  switch (command->type) {
+    case FRAME_SET:
+      return decodeSet(parser->buffer, parser->length, command);
+    case FRAME_EVENT:
+      if (parser->length < 4)
+        return PARSE_INVALID;
+      command->time = decodeTime(parser->buffer);
+      return decodeSet(parser->buffer + 4, parser->length - 4, command);
+    case FRAME_SYNC:
+      if (parser->length != 4)
+        return PARSE_INVALID;
+      command->time = decodeTime(parser->buffer);
+      return PARSE_FRAME;
+    default:
+      return PARSE_FRAME;
+  }
+}
+
+/***************************************************************************/
+
+void protocolReset(parser_t *parser) {
+  parser->state = STATE_IDLE;
+  parser->count = 0;
+}
+
+int protocolParse(parser_t *parser, uint8_t b, command_t *command) {
+  switch (parser->state) {
+
+    case STATE_IDLE:
+      // bytes outside a command or frame are ignored
+      if (b == '*') {
+        parser->count = 0;
+        parser->state = STATE_ASCII;
+      }
+      else if (b == PROTOCOL_SYNC) {
+        parser->state = STATE_TYPE;
+      }
+      return PARSE_BUSY;
+
+    case STATE_ASCII:
+      if (b == '#') {
+        parser->state = STATE_IDLE;
+        return parseASCII(parser->buffer, parser->count, command);
+      }
+      else if (parser->count == PROTOCOL_MAXASCII) {
+        parser->state = STATE_IDLE;
+        return PARSE_ERROR;
+      }
+      parser->buffer[parser->count++] = b;
+      return PARSE_BUSY;
+
+    case STATE_TYPE:
+      parser->type = b;
+      parser->crc = protocolCRC(0, b);
+      parser->state = STATE_LENGTH;
+      return PARSE_BUSY;
+
+    case STATE_LENGTH:
+      if (b > PROTOCOL_MAXPAYLOAD) {
+        parser->state = STATE_IDLE;
+        return PARSE_INVALID;
+      }
+      parser->length = b;
+      parser->count = 0;
+      parser->crc = protocolCRC(parser->crc, b);
+      parser->state = (b ? STATE_PAYLOAD : STATE_CRC);
+      return PARSE_BUSY;
+
+    case STATE_PAYLOAD:
+      parser->buffer[parser->count++] = b;
+      parser->crc = protocolCRC(parser->crc, b);
+      if (parser->count == parser->length)
+        parser->state = STATE_CRC;
+      return PARSE_BUSY;
+
+    case STATE_CRC:
+      parser->state = STATE_IDLE;
+      if (b != parser->crc)
+        return PARSE_INVALID;
+      return parseFrame(parser, command);
+  }
+
+  protocolReset(parser);
+  return PARSE_INVALID;
+}
+
+/***************************************************************************/
+
+uint8_t protocolFrame(uint8_t *buf, uint8_t type, const uint8_t *payload, uint8_t length) {
+  // the buffer should have space for the payload plus 4 bytes
+  uint8_t crc = 0;
+  buf[0] = PROTOCOL_SYNC;
+  buf[1] = type;
+  buf[2] = length;
+  memcpy(buf + 3, payload, length);
+  for (uint8_t i = 1; i < length + 3; i++)
+    crc = protocolCRC(crc, buf[i]);
+  buf[length + 3] = crc;
+  return length + 4;
+}
+
+uint8_t protocolPack(uint8_t *payload, uint8_t cvmask, uint8_t gatemask, uint8_t gates, const uint16_t *cv) {
+  // this formats the payload of a FRAME_SET, it is the inverse of parseFrame
+  uint8_t *p = payload + 3, k = 0;
+  payload[0] = cvmask;
+  payload[1] = gatemask;
+  payload[2] = gates & gatemask;
+  for (uint8_t channel = 0; channel < PROTOCOL_CHANNELS; channel++) {
+    if (!(cvmask & (1 << channel)))
+      continue;
+    uint16_t value = cv[channel] & 0x0FFF;
+    if ((k & 1) == 0) {
+      p[0] = value & 0xFF;
+      p[1] = value >> 8;
+    }
+    else {
+      p[1] |= (value & 0x0F) << 4;
+      p[2] = value >> 4;
+      p += 3;
+    }
+    k++;
+  }
+  return 3 + (3 * k + 1) / 2;
+}
+
+uint8_t protocolAck(uint8_t *buf, uint8_t type, uint8_t status) {
+  uint8_t payload[2] = {type, status};
+  return protocolFrame(buf, FRAME_ACK, payload, 2);
+}
@@ -0,0 +1,98 @@
+#ifndef _PROTOCOL_H_
+#define _PROTOCOL_H_
+
+#include <stdint.h>
+
+/*
+  This implements the serial protocol of the EEGsynth CV/Gate controllers. The parser
+  is fed one byte at a time and never blocks. It accepts the original ASCII commands
+  and compact binary frames at the same time.
+
+  The ASCII commands update a single channel and are answered with "ok" or "error"
+    *c1v1024#  control 1 voltage 5*1024/4095 = 1.25 V
+    *g1v1#     gate 1 value ON
+
+  A binary frame updates any number of channels at once and is formatted as
+    sync    0xA5
+    type    frame type, the most significant bit requests an acknowledgement
+    length  number of bytes in the payload
+    payload
+    crc     CRC-8 with polynomial 0x07 over the type, length and payload
+
+  The payload of a FRAME_SET contains
+    cvmask    bit N is set if control voltage N+1 is to be updated
+    gatemask  bit N is set if gate N+1 is to be updated
+    gates     bit N contains the new value of gate N+1
+    values    12-bit control voltages in increasing channel order, packed as two
+              values in three bytes, least significant bits first
+
+  The payload of a FRAME_MODULATION contains
+    cvmask    bit N is set if the modulation of control voltage N+1 is to be changed
+    mode      see modulation.h, this is only supported by the MCP4822 sketches
+    params    four 16-bit parameters, least significant byte first
+
+  The payload of a FRAME_EVENT contains a 32-bit timestamp in ms of the host clock,
+  least significant byte first, followed by the payload of a FRAME_SET. The event is
+  applied at that moment, which requires the clocks to be synchronized with a FRAME_SYNC.
+
+  The payload of a FRAME_SYNC contains the 32-bit time in ms of the host clock. It is
+  answered with a FRAME_SYNC that contains the 32-bit time of the device, followed by
+  the 16-bit number of events that arrived too late and that were dropped. Scheduled
+  events are only supported by the MCP4822 sketches.
+
+  The acknowledgement is a FRAME_ACK with the type of the original frame and the status.
+*/
+
+#define PROTOCOL_SYNC           0xA5
+#define PROTOCOL_CHANNELS       8
+#define PROTOCOL_MAXPAYLOAD     32
+#define PROTOCOL_MAXASCII       10
+#define PROTOCOL_MAXVALUE       4095
+
+#define FRAME_SET               0x01
+#define FRAME_MODULATION        0x02
+#define FRAME_EVENT             0x03
+#define FRAME_SYNC              0x04
+#define FRAME_ACK               0x06
+#define FRAME_ACKREQUEST        0x80
+
+// the return value of the parser
+#define PARSE_BUSY              0
+#define PARSE_ASCII             1
+#define PARSE_FRAME             2
+#define PARSE_ERROR             -1  // malformed ASCII command, this is answered with "error"
+#define PARSE_INVALID           -2  // invalid binary frame, this is not answered
+
+// the status that is returned to the host
+#define STATUS_OK               0
+#define STATUS_ERROR            1
+
+typedef struct {
+  uint8_t  type;                  // without the acknowledgement bit
+  uint8_t  ack;                   // whether an acknowledgement was requested
+  uint8_t  cvmask;
+  uint8_t  gatemask;
+  uint8_t  gates;
+  uint16_t cv[PROTOCOL_CHANNELS];
+  uint32_t time;                  // in ms of the host clock
+  uint8_t  length;                // the raw payload, for frame types that are not decoded here
+  const uint8_t *payload;
+} command_t;
+
+typedef struct {
+  uint8_t state;
+  uint8_t type;
+  uint8_t length;
+  uint8_t count;
+  uint8_t crc;
+  uint8_t buffer[PROTOCOL_MAXPAYLOAD];
+} parser_t;
+
+void protocolReset(parser_t *);
+int protocolParse(parser_t *, uint8_t, command_t *);
+uint8_t protocolCRC(uint8_t, uint8_t);
+uint8_t protocolPack(uint8_t *, uint8_t, uint8_t, uint8_t, const uint16_t *);
+uint8_t protocolFrame(uint8_t *, uint8_t, const uint8_t *, uint8_t);
+uint8_t protocolAck(uint8_t *, uint8_t, uint8_t);
+
+#endif // _PROTOCOL_H_
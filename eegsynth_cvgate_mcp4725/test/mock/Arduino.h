@@ -0,0 +1,14 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the Arduino core for the host tests, it only
+// provides what the modules of this sketch use.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+typedef uint8_t byte;
+
+#endif // _ARDUINO_H_
@@ -0,0 +1,43 @@
+#ifndef _WIRE_H_
+#define _WIRE_H_
+
+// This replaces the Wire library for the host tests. Every transmission is recorded
+// and the time that it takes on the bus is added up: each byte takes nine clocks
+// including the acknowledgement, the start and stop conditions take one clock each.
+
+#include <Arduino.h>
+
+struct MockTransmission {
+  uint8_t address;
+  std::vector<uint8_t> bytes;
+};
+
+class MockWire {
+  public:
+    uint32_t clock = 100000;
+    double busTime = 0;         // in microseconds
+    unsigned int nack = 0;      // the number of transmissions that will not be acknowledged
+    std::vector<MockTransmission> log;
+
+    void begin() {}
+    void setClock(uint32_t c) { clock = c; }
+    void beginTransmission(uint8_t address) {
+      log.push_back({address, {}});
+    }
+    size_t write(uint8_t b) {
+      log.back().bytes.push_back(b);
+      return 1;
+    }
+    uint8_t endTransmission() {
+      busTime += (9. * (1 + log.back().bytes.size()) + 2) * 1e6 / clock;
+      if (nack) {
+        nack--;
+        return 2;   // the address was not acknowledged
+      }
+      return 0;
+    }
+};
+
+extern MockWire Wire;
+
+#endif // _WIRE_H_
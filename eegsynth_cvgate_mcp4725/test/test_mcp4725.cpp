@@ -0,0 +1,129 @@
+// Host test of the MCP4725 module, with a Wire mock that records the transmissions and
+// adds up the time that they take on the bus
+//
+// The benchmark compares the fast-write command to the write-DAC command at the standard
+// and fast I2C clock. The bus time follows from the number of bytes and is what the DAC
+// actually sees, the time that the microcontroller spends around it is not included.
+
+#include "check.h"
+#include "mcp4725.h"
+#include <Wire.h>
+
+MockWire Wire;
+
+static void reset() {
+  Wire.log.clear();
+  Wire.busTime = 0;
+  Wire.nack = 0;
+}
+
+/***************************************************************************/
+
+static void testCommands() {
+  // the fast-write command puts the 12 bits in two bytes
+  reset();
+  CHECK(mcp4725Write(0x60, MCP4726_CMD_FASTWRITE, 0x123));
+  CHECK(mcp4725Write(0x61, MCP4726_CMD_FASTWRITE, 4095));
+  CHECK_EQUAL(Wire.log.size(), 2);
+  CHECK_EQUAL(Wire.log[0].address, 0x60);
+  CHECK_EQUAL(Wire.log[0].bytes.size(), 2);
+  CHECK_EQUAL(Wire.log[0].bytes[0], 0x01);
+  CHECK_EQUAL(Wire.log[0].bytes[1], 0x23);
+  CHECK_EQUAL(Wire.log[1].address, 0x61);
+  CHECK_EQUAL(Wire.log[1].bytes[0], 0x0F);
+  CHECK_EQUAL(Wire.log[1].bytes[1], 0xFF);
+
+  // the write-DAC command puts them in the second and third byte, left aligned
+  reset();
+  CHECK(mcp4725Write(0x60, MCP4726_CMD_WRITEDAC, 0x123));
+  CHECK_EQUAL(Wire.log[0].bytes.size(), 3);
+  CHECK_EQUAL(Wire.log[0].bytes[0], MCP4726_CMD_WRITEDAC);
+  CHECK_EQUAL(Wire.log[0].bytes[1], 0x12);
+  CHECK_EQUAL(Wire.log[0].bytes[2], 0x30);
+
+  // a write that is not acknowledged fails
+  Wire.nack = 1;
+  CHECK(!mcp4725Write(0x60, MCP4726_CMD_FASTWRITE, 0));
+  CHECK(mcp4725Write(0x60, MCP4726_CMD_FASTWRITE, 0));
+}
+
+static void testUpdate() {
+  mcp4725_t dac;
+  mcp4725Begin(&dac, 0x60);
+  reset();
+
+  // the first update is always written, the same value is not written again
+  CHECK(mcp4725Update(&dac, 0));
+  CHECK(mcp4725Update(&dac, 0));
+  CHECK_EQUAL(Wire.log.size(), 1);
+  CHECK(mcp4725Update(&dac, 1000));
+  CHECK(mcp4725Update(&dac, 1000));
+  CHECK_EQUAL(Wire.log.size(), 2);
+  CHECK_EQUAL(dac.written, 1000);
+
+  // a failed write is not remembered, hence the next update with the same value repeats it
+  Wire.nack = 1;
+  CHECK(!mcp4725Update(&dac, 2000));
+  CHECK_EQUAL(dac.written, -1);
+  CHECK_EQUAL(Wire.log.size(), 3);
+  CHECK(mcp4725Update(&dac, 2000));
+  CHECK_EQUAL(dac.written, 2000);
+  CHECK_EQUAL(Wire.log.size(), 4);
+  CHECK_EQUAL(Wire.log[3].bytes[1], 2000 & 0xFF);
+
+  // the DAC might not hold the previous value anymore, hence that is written again as well
+  Wire.nack = 1;
+  CHECK(!mcp4725Update(&dac, 3000));
+  CHECK(mcp4725Update(&dac, 2000));
+  CHECK_EQUAL(Wire.log.size(), 6);
+
+  // also when it fails several times in a row
+  Wire.nack = 3;
+  for (int i = 0; i < 3; i++)
+    CHECK(!mcp4725Update(&dac, 1000));
+  CHECK(mcp4725Update(&dac, 1000));
+  CHECK(mcp4725Update(&dac, 1000));
+  CHECK_EQUAL(Wire.log.size(), 10);
+}
+
+static void testBenchmark() {
+  static const uint32_t clock[] = {100000, 400000};
+  static const struct {
+    uint8_t cmd;
+    const char *name;
+    unsigned int bytes;
+  } write[] = {{MCP4726_CMD_WRITEDAC, "write-DAC", 4}, {MCP4726_CMD_FASTWRITE, "fast-write", 3}};
+  const unsigned int updates = 4096;
+  double fastest = 0, slowest = 1e9;
+
+  for (unsigned int i = 0; i < sizeof(clock) / sizeof(clock[0]); i++)
+    for (unsigned int j = 0; j < sizeof(write) / sizeof(write[0]); j++) {
+      reset();
+      Wire.setClock(clock[i]);
+      for (unsigned int k = 0; k < updates; k++)
+        mcp4725Write(0x60, write[j].cmd, k);
+
+      // the address is sent on the bus as well
+      size_t bytes = 0;
+      for (size_t k = 0; k < Wire.log.size(); k++)
+        bytes += 1 + Wire.log[k].bytes.size();
+      CHECK_EQUAL(bytes, updates * write[j].bytes);
+
+      double perUpdate = Wire.busTime / updates;
+      printf("%-10s at %3u kHz: %u bytes and %5.1f us per update, %5.0f updates/s\n",
+             write[j].name, clock[i] / 1000, write[j].bytes, perUpdate, 1e6 / perUpdate);
+      fastest = (1e6 / perUpdate > fastest ? 1e6 / perUpdate : fastest);
+      slowest = (1e6 / perUpdate < slowest ? 1e6 / perUpdate : slowest);
+    }
+
+  // the fast-write command at 400 kHz against the write-DAC command at 100 kHz
+  CHECK_CLOSE(fastest, 400000. / 29, 1);
+  CHECK_CLOSE(slowest, 100000. / 38, 1);
+}
+
+int main() {
+  testCommands();
+  testUpdate();
+  testBenchmark();
+  return report("test_mcp4725");
+}
@@ -9,47 +9,110 @@
 *   *c1v1024#  control 1 voltage 5*1024/4095 = 1.25 V
 *   *g1v1#     gate 1 value ON
 *
+* Besides these ASCII commands, it accepts binary frames that update
+* all control voltages and gates at once, see protocol.h
+*
+* The LDAC pins of all MCP4822 DACs must be connected to pin 4, the
+* outputs are updated simultaneously at a fixed rate, see output.h
+*
+* Each control voltage can glide to a new value, follow an ADSR envelope
+* that is triggered by its gate, or oscillate, see modulation.h
+*
+* Commands can be scheduled ahead with a timestamp of the host clock,
+* which prevents the serial jitter from affecting the rhythm, see protocol.h
+*
 * This work is licensed under a Creative Commons Attribution-ShareAlike 4.0 International License.
 * See http://creativecommons.org/licenses/by-sa/4.0/
 *
 * Copyright (C) 2015, Robert Oostenveld, http://www.eegsynth.org/
 */
 
-#include <SPI.h>
-
-const int GAIN_1 = 0x1;
-const int GAIN_2 = 0x0;
+#include "protocol.h"
+#include "output.h"
+#include "modulation.h"
 
 #define voltage12cs     2      // the slave-select pin for channel 1 and 2 on DAC #1
 #define voltage34cs     3      // the slave-select pin for channel 3 and 4 on DAC #2
+#define ldacpin         4      // the pin that latches all DACs at the same moment
 #define gate1pin A0            // the pin controlling the digital gate
 #define gate2pin A1            // the pin controlling the digital gate
 #define gate3pin A2            // the pin controlling the digital gate
 #define gate4pin A3            // the pin controlling the digital gate
 
-#define NONE    0
-#define VOLTAGE 1
-#define GATE    2
-
-#define OK    1
-#define ERROR 2
-
+#define NUMCHANNEL 4
+
+const byte cspin[NUMCHANNEL]   = {voltage12cs, voltage12cs, voltage34cs, voltage34cs};
+const byte gatepin[NUMCHANNEL] = {gate1pin, gate2pin, gate3pin, gate4pin};
+
+const byte enable = 0x0F;      // bit N is set if channel N+1 is enabled
+
+parser_t parser;
+command_t command;
+int32_t offset = 0;           // between the host clock and the device clock, in ms
+
+byte applyModulation(const command_t *command) {
+  const byte *p = command->payload;
+  uint16_t param[MOD_PARAMETERS];
+  byte status = STATUS_OK;
+  if (command->length != 2 + 2 * MOD_PARAMETERS)
+    return STATUS_ERROR;
+  for (byte k = 0; k < MOD_PARAMETERS; k++)
+    param[k] = p[2 + 2 * k] | (p[3 + 2 * k] << 8);
+  for (byte i = 0; i < NUMCHANNEL; i++)
+    if (p[0] & enable & (1 << i))
+      if (!modulationConfig(i, p[1], param))
+        status = STATUS_ERROR;
+  return ((p[0] & ~enable) ? STATUS_ERROR : status);
+}
 
-// these remember the state of all CV and gate outputs
-int voltage1 = 0, voltage2 = 0, voltage3 = 0, voltage4 = 0;
-int gate1 = 0, gate2 = 0, gate3 = 0, gate4 = 0;
-const int enable1 = 1, enable2 = 1, enable3 = 1, enable4 = 1;
+byte scheduleEvent(const command_t *command) {
+  event_t event;
+  event.time = command->time + offset;
+  event.cvmask = command->cvmask & enable;
+  event.gatemask = command->gatemask & enable;
+  event.gates = command->gates;
+  for (byte i = 0; i < OUTPUT_MAXCHANNEL; i++)
+    event.cv[i] = command->cv[i];
+  if (!outputSchedule(&event))
+    return STATUS_ERROR;
+  return ((command->cvmask & ~enable) ? STATUS_ERROR : STATUS_OK);
+}
 
-void setDacOutput(byte channel, byte gain, byte shutdown, unsigned int val)
-{
-  byte lowByte = val & 0xff;
-  byte highByte = ((val >> 8) & 0xff) | channel << 7 | gain << 5 | shutdown << 4;
+void synchronize(const command_t *command) {
+  // map the host clock onto the device clock and report the device clock and counters
+  byte payload[8], buf[12];
+  uint32_t now = outputTime();
+  uint16_t late = outputLate(), dropped = outputDropped();
+  offset = now - command->time;
+  for (byte k = 0; k < 4; k++)
+    payload[k] = (now >> (8 * k)) & 0xFF;
+  payload[4] = late & 0xFF;
+  payload[5] = late >> 8;
+  payload[6] = dropped & 0xFF;
+  payload[7] = dropped >> 8;
+  Serial.write(buf, protocolFrame(buf, FRAME_SYNC, payload, 8));
+}
 
-  // note that we are not using the default pin 10 for slave select, see further down
-  // PORTB &= 0xfb; // toggle pin 10 as Slave Select low
-  SPI.transfer(highByte);
-  SPI.transfer(lowByte);
-  // PORTB |= 0x4; // toggle pin 10 as Slave Select high
+byte applyCommand(const command_t *command) {
+  if (command->type == FRAME_MODULATION)
+    return applyModulation(command);
+  else if (command->type == FRAME_EVENT)
+    return scheduleEvent(command);
+  else if (command->type != FRAME_SET)
+    return STATUS_ERROR;
+  // all channels in the command change at the same update of the outputs
+  noInterrupts();
+  for (byte i = 0; i < NUMCHANNEL; i++) {
+    if (command->cvmask & enable & (1 << i))
+      outputVoltage(i, command->cv[i]);
+    if (command->gatemask & enable & (1 << i))
+      outputGate(i, (command->gates >> i) & 1);
+  }
+  interrupts();
+  // it is an error to address a channel that does not exist or that is not enabled
+  if ((command->cvmask & ~enable) || (command->gatemask >> NUMCHANNEL))
+    return STATUS_ERROR;
+  return STATUS_OK;
 }
 
 void setup() {
@@ -60,141 +123,34 @@ void setup() {
   Serial.print(" / ");
   Serial.print(__TIME__);
   Serial.println("]");
-  Serial.setTimeout(1000);
-
-  SPI.begin();
 
-  // initialize the gate pins as output:
-  pinMode(gate1pin, OUTPUT);
-  pinMode(gate2pin, OUTPUT);
-  pinMode(gate3pin, OUTPUT);
-  pinMode(gate4pin, OUTPUT);
+  // the control voltages and gates are updated from a timer interrupt
+  outputBegin(cspin, gatepin, ldacpin, NUMCHANNEL);
 
-  // initialize the control voltage pins as output:
-  pinMode(voltage12cs, OUTPUT);
-  pinMode(voltage34cs, OUTPUT);
-
-  // default is to disable the communication with all SPI devices
-  digitalWrite(voltage12cs, HIGH);
-  digitalWrite(voltage34cs, HIGH);
+  protocolReset(&parser);
 }
 
 void loop() {
-  byte b, channel = 0, command = NONE, status = OK;
-  int value = 0;
-
-  if (Serial.available()) {
-
-    // parse the input over the serial connection
-    b = Serial.read();
-    if (b == '*') {
-      Serial.readBytes(&b, 1);
-      if (b == 'c') {
-        command = VOLTAGE;
-        value = 0;
-        Serial.readBytes(&b, 1); channel = b - 48; // character '1' is ascii value 49
-        Serial.readBytes(&b, 1); // 'v'
-        Serial.readBytes(&b, 1); value  = (b - 48) * 1000;
-        Serial.readBytes(&b, 1); value += (b - 48) * 100;
-        Serial.readBytes(&b, 1); value += (b - 48) * 10;
-        Serial.readBytes(&b, 1); value += (b - 48) * 1;
-        Serial.readBytes(&b, 1); command = (b == '#' ? command : NONE);
-      }
-      else if (b == 'g') {
-        command = GATE;
-        Serial.readBytes(&b, 1); channel = b - 48; // character '1' is ascii value 49
-        Serial.readBytes(&b, 1); // 'v'
-        Serial.readBytes(&b, 1); value  = (b == '1');
-        Serial.readBytes(&b, 1); command = (b == '#' ? command : NONE);
-      }
-      else {
-        command = NONE;
-      }
-    }
-    else {
-      command = NONE;
-    }
-
-    // update the internal state of all output channels
-    if (command == VOLTAGE) {
-      switch (channel) {
-        case 1:
-          voltage1 = value;
-          status = (enable1 ? OK : ERROR);
-          break;
-        case 2:
-          voltage2 = value;
-          status = (enable2 ? OK : ERROR);
-          break;
-        case 3:
-          voltage3 = value;
-          status = (enable3 ? OK : ERROR);
-          break;
-        case 4:
-          voltage4 = value;
-          status = (enable4 ? OK : ERROR);
-          break;
-        default:
-          status = ERROR;
-      }
-
+  byte buf[8], status;
+  int result;
+
+  // parse the input over the serial connection, this does not wait for incomplete commands
+  while (Serial.available()) {
+    result = protocolParse(&parser, Serial.read(), &command);
+    if (result == PARSE_ASCII) {
+      status = applyCommand(&command);
+      Serial.println(status == STATUS_OK ? "ok" : "error");
     }
-    else if (command == GATE) {
-      switch (channel) {
-        case 1:
-          gate1 = (value != 0);
-          status = OK;
-          break;
-        case 2:
-          gate2 = (value != 0);
-          status = OK;
-          break;
-        case 3:
-          gate3 = (value != 0);
-          status = OK;
-          break;
-        case 4:
-          gate4 = (value != 0);
-          status = OK;
-          break;
-        default:
-          status = ERROR;
-      }
+    else if (result == PARSE_FRAME && command.type == FRAME_SYNC) {
+      synchronize(&command);
     }
-    else {
-      status = ERROR;
+    else if (result == PARSE_FRAME) {
+      status = applyCommand(&command);
+      if (command.ack)
+        Serial.write(buf, protocolAck(buf, command.type, status));
     }
-    if (status == OK)
-      Serial.println("ok");
-    else if (status == ERROR)
+    else if (result == PARSE_ERROR) {
       Serial.println("error");
-  }
-  else {
-    // refresh all enabled output channels
-    if (enable1) {
-      digitalWrite(voltage12cs, LOW); // enable slave select
-      setDacOutput(0, GAIN_2, 1, voltage1);
-      digitalWrite(voltage12cs, HIGH); // disable slave select
-      digitalWrite(gate1pin, gate1);
-    }
-    if (enable2) {
-      digitalWrite(voltage12cs, LOW); // enable slave select
-      setDacOutput(1, GAIN_2, 1, voltage2);
-      digitalWrite(voltage12cs, HIGH); // disable slave select
-      digitalWrite(gate2pin, gate2);
-    }
-    if (enable3) {
-      digitalWrite(voltage34cs, LOW); // enable slave select
-      setDacOutput(0, GAIN_2, 1, voltage3);
-      digitalWrite(voltage34cs, HIGH); // disable slave select
-      digitalWrite(gate3pin, gate3);
-    }
-    if (enable4) {
-      digitalWrite(voltage34cs, LOW); // enable slave select
-      setDacOutput(1, GAIN_2, 1, voltage4);
-      digitalWrite(voltage34cs, HIGH); // disable slave select
-      digitalWrite(gate4pin, gate4);
     }
   }
 } //main
-
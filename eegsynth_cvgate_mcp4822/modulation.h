@@ -0,0 +1,39 @@
+#ifndef _MODULATION_H_
+#define _MODULATION_H_
+
+#include <stdint.h>
+
+/*
+  This computes the control voltage of each channel at every update of the outputs,
+  so that the host only has to send the target value or a gate instead of streaming
+  many intermediate values. All computations use fixed-point integers.
+
+  The modes and their parameters are
+    MOD_NONE         the output jumps to the target value
+    MOD_LINEAR       time in ms for a full-scale change
+    MOD_EXPONENTIAL  time constant in ms
+    MOD_ADSR         attack in ms, decay in ms, sustain level 0-4095, release in ms
+    MOD_LFO          frequency in 0.01 Hz, depth 0-4095, waveform
+
+  The ADSR envelope is triggered by the gate of the same channel and scales the target
+  value, which therefore sets the peak level. The LFO oscillates around the target value.
+*/
+
+#define MOD_NONE          0
+#define MOD_LINEAR        1
+#define MOD_EXPONENTIAL   2
+#define MOD_ADSR          3
+#define MOD_LFO           4
+
+#define WAVE_TRIANGLE     0
+#define WAVE_SAWTOOTH     1
+#define WAVE_SQUARE       2
+
+#define MOD_MAXCHANNEL    8
+#define MOD_PARAMETERS    4
+
+void modulationBegin(uint16_t);
+bool modulationConfig(uint8_t, uint8_t, const uint16_t *);
+uint16_t modulationTick(uint8_t, uint16_t, uint8_t);
+
+#endif // _MODULATION_H_
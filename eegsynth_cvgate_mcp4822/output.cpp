@@ -0,0 +1,210 @@
+#include <SPI.h>
+#include "output.h"
+#include "modulation.h"
+
+#define GAIN_1 0x1
+#define GAIN_2 0x0
+#define TICKS  (OUTPUT_RATE / 1000)  // number of updates per ms
+
+static const uint8_t *cspin, *gatepin;
+static uint8_t ldacpin, numchannel = 0;
+
+// these are shared between the main loop and the interrupt
+static volatile uint16_t voltage[OUTPUT_MAXCHANNEL];
+static volatile uint8_t gate = 0;
+static volatile uint8_t gateDirty = 0;
+
+// this is the value that was last written to each DAC
+static uint16_t current[OUTPUT_MAXCHANNEL];
+static volatile unsigned long latches = 0;
+
+// the scheduled events are sorted by time, the first one is at the head
+static event_t event[OUTPUT_NUMEVENTS];
+static volatile uint8_t head = 0, count = 0;
+static volatile uint32_t now = 0;   // in updates since the start
+static volatile uint16_t late = 0, dropped = 0;
+
+/***************************************************************************/
+
+static inline void setDacOutput(uint8_t channel, uint8_t gain, uint8_t shutdown, uint16_t val) {
+  uint8_t lowByte = val & 0xff;
+  uint8_t highByte = ((val >> 8) & 0x0f) | channel << 7 | gain << 5 | shutdown << 4;
+  SPI.transfer(highByte);
+  SPI.transfer(lowByte);
+}
+
+static void applyEvent(const event_t *e) {
+  for (uint8_t i = 0; i < numchannel; i++) {
+    if (e->cvmask & (1 << i))
+      voltage[i] = e->cv[i];
+    if ((e->gatemask & (1 << i)) && ((gate ^ e->gates) & (1 << i))) {
+      gate ^= (1 << i);
+      gateDirty |= (1 << i);
+    }
+  }
+}
+
+ISR(TIMER1_COMPA_vect) {
+  uint8_t dirty = 0;
+  now++;
+  // apply the events that are due at this update
+  while (count && (int32_t)(event[head].time - now) <= 0) {
+    applyEvent(&event[head]);
+    head = (head + 1) % OUTPUT_NUMEVENTS;
+    count--;
+  }
+  // the requested voltage is the target for slew, envelope or LFO
+  for (uint8_t i = 0; i < numchannel; i++) {
+    uint16_t value = modulationTick(i, voltage[i], (gate >> i) & 1);
+    if (value != current[i]) {
+      current[i] = value;
+      dirty |= (1 << i);
+    }
+  }
+  if (dirty) {
+    // write the changed channels to the input registers, the outputs do not change yet
+    for (uint8_t i = 0; i < numchannel; i++) {
+      if (dirty & (1 << i)) {
+        digitalWrite(cspin[i], LOW);
+        setDacOutput(i % 2, GAIN_2, 1, current[i]);
+        digitalWrite(cspin[i], HIGH);
+      }
+    }
+    // transfer the input registers of all DACs to their outputs at the same moment
+    digitalWrite(ldacpin, LOW);
+    digitalWrite(ldacpin, HIGH);
+    latches++;
+  }
+  dirty = gateDirty;
+  if (dirty) {
+    for (uint8_t i = 0; i < numchannel; i++)
+      if (dirty & (1 << i))
+        digitalWrite(gatepin[i], (gate >> i) & 1);
+    gateDirty = 0;
+  }
+}
+
+/***************************************************************************/
+
+void outputBegin(const uint8_t *cs, const uint8_t *gp, uint8_t ldac, uint8_t n) {
+  cspin = cs;
+  gatepin = gp;
+  ldacpin = ldac;
+  numchannel = (n < OUTPUT_MAXCHANNEL ? n : OUTPUT_MAXCHANNEL);
+
+  for (uint8_t i = 0; i < numchannel; i++) {
+    pinMode(cspin[i], OUTPUT);
+    digitalWrite(cspin[i], HIGH);
+    pinMode(gatepin[i], OUTPUT);
+    digitalWrite(gatepin[i], LOW);
+    voltage[i] = 0;
+    current[i] = 0xFFFF;
+  }
+  pinMode(ldacpin, OUTPUT);
+  digitalWrite(ldacpin, HIGH);
+
+  // the MCP4822 accepts a clock of up to 20 MHz
+  SPI.begin();
+  SPI.setClockDivider(SPI_CLOCK_DIV2);
+
+  // all channels are written once at the first update
+  gateDirty = 0;
+  modulationBegin(OUTPUT_RATE);
+
+  // Timer1 in CTC mode with a prescaler of 8
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = (1 << WGM12) | (1 << CS11);
+  TCNT1  = 0;
+  OCR1A  = (F_CPU / 8) / OUTPUT_RATE - 1;
+  TIMSK1 = (1 << OCIE1A);
+  interrupts();
+}
+
+void outputVoltage(uint8_t channel, uint16_t value) {
+  if (channel >= numchannel)
+    return;
+  value = (value > 4095 ? 4095 : value);
+  uint8_t sreg = SREG;
+  cli();
+  voltage[channel] = value;
+  SREG = sreg;
+}
+
+void outputGate(uint8_t channel, uint8_t value) {
+  if (channel >= numchannel)
+    return;
+  uint8_t sreg = SREG;
+  cli();
+  if (((gate >> channel) & 1) != (value != 0)) {
+    gate ^= (1 << channel);
+    gateDirty |= (1 << channel);
+  }
+  SREG = sreg;
+}
+
+unsigned long outputLatches() {
+  uint8_t sreg = SREG;
+  cli();
+  unsigned long n = latches;
+  SREG = sreg;
+  return n;
+}
+
+bool outputSchedule(const event_t *e) {
+  bool status = true;
+  event_t scheduled = *e;
+  scheduled.time = e->time * TICKS;
+  for (uint8_t i = 0; i < OUTPUT_MAXCHANNEL; i++)
+    scheduled.cv[i] = (e->cv[i] > 4095 ? 4095 : e->cv[i]);
+
+  uint8_t sreg = SREG;
+  cli();
+  if ((int32_t)(scheduled.time - now) <= 0) {
+    // it will be applied at the next update
+    late++;
+  }
+  if (count == OUTPUT_NUMEVENTS) {
+    dropped++;
+    status = false;
+  }
+  else {
+    // the events usually arrive in order, so this insertion rarely has to move any
+    uint8_t k = count;
+    while (k > 0) {
+      event_t *previous = &event[(head + k - 1) % OUTPUT_NUMEVENTS];
+      if ((int32_t)(scheduled.time - previous->time) >= 0)
+        break;
+      event[(head + k) % OUTPUT_NUMEVENTS] = *previous;
+      k--;
+    }
+    event[(head + k) % OUTPUT_NUMEVENTS] = scheduled;
+    count++;
+  }
+  SREG = sreg;
+  return status;
+}
+
+uint32_t outputTime() {
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t t = now;
+  SREG = sreg;
+  return t / TICKS;
+}
+
+uint16_t outputLate() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = late;
+  SREG = sreg;
+  return n;
+}
+
+uint16_t outputDropped() {
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = dropped;
+  SREG = sreg;
+  return n;
+}
@@ -0,0 +1,61 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the Arduino core for the host tests, it only
+// provides what the modules of this sketch use. The timer registers are plain
+// variables, the interrupt service routine is called by the test. Every write
+// to a pin is recorded, together with the SPI transfers, in the order in which
+// they happen.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+typedef uint8_t byte;
+
+#define F_CPU 16000000UL
+
+#define INPUT  0
+#define OUTPUT 1
+#define LOW    0
+#define HIGH   1
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+struct MockAction {
+  char type;      // 'p' for a pin and 's' for an SPI transfer
+  uint8_t pin;
+  uint8_t value;
+};
+
+extern std::vector<MockAction> mockLog;
+extern uint8_t mockPin[20];
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+  mockPin[pin] = value;
+  mockLog.push_back({'p', pin, value});
+}
+
+// the AVR status register and the registers of Timer1
+extern uint8_t SREG, TCCR1A, TCCR1B, TIMSK1;
+extern uint16_t TCNT1, OCR1A;
+
+#define WGM12  3
+#define CS11   1
+#define OCIE1A 1
+
+inline void cli() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+#define ISR(vector) extern "C" void vector(void)
+extern "C" void TIMER1_COMPA_vect(void);
+
+#endif // _ARDUINO_H_
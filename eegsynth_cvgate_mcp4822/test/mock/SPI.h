@@ -0,0 +1,24 @@
+#ifndef _SPI_H_
+#define _SPI_H_
+
+// This replaces the SPI library for the host tests, every transfer is recorded.
+
+#include <Arduino.h>
+
+#define SPI_CLOCK_DIV2 4
+
+class MockSPI {
+  public:
+    uint8_t divider = 0;
+
+    void begin() {}
+    void setClockDivider(uint8_t d) { divider = d; }
+    uint8_t transfer(uint8_t b) {
+      mockLog.push_back({'s', 0, b});
+      return 0;
+    }
+};
+
+extern MockSPI SPI;
+
+#endif // _SPI_H_
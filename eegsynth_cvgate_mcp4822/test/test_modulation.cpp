@@ -0,0 +1,178 @@
+// Host test of the curve shapes of the modulation, and of the LFO frequency at 1-4 kHz update rates
+
+#include <time.h>
+#include "check.h"
+#include "modulation.h"
+
+static uint16_t run(uint8_t channel, uint16_t target, uint8_t gate, unsigned long ticks) {
+  uint16_t value = 0;
+  for (unsigned long k = 0; k < ticks; k++)
+    value = modulationTick(channel, target, gate);
+  return value;
+}
+
+static void config(uint8_t channel, uint8_t mode, uint16_t p0, uint16_t p1 = 0, uint16_t p2 = 0, uint16_t p3 = 0) {
+  uint16_t param[MOD_PARAMETERS] = {p0, p1, p2, p3};
+  CHECK(modulationConfig(channel, mode, param));
+}
+
+static void testNone() {
+  modulationBegin(1000);
+  CHECK_EQUAL(modulationTick(0, 1234, 0), 1234);
+  CHECK_EQUAL(modulationTick(0, 0, 0), 0);
+
+  uint16_t param[MOD_PARAMETERS] = {0};
+  CHECK(!modulationConfig(MOD_MAXCHANNEL, MOD_LINEAR, param));
+  CHECK(!modulationConfig(0, 99, param));
+}
+
+static void testLinear() {
+  // a full-scale change takes 100 ms, at 1 kHz that is 100 updates
+  modulationBegin(1000);
+  config(0, MOD_LINEAR, 100);
+  uint16_t previous = 0;
+  for (int k = 1; k <= 100; k++) {
+    uint16_t value = modulationTick(0, 4095, 0);
+    CHECK(value >= previous);
+    CHECK_CLOSE(value, 40.95 * k, 1);
+    previous = value;
+  }
+  CHECK_EQUAL(previous, 4095);
+
+  // half the change takes half the time, also downwards
+  CHECK_CLOSE(run(0, 2048, 0, 25), 4095 - 25 * 40.95, 1);
+  CHECK_EQUAL(run(0, 2048, 0, 25), 2048);
+  CHECK_EQUAL(run(0, 2048, 0, 1000), 2048);
+
+  // the time scales with the update rate
+  modulationBegin(4000);
+  config(0, MOD_LINEAR, 100);
+  CHECK_CLOSE(run(0, 4095, 0, 200), 2048, 1);
+  CHECK_EQUAL(run(0, 4095, 0, 200), 4095);
+}
+
+static void testExponential() {
+  // after one time constant the value covers 63% of the change
+  modulationBegin(1000);
+  config(1, MOD_EXPONENTIAL, 100);
+  CHECK_CLOSE(run(1, 4000, 0, 100), 4000 * (1 - exp(-1)), 0.01 * 4000);
+  CHECK_CLOSE(run(1, 4000, 0, 100), 4000 * (1 - exp(-2)), 0.01 * 4000);
+  CHECK_CLOSE(run(1, 4000, 0, 300), 4000 * (1 - exp(-5)), 0.01 * 4000);
+
+  // it does not get stuck just below the target, and it also works downwards
+  CHECK_EQUAL(run(1, 4000, 0, 2000), 4000);
+  CHECK_CLOSE(run(1, 1000, 0, 100), 1000 + 3000 * exp(-1), 0.01 * 3000);
+  CHECK_EQUAL(run(1, 1000, 0, 2000), 1000);
+}
+
+static void testADSR() {
+  // attack 10 ms, decay 20 ms, sustain at half the level and release 50 ms
+  modulationBegin(1000);
+  config(2, MOD_ADSR, 10, 20, 2048, 50);
+  CHECK_EQUAL(run(2, 4000, 0, 10), 0);
+
+  // the gate starts the attack, the target sets the peak
+  uint16_t previous = 0;
+  for (int k = 1; k <= 10; k++) {
+    uint16_t value = modulationTick(2, 4000, 1);
+    CHECK(value > previous);
+    CHECK_CLOSE(value, 400 * k, 2);
+    previous = value;
+  }
+  CHECK_CLOSE(previous, 4000, 1);
+
+  // the update after the attack is at the peak, after which the decay starts
+  CHECK_EQUAL(run(2, 4000, 1, 1), 4000);
+  CHECK_CLOSE(run(2, 4000, 1, 10), 4000 - (4000 - 2000) / 2, 2);
+  CHECK_CLOSE(run(2, 4000, 1, 10), 4000 * 2048 / 4095., 2);
+  CHECK_CLOSE(run(2, 4000, 1, 1000), 4000 * 2048 / 4095., 2);
+
+  // the release goes from the current level down to zero
+  CHECK_CLOSE(run(2, 4000, 0, 25), 4000 * 2048 / 4095. - 2000, 2);
+  CHECK_EQUAL(run(2, 4000, 0, 1000), 0);
+
+  // a gate that ends during the attack releases from that level
+  run(2, 4000, 1, 5);
+  uint16_t value = modulationTick(2, 4000, 0);
+  CHECK_CLOSE(value, 2000 - 80, 2);
+  CHECK_EQUAL(run(2, 4000, 0, 25), 0);
+
+  // a new gate restarts the attack from the current level
+  run(2, 4000, 1, 5);
+  run(2, 4000, 0, 10);
+  CHECK_CLOSE(run(2, 4000, 1, 1), 2000 - 800 + 400, 2);
+}
+
+// the frequency that is measured from the rising edges of a square wave
+static double frequency(uint16_t rate, uint16_t centihertz, double duration) {
+  modulationBegin(rate);
+  config(3, MOD_LFO, centihertz, 1000, WAVE_SQUARE);
+  long first = -1, last = -1, edges = 0;
+  uint16_t previous = modulationTick(3, 2048, 0);
+  for (long k = 1; k < duration * rate; k++) {
+    uint16_t value = modulationTick(3, 2048, 0);
+    if (value > previous) {
+      if (first < 0)
+        first = k;
+      last = k;
+      edges++;
+    }
+    previous = value;
+  }
+  return (edges > 1 ? (double)(edges - 1) * rate / (last - first) : 0);
+}
+
+static void testLFO() {
+  // the frequency is accurate at all update rates, including the lowest frequencies
+  static const uint16_t rate[] = {1000, 2000, 4000};
+  for (int i = 0; i < 3; i++) {
+    CHECK_CLOSE(frequency(rate[i], 1337, 10), 13.37, 13.37 * 1e-3);
+    CHECK_CLOSE(frequency(rate[i], 100, 10), 1.00, 1e-3);
+    CHECK_CLOSE(frequency(rate[i], 10, 30), 0.10, 1e-4);
+  }
+  CHECK_CLOSE(frequency(1000, 1, 300), 0.01, 1e-5);
+
+  // the triangle starts at the bottom and oscillates around the target with the given depth
+  modulationBegin(1000);
+  config(4, MOD_LFO, 100, 1000, WAVE_TRIANGLE);
+  CHECK_CLOSE(modulationTick(4, 2048, 0), 1048, 5);
+  CHECK_CLOSE(run(4, 2048, 0, 250), 2048, 5);
+  CHECK_CLOSE(run(4, 2048, 0, 250), 3048, 5);
+  CHECK_CLOSE(run(4, 2048, 0, 250), 2048, 5);
+  CHECK_CLOSE(run(4, 2048, 0, 250), 1048, 5);
+
+  // the sawtooth rises during the whole period
+  config(5, MOD_LFO, 100, 1000, WAVE_SAWTOOTH);
+  CHECK_CLOSE(run(5, 2048, 0, 500), 2048, 5);
+  CHECK_CLOSE(run(5, 2048, 0, 499), 3048, 5);
+
+  // the output is limited to 12 bits
+  config(6, MOD_LFO, 100, 1000, WAVE_SQUARE);
+  CHECK_EQUAL(run(6, 4000, 0, 100), 4095);
+  CHECK_EQUAL(run(6, 500, 0, 600), 0);
+}
+
+static void benchmark() {
+  // the time that one update takes on this computer, only as a relative measure between the modes
+  static const char *name[] = {"none", "linear", "exponential", "ADSR", "LFO"};
+  const unsigned long repeat = 4000000;
+  modulationBegin(4000);
+  for (uint8_t mode = MOD_NONE; mode <= MOD_LFO; mode++) {
+    config(7, mode, 100, 100, 2048, 100);
+    clock_t start = clock();
+    unsigned long sum = 0;
+    for (unsigned long k = 0; k < repeat; k++)
+      sum += modulationTick(7, (k & 0x1000 ? 4000 : 100), (k >> 12) & 1);
+    printf("%-12s %.1f ns per channel per update on this computer (%lu)\n", name[mode], 1e9 * (clock() - start) / CLOCKS_PER_SEC / repeat, sum & 1);
+  }
+}
+
+int main() {
+  testNone();
+  testLinear();
+  testExponential();
+  testADSR();
+  testLFO();
+  benchmark();
+  return report("test_modulation");
+}
@@ -0,0 +1,167 @@
+// Host test of the output engine, with an SPI mock that records the transfers, the
+// chip selects, the LDAC latch and the gates in the order in which they happen
+
+#include "check.h"
+#include "output.h"
+#include "modulation.h"
+#include <SPI.h>
+
+std::vector<MockAction> mockLog;
+uint8_t mockPin[20];
+uint8_t SREG, TCCR1A, TCCR1B, TIMSK1;
+uint16_t TCNT1, OCR1A;
+MockSPI SPI;
+
+#define LDAC 4
+#define NUMCHANNEL 4
+
+static const uint8_t cspin[NUMCHANNEL]   = {2, 2, 3, 3};
+static const uint8_t gatepin[NUMCHANNEL] = {A0, A1, A2, A3};
+
+// a transaction is a chip select, the transfers and the release of the chip select
+struct Transaction {
+  uint8_t pin;
+  uint8_t high, low;
+};
+
+struct Update {
+  std::vector<Transaction> transaction;
+  int latches;          // the number of LDAC pulses
+  int latchedBefore;    // the number of transactions before the first LDAC pulse
+  std::vector<MockAction> gate;
+  bool gateBeforeLatch;
+};
+
+// run one update of the timer interrupt and decode what happened on the pins
+static Update tick() {
+  Update u = {};
+  mockLog.clear();
+  TIMER1_COMPA_vect();
+
+  for (size_t i = 0; i < mockLog.size(); i++) {
+    const MockAction &a = mockLog[i];
+    if (a.type == 'p' && a.pin == LDAC && a.value == LOW) {
+      if (u.latches++ == 0)
+        u.latchedBefore = u.transaction.size();
+      CHECK(i + 1 < mockLog.size() && mockLog[i + 1].pin == LDAC && mockLog[i + 1].value == HIGH);
+      i++;
+    }
+    else if (a.type == 'p' && (a.pin == cspin[0] || a.pin == cspin[2]) && a.value == LOW) {
+      // the chip select should be followed by two bytes and its release
+      CHECK(i + 3 < mockLog.size());
+      if (i + 3 >= mockLog.size())
+        break;
+      CHECK(mockLog[i + 1].type == 's' && mockLog[i + 2].type == 's');
+      CHECK(mockLog[i + 3].type == 'p' && mockLog[i + 3].pin == a.pin && mockLog[i + 3].value == HIGH);
+      Transaction t = {a.pin, mockLog[i + 1].value, mockLog[i + 2].value};
+      u.transaction.push_back(t);
+      i += 3;
+    }
+    else if (a.type == 'p') {
+      if (u.latches == 0 && !u.transaction.empty())
+        u.gateBeforeLatch = true;
+      u.gate.push_back(a);
+    }
+    else {
+      printf("SPI transfer without chip select\n");
+      failures++;
+    }
+  }
+  return u;
+}
+
+// the command for channel A or B of the MCP4822, with a gain of 2 and the output enabled
+static uint8_t command(uint8_t channel, uint16_t value) {
+  return (channel << 7) | (1 << 4) | (value >> 8);
+}
+
+static void testBegin() {
+  outputBegin(cspin, gatepin, LDAC, NUMCHANNEL);
+  CHECK_EQUAL(OCR1A, 1999);   // 1 kHz from 16 MHz with a prescaler of 8
+  CHECK_EQUAL(TCCR1B, (1 << WGM12) | (1 << CS11));
+  CHECK_EQUAL(TIMSK1, (1 << OCIE1A));
+  CHECK_EQUAL(SPI.divider, SPI_CLOCK_DIV2);
+  CHECK_EQUAL(mockPin[LDAC], HIGH);
+  CHECK_EQUAL(mockPin[cspin[0]], HIGH);
+
+  // all channels are written at the first update and latched at once
+  Update u = tick();
+  CHECK_EQUAL(u.transaction.size(), NUMCHANNEL);
+  CHECK_EQUAL(u.latches, 1);
+  CHECK_EQUAL(u.latchedBefore, NUMCHANNEL);
+  for (int i = 0; i < NUMCHANNEL; i++) {
+    CHECK_EQUAL(u.transaction[i].pin, cspin[i]);
+    CHECK_EQUAL(u.transaction[i].high, command(i % 2, 0));
+    CHECK_EQUAL(u.transaction[i].low, 0);
+  }
+  CHECK_EQUAL(outputLatches(), 1);
+
+  // nothing changed, hence the SPI bus stays idle
+  u = tick();
+  CHECK_EQUAL(u.transaction.size(), 0);
+  CHECK_EQUAL(u.latches, 0);
+  CHECK_EQUAL(outputLatches(), 1);
+}
+
+static void testChanged() {
+  // only the changed channels are written, both are latched at the same moment
+  outputVoltage(1, 1000);
+  outputVoltage(3, 5000);
+  Update u = tick();
+  CHECK_EQUAL(u.transaction.size(), 2);
+  CHECK_EQUAL(u.latches, 1);
+  CHECK_EQUAL(u.latchedBefore, 2);
+  CHECK_EQUAL(u.transaction[0].pin, cspin[1]);
+  CHECK_EQUAL(u.transaction[0].high, command(1, 1000));
+  CHECK_EQUAL(u.transaction[0].low, 1000 & 0xFF);
+  CHECK_EQUAL(u.transaction[1].pin, cspin[3]);
+  CHECK_EQUAL(u.transaction[1].high, command(1, 4095));   // the value is clamped to 12 bits
+  CHECK_EQUAL(u.transaction[1].low, 0xFF);
+
+  // writing the same value again does not cause a transfer
+  outputVoltage(1, 1000);
+  u = tick();
+  CHECK_EQUAL(u.transaction.size(), 0);
+
+  // channels that do not exist are ignored
+  outputVoltage(NUMCHANNEL, 100);
+  outputGate(NUMCHANNEL, 1);
+  u = tick();
+  CHECK_EQUAL(u.transaction.size(), 0);
+  CHECK_EQUAL(u.gate.size(), 0);
+  CHECK_EQUAL(outputLatches(), 2);
+}
+
+static void testGates() {
+  // a gate without a voltage change does not latch the DACs
+  outputGate(2, 1);
+  Update u = tick();
+  CHECK_EQUAL(u.latches, 0);
+  CHECK_EQUAL(u.gate.size(), 1);
+  CHECK_EQUAL(u.gate[0].pin, gatepin[2]);
+  CHECK_EQUAL(u.gate[0].value, HIGH);
+
+  // the gates follow the latch of the voltages in the same update
+  outputVoltage(0, 2048);
+  outputGate(0, 1);
+  outputGate(2, 0);
+  u = tick();
+  CHECK_EQUAL(u.transaction.size(), 1);
+  CHECK_EQUAL(u.latches, 1);
+  CHECK(!u.gateBeforeLatch);
+  CHECK_EQUAL(u.gate.size(), 2);
+  CHECK_EQUAL(mockPin[gatepin[0]], HIGH);
+  CHECK_EQUAL(mockPin[gatepin[2]], LOW);
+
+  // setting a gate to its current value does nothing
+  outputGate(0, 1);
+  u = tick();
+  CHECK_EQUAL(u.gate.size(), 0);
+}
+
+int main() {
+  testBegin();
+  testChanged();
+  testGates();
+  return report("test_output");
+}
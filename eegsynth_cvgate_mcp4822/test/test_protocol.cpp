@@ -0,0 +1,209 @@
+// Host test of the serial protocol parser, with a comparison of the ASCII and binary throughput
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "protocol.h"
+
+static parser_t parser;
+static command_t command;
+
+// feed the bytes to the parser and return the result of the last one
+static int feed(const uint8_t *buf, unsigned int len) {
+  int result = PARSE_BUSY;
+  for (unsigned int i = 0; i < len; i++) {
+    result = protocolParse(&parser, buf[i], &command);
+    if (result != PARSE_BUSY && i + 1 < len) {
+      printf("the parser returned %d before the end of the input\n", result);
+      failures++;
+    }
+  }
+  return result;
+}
+
+static int feed(const char *str) {
+  return feed((const uint8_t *)str, strlen(str));
+}
+
+static void testCRC() {
+  // the check value of CRC-8 with polynomial 0x07 and without reflection
+  uint8_t crc = 0;
+  for (const char *p = "123456789"; *p; p++)
+    crc = protocolCRC(crc, *p);
+  CHECK_EQUAL(crc, 0xF4);
+}
+
+static void testASCII() {
+  protocolReset(&parser);
+  CHECK_EQUAL(feed("*c1v1024#"), PARSE_ASCII);
+  CHECK_EQUAL(command.type, FRAME_SET);
+  CHECK_EQUAL(command.cvmask, 0x01);
+  CHECK_EQUAL(command.gatemask, 0);
+  CHECK_EQUAL(command.cv[0], 1024);
+
+  CHECK_EQUAL(feed("*g8v1#"), PARSE_ASCII);
+  CHECK_EQUAL(command.cvmask, 0);
+  CHECK_EQUAL(command.gatemask, 0x80);
+  CHECK_EQUAL(command.gates, 0x80);
+  CHECK_EQUAL(feed("*g3v0#"), PARSE_ASCII);
+  CHECK_EQUAL(command.gatemask, 0x04);
+  CHECK_EQUAL(command.gates, 0);
+
+  // values beyond 12 bits are clamped
+  CHECK_EQUAL(feed("*c2v5000#"), PARSE_ASCII);
+  CHECK_EQUAL(command.cv[1], PROTOCOL_MAXVALUE);
+
+  // malformed commands are answered with an error, after which the next command is parsed again
+  CHECK_EQUAL(feed("*c9v1#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*c0v1#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*x1v1#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*c1v#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*c1v12a#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*c1v99999#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*g1v10#"), PARSE_ERROR);
+  CHECK_EQUAL(feed("*c1v12345678"), PARSE_ERROR);  // too long, the parser does not wait for the '#'
+  CHECK_EQUAL(feed("#\r\n*c3v7#"), PARSE_ASCII);
+  CHECK_EQUAL(command.cv[2], 7);
+}
+
+static void testFrame() {
+  uint8_t payload[PROTOCOL_MAXPAYLOAD], buf[PROTOCOL_MAXPAYLOAD + 4];
+  uint16_t cv[PROTOCOL_CHANNELS];
+  srand(1);
+
+  // every combination of channels is packed and parsed again
+  protocolReset(&parser);
+  for (unsigned int cvmask = 0; cvmask < 256; cvmask++) {
+    for (int i = 0; i < PROTOCOL_CHANNELS; i++)
+      cv[i] = rand() % 4096;
+    uint8_t gatemask = rand() & 0xFF, gates = rand() & 0xFF;
+    uint8_t length = protocolPack(payload, cvmask, gatemask, gates, cv);
+    uint8_t n = 0;
+    for (unsigned int m = cvmask; m; m >>= 1)
+      n += m & 1;
+    CHECK_EQUAL(length, 3 + (3 * n + 1) / 2);
+
+    uint8_t total = protocolFrame(buf, FRAME_SET | (cvmask & 1 ? FRAME_ACKREQUEST : 0), payload, length);
+    CHECK_EQUAL(total, length + 4);
+    CHECK_EQUAL(feed(buf, total), PARSE_FRAME);
+    CHECK_EQUAL(command.type, FRAME_SET);
+    CHECK_EQUAL(command.ack, cvmask & 1);
+    CHECK_EQUAL(command.cvmask, cvmask);
+    CHECK_EQUAL(command.gatemask, gatemask);
+    CHECK_EQUAL(command.gates, gates & gatemask);
+    for (int i = 0; i < PROTOCOL_CHANNELS; i++)
+      CHECK_EQUAL(command.cv[i], (cvmask & (1 << i)) ? cv[i] : 0);
+  }
+
+  // all 8 control voltages and 8 gates fit in 19 bytes
+  CHECK_EQUAL(protocolFrame(buf, FRAME_SET, payload, protocolPack(payload, 0xFF, 0xFF, 0, cv)), 19);
+}
+
+static void testInvalid() {
+  uint8_t payload[PROTOCOL_MAXPAYLOAD], buf[PROTOCOL_MAXPAYLOAD + 4];
+  uint16_t cv[PROTOCOL_CHANNELS] = {1, 2, 3, 4, 5, 6, 7, 8};
+  uint8_t length = protocolPack(payload, 0x0F, 0x0F, 0x05, cv);
+  uint8_t total = protocolFrame(buf, FRAME_SET, payload, length);
+  protocolReset(&parser);
+
+  // every single bit error is detected by the CRC
+  for (unsigned int i = 1; i < total; i++) {
+    for (unsigned int bit = 0; bit < 8; bit++) {
+      uint8_t corrupt[sizeof(buf)];
+      memcpy(corrupt, buf, total);
+      corrupt[i] ^= (1 << bit);
+      int result = PARSE_BUSY;
+      for (unsigned int k = 0; k < total && result == PARSE_BUSY; k++)
+        result = protocolParse(&parser, corrupt[k], &command);
+      CHECK(result != PARSE_FRAME || memcmp(corrupt, buf, total) == 0);
+      protocolReset(&parser);
+    }
+  }
+
+  // a length beyond the buffer is rejected immediately, after which the parser synchronizes again
+  uint8_t toolong[] = {PROTOCOL_SYNC, FRAME_SET, PROTOCOL_MAXPAYLOAD + 1};
+  CHECK_EQUAL(feed(toolong, sizeof(toolong)), PARSE_INVALID);
+  CHECK_EQUAL(feed(buf, total), PARSE_FRAME);
+  CHECK_EQUAL(command.cv[3], 4);
+
+  // a payload with a length that does not match the channel mask is rejected
+  payload[0] = 0xFF;
+  total = protocolFrame(buf, FRAME_SET, payload, length);
+  CHECK_EQUAL(feed(buf, total), PARSE_INVALID);
+
+  // garbage between frames and ASCII commands is skipped
+  CHECK_EQUAL(feed("\x01\x02garbage*c1v5#"), PARSE_ASCII);
+  CHECK_EQUAL(command.cv[0], 5);
+}
+
+static void testEvent() {
+  uint8_t payload[PROTOCOL_MAXPAYLOAD], buf[PROTOCOL_MAXPAYLOAD + 4];
+  uint16_t cv[PROTOCOL_CHANNELS] = {0, 4095};
+  protocolReset(&parser);
+
+  // an event is a timestamp followed by the payload of a FRAME_SET
+  uint32_t time = 0x89ABCDEF;
+  for (int k = 0; k < 4; k++)
+    payload[k] = (time >> (8 * k)) & 0xFF;
+  uint8_t length = 4 + protocolPack(payload + 4, 0x02, 0x01, 0x01, cv);
+  CHECK_EQUAL(feed(buf, protocolFrame(buf, FRAME_EVENT, payload, length)), PARSE_FRAME);
+  CHECK_EQUAL(command.type, FRAME_EVENT);
+  CHECK_EQUAL(command.time, time);
+  CHECK_EQUAL(command.cvmask, 0x02);
+  CHECK_EQUAL(command.cv[1], 4095);
+  CHECK_EQUAL(command.gates, 0x01);
+
+  CHECK_EQUAL(feed(buf, protocolFrame(buf, FRAME_SYNC, payload, 4)), PARSE_FRAME);
+  CHECK_EQUAL(command.type, FRAME_SYNC);
+  CHECK_EQUAL(command.time, time);
+  CHECK_EQUAL(feed(buf, protocolFrame(buf, FRAME_SYNC, payload, 3)), PARSE_INVALID);
+
+  // other frame types are passed on with their raw payload
+  uint8_t modulation[10] = {0x03, 1, 100, 0};
+  CHECK_EQUAL(feed(buf, protocolFrame(buf, FRAME_MODULATION | FRAME_ACKREQUEST, modulation, sizeof(modulation))), PARSE_FRAME);
+  CHECK_EQUAL(command.type, FRAME_MODULATION);
+  CHECK_EQUAL(command.ack, 1);
+  CHECK_EQUAL(command.length, sizeof(modulation));
+  CHECK_EQUAL(command.payload[2], 100);
+
+  // the acknowledgement is a frame itself
+  uint8_t ack[6];
+  CHECK_EQUAL(protocolAck(ack, FRAME_MODULATION, STATUS_ERROR), 6);
+  CHECK_EQUAL(feed(ack, 6), PARSE_FRAME);
+  CHECK_EQUAL(command.type, FRAME_ACK);
+  CHECK_EQUAL(command.payload[0], FRAME_MODULATION);
+  CHECK_EQUAL(command.payload[1], STATUS_ERROR);
+}
+
+static void benchmark() {
+  // the number of bytes on the serial connection for an update of all 8 control voltages and 8 gates
+  uint8_t payload[PROTOCOL_MAXPAYLOAD], buf[PROTOCOL_MAXPAYLOAD + 4];
+  uint16_t cv[PROTOCOL_CHANNELS] = {4095, 4095, 4095, 4095, 4095, 4095, 4095, 4095};
+  unsigned int binary = protocolFrame(buf, FRAME_SET, payload, protocolPack(payload, 0xFF, 0xFF, 0xFF, cv));
+  unsigned int ascii = 8 * strlen("*c1v4095#") + 8 * strlen("*g1v1#");
+  unsigned int reply = 16 * strlen("ok\r\n");
+  printf("update of 16 channels: %u bytes binary, %u + %u bytes ASCII with replies\n", binary, ascii, reply);
+  printf("updates per second at 115200 baud: %u binary, %u ASCII\n", 11520 / binary, 11520 / (ascii > reply ? ascii : reply));
+  CHECK(binary * 5 < ascii);
+
+  // the time that the parser takes on this computer, only as a relative measure
+  const unsigned int repeat = 100000;
+  clock_t start = clock();
+  unsigned int frames = 0;
+  for (unsigned int k = 0; k < repeat; k++)
+    for (unsigned int i = 0; i < binary; i++)
+      frames += (protocolParse(&parser, buf[i], &command) == PARSE_FRAME);
+  CHECK_EQUAL(frames, repeat);
+  printf("parsing takes %.1f ns per byte on this computer\n", 1e9 * (clock() - start) / CLOCKS_PER_SEC / (repeat * binary));
+}
+
+int main() {
+  testCRC();
+  testASCII();
+  testFrame();
+  testInvalid();
+  testEvent();
+  benchmark();
+  return report("test_protocol");
+}
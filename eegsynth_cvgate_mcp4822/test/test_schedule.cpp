@@ -0,0 +1,172 @@
+// Host simulation of scheduled events over a serial connection with a random delay
+//
+// The host sends a gate event every 50 ms, stamped with a moment that is a fixed
+// time ahead of its own clock. The serial connection delays each message by 1 to
+// 10 ms. The moments at which the gate changes on the device should be exactly
+// 50 ms apart, whereas events that are applied upon arrival show the jitter of
+// the connection.
+
+#include <stdlib.h>
+#include <map>
+#include "check.h"
+#include "output.h"
+#include <SPI.h>
+
+std::vector<MockAction> mockLog;
+uint8_t mockPin[20];
+uint8_t SREG, TCCR1A, TCCR1B, TIMSK1;
+uint16_t TCNT1, OCR1A;
+MockSPI SPI;
+
+#define NUMCHANNEL 4
+#define INTERVAL   50         // in ms, between the events
+#define HOSTCLOCK  1234567    // in ms, the host clock is ahead of the device clock
+
+static const uint8_t cspin[NUMCHANNEL]   = {2, 2, 3, 3};
+static const uint8_t gatepin[NUMCHANNEL] = {A0, A1, A2, A3};
+
+static uint32_t device = 0;          // in ms, the device clock that is simulated
+static uint32_t start = 0;           // in ms of the device clock, when the simulation started
+static int32_t offset = 0;           // in ms, between the host and the device clock, like the sketch
+static std::vector<uint32_t> change; // in ms of the device clock, when the first gate changed
+
+// one update of the outputs, after which the changes of the first gate are recorded
+static void tick() {
+  mockLog.clear();
+  TIMER1_COMPA_vect();
+  device++;
+  for (const MockAction &a : mockLog)
+    if (a.type == 'p' && a.pin == gatepin[0])
+      change.push_back(device);
+}
+
+static void begin() {
+  outputBegin(cspin, gatepin, 4, NUMCHANNEL);
+  device = outputTime();
+  change.clear();
+  tick();
+}
+
+// the messages that are on their way, sorted by the device time at which they arrive
+typedef std::multimap<uint32_t, uint32_t> link_t;
+
+// simulate the given number of gate events that are sent lead ms ahead of their moment
+static void simulate(unsigned int events, uint32_t lead, bool scheduled) {
+  link_t link;
+  uint32_t host = device + HOSTCLOCK;
+  start = device;
+
+  // the clocks are synchronized once, the delay of the sync message causes a constant shift
+  offset = outputTime() + 5 - host;
+  for (int k = 0; k < 5; k++)
+    tick();
+
+  for (unsigned int k = 0; k < events; k++) {
+    uint32_t moment = host + 100 + k * INTERVAL;  // in ms of the host clock
+    uint32_t sent = moment - lead - HOSTCLOCK;    // in ms of the device clock
+    link.insert(std::make_pair(sent + 1 + rand() % 10, moment));
+  }
+
+  while (!link.empty()) {
+    // the main loop handles the messages that arrived since the previous update
+    while (!link.empty() && link.begin()->first <= device) {
+      uint32_t moment = link.begin()->second;
+      uint8_t value = ((moment - host - 100) / INTERVAL) % 2 == 0;
+      if (scheduled) {
+        event_t e = {};
+        e.time = moment + offset;
+        e.gatemask = 0x01;
+        e.gates = value;
+        CHECK(outputSchedule(&e));
+      }
+      else {
+        outputGate(0, value);
+      }
+      link.erase(link.begin());
+    }
+    tick();
+  }
+  for (int k = 0; k < 2 * INTERVAL; k++)
+    tick();
+}
+
+// the difference between the longest and the shortest interval between the gate changes
+static uint32_t jitter() {
+  uint32_t shortest = 0xFFFFFFFF, longest = 0;
+  for (size_t i = 1; i < change.size(); i++) {
+    uint32_t interval = change[i] - change[i - 1];
+    shortest = (interval < shortest ? interval : shortest);
+    longest = (interval > longest ? interval : longest);
+  }
+  return longest - shortest;
+}
+
+static void testJitter() {
+  // applied upon arrival, the jitter of the connection shows up in the output
+  begin();
+  simulate(200, 20, false);
+  CHECK_EQUAL(change.size(), 200);
+  printf("jitter when applied upon arrival: %u ms\n", jitter());
+  CHECK(jitter() >= 5);
+
+  // scheduled ahead of the delay, the output jitter is bounded by the update period of 1 ms
+  begin();
+  uint16_t late = outputLate();
+  simulate(200, 20, true);
+  CHECK_EQUAL(change.size(), 200);
+  printf("jitter when scheduled: %u ms\n", jitter());
+  CHECK(jitter() <= 1000 / OUTPUT_RATE);
+  CHECK_EQUAL(outputLate(), late);
+
+  // the gate changes at the scheduled moment, including the constant shift of the synchronization
+  CHECK_EQUAL(change[0] - start, 100 + 5);
+}
+
+static void testLate() {
+  // events that are sent too late are counted and applied at the next update
+  begin();
+  srand(2);
+  uint16_t late = outputLate();
+  simulate(200, 5, true);
+  CHECK_EQUAL(change.size(), 200);
+  CHECK(outputLate() - late > 20);
+  CHECK(outputLate() - late < 150);
+  printf("%u of 200 events arrived late\n", outputLate() - late);
+}
+
+static void testQueue() {
+  begin();
+  uint16_t dropped = outputDropped();
+
+  // events that arrive out of order are applied in the order of their time
+  event_t e = {};
+  e.gatemask = 0x01;
+  for (int k = OUTPUT_NUMEVENTS - 1; k >= 0; k--) {
+    e.time = outputTime() + 10 + k;
+    e.gates = (k % 2 == 0);
+    CHECK(outputSchedule(&e));
+  }
+
+  // the queue is full
+  CHECK(!outputSchedule(&e));
+  CHECK_EQUAL(outputDropped(), dropped + 1);
+
+  start = device;
+  for (int k = 0; k < 100; k++)
+    tick();
+  CHECK_EQUAL(change.size(), OUTPUT_NUMEVENTS);
+  for (size_t i = 0; i < change.size(); i++)
+    CHECK_EQUAL(change[i], start + 10 + i);
+  CHECK_EQUAL(mockPin[gatepin[0]], (OUTPUT_NUMEVENTS - 1) % 2 == 0);
+
+  // the device clock is in ms
+  CHECK_EQUAL(outputTime(), device);
+}
+
+int main() {
+  srand(1);
+  testJitter();
+  testLate();
+  testQueue();
+  return report("test_schedule");
+}
@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include <string.h>
+#include "modulation.h"
+
+// the values are represented with 16 fractional bits
+#define ONE       (1UL << 16)
+#define FULLSCALE (4095UL << 16)
+#define ENVMAX    0x00FFFFFFUL
+
+// these are the stages of the envelope
+#define STAGE_IDLE    0
+#define STAGE_ATTACK  1
+#define STAGE_DECAY   2
+#define STAGE_SUSTAIN 3
+#define STAGE_RELEASE 4
+
+typedef struct {
+  uint8_t  mode;
+  uint8_t  stage;
+  uint8_t  gate;
+  uint8_t  waveform;
+  uint32_t value;       // the current output, with 16 fractional bits
+  uint32_t envelope;    // between 0 and ENVMAX
+  uint32_t step[3];     // the increment per update, depends on the mode
+  uint32_t level;       // the sustain level or the LFO depth
+  uint32_t phase;       // the LFO phase, only the upper 16 bits are used for the waveform
+} modulation_t;
+
+static modulation_t channel[MOD_MAXCHANNEL];
+static uint16_t rate = 1000;
+
+/***************************************************************************/
+
+static uint32_t ticks(uint16_t ms) {
+  // convert a duration in ms into the number of updates, which is at least one
+  uint32_t n = ((uint32_t)ms * rate) / 1000;
+  return (n ? n : 1);
+}
+
+static uint32_t multiply(uint32_t a, uint16_t k) {
+  // this multiplies a value with 16 fractional bits with a factor between 0 and 1 without overflow
+  return (a >> 16) * k + (((a & 0xFFFF) * k) >> 16);
+}
+
+static int32_t wave(uint8_t waveform, uint16_t phase) {
+  // this returns a value between -32768 and 32767
+  switch (waveform) {
+    case WAVE_SAWTOOTH:
+      return (int32_t)phase - 32768;
+    case WAVE_SQUARE:
+      return (phase < 32768 ? 32767 : -32768);
+    default:
+      return (phase < 32768 ? (int32_t)phase * 2 - 32768 : 32767 - ((int32_t)phase - 32768) * 2);
+  }
+}
+
+/***************************************************************************/
+
+void modulationBegin(uint16_t r) {
+  rate = r;
+  memset(channel, 0, sizeof(channel));
+}
+
+bool modulationConfig(uint8_t i, uint8_t mode, const uint16_t *param) {
+  uint32_t step[3] = {0, 0, 0}, level = 0;
+  if (i >= MOD_MAXCHANNEL)
+    return false;
+
+  // the divisions are done first, the interrupts are only disabled while the result is copied
+  switch (mode) {
+    case MOD_NONE:
+      break;
+    case MOD_LINEAR:
+      step[0] = FULLSCALE / ticks(param[0]);
+      break;
+    case MOD_EXPONENTIAL:
+      // the fraction of the remaining difference that is covered in each update
+      step[0] = 65535UL / ticks(param[0]);
+      step[0] = (step[0] ? step[0] : 1);
+      break;
+    case MOD_ADSR:
+      level   = ((uint32_t)(param[2] > 4095 ? 4095 : param[2]) * (ENVMAX >> 12));
+      step[0] = ENVMAX / ticks(param[0]);
+      step[1] = (ENVMAX - level) / ticks(param[1]);
+      step[2] = ENVMAX / ticks(param[3]);
+      break;
+    case MOD_LFO:
+      // the phase increment per update, the phase wraps around at 2^32 for a resolution of about 0.25 uHz
+      step[0] = ((uint64_t)param[0] << 32) / (100UL * rate);
+      level   = (param[1] > 4095 ? 4095 : param[1]);
+      break;
+    default:
+      return false;
+  }
+
+  modulation_t *m = &channel[i];
+  noInterrupts();
+  memcpy(m->step, step, sizeof(step));
+  m->level = level;
+  m->waveform = param[2];
+  if (mode != m->mode) {
+    m->stage = STAGE_IDLE;
+    m->envelope = 0;
+    m->phase = 0;
+  }
+  m->mode = mode;
+  interrupts();
+  return true;
+}
+
+uint16_t modulationTick(uint8_t i, uint16_t target, uint8_t gate) {
+  modulation_t *m = &channel[i];
+  uint32_t goal = (uint32_t)target << 16;
+
+  switch (m->mode) {
+
+    case MOD_LINEAR:
+      if (m->value + m->step[0] < goal)
+        m->value += m->step[0];
+      else if (m->value > goal + m->step[0])
+        m->value -= m->step[0];
+      else
+        m->value = goal;
+      break;
+
+    case MOD_EXPONENTIAL: {
+        uint32_t delta = (goal > m->value ? goal - m->value : m->value - goal);
+        uint32_t step = multiply(delta, m->step[0]);
+        if (step == 0 || delta < ONE / 16)
+          m->value = goal;
+        else if (goal > m->value)
+          m->value += step;
+        else
+          m->value -= step;
+        break;
+      }
+
+    case MOD_ADSR:
+      if (gate && !m->gate)
+        m->stage = STAGE_ATTACK;
+      else if (!gate && m->gate)
+        m->stage = STAGE_RELEASE;
+      m->gate = gate;
+
+      switch (m->stage) {
+        case STAGE_ATTACK:
+          if (m->envelope + m->step[0] < ENVMAX) {
+            m->envelope += m->step[0];
+          }
+          else {
+            m->envelope = ENVMAX;
+            m->stage = STAGE_DECAY;
+          }
+          break;
+        case STAGE_DECAY:
+          if (m->envelope > m->level + m->step[1]) {
+            m->envelope -= m->step[1];
+          }
+          else {
+            m->envelope = m->level;
+            m->stage = STAGE_SUSTAIN;
+          }
+          break;
+        case STAGE_RELEASE:
+          if (m->envelope > m->step[2]) {
+            m->envelope -= m->step[2];
+          }
+          else {
+            m->envelope = 0;
+            m->stage = STAGE_IDLE;
+          }
+          break;
+      }
+      // the envelope scales the target value
+      m->value = (uint32_t)target * (m->envelope >> 8);
+      break;
+
+    case MOD_LFO: {
+        m->phase += m->step[0];
+        int32_t value = (int32_t)target + ((int32_t)m->level * wave(m->waveform, m->phase >> 16)) / 32768;
+        value = (value < 0 ? 0 : (value > 4095 ? 4095 : value));
+        m->value = (uint32_t)value << 16;
+        break;
+      }
+
+    default:
+      m->value = goal;
+  }
+
+  return (m->value + ONE / 2) >> 16;
+}
@@ -0,0 +1,43 @@
+#ifndef _OUTPUT_H_
+#define _OUTPUT_H_
+
+#include <Arduino.h>
+
+/*
+  This drives the control voltages of a number of MCP4822 dual 12-bit DACs and the
+  corresponding gates. The outputs are updated from the Timer1 interrupt at a fixed
+  rate. Only the channels that changed are written to the input registers of the DACs,
+  after which all DACs are latched at the same moment by pulsing their shared LDAC pin
+  low. The gates are updated right after the latch.
+
+  The requested voltage is passed through the modulation of each channel before it is
+  written, see modulation.h
+
+  Events can be scheduled for a moment in the future. They are applied in the timer
+  interrupt at the update that corresponds to their time, so that the jitter of the
+  serial connection does not affect the timing of the outputs. Time is expressed in ms
+  since the start of the device, OUTPUT_RATE should therefore be a multiple of 1000.
+*/
+
+#define OUTPUT_RATE       1000    // in Hz
+#define OUTPUT_MAXCHANNEL 8
+#define OUTPUT_NUMEVENTS  16
+
+typedef struct {
+  uint32_t time;        // in ms of the device clock
+  uint8_t  cvmask;
+  uint8_t  gatemask;
+  uint8_t  gates;
+  uint16_t cv[OUTPUT_MAXCHANNEL];
+} event_t;
+
+void outputBegin(const uint8_t *, const uint8_t *, uint8_t, uint8_t);
+void outputVoltage(uint8_t, uint16_t);
+void outputGate(uint8_t, uint8_t);
+unsigned long outputLatches(void);
+bool outputSchedule(const event_t *);
+uint32_t outputTime(void);
+uint16_t outputLate(void);
+uint16_t outputDropped(void);
+
+#endif // _OUTPUT_H_
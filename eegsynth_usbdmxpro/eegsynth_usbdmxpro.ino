@@ -2,9 +2,14 @@
    The purpose of this sketch is to implement a module that converts from USB to DMX512.
    This allows to use computer software to control stage lighting lamps
 
-   This sketch is partially compatible with the Enttec DMX USB Pro module, but the startup
-   sequence of this Arduino sketch is different and other/commercial software is likely not
-   to recognize the module as DMX USB Pro .
+   This sketch implements the Enttec DMX USB Pro protocol to the extent that is needed
+   by common software. Each message is collected completely and its length and end code
+   are checked before it is used. The channel values of a valid DMX message are copied
+   in one go to the output buffer, so that the output never contains a mix of an old and
+   a new message. Widget parameter and serial number requests are answered.
+
+   In addition to the standard labels, there is a non-standard label 100 that returns
+   the message and error counters, each as a 16-bit LSB-first number.
 
    Components
    - Arduino Nano or compatible 5V board, e.g. http://ebay.to/2iAeUON
@@ -42,56 +47,183 @@
 #define DMX_PRO_GET_SERIAL_NUMBER     10
 #define DMX_PRO_SENT_DRM_DISCOVERY    11
 
+// this is not part of the Enttec specification
+#define DMX_PRO_GET_STATISTICS        100
+
 // each DMX data packet starts with this code
 #define DMX_PRO_START_CODE            0
 
-// these are some local states
-#define DMX_PRO_SEND_DMX_LSB          240
-#define DMX_PRO_SEND_DMX_MSB          241
-#define DMX_PRO_SEND_DMX_DATA         242
+// these are the states of the receiver
+#define STATE_START                   0
+#define STATE_LABEL                   1
+#define STATE_LENGTH_LSB              2
+#define STATE_LENGTH_MSB              3
+#define STATE_DATA                    4
+#define STATE_END                     5
+
+#define DMX_SIZE                      512
+#define MESSAGE_SIZE                  (DMX_SIZE + 1)  // the start code plus all channels
+#define MESSAGE_TIMEOUT               50              // in milliseconds, since the last byte
+
+#define FIRMWARE_VERSION              0x0144          // the version that common software expects
+#define SERIAL_NUMBER                 0x12345678      // as binary coded decimal
+
+// this is declared in DmxSimple.cpp and is sent by its timer interrupt
+extern volatile uint8_t dmxBuffer[DMX_SIZE];
+
+// the message that is being received
+byte state = STATE_START;
+byte label;
+unsigned int messageSize, received;
+byte message[MESSAGE_SIZE];
+unsigned long lastByte = 0;
+
+// the widget parameters, these are stored but not used by DmxSimple
+byte breakTime = 9, mabTime = 1, refreshRate = 40;
+
+// the message and error counters
+struct {
+  unsigned int messages;
+  unsigned int frames;
+  unsigned int garbage;
+  unsigned int overflow;
+  unsigned int endCode;
+  unsigned int startCode;
+  unsigned int timeout;
+  unsigned int unknown;
+} counter;
+
+void sendMessage(byte label, const byte *data, unsigned int size) {
+  Serial.write(DMX_PRO_START_MSG);
+  Serial.write(label);
+  Serial.write(size & 0xff);
+  Serial.write((size >> 8) & 0xff);
+  Serial.write(data, size);
+  Serial.write(DMX_PRO_END_MSG);
+}
+
+void handleMessage() {
+  counter.messages++;
+
+  switch (label) {
+    case DMX_PRO_SEND_DMX: {
+        if (messageSize < 1 || message[0] != DMX_PRO_START_CODE) {
+          counter.startCode++;
+          break;
+        }
+        unsigned int channels = messageSize - 1;
+        // replace all channels at once, the timer interrupt of DmxSimple should not see a partial update
+        noInterrupts();
+        memcpy((void *)dmxBuffer, message + 1, channels);
+        interrupts();
+        if (channels > 0)
+          DmxSimple.maxChannel(channels);
+        counter.frames++;
+        break;
+      }
+
+    case DMX_PRO_GET_WIDGET_PARAM: {
+        // the user configuration is not supported, hence it is always returned empty
+        byte reply[5] = {FIRMWARE_VERSION & 0xff, (FIRMWARE_VERSION >> 8) & 0xff, breakTime, mabTime, refreshRate};
+        sendMessage(DMX_PRO_GET_WIDGET_PARAM, reply, sizeof(reply));
+        break;
+      }
+
+    case DMX_PRO_SET_WIDGET_PARAM: {
+        // the first two bytes are the size of the user configuration
+        if (messageSize >= 5) {
+          breakTime   = message[2];
+          mabTime     = message[3];
+          refreshRate = message[4];
+        }
+        break;
+      }
+
+    case DMX_PRO_GET_SERIAL_NUMBER: {
+        byte reply[4] = {SERIAL_NUMBER & 0xff, (SERIAL_NUMBER >> 8) & 0xff, (SERIAL_NUMBER >> 16) & 0xff, (SERIAL_NUMBER >> 24) & 0xff};
+        sendMessage(DMX_PRO_GET_SERIAL_NUMBER, reply, sizeof(reply));
+        break;
+      }
+
+    case DMX_PRO_GET_STATISTICS: {
+        sendMessage(DMX_PRO_GET_STATISTICS, (const byte *)&counter, sizeof(counter));
+        break;
+      }
 
-unsigned char state = DMX_PRO_END_MSG;
-unsigned int dataSize;
-unsigned int channel;
+    default:
+      counter.unknown++;
+  }
+}
 
 void setup() {
+  memset(&counter, 0, sizeof(counter));
   DmxSimple.usePin(DI_PIN);
+  DmxSimple.maxChannel(DMX_SIZE);
   Serial.begin(57600);
   while (!Serial);
 }
 
 void loop() {
-  while (!Serial.available())
-    yield();
+  // a message that stalls halfway is discarded, so that the next one is received correctly
+  if (state != STATE_START && (millis() - lastByte) > MESSAGE_TIMEOUT) {
+    counter.timeout++;
+    state = STATE_START;
+  }
 
-  unsigned char c = Serial.read();
+  if (!Serial.available())
+    return;
 
-  if (c == DMX_PRO_START_MSG && state != DMX_PRO_END_MSG) {
-    state = c; // this should not happen, it means that part of the previous packet was lost
-  }
-  if (c == DMX_PRO_START_MSG && state == DMX_PRO_END_MSG) {
-    state = c;
-  }
-  else if (c == DMX_PRO_SEND_DMX && state == DMX_PRO_START_MSG) {
-    state = c;
-  }
-  else if (state == DMX_PRO_SEND_DMX) {
-    dataSize = c & 0xff;
-    state = DMX_PRO_SEND_DMX_LSB;
-  }
-  else if (state == DMX_PRO_SEND_DMX_LSB) {
-    dataSize += (c << 8) & 0xff00;
-    state = DMX_PRO_SEND_DMX_MSB;
-  }
-  else if (state == DMX_PRO_SEND_DMX_MSB && c == DMX_PRO_START_CODE) {
-    state = DMX_PRO_SEND_DMX_DATA;
-    channel = 1;
-  }
-  else if (state == DMX_PRO_SEND_DMX_DATA && channel < dataSize) {
-    DmxSimple.write(channel, c);
-    channel++;
-  }
-  else if (state == DMX_PRO_SEND_DMX_DATA && channel == dataSize && c == DMX_PRO_END_MSG) {
-    state = c;
+  byte c = Serial.read();
+  lastByte = millis();
+
+  switch (state) {
+    case STATE_START:
+      if (c == DMX_PRO_START_MSG)
+        state = STATE_LABEL;
+      else
+        counter.garbage++;
+      break;
+
+    case STATE_LABEL:
+      label = c;
+      state = STATE_LENGTH_LSB;
+      break;
+
+    case STATE_LENGTH_LSB:
+      messageSize = c;
+      state = STATE_LENGTH_MSB;
+      break;
+
+    case STATE_LENGTH_MSB:
+      messageSize |= (c << 8);
+      received = 0;
+      if (messageSize > MESSAGE_SIZE) {
+        // the length is corrupt, waiting for that many bytes would swallow the next messages
+        counter.overflow++;
+        state = STATE_START;
+      }
+      else
+        state = (messageSize > 0 ? STATE_DATA : STATE_END);
+      break;
+
+    case STATE_DATA:
+      message[received++] = c;
+      if (received == messageSize)
+        state = STATE_END;
+      break;
+
+    case STATE_END:
+      if (c == DMX_PRO_START_MSG) {
+        // the end code is missing, but the next message starts here
+        counter.endCode++;
+        state = STATE_LABEL;
+        break;
+      }
+      else if (c != DMX_PRO_END_MSG)
+        counter.endCode++;
+      else
+        handleMessage();
+      state = STATE_START;
+      break;
   }
 }
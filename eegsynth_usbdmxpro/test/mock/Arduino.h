@@ -0,0 +1,45 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the Arduino core for the host tests, it only
+// provides what this sketch uses. The bytes that the test sends to the serial
+// port are read by the sketch, the bytes that the sketch writes are kept for
+// the test to inspect.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+typedef uint8_t byte;
+
+// the time is set by the test
+extern unsigned long mockMillis;
+
+inline unsigned long millis() { return mockMillis; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class MockSerial {
+  public:
+    std::deque<uint8_t> input;
+    std::vector<uint8_t> output;
+
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    int available() { return input.size(); }
+    int read() {
+      if (input.empty())
+        return -1;
+      uint8_t c = input.front();
+      input.pop_front();
+      return c;
+    }
+    size_t write(uint8_t c) { output.push_back(c); return 1; }
+    size_t write(const uint8_t *buf, size_t len) { output.insert(output.end(), buf, buf + len); return len; }
+};
+
+extern MockSerial Serial;
+
+#endif // _ARDUINO_H_
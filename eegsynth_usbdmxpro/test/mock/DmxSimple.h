@@ -0,0 +1,20 @@
+#ifndef _DMXSIMPLE_H_
+#define _DMXSIMPLE_H_
+
+// This replaces the DmxSimple library for the host tests. The channel values
+// are in dmxBuffer, which is defined by the test, just like the library does.
+
+#include <Arduino.h>
+
+class MockDmxSimple {
+  public:
+    int pin = -1;
+    int channels = 0;
+
+    void usePin(uint8_t p) { pin = p; }
+    void maxChannel(int n) { channels = n; }
+};
+
+extern MockDmxSimple DmxSimple;
+
+#endif // _DMXSIMPLE_H_
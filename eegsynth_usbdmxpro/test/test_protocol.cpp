@@ -0,0 +1,185 @@
+// Host test of the Enttec DMX USB Pro message parser
+//
+// The messages are fed byte by byte to the main loop of the sketch, like they
+// arrive over the serial port.
+
+#include "check.h"
+#include "../eegsynth_usbdmxpro.ino"
+
+unsigned long mockMillis = 0;
+MockSerial Serial;
+MockDmxSimple DmxSimple;
+volatile uint8_t dmxBuffer[DMX_SIZE];
+
+static void send(const std::vector<uint8_t> &bytes) {
+  Serial.input.insert(Serial.input.end(), bytes.begin(), bytes.end());
+  while (Serial.available())
+    loop();
+}
+
+static std::vector<uint8_t> packet(byte label, const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> bytes = {DMX_PRO_START_MSG, label, (uint8_t)(data.size() & 0xff), (uint8_t)(data.size() >> 8)};
+  bytes.insert(bytes.end(), data.begin(), data.end());
+  bytes.push_back(DMX_PRO_END_MSG);
+  return bytes;
+}
+
+static std::vector<uint8_t> frame(unsigned int channels, uint8_t value) {
+  std::vector<uint8_t> data(channels + 1, value);
+  data[0] = DMX_PRO_START_CODE;
+  return packet(DMX_PRO_SEND_DMX, data);
+}
+
+static void reset() {
+  setup();
+  state = STATE_START;
+  memset((void *)dmxBuffer, 0, sizeof(dmxBuffer));
+  Serial.output.clear();
+  mockMillis = 0;
+}
+
+static void testFrame() {
+  reset();
+  send(frame(DMX_SIZE, 42));
+  CHECK_EQUAL(counter.frames, 1);
+  CHECK_EQUAL(dmxBuffer[0], 42);
+  CHECK_EQUAL(dmxBuffer[DMX_SIZE - 1], 42);
+  CHECK_EQUAL(DmxSimple.channels, DMX_SIZE);
+
+  // a shorter frame only updates the first channels
+  send(frame(3, 7));
+  CHECK_EQUAL(counter.frames, 2);
+  CHECK_EQUAL(dmxBuffer[2], 7);
+  CHECK_EQUAL(dmxBuffer[3], 42);
+  CHECK_EQUAL(DmxSimple.channels, 3);
+
+  // a frame with another start code is not used
+  std::vector<uint8_t> bytes = frame(3, 9);
+  bytes[4] = 0xCC;
+  send(bytes);
+  CHECK_EQUAL(counter.frames, 2);
+  CHECK_EQUAL(counter.startCode, 1);
+  CHECK_EQUAL(dmxBuffer[0], 7);
+  CHECK_EQUAL(state, STATE_START);
+}
+
+static void testLength() {
+  // a corrupt length is rejected immediately, the data that follows is ignored and the next frame is accepted
+  reset();
+  send({DMX_PRO_START_MSG, DMX_PRO_SEND_DMX, 0xff, 0xff, 0, 1, 2, 3, DMX_PRO_END_MSG});
+  CHECK_EQUAL(counter.overflow, 1);
+  CHECK_EQUAL(counter.frames, 0);
+  CHECK_EQUAL(state, STATE_START);
+  send(frame(4, 99));
+  CHECK_EQUAL(counter.frames, 1);
+  CHECK_EQUAL(dmxBuffer[3], 99);
+
+  // one more byte than the largest frame is also too long
+  send({DMX_PRO_START_MSG, DMX_PRO_SEND_DMX, (MESSAGE_SIZE + 1) & 0xff, (MESSAGE_SIZE + 1) >> 8});
+  CHECK_EQUAL(counter.overflow, 2);
+  CHECK_EQUAL(state, STATE_START);
+}
+
+static void testEndCode() {
+  reset();
+
+  // the end code is replaced by another byte, the frame is not used
+  std::vector<uint8_t> bytes = frame(2, 5);
+  bytes.back() = 0x00;
+  send(bytes);
+  CHECK_EQUAL(counter.endCode, 1);
+  CHECK_EQUAL(counter.frames, 0);
+  CHECK_EQUAL(dmxBuffer[0], 0);
+
+  // the end code is missing and the next message follows immediately, that one is still received
+  bytes = frame(2, 5);
+  bytes.pop_back();
+  std::vector<uint8_t> next = frame(2, 6);
+  bytes.insert(bytes.end(), next.begin(), next.end());
+  send(bytes);
+  CHECK_EQUAL(counter.endCode, 2);
+  CHECK_EQUAL(counter.frames, 1);
+  CHECK_EQUAL(dmxBuffer[0], 6);
+}
+
+static void testTimeout() {
+  // a message that stalls halfway is discarded
+  reset();
+  std::vector<uint8_t> bytes = frame(10, 1);
+  bytes.resize(8);
+  send(bytes);
+  CHECK_EQUAL(state, STATE_DATA);
+  mockMillis += MESSAGE_TIMEOUT + 1;
+  loop();
+  CHECK_EQUAL(counter.timeout, 1);
+  CHECK_EQUAL(state, STATE_START);
+
+  // the next message is received completely, even when the bytes arrive slowly
+  bytes = frame(10, 2);
+  for (uint8_t c : bytes) {
+    mockMillis += MESSAGE_TIMEOUT / 2;
+    send({c});
+  }
+  CHECK_EQUAL(counter.timeout, 1);
+  CHECK_EQUAL(counter.frames, 1);
+  CHECK_EQUAL(dmxBuffer[9], 2);
+}
+
+static void testReplies() {
+  reset();
+  send(packet(DMX_PRO_GET_WIDGET_PARAM, {0, 0}));
+  std::vector<uint8_t> expected = {DMX_PRO_START_MSG, DMX_PRO_GET_WIDGET_PARAM, 5, 0, 0x44, 0x01, 9, 1, 40, DMX_PRO_END_MSG};
+  CHECK(Serial.output == expected);
+
+  // the widget parameters are stored and returned
+  send(packet(DMX_PRO_SET_WIDGET_PARAM, {0, 0, 20, 2, 30}));
+  Serial.output.clear();
+  send(packet(DMX_PRO_GET_WIDGET_PARAM, {0, 0}));
+  CHECK_EQUAL(Serial.output.size(), 10);
+  CHECK_EQUAL(Serial.output[6], 20);
+  CHECK_EQUAL(Serial.output[7], 2);
+  CHECK_EQUAL(Serial.output[8], 30);
+
+  Serial.output.clear();
+  send(packet(DMX_PRO_GET_SERIAL_NUMBER, {}));
+  expected = {DMX_PRO_START_MSG, DMX_PRO_GET_SERIAL_NUMBER, 4, 0, 0x78, 0x56, 0x34, 0x12, DMX_PRO_END_MSG};
+  CHECK(Serial.output == expected);
+
+  // an unknown label is counted, but not answered
+  Serial.output.clear();
+  send(packet(DMX_PRO_SEND_RDM, {1, 2}));
+  CHECK_EQUAL(counter.unknown, 1);
+  CHECK_EQUAL(Serial.output.size(), 0);
+}
+
+static void testStatistics() {
+  reset();
+  send({0x00, 0x01});
+  send(frame(1, 1));
+  send(frame(1, 1));
+  send({DMX_PRO_START_MSG, DMX_PRO_SEND_DMX, 0xff, 0xff});
+  send(packet(DMX_PRO_GET_STATISTICS, {}));
+  CHECK_EQUAL(counter.garbage, 2);
+  CHECK_EQUAL(counter.frames, 2);
+  CHECK_EQUAL(counter.overflow, 1);
+  CHECK_EQUAL(counter.messages, 3);
+
+  // the counters are returned in the same order and size as they are in memory, i.e. 16-bit on the Arduino
+  CHECK_EQUAL(Serial.output.size(), 5 + sizeof(counter));
+  CHECK_EQUAL(Serial.output[1], DMX_PRO_GET_STATISTICS);
+  CHECK_EQUAL(Serial.output[2], sizeof(counter));
+  CHECK_EQUAL(Serial.output[4 + 0 * sizeof(unsigned int)], 3);  // messages, including the statistics request itself
+  CHECK_EQUAL(Serial.output[4 + 1 * sizeof(unsigned int)], 2);  // frames
+  CHECK_EQUAL(Serial.output[4 + 2 * sizeof(unsigned int)], 2);  // garbage
+  CHECK_EQUAL(Serial.output[4 + 3 * sizeof(unsigned int)], 1);  // overflow
+}
+
+int main() {
+  testFrame();
+  testLength();
+  testEndCode();
+  testTimeout();
+  testReplies();
+  testStatistics();
+  return report("test_protocol");
+}
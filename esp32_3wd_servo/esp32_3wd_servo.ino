@@ -4,6 +4,8 @@
 #include <WiFiUdp.h>
 #include <OSCMessage.h>   // https://github.com/CNMAT/OSC
 #include <ESP32Servo.h>
+#include "oscdispatch.h"
+#include "kinematics.h"
 #include <math.h>
 
 WiFiUDP Udp;
@@ -25,10 +27,9 @@ const int servo3_pin = 27;
 const int minUs = 500;
 const int maxUs = 2500;
 
-const float pr = 0.06;            // platform radius, distance from the platform center to each of the wheels, in meter
 float vx = 0, vy = 0, vt = 0;     // speed in meter per second, and in radians per second
 float x = 0, y = 0, theta = 0;    // absolute position (in meter) and rotation (in radians)
-float r1 = 0, r2 = 0, r3 = 0;     // speed of the stepper motors, in steps per second
+float r1 = 0, r2 = 0, r3 = 0;     // speed of the wheels, in meter per second or as servo control value
 
 // don't use the built-in version of map(), as that is only for long int values
 // see https://docs.arduino.cc/language-reference/en/functions/math/map/
@@ -71,16 +72,10 @@ void accxyzCallback(OSCMessage &msg) {
 
 void updateSpeed() {
   // convert the speed in world-coordinates into rotation speed of the motors and into servo controls
-  // see https://github.com/manav20/3-wheel-omni
-
-  // pr is the platform radius, i.e. the distance of the center of the platform to each wheel 
   // vx, vy, and vt is the speed in world-coordinates
   // r1, r2, and r3 is the rotation speed of the three motors
   // theta is the heading of the robot (FIXME, needs to be integrated over time)
-
-  r1 = -sin(theta) * vx + cos(theta) * vy + pr * vt;
-  r2 = -sin(PI / 3 - theta) * vx - cos(PI / 3 - theta) * vy + pr * vt;
-  r3 = sin(PI / 3 + theta) * vx - cos(PI / 3 + theta) * vy + pr * vt;
+  inverseKinematics(theta, vx, vy, vt, &r1, &r2, &r3);
 
   // convert the rotation speed of the motors into servo control values between 0 and 180, where 90 is neutral
   r1 = map(r1, -1, 1, 0, 180);
@@ -136,6 +131,13 @@ void setup() {
 
   // Used for OSC
   Udp.begin(inPort);
+  oscAdd("/accxyz", accxyzCallback);
+  oscAdd("/wheel1", wheel1Callback);
+  oscAdd("/wheel2", wheel2Callback);
+  oscAdd("/wheel3", wheel3Callback);
+  oscAdd("/*/*/*", printCallback);
+  oscAdd("/*/*", printCallback);
+  oscAdd("/*", printCallback);
 
   servo1.attach(servo1_pin, minUs, maxUs);
   servo2.attach(servo2_pin, minUs, maxUs);
@@ -151,11 +153,7 @@ void loop() {
       msg.fill(Udp.read());
     }
     if (!msg.hasError()) {
-      msg.dispatch("/accxyz", accxyzCallback);
-      msg.dispatch("/wheel1", wheel1Callback);
-      msg.dispatch("/wheel2", wheel2Callback);
-      msg.dispatch("/wheel3", wheel3Callback);
-      msg.dispatch("/*/*/*", printCallback) || msg.dispatch("/*/*", printCallback) || msg.dispatch("/*", printCallback);
+      oscDispatch(msg);
     } else {
       error = msg.getError();
       Serial.print("error: ");
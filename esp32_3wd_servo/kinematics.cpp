@@ -0,0 +1,10 @@
+#include "kinematics.h"
+
+/********************************************************************************/
+
+void inverseKinematics(float theta, float vx, float vy, float vt, float *r1, float *r2, float *r3) {
+  // the rotation of the platform contributes equally to all wheels
+  *r1 = -sin(theta) * vx + cos(theta) * vy + PLATFORM_RADIUS * vt;
+  *r2 = -sin(M_PI / 3 - theta) * vx - cos(M_PI / 3 - theta) * vy + PLATFORM_RADIUS * vt;
+  *r3 = sin(M_PI / 3 + theta) * vx - cos(M_PI / 3 + theta) * vy + PLATFORM_RADIUS * vt;
+} // inverseKinematics
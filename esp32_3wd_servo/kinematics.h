@@ -0,0 +1,15 @@
+#ifndef _KINEMATICS_H_
+#define _KINEMATICS_H_
+
+#include <math.h>
+
+// This does not depend on the Arduino core, so that it can also be tested on another computer.
+// See https://github.com/manav20/3-wheel-omni
+
+#define PLATFORM_RADIUS 0.06  // distance from the platform center to each of the wheels, in meter
+
+// the speed in world coordinates (in meter and radians per second) and the heading of the platform
+// are converted into the rotation speed of the three wheels, expressed as their surface speed in meter per second
+void inverseKinematics(float theta, float vx, float vy, float vt, float *r1, float *r2, float *r3);
+
+#endif // _KINEMATICS_H_
@@ -0,0 +1,29 @@
+#ifndef _OSCDISPATCH_H_
+#define _OSCDISPATCH_H_
+
+#include <OSCMessage.h>         // https://github.com/CNMAT/OSC
+#include <OSCBundle.h>
+
+/*
+  The OSC addresses and their callbacks are compiled into a tree with one node per part
+  of the address. An incoming message is dispatched by splitting its address once and
+  walking down the tree, rather than by matching it against every address in turn.
+
+  The parts of the address can contain the OSC pattern-matching characters, i.e. "?",
+  "*", "[abc]", "[a-z]", "[!abc]" and "{foo,bar}". These can be used both in the addresses
+  that are added to the tree and in the addresses of incoming messages.
+*/
+
+#define OSC_MAXNODES   48   // maximum number of nodes in the tree
+#define OSC_MAXNAME    16   // maximum length of each part of the address
+#define OSC_MAXDEPTH   8    // maximum number of parts of the address
+#define OSC_MAXADDRESS 64   // maximum length of the address
+
+typedef void (*osc_callback_t)(OSCMessage &);
+
+bool oscAdd(const char *, osc_callback_t);
+int oscDispatch(OSCMessage &);
+int oscDispatch(OSCBundle &);
+bool oscMatch(const char *, const char *);
+
+#endif // _OSCDISPATCH_H_
@@ -0,0 +1,84 @@
+// Host test of the inverse kinematics of the servo platform, which has the same geometry as
+// the stepper platform in esp32_3wd_stepper, except that the wheels turn the other way
+
+#include <stdlib.h>
+#include "check.h"
+#include "kinematics.h"
+
+// the surface speed of the wheels of the stepper platform, see esp32_3wd_stepper/kinematics.cpp
+static void stepperKinematics(float a, float vx, float vy, float *r) {
+  for (int i = 0; i < 3; i++) {
+    float b = a + (i == 0 ? 0 : (i == 1 ? 2 * M_PI / 3 : -2 * M_PI / 3));
+    r[i] = sin(b) * vx - cos(b) * vy;
+  }
+}
+
+static float uniform(float range) {
+  return range * (2.0 * rand() / RAND_MAX - 1);
+}
+
+static void testRest() {
+  float r1, r2, r3;
+  inverseKinematics(1.234, 0, 0, 0, &r1, &r2, &r3);
+  CHECK_EQUAL(r1, 0);
+  CHECK_EQUAL(r2, 0);
+  CHECK_EQUAL(r3, 0);
+}
+
+static void testTranslation() {
+  for (int k = 0; k < 1000; k++) {
+    float theta = uniform(M_PI), vx = uniform(1), vy = uniform(1), r1, r2, r3, r[3];
+    inverseKinematics(theta, vx, vy, 0, &r1, &r2, &r3);
+
+    // the wheels are at 120 degrees, hence their speeds sum to zero
+    CHECK_CLOSE(r1 + r2 + r3, 0, 1e-5);
+
+    // the speed of the platform is distributed over the wheels
+    CHECK_CLOSE(r1 * r1 + r2 * r2 + r3 * r3, 1.5 * (vx * vx + vy * vy), 1e-5);
+
+    stepperKinematics(theta, vx, vy, r);
+    CHECK_CLOSE(r1, -r[0], 1e-5);
+    CHECK_CLOSE(r2, -r[1], 1e-5);
+    CHECK_CLOSE(r3, -r[2], 1e-5);
+  }
+
+  // straight ahead the first wheel rolls at the full speed
+  float r1, r2, r3;
+  inverseKinematics(0, 0, 0.1, 0, &r1, &r2, &r3);
+  CHECK_CLOSE(r1, 0.1, 1e-6);
+  CHECK_CLOSE(r2, -0.05, 1e-6);
+  CHECK_CLOSE(r3, -0.05, 1e-6);
+}
+
+static void testRotation() {
+  // the rotation contributes equally to all wheels, also while translating
+  for (int k = 0; k < 1000; k++) {
+    float theta = uniform(M_PI), vx = uniform(1), vy = uniform(1), vt = uniform(3), r1, r2, r3, s1, s2, s3;
+    inverseKinematics(theta, vx, vy, 0, &r1, &r2, &r3);
+    inverseKinematics(theta, vx, vy, vt, &s1, &s2, &s3);
+    CHECK_CLOSE(s1 - r1, PLATFORM_RADIUS * vt, 1e-5);
+    CHECK_CLOSE(s2 - r2, PLATFORM_RADIUS * vt, 1e-5);
+    CHECK_CLOSE(s3 - r3, PLATFORM_RADIUS * vt, 1e-5);
+  }
+}
+
+static void testHeading() {
+  // turning the platform and the speed over the same angle does not change the wheel speeds
+  for (int k = 0; k < 1000; k++) {
+    float theta = uniform(M_PI), vx = uniform(1), vy = uniform(1), r1, r2, r3, s1, s2, s3;
+    inverseKinematics(0, vx, vy, 0, &r1, &r2, &r3);
+    inverseKinematics(theta, vx * cos(theta) - vy * sin(theta), vx * sin(theta) + vy * cos(theta), 0, &s1, &s2, &s3);
+    CHECK_CLOSE(s1, r1, 1e-5);
+    CHECK_CLOSE(s2, r2, 1e-5);
+    CHECK_CLOSE(s3, r3, 1e-5);
+  }
+}
+
+int main() {
+  srand(1);
+  testRest();
+  testTranslation();
+  testRotation();
+  testHeading();
+  return report("test_kinematics");
+}
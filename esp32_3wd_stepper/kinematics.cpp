@@ -0,0 +1,38 @@
+#include "kinematics.h"
+
+static const float pc = PLATFORM_DIAMETER * M_PI;  // platform circumference, in meter
+static const float wc = WHEEL_DIAMETER * M_PI;     // wheel circumference, in meter
+
+/********************************************************************************/
+
+void inverseKinematics(float a, float vx, float vy, float va, float *r1, float *r2, float *r3) {
+  // convert the speed from world-coordinates into the rotation speed of the motors
+  *r1 = sin(a               ) * vx / wc - cos(a               ) * vy / wc - va * (pc / wc) / (M_PI * 2);
+  *r2 = sin(a + M_PI * 2 / 3) * vx / wc - cos(a + M_PI * 2 / 3) * vy / wc - va * (pc / wc) / (M_PI * 2);
+  *r3 = sin(a - M_PI * 2 / 3) * vx / wc - cos(a - M_PI * 2 / 3) * vy / wc - va * (pc / wc) / (M_PI * 2);
+
+  // convert from rotations per second into steps per second
+  *r1 *= WHEEL_STEPS;
+  *r2 *= WHEEL_STEPS;
+  *r3 *= WHEEL_STEPS;
+} // inverseKinematics
+
+/********************************************************************************/
+
+void forwardKinematics(float a, float s1, float s2, float s3, float *dx, float *dy, float *da) {
+  // convert from steps into the distance that each wheel has rolled, in meter
+  s1 *= wc / WHEEL_STEPS;
+  s2 *= wc / WHEEL_STEPS;
+  s3 *= wc / WHEEL_STEPS;
+
+  // the rotation of the platform contributes equally to all wheels, the translation sums to zero over the three wheels
+  *da = -(s1 + s2 + s3) * (M_PI * 2) / (3 * pc);
+
+  // the remainder of each wheel is due to the translation, which is taken at the angle halfway the movement
+  float u1 = s1 + *da * pc / (M_PI * 2);
+  float u2 = s2 + *da * pc / (M_PI * 2);
+  float u3 = s3 + *da * pc / (M_PI * 2);
+  a += *da / 2;
+  *dx =  (u1 * sin(a) + u2 * sin(a + M_PI * 2 / 3) + u3 * sin(a - M_PI * 2 / 3)) * 2 / 3;
+  *dy = -(u1 * cos(a) + u2 * cos(a + M_PI * 2 / 3) + u3 * cos(a - M_PI * 2 / 3)) * 2 / 3;
+} // forwardKinematics
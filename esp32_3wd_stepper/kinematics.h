@@ -0,0 +1,19 @@
+#ifndef _KINEMATICS_H_
+#define _KINEMATICS_H_
+
+#include <math.h>
+
+// This does not depend on the Arduino core, so that the motion of the platform can
+// also be computed on another computer from a recording of the wheel steps.
+
+#define PLATFORM_DIAMETER 0.084252  // in meter
+#define WHEEL_DIAMETER    0.038     // in meter
+#define WHEEL_STEPS       2048      // steps per revolution, see http://www.mjblythe.com/hacks/2016/09/28byj-48-stepper-motor/
+
+// the speed in world coordinates and the angle of the platform are converted into the speed of the three wheels in steps per second
+void inverseKinematics(float a, float vx, float vy, float va, float *r1, float *r2, float *r3);
+
+// the number of steps made by the three wheels is converted into the displacement in world coordinates, given the angle at the start
+void forwardKinematics(float a, float s1, float s2, float s3, float *dx, float *dy, float *da);
+
+#endif // _KINEMATICS_H_
@@ -0,0 +1,297 @@
+#include "motion.h"
+#include "waypoints.h"
+#include "kinematics.h"
+#include "webinterface.h"
+#include "blink_led.h"
+#include "util.h"
+
+// The position of the platform is integrated from the steps that the wheels made, the
+// speed follows from the distance to the target on the route or from the manual control.
+// The main loop calls updatePosition, updateTarget, updateSpeed and updateWheels in turn.
+
+Stepper wheel1;
+Stepper wheel2;
+Stepper wheel3;
+
+static const float lookahead = 0.2;  // in seconds, for following the smooth path between the waypoints
+
+static unsigned long previous = 0;          // timer to shift the route while it is paused
+static int32_t steps[STEPPER_MAX] = {0};    // number of half-steps made by each wheel
+
+float x = 0, y = 0, a = 0;          // absolute position (in meter) and angle (in radians)
+float vx = 0, vy = 0, va = 0;       // speed in meter per second, and angular speed in radians per second
+float r1 = 0, r2 = 0, r3 = 0;       // speed of the stepper motors, in steps per second
+
+float target_x = 0, target_y = 0, target_a = 0;
+unsigned long route_starttime = 4294967295;
+unsigned long target_eta = 4294967295;
+
+// when there is an active route, the speed is determined by the distance to the target waypoint
+// when there is no route, the speed is determined manually by the user
+int current_route = -1;
+int current_segment = -1;
+bool route_pause = false;
+
+/********************************************************************************/
+
+void startRoute(int route) {
+  unsigned long now = millis();
+
+  // stop the current movement
+  vx = 0;
+  vy = 0;
+  va = 0;
+
+  if (!config.absolute) {
+    // set the current position and orientation as zero
+    x = 0;
+    y = 0;
+    a = 0;
+  }
+
+  // read the compiled waypoints from the SPIFFS filesystem
+  unsigned long start = micros();
+  if (!readWaypoints(route))
+    waypoints_n = 1;
+
+  // the first waypoint is reserved for the current position and orientation as the starting point
+  waypoints_t[0] = 0;
+  waypoints_x[0] = x;
+  waypoints_y[0] = y;
+  waypoints_a[0] = a;
+
+  if (config.debug) {
+    Serial.print("route start took ");
+    Serial.print(micros() - start);
+    Serial.println(" us");
+  }
+
+  // start the new route
+  route_starttime = now;
+  current_route = route;
+  route_pause = false;
+
+  if (config.debug)
+    printWaypoints(route);
+} // startRoute
+
+/********************************************************************************/
+
+void pauseRoute() {
+  // pause the current route
+  vx = 0;
+  vy = 0;
+  va = 0;
+  route_pause = true;
+} // pauseRoute
+
+/********************************************************************************/
+
+void resumeRoute() {
+  // resume the current route
+  route_pause = false;
+} // resumeRoute
+
+/********************************************************************************/
+
+void stopRoute() {
+  // stop the current route
+  vx = 0;
+  vy = 0;
+  va = 0;
+  current_route = -1;
+  route_starttime = 4294967295;
+  target_eta = 4294967295;
+  route_pause = false;
+} // stopRoute
+
+/********************************************************************************/
+
+void resetRoute() {
+  // stop the current route and reset the current position to zero
+  stopRoute();
+  x = 0;
+  y = 0;
+  a = 0;
+} // resetRoute
+
+/********************************************************************************/
+
+void updatePosition() {
+  unsigned long now = millis();
+  if (route_pause) {
+    // shift the time so that we remain in the same state
+    // this is as if the time has stopped
+    route_starttime += (now - previous);
+    target_eta += (now - previous);
+  }
+  previous = now;
+
+  // integrate the steps that the wheels actually made to keep track of the current position and angle
+  // this includes the ramps and continues while the wheels slow down after a pause
+  int32_t current[STEPPER_MAX] = {0};
+  Stepper::steps(current);
+  float dx, dy, da;
+  forwardKinematics(a, 0.5 * (current[0] - steps[0]), 0.5 * (current[1] - steps[1]), 0.5 * (current[2] - steps[2]), &dx, &dy, &da);
+  x += dx;
+  y += dy;
+  a += da;
+  memcpy(steps, current, sizeof(steps));
+}  // updatePosition
+
+/********************************************************************************/
+
+void updateTarget() {
+  unsigned long now = millis();
+
+  if (current_route < 0) {
+    // when there is no route, the speed is determined manually by the user
+    // hence the current position is as good a target as anywhere else
+    target_x = x;
+    target_y = y;
+    target_a = a;
+    target_eta = 4294967295;
+  }
+  else {
+    // when there is an active route, the speed is determined by the distance to the target waypoint
+    // determine the segment or leg that we are currently on
+    current_segment = -1;
+
+    int n = waypoints_n;
+    unsigned long route_endtime = route_starttime + 1000 * waypoints_t[n - 1];
+
+    if (now < route_starttime) {
+      // the route has not yet started
+      // stay where we are
+      target_x = x;
+      target_y = y;
+      target_a = a;
+      target_eta = 4294967295;
+    }
+    else if (now >= route_endtime) {
+      // the route has finished
+      if (config.repeat) {
+        // start the same route again
+        startRoute(current_route);
+      }
+      else {
+        // stop the route
+        current_route = -1;
+        vx = 0;
+        vy = 0;
+        va = 0;
+        // stay where we are
+        target_x = x;
+        target_y = y;
+        target_a = a;
+        target_eta = 4294967295;
+      }
+    }
+    else if (config.smooth) {
+      // follow a smooth path through the waypoints, the target is slightly ahead on the path
+      float t = 0.001 * (now - route_starttime) + lookahead;
+      current_segment = interpolateWaypoints(t, &target_x, &target_y, &target_a);
+      target_eta = now + 1000 * lookahead;
+    }
+    else {
+      // determine the segment or leg that we are currently on
+      // the N waypoints are connected by N-1 segments
+      for (int i = 0; i < (n - 1); i++) {
+        unsigned long segment_starttime = route_starttime + 1000 * waypoints_t[i];
+        unsigned long segment_endtime   = route_starttime + 1000 * waypoints_t[i + 1];
+        if (now >= segment_starttime && now < segment_endtime) {
+          current_segment = i + 1;
+          target_x = waypoints_x[i + 1];
+          target_y = waypoints_y[i + 1];
+          target_a = waypoints_a[i + 1];
+          target_eta = segment_endtime;
+          break;
+        }
+      } // for all segments
+    } // if route_starttime
+  } // if current_route
+
+} // updateTarget
+
+/********************************************************************************/
+
+void updateSpeed() {
+  unsigned long now = millis();
+
+  if (current_route < 0) {
+    // when there is no route, the speed is determined manually by the user
+  }
+  else if (route_pause) {
+    // don't move if the route is paused
+    vx = 0;
+    vy = 0;
+    va = 0;
+  }
+  else {
+    // when there is an active route, the speed is determined by the distance to the target waypoint
+    if (current_segment > 0) {
+      // determine the speed needed to reach the target at the desired time
+      float dt = 0.001 * (target_eta - now); // in seconds
+      if (dt > 0) {
+        vx = (target_x - x) / dt;
+        vy = (target_y - y) / dt;
+        va = (target_a - a) / dt;
+      }
+      else {
+        // infinite or negative speed is not allowed
+        vx = 0;
+        vy = 0;
+        va = 0;
+      }
+    }
+    else {
+      // the current segment could not be determined
+      vx = 0;
+      vy = 0;
+      va = 0;
+    } // if current_segment
+  } // if current_route
+
+} // updateSpeed
+
+/********************************************************************************/
+
+void updateWheels() {
+  // convert the speed from world-coordinates into the speed of the motors in steps per second
+  inverseKinematics(a, vx, vy, va, &r1, &r2, &r3);
+
+  // the stepper motors cannot rotate at more than ~512 steps/second, or somewhat faster when ramping up
+  float r = maxOfThree(abs(r1), abs(r2), abs(r3));
+  float maxspeed = (config.maxspeed > 0 ? config.maxspeed : 512);
+  if (r > maxspeed) {
+    float reduction = r / maxspeed;
+    Serial.print("reducing speed by factor ");
+    Serial.println(reduction);
+    vx /= reduction;
+    vy /= reduction;
+    va /= reduction;
+    r1 /= reduction;
+    r2 /= reduction;
+    r3 /= reduction;
+  }
+
+  if (r1 == 0 && r2 == 0 && r3 == 0) {
+    // save energy by switching the motors off
+    wheel1.powerOff();
+    wheel2.powerOff();
+    wheel3.powerOff();
+    ledOn();
+  }
+  else {
+    wheel1.powerOn();
+    wheel2.powerOn();
+    wheel3.powerOn();
+    ledSlow();
+  }
+
+  // set the motor speed in steps per seconds, the three wheels change speed at the same time
+  wheel1.spin(r1);
+  wheel2.spin(r2);
+  wheel3.spin(r3);
+  Stepper::update(config.profile, config.acceleration, config.jerk);
+}  // updateWheels
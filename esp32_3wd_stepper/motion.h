@@ -0,0 +1,32 @@
+#ifndef _MOTION_H_
+#define _MOTION_H_
+
+#include <Arduino.h>
+#include "stepper.h"
+
+// these are defined in the corresponding CPP file
+
+extern Stepper wheel1, wheel2, wheel3;
+
+extern float x, y, a;                 // absolute position (in meter) and angle (in radians)
+extern float vx, vy, va;              // speed in meter per second, and angular speed in radians per second
+extern float r1, r2, r3;              // speed of the stepper motors, in steps per second
+extern float target_x, target_y, target_a;
+extern unsigned long route_starttime;
+extern unsigned long target_eta;
+extern int current_route;
+extern int current_segment;
+extern bool route_pause;
+
+void startRoute(int);
+void pauseRoute();
+void resumeRoute();
+void stopRoute();
+void resetRoute();
+
+void updatePosition();                // integrate the steps of the wheels into the position
+void updateTarget();                  // determine the target on the route
+void updateSpeed();                   // determine the speed towards the target
+void updateWheels();                  // convert the speed into the speed of the wheels
+
+#endif // _MOTION_H_
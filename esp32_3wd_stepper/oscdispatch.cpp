@@ -0,0 +1,207 @@
+#include "oscdispatch.h"
+
+typedef struct {
+  char name[OSC_MAXNAME];
+  bool pattern;              // whether the name contains pattern-matching characters
+  int8_t child;              // the first child, or -1
+  int8_t sibling;            // the next sibling, or -1
+  osc_callback_t callback;   // this is called when the address ends at this node
+} node_t;
+
+// the first node is the root of the tree
+static node_t node[OSC_MAXNODES];
+static int8_t nodes = 0;
+
+/***************************************************************************/
+
+static bool hasPattern(const char *str) {
+  return strpbrk(str, "?*[]{}") != NULL;
+}
+
+static int8_t newNode(const char *name, size_t len) {
+  if (nodes == OSC_MAXNODES || len >= OSC_MAXNAME) {
+    Serial.println("Cannot add OSC address");
+    return -1;
+  }
+  node_t *n = &node[nodes];
+  memcpy(n->name, name, len);
+  n->name[len] = 0;
+  n->pattern = hasPattern(n->name);
+  n->child = -1;
+  n->sibling = -1;
+  n->callback = NULL;
+  return nodes++;
+}
+
+bool oscAdd(const char *address, osc_callback_t callback) {
+  if (nodes == 0 && newNode("", 0) < 0)
+    return false;
+
+  int8_t current = 0;
+  const char *p = address;
+  while (*p == '/') {
+    p++;
+    const char *end = strchr(p, '/');
+    size_t len = (end ? end - p : strlen(p));
+
+    // find the child with the same name, or add a new one at the end
+    int8_t previous = -1, c = node[current].child;
+    while (c >= 0 && !(strlen(node[c].name) == len && strncmp(node[c].name, p, len) == 0)) {
+      previous = c;
+      c = node[c].sibling;
+    }
+    if (c < 0) {
+      c = newNode(p, len);
+      if (c < 0)
+        return false;
+      if (previous < 0)
+        node[current].child = c;
+      else
+        node[previous].sibling = c;
+    }
+
+    current = c;
+    p += len;
+  }
+
+  node[current].callback = callback;
+  return true;
+}
+
+/***************************************************************************/
+
+bool oscMatch(const char *pattern, const char *str) {
+  // this matches one part of the address, i.e. without slashes
+  while (*pattern) {
+    switch (*pattern) {
+
+      case '*':
+        // try to match the remainder of the pattern at every position
+        while (*pattern == '*')
+          pattern++;
+        if (*pattern == 0)
+          return true;
+        for (; *str; str++)
+          if (oscMatch(pattern, str))
+            return true;
+        return oscMatch(pattern, str);
+
+      case '?':
+        if (*str == 0)
+          return false;
+        pattern++;
+        str++;
+        break;
+
+      case '[': {
+          if (*str == 0)
+            return false;
+          pattern++;
+          bool negate = (*pattern == '!');
+          if (negate)
+            pattern++;
+          bool found = false;
+          while (*pattern && *pattern != ']') {
+            char lo = *pattern++, hi = lo;
+            if (*pattern == '-' && pattern[1] && pattern[1] != ']') {
+              hi = pattern[1];
+              pattern += 2;
+            }
+            found |= (*str >= lo && *str <= hi);
+          }
+          if (*pattern == ']')
+            pattern++;
+          if (found == negate)
+            return false;
+          str++;
+          break;
+        }
+
+      case '{': {
+          // try each of the comma-separated alternatives, followed by the remainder of the pattern
+          const char *close = strchr(pattern, '}');
+          if (close == NULL)
+            return false;
+          const char *alternative = pattern + 1;
+          while (alternative <= close) {
+            const char *end = alternative;
+            while (end < close && *end != ',')
+              end++;
+            size_t len = end - alternative;
+            if (strncmp(alternative, str, len) == 0 && oscMatch(close + 1, str + len))
+              return true;
+            alternative = end + 1;
+          }
+          return false;
+        }
+
+      default:
+        if (*pattern != *str)
+          return false;
+        pattern++;
+        str++;
+    }
+  }
+  return (*str == 0);
+}
+
+/***************************************************************************/
+
+static int dispatchNode(int8_t n, char **part, bool *pattern, int depth, OSCMessage &msg) {
+  // this returns the number of callbacks
+  if (depth == 0) {
+    if (node[n].callback == NULL)
+      return 0;
+    node[n].callback(msg);
+    return 1;
+  }
+
+  int count = 0;
+  for (int8_t c = node[n].child; c >= 0; c = node[c].sibling) {
+    bool match;
+    if (node[c].pattern)
+      match = oscMatch(node[c].name, part[0]);
+    else if (pattern[0])
+      match = oscMatch(part[0], node[c].name);
+    else
+      match = (strcmp(node[c].name, part[0]) == 0);
+    if (match)
+      count += dispatchNode(c, part + 1, pattern + 1, depth - 1, msg);
+  }
+  return count;
+}
+
+int oscDispatch(OSCMessage &msg) {
+  if (nodes == 0)
+    return 0;
+
+  char address[OSC_MAXADDRESS];
+  msg.getAddress(address, 0, sizeof(address) - 1);
+  address[sizeof(address) - 1] = 0;
+
+  // split the address in place into its parts, each slash terminates the previous part
+  char *part[OSC_MAXDEPTH];
+  bool pattern[OSC_MAXDEPTH];
+  int depth = 0;
+  char *p = address;
+  while (*p == '/') {
+    if (depth == OSC_MAXDEPTH)
+      return 0;
+    *p++ = 0;
+    part[depth++] = p;
+    while (*p && *p != '/')
+      p++;
+  }
+  for (int i = 0; i < depth; i++)
+    pattern[i] = hasPattern(part[i]);
+
+  return dispatchNode(0, part, pattern, depth, msg);
+}
+
+int oscDispatch(OSCBundle &bundle) {
+  // the messages in a bundle are dispatched in the same way as single messages
+  int count = 0;
+  for (int i = 0; i < bundle.size(); i++)
+    count += oscDispatch(*bundle.getOSCMessage(i));
+  return count;
+}
@@ -1,4 +1,27 @@
 #include "parseosc.h"
+#include "oscdispatch.h"
+
+/********************************************************************************/
+
+void setupOSC() {
+  // the print callback is added first, so that it is called before the others
+  oscAdd("/*",           printCallback);
+  oscAdd("/*/*",         printCallback);
+  oscAdd("/*/*/*",       printCallback);
+  oscAdd("/route/*",     routeCallback);   // the route number is part of the address
+  oscAdd("/pause",       pauseCallback);
+  oscAdd("/resume",      resumeCallback);
+  oscAdd("/stop",        stopCallback);
+  oscAdd("/reset",       resetCallback);
+  oscAdd("/adjust/x",    dxCallback);
+  oscAdd("/adjust/y",    dyCallback);
+  oscAdd("/adjust/a",    daCallback);
+  oscAdd("/manual/x",    xCallback);
+  oscAdd("/manual/y",    yCallback);
+  oscAdd("/manual/a",    aCallback);
+  oscAdd("/manual/xy/1", xyCallback);      // this is for the 2D panel in touchOSC
+  oscAdd("/accxyz",      accxyzCallback);  // this is for the accelerometer in touchOSC
+}  // setupOSC
 
 /********************************************************************************/
 
@@ -17,27 +40,7 @@ void parseOSC() {
         bundle.fill(Udp.read());
       }
       if (!bundle.hasError()) {
-        bundle.dispatch("/*", printCallback) || bundle.dispatch("/*/*", printCallback) || bundle.dispatch("/*/*/*", printCallback);
-        bundle.dispatch("/route/1",     route1Callback);
-        bundle.dispatch("/route/2",     route2Callback);
-        bundle.dispatch("/route/3",     route3Callback);
-        bundle.dispatch("/route/4",     route4Callback);
-        bundle.dispatch("/route/5",     route5Callback);
-        bundle.dispatch("/route/6",     route6Callback);
-        bundle.dispatch("/route/7",     route7Callback);
-        bundle.dispatch("/route/8",     route8Callback);
-        bundle.dispatch("/pause",       pauseCallback);
-        bundle.dispatch("/resume",      resumeCallback);
-        bundle.dispatch("/stop",        stopCallback);
-        bundle.dispatch("/reset",       resetCallback);
-        bundle.dispatch("/adjust/x",    dxCallback);
-        bundle.dispatch("/adjust/y",    dyCallback);
-        bundle.dispatch("/adjust/a",    daCallback);
-        bundle.dispatch("/manual/x",    xCallback);
-        bundle.dispatch("/manual/y",    yCallback);
-        bundle.dispatch("/manual/a",    aCallback);
-        bundle.dispatch("/manual/xy/1", xyCallback);      // this is for the 2D panel in touchOSC
-        bundle.dispatch("/accxyz",      accxyzCallback);  // this is for the accelerometer in touchOSC
+        oscDispatch(bundle);
       } else {
         error = bundle.getError();
         Serial.print("error: ");
@@ -49,27 +52,7 @@ void parseOSC() {
         msg.fill(Udp.read());
       }
       if (!msg.hasError()) {
-        msg.dispatch("/*", printCallback) || msg.dispatch("/*/*", printCallback) || msg.dispatch("/*/*/*", printCallback);
-        msg.dispatch("/route/1",     route1Callback);
-        msg.dispatch("/route/2",     route2Callback);
-        msg.dispatch("/route/3",     route3Callback);
-        msg.dispatch("/route/4",     route4Callback);
-        msg.dispatch("/route/5",     route5Callback);
-        msg.dispatch("/route/6",     route6Callback);
-        msg.dispatch("/route/7",     route7Callback);
-        msg.dispatch("/route/8",     route8Callback);
-        msg.dispatch("/pause",       pauseCallback);
-        msg.dispatch("/resume",      resumeCallback);
-        msg.dispatch("/stop",        stopCallback);
-        msg.dispatch("/reset",       resetCallback);
-        msg.dispatch("/adjust/x",    dxCallback);
-        msg.dispatch("/adjust/y",    dyCallback);
-        msg.dispatch("/adjust/a",    daCallback);
-        msg.dispatch("/manual/x",    xCallback);
-        msg.dispatch("/manual/y",    yCallback);
-        msg.dispatch("/manual/a",    aCallback);
-        msg.dispatch("/manual/xy/1", xyCallback);      // this is for the 2D panel in touchOSC
-        msg.dispatch("/accxyz",      accxyzCallback);  // this is for the accelerometer in touchOSC
+        oscDispatch(msg);
       } else {
         error = msg.getError();
         Serial.print("error: ");
@@ -111,44 +94,14 @@ void printCallback(OSCMessage &msg) {
 
 /********************************************************************************/
 
-void route1Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(1);
-}
-
-void route2Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(2);
-}
-
-void route3Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(3);
-}
-
-void route4Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(4);
-}
-
-void route5Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(5);
-}
-
-void route6Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(6);
-}
-
-void route7Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(7);
-}
-
-void route8Callback(OSCMessage &msg) {
-  if (msg.getInt(0))
-    startRoute(8);
+void routeCallback(OSCMessage &msg) {
+  // the address is /route/N, where N can be any positive number
+  char address[32];
+  msg.getAddress(address, 0, sizeof(address) - 1);
+  address[sizeof(address) - 1] = 0;
+  int route = atoi(address + 7);
+  if (route > 0 && msg.getInt(0))
+    startRoute(route);
 }
 
 void pauseCallback(OSCMessage &msg) {
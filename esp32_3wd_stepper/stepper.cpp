@@ -3,7 +3,19 @@
 // This implements the ESP32 control for the 28BYJ-48 motor and the ULN2003 driver board.
 //
 // It is specifically written to keep up to four stepper motors spinning at a constant speed
-// and it uses ESP32 hardware timers for precise timing.
+// and it uses a single ESP32 hardware timer for precise timing. The timer runs at a fixed
+// rate, and on every tick each motor adds its increment to a phase accumulator; the motor
+// makes a half-step whenever its accumulator overflows. This is a digital differential
+// analyzer (DDA) that generates the steps of all motors from the same clock.
+//
+// New speeds are applied to all motors at the same tick, so that the omni wheels of my
+// 3-wheel robot platform change speed together and the platform keeps going straight.
+//
+// Optionally the speed is ramped, which prevents the 28BYJ-48 motors from missing steps
+// when they have to speed up. The ramp is linear (a trapezoidal speed profile) or has the
+// shape of a smoothstep (an S-curve with limited jerk). All motors use the same duration
+// and shape of the ramp, hence the direction of the platform does not change during the
+// ramp. The speed is updated in the timer interrupt using fixed-point math.
 //
 // The https://docs.arduino.cc/libraries/stepper/ was not convenient to set and 
 // keep the stepper motor runnning at a specific speed.
@@ -14,6 +26,16 @@
 //
 // See https://espressif-docs.readthedocs-hosted.com/projects/arduino-esp32/en/latest/api/timer.html
 
+Stepper *Stepper::instance[STEPPER_MAX];
+unsigned int Stepper::count = 0;
+hw_timer_t *Stepper::timer = NULL;
+portMUX_TYPE Stepper::mux = portMUX_INITIALIZER_UNLOCKED;
+int Stepper::rampProfile = RAMP_NONE;
+uint32_t Stepper::rampLength = 0;
+uint32_t Stepper::rampCount = 0;
+unsigned int Stepper::subtick = 0;
+uint32_t Stepper::maxCycles = 0;
+
 /******************************************************************************/
 
 Stepper::Stepper() {
@@ -33,25 +55,105 @@ void Stepper::begin(unsigned int _in1, int _in2, int _in3, int _in4) {
   pinMode(in3, OUTPUT);
   pinMode(in4, OUTPUT);
 
-  timer = timerBegin(frequency);
-  timerAttachInterruptArg(timer, &onTimer, (void*)this);
+  if (count == STEPPER_MAX)
+    return;
+
+  portENTER_CRITICAL(&mux);
+  instance[count++] = this;
+  portEXIT_CRITICAL(&mux);
+
+  if (timer == NULL) {
+    // the timer is shared by all stepper motors
+    timer = timerBegin(frequency);
+    timerAttachInterrupt(timer, &onTimer);
+    timerAlarm(timer, frequency / STEPPER_TICKRATE, true, 0);
+  }
 }
 
 /******************************************************************************/
 
 void Stepper::spin(int speed) {
-  if (speed > 0) {
-    direction = +1;
-    timerAlarm(timer, frequency / (+speed * 2), true, 0); // speed times two since half-steps
+  // speed times two since half-steps, the increment is a fraction of 2^32 per tick
+  int32_t rate = min(abs(speed) * 2, STEPPER_TICKRATE / 2 - 1);
+  int32_t value = ((uint64_t)rate << 32) / STEPPER_TICKRATE;
+  nextVelocity = (speed < 0 ? -value : value);
+}
+
+/******************************************************************************/
+
+void Stepper::update(int profile, float acceleration, float jerk) {
+  // the timer interrupt cannot run while the new speeds are copied
+  portENTER_CRITICAL(&mux);
+
+  bool changed = false;
+  for (unsigned int i = 0; i < count; i++)
+    changed |= (instance[i]->nextVelocity != instance[i]->target);
+  if (!changed) {
+    // do not restart the ramp that is in progress
+    portEXIT_CRITICAL(&mux);
+    return;
   }
-  else if (speed < 0) {
-    direction = -1;
-    timerAlarm(timer, frequency / (-speed * 2), true, 0); // speed times two since half-steps
+
+  // an S-curve that is restarted begins again with zero acceleration, hence a ramp that is
+  // restarted by every control cycle would hardly progress; a small change of the target
+  // speed is therefore applied to the ramp that is in progress
+  if (profile == RAMP_SCURVE && rampProfile == RAMP_SCURVE && rampCount < rampLength && acceleration > 0) {
+    int64_t u = ((int64_t)rampCount << 16) / rampLength;
+    int64_t s = (3 * u * u - ((2 * u * u * u) >> 16)) >> 16;
+    int64_t limit = acceleration / STEPPER_RAMPRATE * 2 * 4294967296.0 / STEPPER_TICKRATE;  // in increments per ramp update
+    bool small = true;
+    for (unsigned int i = 0; i < count; i++) {
+      int64_t jump = (((int64_t)instance[i]->nextVelocity - instance[i]->target) * s) >> 16;
+      small &= (jump <= limit && jump >= -limit);
+    }
+    if (small) {
+      for (unsigned int i = 0; i < count; i++)
+        instance[i]->target = instance[i]->nextVelocity;
+      portEXIT_CRITICAL(&mux);
+      return;
+    }
   }
-  else if (speed == 0) {
-    direction = 0;
-    timerAlarm(timer, 0, false, 0); // execute the alarm once, do not repeat
+
+  // the ramp starts at the current speed, also if the previous ramp did not finish yet
+  int64_t largest = 0;
+  for (unsigned int i = 0; i < count; i++) {
+    instance[i]->start = instance[i]->velocity;
+    instance[i]->target = instance[i]->nextVelocity;
+    int64_t change = (int64_t)instance[i]->target - instance[i]->start;
+    change = (change < 0 ? -change : change);
+    largest = (change > largest ? change : largest);
   }
+
+  // the duration of the ramp is determined by the motor with the largest change in speed
+  float change = largest * (float)STEPPER_TICKRATE / 4294967296.0 / 2;  // in steps per second
+  float duration = 0;                                                    // in seconds
+  if (profile == RAMP_TRAPEZOID && acceleration > 0)
+    duration = change / acceleration;
+  else if (profile == RAMP_SCURVE && acceleration > 0 && jerk > 0)
+    // the peak acceleration of the smoothstep is 1.5 times the average, the peak jerk is 6 times
+    duration = max(1.5f * change / acceleration, sqrtf(6 * change / jerk));
+
+  rampProfile = profile;
+  rampLength = min(duration * STEPPER_RAMPRATE, 65535.f);
+  rampCount = 0;  // the subtick keeps running, so that a ramp that restarts often still progresses
+  if (rampLength == 0)
+    for (unsigned int i = 0; i < count; i++)
+      instance[i]->setVelocity(instance[i]->target);
+
+  portEXIT_CRITICAL(&mux);
+}
+
+uint32_t Stepper::cycles() {
+  uint32_t value = maxCycles;
+  maxCycles = 0;
+  return value;
+}
+
+void Stepper::steps(int32_t *value) {
+  portENTER_CRITICAL(&mux);
+  for (unsigned int i = 0; i < count; i++)
+    value[i] = instance[i]->position;
+  portEXIT_CRITICAL(&mux);
 }
 
 /******************************************************************************/
@@ -66,36 +168,73 @@ void Stepper::powerOff() {
 
 /******************************************************************************/
 
-void IRAM_ATTR Stepper::onTimer(void* arg) {
-  // This is to work around the error that ISO C++ forbids taking the address of
-  // an unqualified or parenthesized non-static member function to form a pointer
-  // to member function.
-  Stepper* pObj = (Stepper*) arg;
-  pObj->doStep();
+void IRAM_ATTR Stepper::onTimer() {
+  uint32_t begin = ESP.getCycleCount();
+  portENTER_CRITICAL_ISR(&mux);
+
+  if (++subtick == STEPPER_TICKRATE / STEPPER_RAMPRATE)
+    subtick = 0;
+  if (rampCount < rampLength && subtick == 0) {
+    rampCount++;
+    // the fraction of the ramp that has been completed, with 16 fractional bits
+    int64_t u = (rampCount << 16) / rampLength;
+    int64_t s = (rampProfile == RAMP_SCURVE ? (3 * u * u - ((2 * u * u * u) >> 16)) >> 16 : u);
+    for (unsigned int i = 0; i < count; i++) {
+      Stepper *m = instance[i];
+      m->setVelocity(m->start + ((((int64_t)m->target - m->start) * s) >> 16));
+    }
+  }
+
+  for (unsigned int i = 0; i < count; i++)
+    instance[i]->doStep();
+
+  portEXIT_CRITICAL_ISR(&mux);
+  uint32_t elapsed = ESP.getCycleCount() - begin;
+  maxCycles = (elapsed > maxCycles ? elapsed : maxCycles);
+}
+
+/******************************************************************************/
+
+void IRAM_ATTR Stepper::setVelocity(int32_t value) {
+  velocity = value;
+  direction = (value > 0 ? +1 : (value < 0 ? -1 : 0));
+  increment = (value < 0 ? -value : value);
 }
 
 /******************************************************************************/
 
 void IRAM_ATTR Stepper::doStep() {
-  if (power) {
-    digitalWrite(in1, bitRead(halfstep[step], 0));
-    digitalWrite(in2, bitRead(halfstep[step], 1));
-    digitalWrite(in3, bitRead(halfstep[step], 2));
-    digitalWrite(in4, bitRead(halfstep[step], 3));
-
-    // increment or decrement, depending on the direction
-    step += direction;
-
-    // wrap between 0 and 7
-    if (step < 0)
-      step = 7;
-    else if (step > 7)
-      step = 0;
-  }
-  else {
-    digitalWrite(in1, 0);
-    digitalWrite(in2, 0);
-    digitalWrite(in3, 0);
-    digitalWrite(in4, 0);
+  if (!power && increment == 0) {
+    // switch the coils off only once, and not before the motor has slowed down to a stop
+    if (energized) {
+      digitalWrite(in1, 0);
+      digitalWrite(in2, 0);
+      digitalWrite(in3, 0);
+      digitalWrite(in4, 0);
+      energized = false;
+    }
+    return;
   }
+
+  // the accumulator keeps its phase when the speed changes
+  uint32_t previous = accumulator;
+  accumulator += increment;
+  if (accumulator >= previous && energized)
+    return;  // no overflow, hence no step
+
+  digitalWrite(in1, bitRead(halfstep[step], 0));
+  digitalWrite(in2, bitRead(halfstep[step], 1));
+  digitalWrite(in3, bitRead(halfstep[step], 2));
+  digitalWrite(in4, bitRead(halfstep[step], 3));
+  energized = true;
+
+  // increment or decrement, depending on the direction
+  step += direction;
+  position += direction;
+
+  // wrap between 0 and 7
+  if (step < 0)
+    step = 7;
+  else if (step > 7)
+    step = 0;
 }
@@ -3,25 +3,63 @@
 
 #include <Arduino.h>
 
+#define STEPPER_MAX      4       // maximum number of stepper motors
+#define STEPPER_TICKRATE 20000   // in Hz, the rate of the timer interrupt that generates the steps
+#define STEPPER_RAMPRATE 1000    // in Hz, the rate at which the speed is updated during a ramp
+
+#define RAMP_NONE        0       // change the speed at once
+#define RAMP_TRAPEZOID   1       // change the speed with a constant acceleration
+#define RAMP_SCURVE      2       // change the speed with a limited acceleration and jerk
+
 class Stepper {
   public:
     Stepper();
     void begin(unsigned int in1, int in2, int in3, int in4);
-    void spin(int speed);
+    void spin(int speed);        // the new speed takes effect on the next update
     void powerOn();
     void powerOff();
 
+    // apply the new speed of all stepper motors at the same tick, the acceleration is in
+    // steps per second^2 and the jerk in steps per second^3
+    static void update(int profile = RAMP_NONE, float acceleration = 0, float jerk = 0);
+    static uint32_t cycles();    // the largest number of CPU cycles spent in the timer interrupt
+    static void steps(int32_t *value);  // the number of half-steps made by each motor, read at the same tick
+
   private:
-    unsigned int frequency = 10000000;
+    unsigned int frequency = 1000000;
     unsigned int halfstep[8] = {0b1000, 0b1100, 0b0100, 0b0110, 0b0010, 0b0011, 0b0001, 0b1001};  // half-step drive
     unsigned int in1, in2, in3, in4;  // the ESP32 pins connected to the ULN2003 driver board
     int step = 0;                     // from 0 to 7, wraps around
-    int direction = 1;                // +1 or -1
+    int direction = 0;                // +1, -1 or 0
+    int32_t position = 0;             // in half-steps, wraps around but the difference remains valid
     bool power = true;                // true or false
-    hw_timer_t *timer = NULL;
+    bool energized = false;           // whether the coils are currently energized
+
+    // each motor has a phase accumulator, it makes a half-step whenever the accumulator overflows
+    uint32_t increment = 0;           // added to the accumulator on every tick
+    uint32_t accumulator = 0;
+
+    // the velocity is signed and expressed as the increment of the accumulator
+    int32_t velocity = 0;             // the current velocity
+    int32_t start = 0;                // the velocity at the start of the ramp
+    int32_t target = 0;               // the velocity at the end of the ramp
+    int32_t nextVelocity = 0;         // this is applied on the next update
+
+    static Stepper *instance[STEPPER_MAX];
+    static unsigned int count;
+    static hw_timer_t *timer;
+    static portMUX_TYPE mux;
+
+    // the ramp is shared by all motors, so that they speed up and slow down together
+    static int rampProfile;
+    static uint32_t rampLength;       // in ramp updates
+    static uint32_t rampCount;
+    static unsigned int subtick;
+    static uint32_t maxCycles;
 
-    static void IRAM_ATTR onTimer(void* arg);   // this calls doStep
-    void IRAM_ATTR doStep();                    // this implements the actual stepping
+    static void IRAM_ATTR onTimer();  // this calls doStep for all stepper motors
+    void IRAM_ATTR setVelocity(int32_t);
+    void IRAM_ATTR doStep();          // this implements the actual stepping
 };
 
 #endif // _STEPPER_H_
@@ -0,0 +1,42 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <stdio.h>
+#include <math.h>
+
+// each test program counts the failed checks and returns a non-zero exit code when there are any
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      failures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQUAL(a, b) do { \
+    long long _a = (a), _b = (b); \
+    if (_a != _b) { \
+      printf("%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+      failures++; \
+    } \
+  } while (0)
+
+#define CHECK_CLOSE(a, b, tol) do { \
+    double _a = (a), _b = (b); \
+    if (!(fabs(_a - _b) <= (tol))) { \
+      printf("%s:%d: check failed: %s == %s (%g != %g)\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+      failures++; \
+    } \
+  } while (0)
+
+static int report(const char *name) {
+  if (failures)
+    printf("%s: %d checks failed\n", name, failures);
+  else
+    printf("%s: ok\n", name);
+  return (failures ? 1 : 0);
+}
+
+#endif // _CHECK_H_
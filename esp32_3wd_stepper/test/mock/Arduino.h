@@ -0,0 +1,141 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the ESP32 Arduino core for the host tests, it
+// only provides what the modules of this sketch use. The hardware timer is not
+// running by itself, mockTick() calls its interrupt and advances the time.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define IRAM_ATTR
+
+typedef uint8_t byte;
+#define OUTPUT 0x03
+#define LOW    0
+#define HIGH   1
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define PI M_PI
+
+extern uint32_t mockMicros;
+extern uint8_t mockPin[40];
+
+inline uint32_t micros() { return mockMicros; }
+inline uint32_t millis() { return mockMicros / 1000; }
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) { mockPin[pin] = value; }
+inline int digitalRead(uint8_t pin) { return mockPin[pin]; }
+
+// the Arduino String class, with only the methods that the modules use
+
+class String {
+ public:
+  String(const char *str = "") : s(str) {}
+  String(const std::string &str) : s(str) {}
+  String(char c) : s(1, c) {}
+  String(int value) : s(std::to_string(value)) {}
+  const char *c_str() const { return s.c_str(); }
+  unsigned int length() const { return s.size(); }
+  bool startsWith(const String &str) const { return s.compare(0, str.s.size(), str.s) == 0; }
+  bool endsWith(const String &str) const { return s.size() >= str.s.size() && s.compare(s.size() - str.s.size(), str.s.size(), str.s) == 0; }
+  String substring(unsigned int from) const { return String(from < s.size() ? s.substr(from) : std::string()); }
+  String substring(unsigned int from, unsigned int to) const { return String(from < to && from < s.size() ? s.substr(from, to - from) : std::string()); }
+  long toInt() const { return atol(s.c_str()); }
+  void trim() {
+    size_t first = s.find_first_not_of(" \t\r\n");
+    size_t last = s.find_last_not_of(" \t\r\n");
+    s = (first == std::string::npos ? std::string() : s.substr(first, last - first + 1));
+  }
+  String &operator+=(const String &str) { s += str.s; return *this; }
+  String &operator+=(char c) { s += c; return *this; }
+  friend String operator+(const String &a, const String &b) { return String(a.s + b.s); }
+  bool operator==(const String &str) const { return s == str.s; }
+ private:
+  std::string s;
+};
+
+// the serial output is printed on the console when mockVerbose is set, otherwise it is discarded
+
+extern bool mockVerbose;
+
+class MockSerial {
+ public:
+  void print(const String &str) { if (mockVerbose) fputs(str.c_str(), stdout); }
+  void print(const char *str) { if (mockVerbose) fputs(str, stdout); }
+  void print(char c) { if (mockVerbose) putchar(c); }
+  void print(int value) { if (mockVerbose) ::printf("%d", value); }
+  void print(long value) { if (mockVerbose) ::printf("%ld", value); }
+  void print(unsigned int value) { if (mockVerbose) ::printf("%u", value); }
+  void print(unsigned long value) { if (mockVerbose) ::printf("%lu", value); }
+  void print(double value) { if (mockVerbose) ::printf("%.2f", value); }
+  template <typename T> void println(T value) { print(value); print('\n'); }
+  void println() { print('\n'); }
+  template <typename... T> void printf(const char *format, T... args) { if (mockVerbose) ::printf(format, args...); }
+};
+
+extern MockSerial Serial;
+
+typedef struct {
+  int depth;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((mux)->depth++)
+#define portEXIT_CRITICAL(mux) ((mux)->depth--)
+#define portENTER_CRITICAL_ISR(mux) ((mux)->depth++)
+#define portEXIT_CRITICAL_ISR(mux) ((mux)->depth--)
+
+typedef struct {
+  uint32_t frequency;
+  uint64_t alarm;
+  void (*isr)(void);
+} hw_timer_t;
+
+extern hw_timer_t mockTimer;
+
+inline hw_timer_t *timerBegin(uint32_t frequency) {
+  mockTimer.frequency = frequency;
+  return &mockTimer;
+}
+
+inline void timerAttachInterrupt(hw_timer_t *timer, void (*isr)(void)) {
+  timer->isr = isr;
+}
+
+inline void timerAlarm(hw_timer_t *timer, uint64_t alarm, bool, uint64_t) {
+  timer->alarm = alarm;
+}
+
+// call the timer interrupt the given number of times, the time advances accordingly
+inline void mockTick(unsigned long ticks = 1) {
+  for (unsigned long k = 0; k < ticks; k++) {
+    mockTimer.isr();
+    mockMicros += mockTimer.alarm * 1000000 / mockTimer.frequency;
+  }
+}
+
+// the cycle counter of the CPU is replaced by the process time in nanoseconds on this computer
+class MockESP {
+ public:
+  uint32_t getCycleCount() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+  }
+};
+
+extern MockESP ESP;
+
+#endif // _ARDUINO_H_
@@ -0,0 +1,9 @@
+#ifndef _ARDUINOJSON_H_
+#define _ARDUINOJSON_H_
+
+// The configuration is set by the test, the JSON library is not used.
+
+#define ARDUINOJSON_VERSION       "7.0.0"
+#define ARDUINOJSON_VERSION_MAJOR 7
+
+#endif // _ARDUINOJSON_H_
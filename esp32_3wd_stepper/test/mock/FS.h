@@ -0,0 +1,83 @@
+#ifndef _FS_H_
+#define _FS_H_
+
+// This replaces the file system with files in memory, the test can put files in it and
+// inspect them. A directory is listed by iterating over all files.
+
+#include <map>
+#include <string>
+#include <Arduino.h>
+
+extern std::map<std::string, std::string> mockFiles;
+
+class File {
+ public:
+  File() : path(), position(0), valid(false), directory(false) {}
+  File(const std::string &p, bool d) : path(p), position(0), valid(true), directory(d) {}
+
+  operator bool() const { return valid; }
+  const char *name() const { return path.c_str(); }
+  void close() { valid = false; }
+
+  int available() {
+    return valid && !directory ? mockFiles[path].size() - position : 0;
+  }
+
+  int read() {
+    return (available() > 0 ? (uint8_t)mockFiles[path][position++] : -1);
+  }
+
+  size_t read(uint8_t *buffer, size_t length) {
+    size_t n = min<size_t>(length, available());
+    memcpy(buffer, mockFiles[path].data() + position, n);
+    position += n;
+    return n;
+  }
+
+  size_t readBytesUntil(char terminator, char *buffer, size_t length) {
+    size_t n = 0;
+    while (n < length && available() > 0) {
+      char c = read();
+      if (c == terminator)
+        break;
+      buffer[n++] = c;
+    }
+    return n;
+  }
+
+  String readStringUntil(char terminator) {
+    String str;
+    while (available() > 0) {
+      char c = read();
+      if (c == terminator)
+        break;
+      str += c;
+    }
+    return str;
+  }
+
+  size_t write(const uint8_t *buffer, size_t length) {
+    mockFiles[path].append((const char *)buffer, length);
+    return length;
+  }
+
+  size_t print(const String &str) {
+    return write((const uint8_t *)str.c_str(), str.length());
+  }
+
+  File openNextFile() {
+    // the files are listed after the one that was returned previously
+    std::map<std::string, std::string>::iterator it = (next.empty() ? mockFiles.begin() : mockFiles.upper_bound(next));
+    if (it == mockFiles.end())
+      return File();
+    next = it->first;
+    return File(it->first, false);
+  }
+
+ private:
+  std::string path, next;
+  size_t position;
+  bool valid, directory;
+};
+
+#endif // _FS_H_
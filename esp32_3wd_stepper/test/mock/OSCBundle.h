@@ -0,0 +1,20 @@
+#ifndef _OSCBUNDLE_H_
+#define _OSCBUNDLE_H_
+
+#include <OSCMessage.h>
+
+class OSCBundle {
+ public:
+  OSCBundle &add(const OSCMessage &msg) { message.push_back(msg); return *this; }
+  int size() { return message.size(); }
+  OSCMessage *getOSCMessage(int i) { return &message[i]; }
+
+  void fill(uint8_t) {}
+  bool hasError() { return false; }
+  OSCErrorCode getError() { return 0; }
+
+ private:
+  std::vector<OSCMessage> message;
+};
+
+#endif // _OSCBUNDLE_H_
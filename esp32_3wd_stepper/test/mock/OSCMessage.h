@@ -0,0 +1,59 @@
+#ifndef _OSCMESSAGE_H_
+#define _OSCMESSAGE_H_
+
+// This replaces the CNMAT OSC library with messages that are made by the test, rather
+// than decoded from the bytes of a packet. The arguments can be integers, floats or strings.
+
+#include <string>
+#include <vector>
+#include <Arduino.h>
+
+typedef int OSCErrorCode;
+
+class OSCMessage {
+ public:
+  OSCMessage(const char *address = "") : address(address) {}
+
+  OSCMessage &add(int value) { arg.push_back(Arg('i', value, 0, "")); return *this; }
+  OSCMessage &add(float value) { arg.push_back(Arg('f', 0, value, "")); return *this; }
+  OSCMessage &add(const char *value) { arg.push_back(Arg('s', 0, 0, value)); return *this; }
+
+  int getAddress(char *buffer, int offset, int length) {
+    strncpy(buffer, address.c_str() + offset, length);
+    return strlen(buffer);
+  }
+  const char *getAddress() { return address.c_str(); }
+
+  int size() { return arg.size(); }
+  bool isInt(int i) { return type(i) == 'i'; }
+  bool isFloat(int i) { return type(i) == 'f'; }
+  bool isString(int i) { return type(i) == 's'; }
+  bool isDouble(int) { return false; }
+  bool isBoolean(int) { return false; }
+  double getDouble(int) { return 0; }
+  bool getBoolean(int) { return false; }
+
+  // like the library, an integer and a float are not converted into each other
+  int32_t getInt(int i) { return isInt(i) ? arg[i].i : 0; }
+  float getFloat(int i) { return isFloat(i) ? arg[i].f : 0; }
+  int getString(int i, char *buffer) { strcpy(buffer, isString(i) ? arg[i].s.c_str() : ""); return strlen(buffer); }
+
+  void fill(uint8_t) {}
+  bool hasError() { return false; }
+  OSCErrorCode getError() { return 0; }
+
+ private:
+  struct Arg {
+    char type;
+    int32_t i;
+    float f;
+    std::string s;
+    Arg(char t, int32_t i, float f, const char *s) : type(t), i(i), f(f), s(s) {}
+  };
+  std::string address;
+  std::vector<Arg> arg;
+
+  char type(int i) { return (i >= 0 && i < (int)arg.size() ? arg[i].type : 0); }
+};
+
+#endif // _OSCMESSAGE_H_
@@ -0,0 +1,33 @@
+#ifndef _SPIFFS_H_
+#define _SPIFFS_H_
+
+#include <FS.h>
+
+class MockSPIFFS {
+ public:
+  bool mounted = true;
+
+  bool begin(bool formatOnFail = false) {
+    return mounted;
+  }
+
+  void end() {}
+
+  bool exists(const String &path) {
+    return mockFiles.count(path.c_str()) > 0;
+  }
+
+  File open(const String &path, const char *mode = "r") {
+    if (path == "/")
+      return File("/", true);
+    if (mode[0] == 'w')
+      mockFiles[path.c_str()].clear();
+    else if (!exists(path))
+      return File();
+    return File(path.c_str(), false);
+  }
+};
+
+extern MockSPIFFS SPIFFS;
+
+#endif // _SPIFFS_H_
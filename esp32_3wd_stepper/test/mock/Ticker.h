@@ -0,0 +1,14 @@
+#ifndef _TICKER_H_
+#define _TICKER_H_
+
+// The blinking of the LED is not simulated.
+
+#include <Arduino.h>
+
+class Ticker {
+ public:
+  void attach_ms(uint32_t, void (*)(void)) {}
+  void detach() {}
+};
+
+#endif // _TICKER_H_
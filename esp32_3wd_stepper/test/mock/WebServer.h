@@ -0,0 +1,10 @@
+#ifndef _WEBSERVER_H_
+#define _WEBSERVER_H_
+
+// The web interface is not simulated, this only provides the declarations that the modules need.
+
+#include <Arduino.h>
+
+class WebServer {};
+
+#endif // _WEBSERVER_H_
@@ -0,0 +1,8 @@
+#ifndef _WIFI_H_
+#define _WIFI_H_
+
+// The network is not simulated, this only provides the declarations that the modules need.
+
+#include <Arduino.h>
+
+#endif // _WIFI_H_
@@ -0,0 +1,184 @@
+// Host test of the OSC address tree and the pattern matching, with a benchmark against
+// matching the address of every message with every address in turn
+
+#include "check.h"
+#include "oscdispatch.h"
+
+uint32_t mockMicros = 0;
+bool mockVerbose = false;
+MockSerial Serial;
+
+// the addresses of the sketch, each callback records its number
+static const char *table[] = {
+  "/*", "/*/*", "/*/*/*", "/route/*", "/pause", "/resume", "/stop", "/reset",
+  "/adjust/x", "/adjust/y", "/adjust/a", "/manual/x", "/manual/y", "/manual/a", "/manual/xy/1", "/accxyz"
+};
+#define TABLESIZE (int)(sizeof(table) / sizeof(table[0]))
+
+static std::vector<int> called;
+
+template <int N> void callback(OSCMessage &) {
+  called.push_back(N);
+}
+
+static const osc_callback_t callbacks[TABLESIZE] = {
+  callback<0>, callback<1>, callback<2>, callback<3>, callback<4>, callback<5>, callback<6>, callback<7>,
+  callback<8>, callback<9>, callback<10>, callback<11>, callback<12>, callback<13>, callback<14>, callback<15>
+};
+
+// dispatch a message and return the callbacks that were called, as a string of their numbers
+static std::string dispatch(const char *address) {
+  called.clear();
+  OSCMessage msg(address);
+  int count = oscDispatch(msg);
+  CHECK_EQUAL(count, called.size());
+  std::string str;
+  for (size_t i = 0; i < called.size(); i++)
+    str += (i ? " " : "") + std::to_string(called[i]);
+  return str;
+}
+
+static void testMatch() {
+  CHECK(oscMatch("foo", "foo"));
+  CHECK(!oscMatch("foo", "fo"));
+  CHECK(!oscMatch("fo", "foo"));
+  CHECK(oscMatch("", ""));
+
+  CHECK(oscMatch("?", "a"));
+  CHECK(!oscMatch("?", ""));
+  CHECK(oscMatch("f??", "foo"));
+  CHECK(!oscMatch("f??", "fo"));
+
+  CHECK(oscMatch("*", ""));
+  CHECK(oscMatch("*", "anything"));
+  CHECK(oscMatch("f*", "foo"));
+  CHECK(oscMatch("*o", "foo"));
+  CHECK(oscMatch("a*b*c", "aXXbYYc"));
+  CHECK(oscMatch("a*b*c", "abc"));
+  CHECK(!oscMatch("a*b*c", "aXXbYY"));
+  CHECK(oscMatch("a**c", "abc"));
+  CHECK(oscMatch("*?", "a"));
+  CHECK(!oscMatch("*?", ""));
+
+  CHECK(oscMatch("[abc]", "b"));
+  CHECK(!oscMatch("[abc]", "d"));
+  CHECK(!oscMatch("[abc]", ""));
+  CHECK(oscMatch("[a-z]9", "q9"));
+  CHECK(!oscMatch("[a-z]9", "Q9"));
+  CHECK(oscMatch("[!abc]", "d"));
+  CHECK(!oscMatch("[!abc]", "a"));
+  CHECK(oscMatch("[!0-9]x", "ax"));
+  CHECK(oscMatch("[a-]", "-"));
+  CHECK(oscMatch("[xy]/", "x/"));
+
+  CHECK(oscMatch("{foo,bar}", "foo"));
+  CHECK(oscMatch("{foo,bar}", "bar"));
+  CHECK(!oscMatch("{foo,bar}", "baz"));
+  CHECK(oscMatch("x{foo,bar}y", "xbary"));
+  CHECK(!oscMatch("x{foo,bar}y", "xbar"));
+  CHECK(oscMatch("{a,ab}c", "abc"));
+  CHECK(oscMatch("{,x}y", "y"));
+  CHECK(!oscMatch("{foo,bar", "foo"));
+  CHECK(oscMatch("{foo,bar}*[0-9]", "barista7"));
+}
+
+static void testAdd() {
+  for (int i = 0; i < TABLESIZE; i++)
+    CHECK(oscAdd(table[i], callbacks[i]));
+
+  // the parts of an address are limited in length
+  CHECK(!oscAdd("/abcdefghijklmnop", callbacks[0]));
+  CHECK(oscAdd("/abcdefghijklmno", callbacks[0]));
+}
+
+static void testDispatch() {
+  // the print callbacks are called before the others, in the order in which they were added
+  CHECK(dispatch("/pause") == "0 4");
+  CHECK(dispatch("/manual/x") == "1 11");
+  CHECK(dispatch("/manual/xy/1") == "2 14");
+  CHECK(dispatch("/route/12") == "1 3");
+  CHECK(dispatch("/route") == "0");
+  CHECK(dispatch("/route/12/x") == "2");
+  CHECK(dispatch("/unknown") == "0");
+  CHECK(dispatch("/manual/z") == "1");
+
+  // the address should match completely
+  CHECK(dispatch("/paus") == "0");
+  CHECK(dispatch("/pauses") == "0");
+  CHECK(dispatch("/adjust/xx") == "1");
+  CHECK(dispatch("") == "");
+  CHECK(dispatch("pause") == "");
+
+  // an incoming address can contain a pattern, which can match several addresses
+  CHECK(dispatch("/manual/[xy]") == "1 11 12");
+  CHECK(dispatch("/adjust/?") == "1 8 9 10");
+  CHECK(dispatch("/{pause,resume}") == "0 4 5");
+  CHECK(dispatch("/manual/*") == "1 11 12 13");
+
+  // where both parts are patterns, the one in the tree is matched against the one in the message
+  CHECK(dispatch("/*/x") == "1 3 8 11");
+  CHECK(dispatch("/[!m]*/a") == "1 3 10");
+
+  // an address with more parts than the tree is deep does not match anything
+  CHECK(dispatch("/a/b/c/d/e/f/g/h") == "");
+  CHECK(dispatch("/a/b/c/d/e/f/g/h/i") == "");
+
+  // a bundle is dispatched message by message
+  OSCBundle bundle;
+  bundle.add(OSCMessage("/pause")).add(OSCMessage("/resume")).add(OSCMessage("/nothing/here/either/deep"));
+  called.clear();
+  CHECK_EQUAL(oscDispatch(bundle), 4);
+  CHECK_EQUAL(called.size(), 4);
+}
+
+// match a complete address against a pattern part by part, like the chain of dispatch calls did
+static bool chainMatch(const char *pattern, const char *address) {
+  char p[OSC_MAXADDRESS] = {0}, a[OSC_MAXADDRESS] = {0};
+  strncpy(p, pattern, sizeof(p) - 1);
+  strncpy(a, address, sizeof(a) - 1);
+  char *ps = NULL, *as = NULL;
+  char *pp = strtok_r(p, "/", &ps), *ap = strtok_r(a, "/", &as);
+  while (pp && ap) {
+    if (!oscMatch(pp, ap))
+      return false;
+    pp = strtok_r(NULL, "/", &ps);
+    ap = strtok_r(NULL, "/", &as);
+  }
+  return (pp == NULL && ap == NULL);
+}
+
+static void benchmark() {
+  static const char *address[] = {"/manual/x", "/manual/xy/1", "/accxyz", "/route/3", "/pause", "/unknown/address"};
+  const int repeat = 200000;
+  OSCMessage msg[6] = {address[0], address[1], address[2], address[3], address[4], address[5]};
+
+  clock_t start = clock();
+  int count = 0;
+  for (int k = 0; k < repeat; k++)
+    for (int i = 0; i < 6; i++)
+      for (int j = 0; j < TABLESIZE; j++)
+        count += chainMatch(table[j], address[i]);
+  double chain = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  called.reserve(16);
+  start = clock();
+  int tree = 0;
+  for (int k = 0; k < repeat; k++)
+    for (int i = 0; i < 6; i++) {
+      called.clear();
+      tree += oscDispatch(msg[i]);
+    }
+  double dispatched = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  CHECK_EQUAL(count, tree);
+  printf("messages per second on this computer: %.0f with the address tree, %.0f with the chain of matches\n", 6 * repeat / dispatched, 6 * repeat / chain);
+  CHECK(dispatched < chain);
+}
+
+int main() {
+  testMatch();
+  testAdd();
+  testDispatch();
+  benchmark();
+  return report("test_oscdispatch");
+}
@@ -0,0 +1,341 @@
+// Host simulation of the platform, the OSC logs in routes/ are replayed against the motion
+// code of the sketch while the timer interrupt of the wheels runs tick by tick
+//
+// The actual pose of the platform is integrated from the steps that the wheels made, and
+// compared to the intended path: the waypoints connected by straight lines, the spline
+// through them, or the speed that is set manually. The time that the control cycle of the
+// main loop takes is measured on this computer, only as a relative measure.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "motion.h"
+#include "waypoints.h"
+#include "kinematics.h"
+#include "parseosc.h"
+#include "oscdispatch.h"
+#include "webinterface.h"
+
+uint32_t mockMicros = 0;
+uint8_t mockPin[40];
+hw_timer_t mockTimer;
+bool mockVerbose = false;
+MockSerial Serial;
+MockESP ESP;
+MockSPIFFS SPIFFS;
+std::map<std::string, std::string> mockFiles;
+
+Config config;
+WiFiUDP Udp;
+
+#define CONTROL 5   // in ms, the period of the control cycle in the main loop
+#define SETTLE  2   // in s, the time after the log to let the platform come to rest
+
+struct Pose {
+  double x, y, a;
+};
+
+// a line of the OSC log, the time is in ms since the start of the log
+struct Event {
+  unsigned long time;
+  OSCMessage msg;
+};
+
+struct Scenario {
+  const char *name;
+  const char *log;
+  int profile;
+  int smooth;
+  unsigned long duration;   // in s
+  double maxError;          // in mm, largest distance to the intended path
+  double finalError;        // in mm, distance at the end
+  double angleError;        // in degrees, largest difference with the intended angle
+};
+
+// the limits are about twice the errors that the sketch reaches, a ramp lags behind at the corners
+static const Scenario scenario[] = {
+  {"square",           "routes/square.osc", RAMP_NONE,      0, 26, 0.5, 0.5, 0.5},
+  {"square trapezoid", "routes/square.osc", RAMP_TRAPEZOID, 0, 26,  15, 0.5,   8},
+  {"square s-curve",   "routes/square.osc", RAMP_SCURVE,    0, 26,  20,   1,  12},
+  {"square pause",     "routes/pause.osc",  RAMP_TRAPEZOID, 0, 29,  15, 0.5,   8},
+  {"circle",           "routes/circle.osc", RAMP_NONE,      1, 32,   1,   1, 0.5},
+  {"circle s-curve",   "routes/circle.osc", RAMP_SCURVE,    1, 32,   7,   1, 1.5},
+  {"manual",           "routes/manual.osc", RAMP_NONE,      0, 13, 0.5, 0.5, 0.5},
+  {"manual trapezoid", "routes/manual.osc", RAMP_TRAPEZOID, 0, 13,   7,   4,   6},
+};
+
+#define MAXODOMETRY 0.5   // in mm, difference between the position of the sketch and the actual position
+#define MAXCONTROL  50    // in us, the mean duration of the control cycle on this computer
+
+static Pose actual;                    // in the world, integrated from the steps of the wheels
+static Pose origin;                    // the pose in the world at which the position of the sketch is zero
+static Pose intended;                  // relative to the origin
+static int32_t previous[STEPPER_MAX];
+
+// the intended path follows the route from the time it starts, or the speed that is set manually
+static std::vector<Pose> route;
+static std::vector<float> route_t;
+static bool route_active = false, paused = false;
+static unsigned long route_start, paused_time, paused_start;
+static double manual_vx, manual_vy, manual_va;
+
+/********************************************************************************/
+
+static std::string readFile(const char *filename) {
+  std::string str;
+  FILE *fp = fopen(filename, "r");
+  if (fp) {
+    int c;
+    while ((c = fgetc(fp)) != EOF)
+      str += (char)c;
+    fclose(fp);
+  }
+  return str;
+}
+
+// copy the routes into the file system in memory and compile them, like the web interface does
+static void loadRoutes() {
+  char filename[64];
+  for (int n = 1; n < 10; n++) {
+    snprintf(filename, sizeof(filename), "routes/waypoints%d.csv", n);
+    std::string csv = readFile(filename);
+    if (csv.empty())
+      continue;
+    mockFiles[filename + 6] = csv;
+    CHECK(compileWaypoints(n));
+  }
+}
+
+// each line of the log contains the time in ms, the address and the arguments, numbers with a decimal point are floats
+static std::vector<Event> loadLog(const char *filename) {
+  std::vector<Event> log;
+  FILE *fp = fopen(filename, "r");
+  CHECK(fp != NULL);
+  if (!fp)
+    return log;
+  char line[256];
+  while (fgets(line, sizeof(line), fp)) {
+    char *p = strtok(line, " \t\r\n");
+    if (!p || *p == '#')
+      continue;
+    Event e;
+    e.time = strtoul(p, NULL, 10);
+    e.msg = OSCMessage(strtok(NULL, " \t\r\n"));
+    while ((p = strtok(NULL, " \t\r\n")))
+      if (strchr(p, '.'))
+        e.msg.add((float)atof(p));
+      else
+        e.msg.add(atoi(p));
+    log.push_back(e);
+  }
+  fclose(fp);
+  return log;
+}
+
+static void loadRoute(int n) {
+  char filename[64];
+  snprintf(filename, sizeof(filename), "routes/waypoints%d.csv", n);
+  route.assign(1, intended);
+  route_t.assign(1, 0);
+  FILE *fp = fopen(filename, "r");
+  float t, x, y, a;
+  while (fp && fscanf(fp, "%f,%f,%f,%f", &t, &x, &y, &a) == 4) {
+    Pose p = {x, y, a * M_PI / 180};
+    route.push_back(p);
+    route_t.push_back(t);
+  }
+  if (fp)
+    fclose(fp);
+}
+
+/********************************************************************************/
+
+// the pose in the world relative to the origin
+static Pose relative(const Pose &p) {
+  double dx = p.x - origin.x, dy = p.y - origin.y;
+  Pose r = {dx * cos(origin.a) + dy * sin(origin.a), -dx * sin(origin.a) + dy * cos(origin.a), p.a - origin.a};
+  return r;
+}
+
+// follow the OSC messages in the log that change the intended path, the sketch gets the same messages
+static void follow(OSCMessage &msg, unsigned long now) {
+  const char *address = msg.getAddress();
+  if (strncmp(address, "/route/", 7) == 0 && msg.getInt(0)) {
+    if (!config.absolute) {
+      origin = actual;
+      intended.x = intended.y = intended.a = 0;
+    }
+    loadRoute(atoi(address + 7));
+    route_active = true;
+    paused = false;
+    route_start = now;
+    paused_time = 0;
+    manual_vx = manual_vy = manual_va = 0;
+  }
+  else if (strcmp(address, "/pause") == 0 && msg.getInt(0) && route_active && !paused) {
+    paused = true;
+    paused_start = now;
+  }
+  else if (strcmp(address, "/resume") == 0 && msg.getInt(0) && paused) {
+    paused = false;
+    paused_time += now - paused_start;
+  }
+  else if (strcmp(address, "/stop") == 0 && msg.getInt(0)) {
+    route_active = false;
+    manual_vx = manual_vy = manual_va = 0;
+  }
+  else if (strcmp(address, "/manual/x") == 0)
+    manual_vx = msg.getFloat(0);
+  else if (strcmp(address, "/manual/y") == 0)
+    manual_vy = msg.getFloat(0);
+  else if (strcmp(address, "/manual/a") == 0)
+    manual_va = msg.getFloat(0);
+  else if (strcmp(address, "/manual/xy/1") == 0) {
+    manual_vx = msg.getFloat(0);
+    manual_vy = msg.getFloat(1);
+  }
+  else if (strcmp(address, "/accxyz") == 0) {
+    manual_vx = msg.getFloat(0) * 0.03;
+    manual_vy = msg.getFloat(1) * 0.03;
+  }
+}
+
+// update the intended pose for the given time in ms
+static void intend(unsigned long now) {
+  if (!route_active) {
+    // the manual speed is applied with the same axes as the position of the sketch
+    intended.x += manual_vx * 0.001;
+    intended.y += manual_vy * 0.001;
+    intended.a += manual_va * 0.001;
+    return;
+  }
+  unsigned long elapsed = now - route_start - paused_time - (paused ? now - paused_start : 0);
+  float t = 0.001 * elapsed;
+  if (t >= route_t.back()) {
+    intended = route.back();
+    route_active = false;
+  }
+  else if (config.smooth) {
+    float x, y, a;
+    interpolateWaypoints(t, &x, &y, &a);
+    intended.x = x;
+    intended.y = y;
+    intended.a = a;
+  }
+  else {
+    // the waypoints are connected by straight lines
+    for (size_t i = 1; i < route.size(); i++)
+      if (t < route_t[i]) {
+        double f = (t - route_t[i - 1]) / (route_t[i] - route_t[i - 1]);
+        intended.x = route[i - 1].x + f * (route[i].x - route[i - 1].x);
+        intended.y = route[i - 1].y + f * (route[i].y - route[i - 1].y);
+        intended.a = route[i - 1].a + f * (route[i].a - route[i - 1].a);
+        break;
+      }
+  }
+}
+
+// integrate the steps that the wheels made since the previous call into the actual pose
+static void integrate() {
+  int32_t current[STEPPER_MAX];
+  Stepper::steps(current);
+  float dx, dy, da;
+  forwardKinematics(actual.a, 0.5 * (current[0] - previous[0]), 0.5 * (current[1] - previous[1]), 0.5 * (current[2] - previous[2]), &dx, &dy, &da);
+  actual.x += dx;
+  actual.y += dy;
+  actual.a += da;
+  memcpy(previous, current, sizeof(previous));
+}
+
+// one pass through the main loop, this returns the time it took in ns
+static uint32_t control() {
+  uint32_t start = ESP.getCycleCount();
+  updatePosition();
+  updateTarget();
+  updateSpeed();
+  updateWheels();
+  return ESP.getCycleCount() - start;
+}
+
+/********************************************************************************/
+
+static void simulate(const Scenario &s) {
+  config.profile = s.profile;
+  config.smooth = s.smooth;
+
+  // bring the platform to rest and start at the origin
+  stopRoute();
+  vx = vy = va = 0;
+  for (int k = 0; k < 2000 / CONTROL; k++) {
+    control();
+    mockTick(CONTROL * STEPPER_TICKRATE / 1000);
+  }
+  updatePosition();
+  resetRoute();
+  Stepper::steps(previous);
+  actual.x = actual.y = actual.a = 0;
+  origin = intended = actual;
+  route_active = paused = false;
+  manual_vx = manual_vy = manual_va = 0;
+
+  std::vector<Event> log = loadLog(s.log);
+  size_t next = 0;
+  unsigned long start = millis();
+  unsigned long cycles = 0;
+  double maxError = 0, sumError = 0, finalError = 0, angleError = 0, odometry = 0, cost = 0, maxCost = 0;
+
+  for (unsigned long t = 0; t < 1000 * (s.duration + SETTLE); t++) {
+    while (next < log.size() && log[next].time <= t) {
+      oscDispatch(log[next].msg);
+      follow(log[next].msg, millis() - start);
+      next++;
+    }
+    if (t % CONTROL == 0) {
+      double elapsed = control() * 1e-3;   // in us
+      cost += elapsed;
+      maxCost = max(maxCost, elapsed);
+      cycles++;
+    }
+    mockTick(STEPPER_TICKRATE / 1000);
+    integrate();
+    intend(millis() - start);
+
+    Pose p = relative(actual);
+    double error = 1000 * sqrt((p.x - intended.x) * (p.x - intended.x) + (p.y - intended.y) * (p.y - intended.y));
+    maxError = max(maxError, error);
+    sumError += error * error;
+    finalError = error;
+    angleError = max(angleError, fabs(p.a - intended.a) * 180 / M_PI);
+    odometry = max(odometry, 1000 * sqrt((p.x - x) * (p.x - x) + (p.y - y) * (p.y - y)));
+  }
+  double rmsError = sqrt(sumError / (1000 * (s.duration + SETTLE)));
+
+  printf("%-18s error %4.1f mm max, %4.1f mm rms, %4.1f mm final, %4.1f deg, odometry %4.2f mm, control %5.2f us mean %6.2f us max\n",
+         s.name, maxError, rmsError, finalError, angleError, odometry, cost / cycles, maxCost);
+  CHECK(next == log.size());
+  CHECK(maxError < s.maxError);
+  CHECK(finalError < s.finalError);
+  CHECK(angleError < s.angleError);
+  CHECK(odometry < MAXODOMETRY);
+  CHECK(cost / cycles < MAXCONTROL);
+}
+
+int main() {
+  // the default settings, the profile and the smooth path are set by each scenario
+  config.warp = 1;
+  config.acceleration = 1024;
+  config.jerk = 8192;
+  config.maxspeed = 512;
+  loadRoutes();
+  setupOSC();
+  mockMicros = 1000000;
+  wheel1.begin(14, 27, 26, 25);
+  wheel2.begin(13, 15, 2, 4);
+  wheel3.begin(16, 17, 5, 18);
+
+  for (size_t i = 0; i < sizeof(scenario) / sizeof(scenario[0]); i++)
+    simulate(scenario[i]);
+  printf("the timer interrupt took at most %.2f us on this computer\n", Stepper::cycles() * 1e-3);
+  return report("test_simulator");
+}
@@ -0,0 +1,311 @@
+// Host test of the step generation of all wheels from a single timer, the step counts
+// and the phase coherence of the wheels are checked against the ideal step streams, and
+// the speed profiles of the ramps are measured from the steps
+
+#include "check.h"
+#include "stepper.h"
+
+uint32_t mockMicros = 0;
+uint8_t mockPin[40];
+hw_timer_t mockTimer;
+MockESP ESP;
+
+static Stepper wheel[3];
+static const unsigned int pin[3][4] = {{14, 27, 26, 25}, {13, 15, 2, 4}, {16, 17, 5, 18}};
+
+// the number of half-steps made by each wheel since the previous call
+static int32_t previous[STEPPER_MAX];
+static void delta(int32_t *value) {
+  int32_t current[STEPPER_MAX];
+  Stepper::steps(current);
+  for (int i = 0; i < 3; i++) {
+    value[i] = current[i] - previous[i];
+    previous[i] = current[i];
+  }
+}
+
+// set the speed of the three wheels in steps per second, and run until they have the new speed
+static void spin(int s1, int s2, int s3, int profile = RAMP_NONE, float acceleration = 0, float jerk = 0) {
+  wheel[0].spin(s1);
+  wheel[1].spin(s2);
+  wheel[2].spin(s3);
+  Stepper::update(profile, acceleration, jerk);
+}
+
+// the coils that are energized, as in the half-step table
+static unsigned int coils(int w) {
+  return mockPin[pin[w][0]] | (mockPin[pin[w][1]] << 1) | (mockPin[pin[w][2]] << 2) | (mockPin[pin[w][3]] << 3);
+}
+
+static void testBegin() {
+  for (int i = 0; i < 3; i++)
+    wheel[i].begin(pin[i][0], pin[i][1], pin[i][2], pin[i][3]);
+
+  // a single timer is shared by all wheels
+  CHECK(mockTimer.isr != NULL);
+  CHECK_EQUAL(mockTimer.frequency / mockTimer.alarm, STEPPER_TICKRATE);
+
+  // the coils are energized at the first tick, also without moving
+  mockTick();
+  for (int i = 0; i < 3; i++)
+    CHECK_EQUAL(coils(i), 0b1000);
+  int32_t d[3];
+  delta(d);
+  CHECK_EQUAL(d[0] | d[1] | d[2], 0);
+}
+
+static void testSpeed() {
+  // the number of half-steps per second is twice the speed
+  static const int speed[][3] = {{100, -250, 512}, {1, 2, 3}, {999, -1000, 0}, {-37, 111, -74}};
+  for (int k = 0; k < 4; k++) {
+    spin(speed[k][0], speed[k][1], speed[k][2]);
+    int32_t d[3];
+    delta(d);
+    mockTick(STEPPER_TICKRATE);
+    delta(d);
+    for (int i = 0; i < 3; i++)
+      CHECK_CLOSE(d[i], 2 * speed[k][i], 1);
+  }
+
+  // the speed is limited to one half-step every other tick
+  spin(20000, -20000, 0);
+  int32_t d[3];
+  delta(d);
+  mockTick(STEPPER_TICKRATE);
+  delta(d);
+  CHECK_CLOSE(d[0], STEPPER_TICKRATE / 2, 1);
+  CHECK_CLOSE(d[1], -STEPPER_TICKRATE / 2, 1);
+}
+
+static void testCoherence() {
+  // the wheels stay in phase with the ideal step streams, none of them drifts over a long time
+  static const int speed[3] = {37, -111, 74};
+  spin(speed[0], speed[1], speed[2]);
+  mockTick();
+  int32_t start[STEPPER_MAX], current[STEPPER_MAX];
+  Stepper::steps(start);
+  double error = 0;
+  for (int t = 1; t <= 60 * STEPPER_TICKRATE; t++) {
+    mockTick();
+    if (t % 20 == 0) {
+      Stepper::steps(current);
+      for (int i = 0; i < 3; i++) {
+        double ideal = 2.0 * speed[i] * t / STEPPER_TICKRATE;
+        error = max(error, fabs(current[i] - start[i] - ideal));
+      }
+    }
+  }
+  printf("largest phase error over 60 seconds: %.2f half-steps\n", error);
+  CHECK(error <= 1);
+
+  // the ratio of the steps is exactly the ratio of the speeds
+  Stepper::steps(current);
+  CHECK_CLOSE((double)(current[1] - start[1]) / (current[0] - start[0]), (double)speed[1] / speed[0], 1e-3);
+  CHECK_CLOSE((double)(current[2] - start[2]) / (current[0] - start[0]), (double)speed[2] / speed[0], 1e-3);
+}
+
+static void testUpdate() {
+  // a new speed has no effect until it is applied to all wheels at once
+  spin(100, 100, 100);
+  int32_t d[3];
+  delta(d);
+  wheel[0].spin(300);
+  wheel[1].spin(-300);
+  wheel[2].spin(0);
+  mockTick(STEPPER_TICKRATE);
+  delta(d);
+  for (int i = 0; i < 3; i++)
+    CHECK_CLOSE(d[i], 200, 1);
+
+  // at the tick after the update all wheels have the new speed
+  Stepper::update();
+  mockTick(STEPPER_TICKRATE);
+  delta(d);
+  CHECK_CLOSE(d[0], 600, 1);
+  CHECK_CLOSE(d[1], -600, 1);
+  CHECK_EQUAL(d[2], 0);
+}
+
+static void testCoils() {
+  // the coils follow the half-step sequence, and go back through it in the other direction
+  static const unsigned int halfstep[8] = {0b1000, 0b1100, 0b0100, 0b0110, 0b0010, 0b0011, 0b0001, 0b1001};
+  spin(500, -500, 0);
+  int32_t d[3];
+  delta(d);
+  unsigned int last[2] = {coils(0), coils(1)};
+  int index[2] = {-1, -1};
+  for (int i = 0; i < 8; i++) {
+    if (halfstep[i] == last[0])
+      index[0] = i;
+    if (halfstep[i] == last[1])
+      index[1] = i;
+  }
+  CHECK(index[0] >= 0 && index[1] >= 0);
+  for (int t = 0; t < STEPPER_TICKRATE; t++) {
+    mockTick();
+    for (int w = 0; w < 2; w++) {
+      if (coils(w) != last[w]) {
+        index[w] = (index[w] + (w == 0 ? 1 : 7)) % 8;
+        CHECK_EQUAL(coils(w), halfstep[index[w]]);
+        last[w] = coils(w);
+      }
+    }
+  }
+
+  // the coils are switched off once the wheel stands still, and on again when it starts
+  for (int i = 0; i < 3; i++)
+    wheel[i].powerOff();
+  mockTick(10);
+  CHECK(coils(0) != 0);
+  spin(0, 0, 0);
+  mockTick(10);
+  CHECK_EQUAL(coils(0) | coils(1) | coils(2), 0);
+  for (int i = 0; i < 3; i++)
+    wheel[i].powerOn();
+  spin(100, 0, 0);
+  mockTick();
+  CHECK(coils(0) != 0);
+  CHECK(coils(1) != 0);
+}
+
+// measure the speed of each wheel in steps per second over the given number of ticks
+static void measure(unsigned int ticks, double *speed) {
+  int32_t d[3];
+  delta(d);
+  mockTick(ticks);
+  delta(d);
+  for (int i = 0; i < 3; i++)
+    speed[i] = 0.5 * d[i] * STEPPER_TICKRATE / ticks;
+}
+
+#define WINDOW 200   // in ticks, 10 ms
+
+// the integral of the linear ramp or the smoothstep from 0 to u
+static double integral(int profile, double u) {
+  return (profile == RAMP_SCURVE ? u * u * u - u * u * u * u / 2 : u * u / 2);
+}
+
+// follow a ramp from standstill to the given speed and compare the steps to those of the expected profile
+static void ramp(int profile, float acceleration, float jerk, double duration) {
+  static const int target[3] = {400, -400, 200};
+  spin(0, 0, 0);
+  mockTick(STEPPER_TICKRATE / 10);
+
+  // the ramp is updated in whole ms
+  duration = floor(duration * STEPPER_RAMPRATE) / STEPPER_RAMPRATE;
+
+  int32_t start[STEPPER_MAX], current[STEPPER_MAX];
+  Stepper::steps(start);
+  spin(target[0], target[1], target[2], profile, acceleration, jerk);
+  double error = 0;
+  for (int t = 1; t <= (duration + 0.2) * STEPPER_RAMPRATE; t++) {
+    mockTick(STEPPER_TICKRATE / STEPPER_RAMPRATE);
+    Stepper::steps(current);
+    double u = (double)t / STEPPER_RAMPRATE / duration;
+    double ideal = 2 * target[0] * duration * (u < 1 ? integral(profile, u) : integral(profile, 1) + u - 1);
+    error = max(error, fabs(current[0] - start[0] - ideal));
+
+    // all wheels change speed together, hence the platform keeps its direction
+    CHECK_CLOSE(current[1] - start[1], -(current[0] - start[0]), 2);
+    CHECK_CLOSE(current[2] - start[2], (current[0] - start[0]) / 2., 2);
+  }
+  printf("%s ramp of %.3f s: largest error %.1f half-steps\n", (profile == RAMP_SCURVE ? "S-curve" : "trapezoidal"), duration, error);
+  CHECK(error <= 2);
+
+  // after the ramp the speed is constant
+  double speed[3];
+  measure(STEPPER_TICKRATE, speed);
+  for (int i = 0; i < 3; i++)
+    CHECK_CLOSE(speed[i], target[i], 1);
+}
+
+static void testRamp() {
+  // the duration of the ramp follows from the acceleration and the largest change in speed
+  ramp(RAMP_TRAPEZOID, 800, 0, 400. / 800);
+  ramp(RAMP_SCURVE, 800, 8000, 1.5 * 400. / 800);
+  ramp(RAMP_SCURVE, 8000, 800, sqrt(6 * 400. / 800));
+
+  // without a profile, or without an acceleration, the speed changes at once
+  spin(0, 0, 0);
+  spin(400, -400, 200, RAMP_TRAPEZOID, 0);
+  double speed[3];
+  measure(WINDOW, speed);
+  CHECK_CLOSE(speed[0], 400, STEPPER_TICKRATE / WINDOW);
+
+  // slowing down is also ramped, the ramp starts at the current speed
+  spin(0, 0, 0, RAMP_TRAPEZOID, 800);
+  measure(STEPPER_TICKRATE / 4, speed);
+  CHECK_CLOSE(speed[0], 300, 2);
+  measure(STEPPER_TICKRATE / 4, speed);
+  CHECK_CLOSE(speed[0], 100, 2);
+  measure(STEPPER_TICKRATE / 4, speed);
+  CHECK_EQUAL(speed[0], 0);
+}
+
+static void testRestart() {
+  // a ramp that restarts with every control cycle still progresses, also when the control
+  // cycle is shorter than the ramp update of 1 ms
+  spin(0, 0, 0);
+  for (int k = 0; k < 2 * STEPPER_TICKRATE / 10; k++) {
+    spin(400 + k % 2, -400, 200, RAMP_TRAPEZOID, 800);
+    mockTick(10);
+  }
+  double speed[3];
+  measure(WINDOW, speed);
+  printf("speed after 2 seconds of restarted ramps: %.1f steps/s\n", speed[0]);
+  CHECK(speed[0] > 200);
+
+  // an S-curve that is restarted every 5 ms with a slightly different speed, like by the
+  // control of the route, does not start again with zero acceleration
+  spin(0, 0, 0);
+  for (int k = 0; k < 2 * 200; k++) {
+    spin(400 + k % 2, -400, 200, RAMP_SCURVE, 800, 8000);
+    mockTick(STEPPER_TICKRATE / 200);
+  }
+  measure(WINDOW, speed);
+  printf("speed after 2 seconds of restarted S-curves: %.1f steps/s\n", speed[0]);
+  CHECK(speed[0] > 350);
+
+  // an update without a new speed does not restart the ramp
+  spin(0, 0, 0);
+  spin(400, -400, 200, RAMP_TRAPEZOID, 800);
+  for (int k = 0; k < STEPPER_TICKRATE / 4; k++) {
+    Stepper::update(RAMP_TRAPEZOID, 800);
+    mockTick();
+  }
+  measure(WINDOW, speed);
+  CHECK_CLOSE(speed[0], 200, STEPPER_TICKRATE / WINDOW);
+}
+
+static void benchmark() {
+  // the time that the interrupt takes on this computer, only as a relative measure
+  spin(512, -512, 256);
+  Stepper::cycles();
+  clock_t start = clock();
+  mockTick(10 * STEPPER_TICKRATE);
+  printf("the timer interrupt takes %.1f ns on average on this computer, %u ns at most\n", 1e9 * (clock() - start) / CLOCKS_PER_SEC / (10 * STEPPER_TICKRATE), Stepper::cycles());
+
+  // during a ramp the speed is also updated once every ms
+  static const int profile[2] = {RAMP_TRAPEZOID, RAMP_SCURVE};
+  for (int k = 0; k < 2; k++) {
+    spin(0, 0, 0);
+    spin(512, -512, 256, profile[k], 10, 10);
+    Stepper::cycles();
+    start = clock();
+    mockTick(10 * STEPPER_TICKRATE);
+    printf("during a %s ramp it takes %.1f ns on average, %u ns at most\n", (profile[k] == RAMP_SCURVE ? "S-curve" : "trapezoidal"), 1e9 * (clock() - start) / CLOCKS_PER_SEC / (10 * STEPPER_TICKRATE), Stepper::cycles());
+  }
+  spin(0, 0, 0);
+}
+
+int main() {
+  testBegin();
+  testSpeed();
+  testCoherence();
+  testUpdate();
+  testCoils();
+  testRamp();
+  testRestart();
+  benchmark();
+  return report("test_stepper");
+}
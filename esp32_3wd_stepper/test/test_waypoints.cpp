@@ -0,0 +1,225 @@
+// Host test of the compilation of the waypoints into the binary file, and of the
+// Catmull-Rom interpolation between them, with a benchmark of the start of a route
+
+#include "check.h"
+#include "waypoints.h"
+
+uint32_t mockMicros = 0;
+bool mockVerbose = false;
+MockSerial Serial;
+MockSPIFFS SPIFFS;
+std::map<std::string, std::string> mockFiles;
+
+static void testCompile() {
+  mockFiles.clear();
+  mockFiles["/waypoints3.csv"] = "0,0,0,0\n1,0.5,0,90\n2.5,0.5,0.5,180\n";
+  CHECK(compileWaypoints(3));
+
+  // the binary file has a header of 8 bytes and 4 arrays of floats
+  CHECK(SPIFFS.exists("/waypoints3.bin"));
+  CHECK_EQUAL(mockFiles["/waypoints3.bin"].size(), 8 + 3 * 4 * sizeof(float));
+
+  // the first waypoint is reserved for the starting point, the angles are in radians
+  CHECK(readWaypoints(3));
+  CHECK_EQUAL(waypoints_n, 4);
+  CHECK_CLOSE(waypoints_t[3], 2.5, 1e-6);
+  CHECK_CLOSE(waypoints_x[2], 0.5, 1e-6);
+  CHECK_CLOSE(waypoints_y[3], 0.5, 1e-6);
+  CHECK_CLOSE(waypoints_a[2], M_PI / 2, 1e-6);
+
+  // a missing route cannot be read
+  CHECK(!compileWaypoints(4));
+  CHECK(!readWaypoints(4));
+
+  // the file system cannot be mounted
+  SPIFFS.mounted = false;
+  CHECK(!readWaypoints(3));
+  SPIFFS.mounted = true;
+}
+
+static void testSkip() {
+  // empty, incomplete and other lines that are not waypoints are skipped
+  mockFiles.clear();
+  mockFiles["/waypoints1.csv"] = "# time,x,y,theta\r\n\r\n0,0,0,0\r\n1,2,3\r\na,b,c,d\r\n2,1,-1,-45\r\n\n";
+  CHECK(readWaypoints(1));
+  CHECK_EQUAL(waypoints_n, 3);
+  CHECK_CLOSE(waypoints_t[2], 2, 1e-6);
+  CHECK_CLOSE(waypoints_a[2], -M_PI / 4, 1e-6);
+
+  // a line that is too long is skipped, and its remainder is not parsed as a new line
+  std::string longline = "5,1,1,1" + std::string(80, ' ') + ",6,7,8,9\n";
+  std::string fits = "3." + std::string(71, '0') + ",1,0,0\n";  // the longest line that fits in the buffer
+  CHECK_EQUAL(fits.size() - 1, 79);
+  mockFiles["/waypoints1.csv"] = "0,0,0,0\n" + longline + fits + longline;
+  CHECK(compileWaypoints(1));
+  CHECK(readWaypoints(1));
+  CHECK_EQUAL(waypoints_n, 3);
+  CHECK_CLOSE(waypoints_t[2], 3, 1e-6);
+  CHECK_CLOSE(waypoints_x[2], 1, 1e-6);
+}
+
+static void testTruncate() {
+  // a route with too many waypoints is truncated, the last ones are ignored
+  mockFiles.clear();
+  std::string csv;
+  for (int i = 0; i < 300; i++)
+    csv += std::to_string(i) + ",0," + std::to_string(i) + ",0\n";
+  mockFiles["/waypoints2.csv"] = csv;
+  CHECK(compileWaypoints(2));
+  CHECK(readWaypoints(2));
+  CHECK_EQUAL(waypoints_n, WAYPOINTS_MAX);
+  CHECK_CLOSE(waypoints_t[WAYPOINTS_MAX - 1], WAYPOINTS_MAX - 2, 1e-6);
+
+  // a binary file with an invalid header or size is rejected
+  std::string bin = mockFiles["/waypoints2.bin"];
+  mockFiles["/waypoints2.bin"] = bin.substr(0, bin.size() - 1);
+  CHECK(!readWaypoints(2));
+  CHECK_EQUAL(waypoints_n, 0);
+  mockFiles["/waypoints2.bin"] = "WPT0" + bin.substr(4);
+  CHECK(!readWaypoints(2));
+  uint32_t count = WAYPOINTS_MAX;
+  mockFiles["/waypoints2.bin"] = bin.substr(0, 4) + std::string((char *)&count, 4) + bin.substr(8);
+  CHECK(!readWaypoints(2));
+}
+
+static void testList() {
+  // any positive route number can be used
+  mockFiles.clear();
+  mockFiles["/config.json"] = "{}";
+  mockFiles["/waypoints0.csv"] = "";
+  mockFiles["/waypoints1.csv"] = "";
+  mockFiles["/waypoints12.csv"] = "";
+  mockFiles["/waypoints13.bin"] = "";
+  int route[8];
+  CHECK_EQUAL(listWaypoints(route, 8), 2);
+  CHECK_EQUAL(route[0], 1);
+  CHECK_EQUAL(route[1], 12);
+  CHECK_EQUAL(listWaypoints(route, 1), 1);
+
+  // the route is compiled when it is saved
+  String csv = "0,0,0,0\n1,0.1,0.2,30\n";
+  CHECK_EQUAL(saveWaypoints(40, csv), csv.length());
+  CHECK(SPIFFS.exists("/waypoints40.bin"));
+  CHECK(loadWaypoints(40) == csv);
+  CHECK(readWaypoints(40));
+  CHECK_EQUAL(waypoints_n, 3);
+
+  // the binary file is made for a CSV file that was uploaded along with the file system
+  mockFiles["/waypoints41.csv"] = csv.c_str();
+  CHECK(readWaypoints(41));
+  CHECK(SPIFFS.exists("/waypoints41.bin"));
+}
+
+// set the waypoints, including the starting point
+static void route(int n, const float *t, const float *x, const float *y, const float *a) {
+  waypoints_n = n;
+  for (int i = 0; i < n; i++) {
+    waypoints_t[i] = t[i];
+    waypoints_x[i] = x[i];
+    waypoints_y[i] = y[i];
+    waypoints_a[i] = a[i];
+  }
+}
+
+static void testInterpolate() {
+  static const float t[] = {0, 1, 3, 4, 6};
+  static const float x[] = {0, 1, 1, 0, 0};
+  static const float y[] = {0, 0, 1, 1, 0};
+  static const float a[] = {0, 0.5, 1, 1.5, 2};
+  route(5, t, x, y, a);
+
+  // the path goes through all waypoints at their time
+  float px, py, pa;
+  for (int i = 0; i < 5; i++) {
+    CHECK_EQUAL(interpolateWaypoints(t[i], &px, &py, &pa), (i == 4 ? 4 : i + 1));
+    CHECK_CLOSE(px, x[i], 1e-5);
+    CHECK_CLOSE(py, y[i], 1e-5);
+    CHECK_CLOSE(pa, a[i], 1e-5);
+  }
+
+  // the robot is at rest at the start and at the end
+  const float h = 1e-3;
+  float x0, y0, a0, x1, y1, a1;
+  interpolateWaypoints(0, &x0, &y0, &a0);
+  interpolateWaypoints(h, &x1, &y1, &a1);
+  CHECK_CLOSE((x1 - x0) / h, 0, 0.01);
+  CHECK_CLOSE((y1 - y0) / h, 0, 0.01);
+  interpolateWaypoints(6 - h, &x0, &y0, &a0);
+  interpolateWaypoints(6, &x1, &y1, &a1);
+  CHECK_CLOSE((x1 - x0) / h, 0, 0.01);
+
+  // the speed is continuous at the waypoints, and the tangent is that of the neighbours
+  for (int i = 1; i < 4; i++) {
+    interpolateWaypoints(t[i] - h, &x0, &y0, &a0);
+    interpolateWaypoints(t[i] + h, &x1, &y1, &a1);
+    CHECK_CLOSE((x1 - x0) / (2 * h), (x[i + 1] - x[i - 1]) / (t[i + 1] - t[i - 1]), 0.01);
+    CHECK_CLOSE((y1 - y0) / (2 * h), (y[i + 1] - y[i - 1]) / (t[i + 1] - t[i - 1]), 0.01);
+    CHECK_CLOSE((a1 - a0) / (2 * h), (a[i + 1] - a[i - 1]) / (t[i + 1] - t[i - 1]), 0.01);
+  }
+
+  // after the end the robot stays at the last waypoint
+  CHECK_EQUAL(interpolateWaypoints(100, &px, &py, &pa), 4);
+  CHECK_CLOSE(pa, 2, 1e-6);
+
+  // with equally spaced waypoints on a line the speed is constant in between
+  static const float line[] = {0, 1, 2, 3, 4};
+  route(5, line, line, line, line);
+  for (float s = 1; s <= 3; s += 0.125) {
+    interpolateWaypoints(s, &px, &py, &pa);
+    CHECK_CLOSE(px, s, 1e-5);
+  }
+
+  // waypoints at the same time do not result in an infinite speed
+  static const float same[] = {0, 1, 1, 2};
+  route(4, same, line, line, line);
+  CHECK_EQUAL(interpolateWaypoints(1, &px, &py, &pa), 3);
+  CHECK(isfinite(px));
+  CHECK_CLOSE(px, 2, 1e-5);
+
+  // a route needs at least two waypoints
+  route(1, line, line, line, line);
+  CHECK_EQUAL(interpolateWaypoints(0, &px, &py, &pa), -1);
+}
+
+static void benchmark() {
+  // the time to start a route of 255 waypoints from the binary file and from the CSV file
+  mockFiles.clear();
+  std::string csv;
+  for (int i = 0; i < WAYPOINTS_MAX - 1; i++)
+    csv += std::to_string(i * 0.5) + "," + std::to_string(sin(i * 0.1)) + "," + std::to_string(cos(i * 0.1)) + "," + std::to_string(i * 3 % 360) + "\n";
+  mockFiles["/waypoints5.csv"] = csv;
+  const int repeat = 1000;
+
+  clock_t start = clock();
+  for (int k = 0; k < repeat; k++)
+    compileWaypoints(5);
+  double parse = 1e6 * (clock() - start) / CLOCKS_PER_SEC / repeat;
+
+  start = clock();
+  for (int k = 0; k < repeat; k++)
+    readWaypoints(5);
+  double read = 1e6 * (clock() - start) / CLOCKS_PER_SEC / repeat;
+  CHECK_EQUAL(waypoints_n, WAYPOINTS_MAX);
+
+  printf("starting a route of %d waypoints on this computer: %.1f us from the CSV file, %.1f us from the binary file\n", WAYPOINTS_MAX - 1, parse, read);
+  CHECK(read < parse);
+
+  // the interpolation is done in every control cycle
+  float px, py, pa, sum = 0;
+  start = clock();
+  for (int k = 0; k < 100 * repeat; k++) {
+    interpolateWaypoints(k * 0.00127, &px, &py, &pa);
+    sum += px;
+  }
+  printf("interpolation takes %.1f ns on this computer (%d)\n", 1e9 * (clock() - start) / CLOCKS_PER_SEC / (100 * repeat), sum > 0);
+}
+
+int main() {
+  testCompile();
+  testSkip();
+  testTruncate();
+  testList();
+  testInterpolate();
+  benchmark();
+  return report("test_waypoints");
+}
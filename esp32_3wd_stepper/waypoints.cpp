@@ -7,11 +7,31 @@
 // time is incremental and in seconds
 // x and y are the position in meter
 // theta is the angle in degrees in the file, it is converted to radians in memory
+//
+// the CSV file is compiled once into a binary file when it is saved, so that a route
+// can be started without parsing. The binary file starts with a header, followed by
+// the time, x, y and theta of all waypoints, each as a contiguous array of floats.
+
+typedef struct {
+  uint32_t magic;
+  uint32_t count;
+} header_t;
+
+float waypoints_t[WAYPOINTS_MAX];
+float waypoints_x[WAYPOINTS_MAX];
+float waypoints_y[WAYPOINTS_MAX];
+float waypoints_a[WAYPOINTS_MAX];
+int waypoints_n = 0;
+
+/****************************************************************************************/
+
+static String csvFilename(int route) {
+  return String("/waypoints") + String(route) + String(".csv");
+}
 
-vector<float> waypoints_t;
-vector<float> waypoints_x;
-vector<float> waypoints_y;
-vector<float> waypoints_a;
+static String binFilename(int route) {
+  return String("/waypoints") + String(route) + String(".bin");
+}
 
 /****************************************************************************************/
 
@@ -19,14 +39,14 @@ void printWaypoints(int route) {
   Serial.print("printWaypoints ");
   Serial.println(route);
 
-  for (int i = 0; i < waypoints_t.size(); i++) {
-    Serial.print(waypoints_t.at(i));
+  for (int i = 0; i < waypoints_n; i++) {
+    Serial.print(waypoints_t[i]);
     Serial.print(",");
-    Serial.print(waypoints_x.at(i));
+    Serial.print(waypoints_x[i]);
     Serial.print(",");
-    Serial.print(waypoints_y.at(i));
+    Serial.print(waypoints_y[i]);
     Serial.print(",");
-    Serial.print(waypoints_a.at(i));
+    Serial.print(waypoints_a[i]);
     Serial.print("\n");
   }
   return;
@@ -43,15 +63,19 @@ size_t saveWaypoints(int route, String s) {
     return 0;
   }
 
-  String filename = String("/waypoints") + String(route) + String(".csv");
+  String filename = csvFilename(route);
   File file = SPIFFS.open(filename, "w");
   if (!file) {
     Serial.print("Failed to open ");
     Serial.print(filename);
     Serial.println(" for writing");
+    return 0;
   }
   
   size_t bytes = file.print(s);
+  file.close();
+
+  compileWaypoints(route);
   return bytes;
 }
 
@@ -67,7 +91,7 @@ String loadWaypoints(int route) {
     return s;
   }
 
-  String filename = String("/waypoints") + String(route) + String(".csv");
+  String filename = csvFilename(route);
   File file = SPIFFS.open(filename, "r");
   if (!file) {
     Serial.print("Failed to open ");
@@ -86,50 +110,205 @@ String loadWaypoints(int route) {
 
 /****************************************************************************************/
 
-void parseWaypoints(int route) {
-  Serial.print("parseWaypoints ");
+int listWaypoints(int *route, int maxroutes) {
+  // this returns the number of routes
+  if (!SPIFFS.begin(true)) {
+    Serial.println("An error has occurred while mounting SPIFFS");
+    return 0;
+  }
+
+  int count = 0;
+  File dir = SPIFFS.open("/");
+  File file = dir.openNextFile();
+  while (file && count < maxroutes) {
+    String name = file.name();
+    if (name.startsWith("/"))
+      name = name.substring(1);
+    if (name.startsWith("waypoints") && name.endsWith(".csv")) {
+      int number = name.substring(9, name.length() - 4).toInt();
+      if (number > 0)
+        route[count++] = number;
+    }
+    file = dir.openNextFile();
+  }
+  return count;
+}
+
+/****************************************************************************************/
+
+bool compileWaypoints(int route) {
+  Serial.print("compileWaypoints ");
   Serial.println(route);
 
   if (!SPIFFS.begin(true)) {
     Serial.println("An error has occurred while mounting SPIFFS");
-    return;
+    return false;
   }
 
-  String filename = String("/waypoints") + String(route) + String(".csv");
+  String filename = csvFilename(route);
+  File in = SPIFFS.open(filename, "r");
+  if (!in) {
+    Serial.print("Failed to open ");
+    Serial.print(filename);
+    Serial.println(" for reading");
+    return false;
+  }
+
+  // the waypoints are parsed into a temporary structure of arrays, the current route remains as it is
+  float *buffer = (float *)malloc(4 * (WAYPOINTS_MAX - 1) * sizeof(float));
+  if (!buffer) {
+    in.close();
+    return false;
+  }
+  float *t = buffer, *x = t + WAYPOINTS_MAX - 1, *y = x + WAYPOINTS_MAX - 1, *a = y + WAYPOINTS_MAX - 1;
+
+  int n = 0;
+  bool truncated = false;
+  char line[80];
+  while (in.available()) {
+    size_t len = in.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[len] = 0;
+    if (len == sizeof(line) - 1) {
+      // the line did not fit in the buffer, the remainder should not be parsed as a new line
+      String remainder = in.readStringUntil('\n');
+      remainder.trim();
+      if (remainder.length() > 0) {
+        Serial.println("Skipping line that is too long");
+        continue;
+      }
+    }
+    float value[4];
+    char *p = line, *end;
+    int i;
+    for (i = 0; i < 4; i++) {
+      value[i] = strtod(p, &end);
+      if (end == p)
+        break;
+      p = (*end == ',' ? end + 1 : end);
+    }
+    if (i < 4)
+      continue;  // skip empty or incomplete lines
+    if (n == WAYPOINTS_MAX - 1) {
+      truncated = true;
+      break;
+    }
+    t[n] = value[0];
+    x[n] = value[1];
+    y[n] = value[2];
+    a[n] = value[3] * M_PI / 180;  // convert from degrees to radians
+    n++;
+  }
+  in.close();
+
+  if (truncated) {
+    Serial.print("Too many waypoints, the route is truncated after ");
+    Serial.println(n);
+  }
+
+  filename = binFilename(route);
+  File out = SPIFFS.open(filename, "w");
+  if (!out) {
+    Serial.print("Failed to open ");
+    Serial.print(filename);
+    Serial.println(" for writing");
+    free(buffer);
+    return false;
+  }
+
+  header_t header = { WAYPOINTS_MAGIC, (uint32_t)n };
+  out.write((uint8_t *)&header, sizeof(header));
+  out.write((uint8_t *)t, n * sizeof(float));
+  out.write((uint8_t *)x, n * sizeof(float));
+  out.write((uint8_t *)y, n * sizeof(float));
+  out.write((uint8_t *)a, n * sizeof(float));
+  out.close();
+
+  free(buffer);
+  return true;
+}
+
+/****************************************************************************************/
+
+bool readWaypoints(int route) {
+  Serial.print("readWaypoints ");
+  Serial.println(route);
+
+  if (!SPIFFS.begin(true)) {
+    Serial.println("An error has occurred while mounting SPIFFS");
+    return false;
+  }
+
+  // the binary file is missing for CSV files that were uploaded along with the file system
+  String filename = binFilename(route);
+  if (!SPIFFS.exists(filename) && !compileWaypoints(route))
+    return false;
+
   File file = SPIFFS.open(filename, "r");
   if (!file) {
     Serial.print("Failed to open ");
     Serial.print(filename);
     Serial.println(" for reading");
+    return false;
   }
 
-  waypoints_t.clear();
-  waypoints_x.clear();
-  waypoints_y.clear();
-  waypoints_a.clear();
+  header_t header;
+  if (file.read((uint8_t *)&header, sizeof(header)) != sizeof(header) || header.magic != WAYPOINTS_MAGIC || header.count > WAYPOINTS_MAX - 1) {
+    Serial.print("Invalid ");
+    Serial.println(filename);
+    file.close();
+    return false;
+  }
 
-  vector<String> v;
-  while (file.available()) {
-    String s = file.readStringUntil('\n');
-    v.push_back(s);
+  // the first waypoint is left for the starting point
+  size_t bytes = header.count * sizeof(float);
+  bool ok = true;
+  ok &= (file.read((uint8_t *)(waypoints_t + 1), bytes) == bytes);
+  ok &= (file.read((uint8_t *)(waypoints_x + 1), bytes) == bytes);
+  ok &= (file.read((uint8_t *)(waypoints_y + 1), bytes) == bytes);
+  ok &= (file.read((uint8_t *)(waypoints_a + 1), bytes) == bytes);
+  file.close();
 
-    int ind1 = s.indexOf(',');                    // finds location of 1st ,
-    int ind2 = s.indexOf(',', ind1 + 1);          // finds location of 2nd ,
-    int ind3 = s.indexOf(',', ind2 + 1);          // finds location of 3rd ,
-    int ind4 = s.length();                        // end of the string
+  waypoints_n = (ok ? header.count + 1 : 0);
+  return ok;
+}
 
-    String tok1 = s.substring(0, ind1);           //captures 1st value
-    String tok2 = s.substring(ind1 + 1, ind2);    //captures 2nd value
-    String tok3 = s.substring(ind2 + 1, ind3);    //captures 3rd value
-    String tok4 = s.substring(ind3 + 1, ind4);    //captures 4th value
+/****************************************************************************************/
 
-    // convert the values to float and store each in their own vector
-    waypoints_t.push_back(atof(tok1.c_str()));
-    waypoints_x.push_back(atof(tok2.c_str()));
-    waypoints_y.push_back(atof(tok3.c_str()));
-    waypoints_a.push_back(atof(tok4.c_str()) * M_PI / 180);  // convert from degrees to radians
+static float hermite(float p0, float p1, float m0, float m1, float h, float u) {
+  // cubic Hermite interpolation, u is between 0 and 1 and h is the duration of the segment
+  float u2 = u * u, u3 = u2 * u;
+  return (2 * u3 - 3 * u2 + 1) * p0 + (u3 - 2 * u2 + u) * h * m0 + (-2 * u3 + 3 * u2) * p1 + (u3 - u2) * h * m1;
+}
+
+static float tangent(const float *p, int i) {
+  // the robot is at rest at the first and the last waypoint
+  if (i == 0 || i == waypoints_n - 1)
+    return 0;
+  float dt = waypoints_t[i + 1] - waypoints_t[i - 1];
+  return (dt > 0 ? (p[i + 1] - p[i - 1]) / dt : 0);
+}
+
+int interpolateWaypoints(float t, float *x, float *y, float *a) {
+  // this returns the segment, the time is in seconds since the start of the route
+  // the N waypoints are connected by N-1 segments
+  if (waypoints_n < 2)
+    return -1;
+  if (t >= waypoints_t[waypoints_n - 1]) {
+    *x = waypoints_x[waypoints_n - 1];
+    *y = waypoints_y[waypoints_n - 1];
+    *a = waypoints_a[waypoints_n - 1];
+    return waypoints_n - 1;
   }
 
-  file.close();
-  return;
+  int i = 0;
+  while (i < waypoints_n - 2 && t >= waypoints_t[i + 1])
+    i++;
+
+  float h = waypoints_t[i + 1] - waypoints_t[i];
+  float u = (h > 0 ? (t - waypoints_t[i]) / h : 1);
+  u = constrain(u, 0, 1);
+  *x = hermite(waypoints_x[i], waypoints_x[i + 1], tangent(waypoints_x, i), tangent(waypoints_x, i + 1), h, u);
+  *y = hermite(waypoints_y[i], waypoints_y[i + 1], tangent(waypoints_y, i), tangent(waypoints_y, i + 1), h, u);
+  *a = hermite(waypoints_a[i], waypoints_a[i + 1], tangent(waypoints_a, i), tangent(waypoints_a, i + 1), h, u);
+  return i + 1;
 }
@@ -3,21 +3,28 @@
 
 #include <FS.h>
 #include <SPIFFS.h>
-#include <vector>
 
-using namespace std;
+#define WAYPOINTS_MAX   256         // maximum number of waypoints per route, including the starting point
+#define WAYPOINTS_MAGIC 0x31545057  // "WPT1" in little-endian order
 
-extern vector<float> waypoints_t;
-extern vector<float> waypoints_x;
-extern vector<float> waypoints_y;
-extern vector<float> waypoints_a;
+// the waypoints of the current route are represented as a structure of arrays
+// the first waypoint is reserved for the position at which the route starts
+
+extern float waypoints_t[WAYPOINTS_MAX];
+extern float waypoints_x[WAYPOINTS_MAX];
+extern float waypoints_y[WAYPOINTS_MAX];
+extern float waypoints_a[WAYPOINTS_MAX];
+extern int waypoints_n;
 
 // the following functions take an integer as first input, which is the route number
-// the route number is between 1 to 8, so you can use 8 predefined sets of waypoints
+// the route number is a positive integer, there can be as many routes as fit on SPIFFS
 
-void printWaypoints(int);            // print the waypoints on the serial console
-void parseWaypoints(int);            // read the waypoints from the file and represent as vectors
-String loadWaypoints(int);           // read the waypoints from the file and return as a string
-size_t saveWaypoints(int, String);   // save the waypoints (as string) to the file
+void printWaypoints(int);                                 // print the waypoints on the serial console
+bool readWaypoints(int);                                  // read the compiled waypoints from the binary file
+bool compileWaypoints(int);                               // convert the waypoints from the CSV file into the binary file
+String loadWaypoints(int);                                // read the waypoints from the CSV file and return as a string
+size_t saveWaypoints(int, String);                        // save the waypoints (as string) to the CSV file and compile them
+int listWaypoints(int *, int);                            // list the route numbers for which there is a CSV file
+int interpolateWaypoints(float, float *, float *, float *);  // interpolate the position at a given time with a Catmull-Rom spline
 
 #endif // _WAYPOINTS_H_
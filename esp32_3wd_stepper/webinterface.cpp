@@ -35,6 +35,11 @@ bool defaultConfig() {
   config.absolute = 0;
   config.warp = 1.000;
   config.debug = 0;
+  config.profile = 0;
+  config.acceleration = 1024;
+  config.jerk = 8192;
+  config.maxspeed = 512;
+  config.smooth = 0;
   return true;
 }
 
@@ -68,6 +73,11 @@ bool loadConfig() {
   N_JSON_TO_CONFIG(absolute, "absolute");
   N_JSON_TO_CONFIG(warp, "warp");
   N_JSON_TO_CONFIG(debug, "debug");
+  N_JSON_TO_CONFIG(profile, "profile");
+  N_JSON_TO_CONFIG(acceleration, "acceleration");
+  N_JSON_TO_CONFIG(jerk, "jerk");
+  N_JSON_TO_CONFIG(maxspeed, "maxspeed");
+  N_JSON_TO_CONFIG(smooth, "smooth");
 
   return true;
 }
@@ -80,6 +90,11 @@ bool saveConfig() {
   N_CONFIG_TO_JSON(absolute, "absolute");
   N_CONFIG_TO_JSON(warp, "warp");
   N_CONFIG_TO_JSON(debug, "debug");
+  N_CONFIG_TO_JSON(profile, "profile");
+  N_CONFIG_TO_JSON(acceleration, "acceleration");
+  N_CONFIG_TO_JSON(jerk, "jerk");
+  N_CONFIG_TO_JSON(maxspeed, "maxspeed");
+  N_CONFIG_TO_JSON(smooth, "smooth");
 
   File configFile = SPIFFS.open("/config.json", "w");
   if (!configFile) {
@@ -102,8 +117,34 @@ void printConfig() {
   Serial.println(config.warp);
   Serial.print("debug = ");
   Serial.println(config.debug);
+  Serial.print("profile = ");
+  Serial.println(config.profile);
+  Serial.print("acceleration = ");
+  Serial.println(config.acceleration);
+  Serial.print("jerk = ");
+  Serial.println(config.jerk);
+  Serial.print("maxspeed = ");
+  Serial.println(config.maxspeed);
+  Serial.print("smooth = ");
+  Serial.println(config.smooth);
 }
 
+static int waypointsRoute(String name) {
+  // this returns the route number for a key like "waypoints12", or 0
+  if (!name.startsWith("waypoints"))
+    return 0;
+  return name.substring(9).toInt();
+}
+
+static bool hasWaypointsArg() {
+  for (int i = 0; i < server.args(); i++)
+    if (waypointsRoute(server.argName(i)) > 0)
+      return true;
+  return false;
+}
+
+/***************************************************************************/
+
 void printRequest() {
   String message = "HTTP Request\n\n";
   message += "URI: ";
@@ -182,36 +223,25 @@ void handleJSON() {
   printRequest();
 
   if (server.hasArg("repeat") || server.hasArg("absolute") || server.hasArg("warp") || server.hasArg("debug")
-      || server.hasArg("waypoints1")
-      || server.hasArg("waypoints2")
-      || server.hasArg("waypoints3")
-      || server.hasArg("waypoints4")
-      || server.hasArg("waypoints5")
-      || server.hasArg("waypoints6")
-      || server.hasArg("waypoints7")
-      || server.hasArg("waypoints8")) {
+      || server.hasArg("profile") || server.hasArg("acceleration") || server.hasArg("jerk") || server.hasArg("maxspeed") || server.hasArg("smooth")
+      || hasWaypointsArg()) {
     // the body is key1=val1&key2=val2&key3=val3 and the ESP8266Webserver has already parsed it
     N_KEYVAL_TO_CONFIG(repeat, "repeat");
     N_KEYVAL_TO_CONFIG(absolute, "absolute");
     N_KEYVAL_TO_CONFIG(warp, "warp");
     N_KEYVAL_TO_CONFIG(debug, "debug");
-
-    if (server.hasArg("waypoints1"))
-      saveWaypoints(1, server.arg("waypoints1"));
-    if (server.hasArg("waypoints2"))
-      saveWaypoints(2, server.arg("waypoints2"));
-    if (server.hasArg("waypoints3"))
-      saveWaypoints(3, server.arg("waypoints3"));
-    if (server.hasArg("waypoints4"))
-      saveWaypoints(4, server.arg("waypoints4"));
-    if (server.hasArg("waypoints5"))
-      saveWaypoints(5, server.arg("waypoints5"));
-    if (server.hasArg("waypoints6"))
-      saveWaypoints(6, server.arg("waypoints6"));
-    if (server.hasArg("waypoints7"))
-      saveWaypoints(7, server.arg("waypoints7"));
-    if (server.hasArg("waypoints8"))
-      saveWaypoints(8, server.arg("waypoints8"));
+    N_KEYVAL_TO_CONFIG(profile, "profile");
+    N_KEYVAL_TO_CONFIG(acceleration, "acceleration");
+    N_KEYVAL_TO_CONFIG(jerk, "jerk");
+    N_KEYVAL_TO_CONFIG(maxspeed, "maxspeed");
+    N_KEYVAL_TO_CONFIG(smooth, "smooth");
+
+    // the waypoints of any route can be specified as waypoints1, waypoints2, etc.
+    for (int i = 0; i < server.args(); i++) {
+      int route = waypointsRoute(server.argName(i));
+      if (route > 0)
+        saveWaypoints(route, server.arg(i));
+    }
 
     handleStaticFile("/reload_success.html");
 
@@ -228,23 +258,18 @@ void handleJSON() {
     N_JSON_TO_CONFIG(absolute, "absolute");
     N_JSON_TO_CONFIG(warp, "warp");
     N_JSON_TO_CONFIG(debug, "debug");
-
-    if (root.containsKey("waypoints1"))
-      saveWaypoints(1, root["waypoints1"]);
-    if (root.containsKey("waypoints2"))
-      saveWaypoints(2, root["waypoints2"]);
-    if (root.containsKey("waypoints3"))
-      saveWaypoints(3, root["waypoints3"]);
-    if (root.containsKey("waypoints4"))
-      saveWaypoints(4, root["waypoints4"]);
-    if (root.containsKey("waypoints5"))
-      saveWaypoints(5, root["waypoints5"]);
-    if (root.containsKey("waypoints6"))
-      saveWaypoints(6, root["waypoints6"]);
-    if (root.containsKey("waypoints7"))
-      saveWaypoints(7, root["waypoints7"]);
-    if (root.containsKey("waypoints8"))
-      saveWaypoints(8, root["waypoints8"]);
+    N_JSON_TO_CONFIG(profile, "profile");
+    N_JSON_TO_CONFIG(acceleration, "acceleration");
+    N_JSON_TO_CONFIG(jerk, "jerk");
+    N_JSON_TO_CONFIG(maxspeed, "maxspeed");
+    N_JSON_TO_CONFIG(smooth, "smooth");
+
+    // the waypoints of any route can be specified as waypoints1, waypoints2, etc.
+    for (JsonPair kv : root.as<JsonObject>()) {
+      int route = waypointsRoute(kv.key().c_str());
+      if (route > 0)
+        saveWaypoints(route, kv.value().as<String>());
+    }
 
     handleStaticFile("/reload_success.html");
 
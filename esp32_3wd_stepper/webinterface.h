@@ -30,6 +30,11 @@ struct Config {
   int absolute;
   float warp;
   int debug;
+  int profile;
+  float acceleration;
+  float jerk;
+  float maxspeed;
+  int smooth;
 };
 
 extern Config config;
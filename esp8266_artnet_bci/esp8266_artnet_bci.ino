@@ -8,9 +8,8 @@
 #include <ArtnetWifi.h>          // https://github.com/rstephan/ArtnetWifi
 #include <Adafruit_NeoPixel.h>   // https://learn.adafruit.com/adafruit-neopixel-uberguide/arduino-library
 
-extern "C" {
-#include "user_interface.h"      // https://github.com/willemwouters/ESP8266/wiki/Timer-example
-}
+#include "sequencer.h"
+#include "store.h"
 
 const char* host = "ARTNET-BCI";
 const char* version = __DATE__ " / " __TIME__;
@@ -19,13 +18,12 @@ const char* version = __DATE__ " / " __TIME__;
 #define OFFSET    0
 #define NUMPIXELS 1
 #define PIN       5
+#define BRIGHTNESS 150
 #define NUMEL(x)  (sizeof(x) / sizeof((x)[0]))
-#define WRAP(x,y) (x>=y ? x-y : x)
 
 WiFiManager wifiManager;
 Adafruit_NeoPixel pixels = Adafruit_NeoPixel(NUMPIXELS, PIN, NEO_RGB + NEO_KHZ800);
 ESP8266WebServer server(80);
-static ETSTimer sequenceTimer;
 
 // Artnet settings
 ArtnetWifi artnet;
@@ -35,48 +33,123 @@ unsigned long packetCounter = 0;
 long tic_web = 0;
 
 // Blink sequence settings
-byte enable = 0, step = 0, current = 0;
+unsigned int current = 0;
+bool streaming = false;
 byte r = 255, g = 255, b = 255;
+unsigned int frequency = 1000;  // in 1/100 Hz
 
 unsigned int sequence0[] = {125, 125};  // default, rapid blinking at 4Hz
 unsigned int sequence1[] = {100, 0};    // constant on
 unsigned int sequence2[] = {0, 100};    // constant off
-unsigned int sequence3[] = {8, 8};      // approximately 60Hz
+unsigned int sequence3[] = {1, 1};      // exactly 60Hz
 unsigned int sequence4[] = {80, 16, 96, 96, 16, 48, 48, 80, 48, 64, 32, 128, 80, 112, 96, 80, 48, 48, 80, 80, 48, 64, 32, 80, 96, 96, 48, 48, 96, 64, 96, 32, 48, 112, 112, 80, 48, 32, 96, 112, 144, 16, 48, 128, 64, 80, 80, 48, 48, 64, 112, 64, 112, 80, 128, 32, 48, 96, 64, 80, 64, 16, 32, 64, 64, 112, 128, 0, 112, 112, 32, 80, 144, 128, 112, 64, 16, 112, 48, 64, 64, 96, 64, 96, 80, 48, 80, 80, 64, 80, 64, 16, 64, 80, 96, 96, 48, 80, 64, 96};
 unsigned int sequence5[] = {80, 100, 60, 60, 100, 80, 100, 100, 80, 100, 140, 60, 120, 160, 120, 160, 40, 80, 100, 200, 200, 160, 60, 80, 120, 100, 80, 160, 80, 180, 80, 80, 160, 100, 100, 100, 40, 60, 140, 160, 100, 80, 100, 100, 20, 60, 60, 100, 160, 100, 180, 200, 60, 220, 120, 60, 120, 100, 160, 80, 100, 160, 80, 140, 60, 140, 20, 100, 120, 100, 80, 60, 100, 60, 140, 140, 40, 140, 80, 100, 140, 180, 60, 100, 200, 140, 140, 60, 60, 80, 80, 60, 80, 40, 80, 60, 80, 220, 160, 80};
 unsigned int sequence6[] = {96, 96, 256, 224, 96, 96, 256, 224, 96, 192, 64, 96, 64, 128, 160, 224, 128, 352, 160, 64, 160, 160, 32, 128, 96, 288, 128, 128, 128, 224, 160, 192, 64, 128, 32, 96, 192, 96, 160, 96, 96, 128, 192, 192, 256, 192, 192, 192, 96, 32, 160, 96, 64, 64, 192, 96, 32, 224, 320, 32, 96, 256, 224, 128, 128, 224, 192, 192, 192, 96, 96, 160, 192, 224, 128, 128, 96, 128, 192, 160, 224, 128, 192, 96, 96, 352, 256, 96, 128, 160, 288, 256, 224, 224, 160, 256, 96, 192, 128, 224};
 
-#define NUMSEQUENCE 7
-unsigned int *sequence[NUMSEQUENCE] = {sequence0, sequence1, sequence2, sequence3, sequence4, sequence5, sequence6};
-unsigned int length[NUMSEQUENCE] = {2, 2, 2, 2, 100, 100, 100};
+unsigned int sequence7[64];             // m-sequence, computed in setup
+unsigned int sequence8[] = {1, 1};      // arbitrary frequency, specified over DMX
+
+#define NUMSEQUENCE 9
+unsigned int *sequence[NUMSEQUENCE] = {sequence0, sequence1, sequence2, sequence3, sequence4, sequence5, sequence6, sequence7, sequence8};
+unsigned int length[NUMSEQUENCE] = {2, 2, 2, 2, 100, 100, 100, 0, 2};
+
+// the duration of each step in the sequence, in 1/65536 microseconds
+uint64_t unit[NUMSEQUENCE] = {
+  UNIT_MILLISECOND,
+  UNIT_MILLISECOND,
+  UNIT_MILLISECOND,
+  UNIT_FREQUENCY(60),
+  UNIT_MILLISECOND,
+  UNIT_MILLISECOND,
+  UNIT_MILLISECOND,
+  UNIT_FREQUENCY(30),   // a bit rate of 60Hz
+  UNIT_FREQUENCY(10),   // updated over DMX
+};
 
 /***********************************************************************************************/
 
-//this is perpetually scheduled for the blink sequence updating
-void sequence_update() {
-  os_timer_disarm(&sequenceTimer);
-
-  step = WRAP(step, length[current]);
-  unsigned int interval = sequence[current][step];
-
-  if (interval == 0 ) {
-    // skip to the next step
-    step++;
-    step = WRAP(step, length[current]);
-    interval = sequence[current][step];
+// compute the run lengths of a 63-bit maximum length sequence, which starts with a run of ones
+unsigned int make_msequence(unsigned int *run) {
+  byte bit[63], lfsr = 0x01;
+  for (int i = 0; i < 63; i++) {
+    // this is a 6-bit Fibonacci LFSR with the primitive polynomial x^6 + x^5 + 1
+    bit[i] = lfsr & 0x01;
+    byte feedback = (lfsr ^ (lfsr >> 1)) & 0x01;
+    lfsr = (lfsr >> 1) | (feedback << 5);
   }
 
-  if (enable) {
-    if (step % 2 == 0)
-      singleBright();
-    else
-      singleBlack();
+  // find the start of a run of ones
+  int first = 0;
+  while (!(bit[first] == 1 && bit[(first + 62) % 63] == 0))
+    first++;
+
+  unsigned int count = 0;
+  run[0] = 0;
+  for (int i = 0; i < 63; i++) {
+    byte current = bit[(first + i) % 63], previous = bit[(first + i + 62) % 63];
+    if (i > 0 && current != previous)
+      run[++count] = 0;
+    run[count]++;
   }
+  return count + 1;
+} // make_msequence
 
-  step++;
+/***********************************************************************************************/
 
-  os_timer_arm(&sequenceTimer, interval, 0);
-} // sequence_update
+void sequence_start() {
+  Serial.print("starting sequence ");
+  Serial.println(current);
+  streaming = false;
+  if (current < NUMSEQUENCE) {
+    sequencerStart(sequence[current], length[current], unit[current]);
+  }
+  else {
+    // the uploaded sequences are numbered after the ones that are compiled in
+    uint64_t u;
+    if (storeSelect(current - NUMSEQUENCE, &u)) {
+      streaming = true;
+      sequencerStream(u);
+      sequence_fill();
+    }
+    else {
+      Serial.println("sequence not found");
+      sequencerStop();
+    }
+  }
+} // sequence_start
+
+void sequence_fill() {
+  // keep the FIFO of the hardware timer filled with uploaded sequences
+  if (!streaming)
+    return;
+  for (unsigned int n = sequencerSpace(); n > 0; n--) {
+    unsigned int interval, step;
+    if (!storeNext(&interval, &step)) {
+      Serial.println("failed to read sequence");
+      streaming = false;
+      sequencerStop();
+      return;
+    }
+    sequencerPush(interval, step);
+  }
+} // sequence_fill
+
+void handle_upload() {
+  static File upload_file;
+  HTTPUpload& upload = server.upload();
+  if (upload.status == UPLOAD_FILE_START) {
+    Serial.println("handleUpload");
+    upload_file = SPIFFS.open(STORE_UPLOAD, "w");
+  }
+  else if (upload.status == UPLOAD_FILE_WRITE) {
+    if (upload_file)
+      upload_file.write(upload.buf, upload.currentSize);
+  }
+  else if (upload.status == UPLOAD_FILE_END) {
+    if (upload_file)
+      upload_file.close();
+  }
+} // handle_upload
 
 /***********************************************************************************************/
 
@@ -92,11 +165,13 @@ void packet_receive(uint16_t universe, uint16_t length, uint8_t sequence, uint8_
   data += OFFSET;
   length -= OFFSET;
 
-  // 0 = current sequence
+  // 0 = current sequence, it restarts with a known phase when selected
+  // 6 = current sequence, high byte for selecting an uploaded sequence
   if (length > 0) {
-    if (data[0] >= 0 && data[0] < NUMSEQUENCE) {
-      current = data[0];
-      step = 0;
+    unsigned int selected = data[0] + (length > 6 ? data[6] << 8 : 0);
+    if (selected != current) {
+      current = selected;
+      sequence_start();
     }
   }
 
@@ -105,6 +180,18 @@ void packet_receive(uint16_t universe, uint16_t length, uint8_t sequence, uint8_
     r = data[1];
     g = data[2];
     b = data[3];
+    sequencerColor((r * (BRIGHTNESS + 1)) >> 8, (g * (BRIGHTNESS + 1)) >> 8, (b * (BRIGHTNESS + 1)) >> 8);
+  }
+
+  // 4, 5 = frequency for sequence 8, in 1/100 Hz
+  if (length > 5) {
+    unsigned int f = (data[4] << 8) | data[5];
+    if (f > 0 && f != frequency) {
+      frequency = f;
+      unit[8] = UNIT_FREQUENCY(frequency / 100.);
+      if (current == 8)
+        sequence_start();
+    }
   }
 } // packet_receive
 
@@ -117,9 +204,14 @@ void setup() {
   }
   Serial.println("setup starting");
 
-  pixels.setBrightness(150);
+  pixels.setBrightness(BRIGHTNESS);
   pixels.begin();
 
+  SPIFFS.begin();
+
+  length[7] = make_msequence(sequence7);
+  sequencerColor((r * (BRIGHTNESS + 1)) >> 8, (g * (BRIGHTNESS + 1)) >> 8, (b * (BRIGHTNESS + 1)) >> 8);
+  sequencerBegin(PIN);
   current = 0;
 
   if (WiFi.status() != WL_CONNECTED)
@@ -145,7 +237,7 @@ void setup() {
     Serial.println("Start OTA");
     server = ESP8266WebServer(); // See https://github.com/esp8266/Arduino/issues/686
     artnet = ArtnetWifi();
-    os_timer_disarm(&sequenceTimer);
+    sequencerStop();
     singleBlue();
   });
   ArduinoOTA.onEnd([]() {
@@ -202,6 +294,51 @@ void setup() {
     ESP.restart();
   });
 
+  server.on("/edges", HTTP_GET, []() {
+    // this does not update tic_web, since that would interrupt the stimulus
+    Serial.println("handleEdges");
+    edge_t edge[NUMEDGES];
+    unsigned int count = sequencerEdges(edge, NUMEDGES);
+    String str = "step level scheduled actual\r\n";
+    for (unsigned int i = 0; i < count; i++) {
+      str += edge[i].step;
+      str += " ";
+      str += edge[i].level;
+      str += " ";
+      str += edge[i].scheduled;
+      str += " ";
+      str += edge[i].actual;
+      str += "\r\n";
+    }
+    server.send(200, "text/plain", str);
+  });
+
+  server.on("/upload", HTTP_POST, []() {
+    tic_web = millis();
+    // the sequence that is currently playing might be replaced
+    sequencerStop();
+    streaming = false;
+    int count = storeEncode();
+    SPIFFS.remove(STORE_UPLOAD);
+    sequence_start();
+    if (count < 0)
+      server.send(500, "text/plain", "failed to encode sequences");
+    else
+      server.send(200, "text/plain", String(count) + " sequences");
+  }, handle_upload);
+
+  server.on("/sequences", HTTP_GET, []() {
+    Serial.println("handleSequences");
+    String str = "";
+    str += NUMSEQUENCE;
+    str += " compiled in, ";
+    str += storeCount();
+    str += " uploaded, ";
+    str += sequencerUnderrun();
+    str += " underruns\r\n";
+    server.send(200, "text/plain", str);
+  });
+
   // start the web server
   server.begin();
 
@@ -216,10 +353,8 @@ void setup() {
   artnet.begin();
   artnet.setArtDmxCallback(packet_receive);
 
-  // start the timer
-  os_timer_disarm(&sequenceTimer);
-  os_timer_setfn(&sequenceTimer, (os_timer_func_t *) sequence_update, NULL);
-  os_timer_arm(&sequenceTimer, 1000, 0);
+  // start the hardware timer
+  sequence_start();
 
   Serial.println("setup done");
 
@@ -230,21 +365,23 @@ void setup() {
 void loop() {
 
   if (WiFi.status() != WL_CONNECTED) {
-    enable = 0;
+    sequencerEnable(0);
     singleRed();
   }
   else if ((millis() - tic_web) < 1000) {
-    enable = 0;
+    sequencerEnable(0);
     singleBlue();
   }
   else  {
-    enable = 1;
+    sequencerEnable(1);
     server.handleClient();
     artnet.read();
     ArduinoOTA.handle();
-    // the remainder of the work gets done by the timer and callback functions
+    // the remainder of the work gets done by the hardware timer and callback functions
   }
 
+  sequence_fill();
+
 } // loop
 
 /***********************************************************************************************/
@@ -279,7 +416,3 @@ void singleWhite() {
   pixels.show();
 }
 
-void singleBright() {
-  pixels.setPixelColor(0, r, g, b);
-  pixels.show();
-}
@@ -0,0 +1,260 @@
+/*
+  This implements the stimulus sequence timing with the ESP8266 hardware timer.
+
+  The edges of the sequence are scheduled on an absolute time axis that is
+  expressed in CPU cycles, with 8 additional bits for the fractional part. Each
+  interval is added to the time of the previous edge, not to the time at which
+  the interrupt happened to be serviced. Hence the latency of an individual edge
+  does not accumulate. The time since the start is added up in the units of the
+  sequence and only then converted to cycles, hence the rounding does not
+  accumulate either and the average frequency is exact up to the accuracy of the
+  crystal.
+
+  The pixel is written directly from the interrupt service routine, since the
+  software timers and the main loop would add milliseconds of jitter.
+
+  Sequences are either an array in RAM, or are streamed through a small FIFO
+  that is filled from the main loop. The flash memory cannot be read from the
+  interrupt service routine.
+*/
+
+#include "sequencer.h"
+
+extern "C" {
+  // this is part of the Adafruit NeoPixel library and is located in IRAM
+  void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz);
+}
+
+#define TIMER_MINTICKS 10        // 2 us at 5 MHz
+#define TIMER_MAXTICKS 5000000   // 1 s at 5 MHz, which keeps the cycle counter extension up to date
+
+static uint8_t pin;
+static uint32_t cyclesPerMicrosecond, tickShift;
+static uint8_t bright[3] = {0, 0, 0}, black[3] = {0, 0, 0};
+static volatile bool enable = false, running = false;
+
+// the current sequence
+static const unsigned int *interval = NULL;
+static unsigned int length = 0;
+static volatile unsigned int step = 0;
+static uint64_t unit = 0;        // in 1/65536 microseconds
+
+// the FIFO for sequences that are streamed, it is filled by the main loop and emptied by the ISR
+static bool streaming = false;
+static volatile struct {
+  unsigned int interval;
+  unsigned int step;
+} fifo[FIFOSIZE];
+static volatile unsigned int fifoHead = 0, fifoTail = 0;
+static volatile unsigned long underrun = 0;
+
+// the timing, all in 1/256 CPU cycles except for the time of the next edge since the start
+static volatile uint64_t start = 0, target = 0;
+static volatile uint64_t offset = 0;   // in 1/65536 microseconds
+
+// the 32-bit cycle counter wraps around every 53 seconds at 80 MHz
+static volatile uint32_t lastCount = 0;
+static volatile uint64_t highCount = 0;
+
+// the edges are stored in CPU cycles and only converted to microseconds when queried
+static struct {
+  uint64_t scheduled;
+  uint64_t actual;
+  uint16_t step;
+  uint8_t  level;
+} edge[NUMEDGES];
+static volatile unsigned int edgeCount = 0;
+
+/***************************************************************************/
+
+static inline uint64_t IRAM_ATTR cycles64() {
+  // this must be called with interrupts disabled
+  uint32_t count = ESP.getCycleCount();
+  if (count < lastCount)
+    highCount += (1ULL << 32);
+  lastCount = count;
+  return (highCount + count) << 8;
+}
+
+static inline uint64_t IRAM_ATTR cycles(uint64_t t) {
+  // convert from 1/65536 microseconds to 1/256 CPU cycles, the whole microseconds separately to prevent an overflow
+  uint64_t whole = t >> UNIT_SHIFT, fraction = t & ((1ULL << UNIT_SHIFT) - 1);
+  return ((whole * cyclesPerMicrosecond) << 8) + ((fraction * cyclesPerMicrosecond) >> (UNIT_SHIFT - 8));
+}
+
+static inline void IRAM_ATTR arm(uint64_t now) {
+  // the timer runs at 5 MHz, i.e. one tick per 16 cycles at 80 MHz or 32 cycles at 160 MHz
+  uint64_t ticks = (target > now ? (target - now) >> (8 + tickShift) : 0);
+  if (ticks < TIMER_MINTICKS)
+    ticks = TIMER_MINTICKS;
+  else if (ticks > TIMER_MAXTICKS)
+    ticks = TIMER_MAXTICKS;
+  timer1_write(ticks);
+}
+
+static inline unsigned int IRAM_ATTR next(unsigned int s) {
+  s++;
+  return (s >= length ? 0 : s);
+}
+
+static bool IRAM_ATTR fetch(unsigned int *i, unsigned int *s) {
+  if (!streaming) {
+    // skip the steps with a zero interval
+    unsigned int guard = length;
+    while (interval[step] == 0 && guard--)
+      step = next(step);
+    *i = interval[step];
+    *s = step;
+    step = next(step);
+    return (*i > 0);
+  }
+  else {
+    do {
+      if (fifoTail == fifoHead)
+        return false;
+      *i = fifo[fifoTail % FIFOSIZE].interval;
+      *s = fifo[fifoTail % FIFOSIZE].step;
+      fifoTail++;
+    } while (*i == 0);
+    return true;
+  }
+}
+
+static void IRAM_ATTR sequencerISR() {
+  if (!running)
+    return;
+
+  uint64_t now = cycles64();
+
+  // the timer cannot be armed for very long intervals, these are done in multiple parts
+  if (target > now + ((uint64_t)TIMER_MINTICKS << (8 + tickShift))) {
+    arm(now);
+    return;
+  }
+
+  unsigned int i, s;
+  if (!fetch(&i, &s)) {
+    if (streaming) {
+      // try again in a millisecond, this edge will be late
+      underrun++;
+      timer1_write(5000);
+    }
+    else {
+      // all intervals are zero
+      running = false;
+    }
+    return;
+  }
+
+  // the even steps are on and the odd steps are off
+  uint8_t level = !(s % 2);
+  if (enable)
+    espShow(pin, level ? bright : black, 3, true);
+  now = cycles64();
+
+  unsigned int e = edgeCount % NUMEDGES;
+  edge[e].scheduled = target - start;
+  edge[e].actual    = now - start;
+  edge[e].step      = s;
+  edge[e].level     = level;
+  edgeCount++;
+
+  // the next edge is relative to the scheduled time of this one, not to the actual time
+  offset += i * unit;
+  target = start + cycles(offset);
+  arm(now);
+}
+
+/***************************************************************************/
+
+void sequencerBegin(uint8_t p) {
+  pin = p;
+  cyclesPerMicrosecond = ESP.getCpuFreqMHz();
+  tickShift = (cyclesPerMicrosecond == 160 ? 5 : 4);
+  timer1_isr_init();
+  timer1_attachInterrupt(sequencerISR);
+  timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+}
+
+void sequencerStart(const unsigned int *i, unsigned int l, uint64_t u) {
+  noInterrupts();
+  streaming = false;
+  interval = i;
+  length = l;
+  unit = u;
+  step = 0;
+  edgeCount = 0;
+  start = cycles64();
+  offset = 0;
+  target = start;
+  running = (length > 0);
+  arm(start);
+  interrupts();
+}
+
+void sequencerStream(uint64_t u) {
+  // the FIFO should be filled right after this, the first edge is 1 ms from now
+  noInterrupts();
+  streaming = true;
+  fifoHead = 0;
+  fifoTail = 0;
+  underrun = 0;
+  unit = u;
+  edgeCount = 0;
+  start = cycles64();
+  offset = UNIT_MILLISECOND;
+  target = start + cycles(offset);
+  running = true;
+  arm(start);
+  interrupts();
+}
+
+unsigned int sequencerSpace() {
+  return FIFOSIZE - (fifoHead - fifoTail);
+}
+
+void sequencerPush(unsigned int i, unsigned int s) {
+  // this should only be called when there is space in the FIFO
+  fifo[fifoHead % FIFOSIZE].interval = i;
+  fifo[fifoHead % FIFOSIZE].step = s;
+  fifoHead++;
+}
+
+unsigned long sequencerUnderrun() {
+  return underrun;
+}
+
+void sequencerStop() {
+  noInterrupts();
+  running = false;
+  interrupts();
+}
+
+void sequencerColor(uint8_t r, uint8_t g, uint8_t b) {
+  // the pixel is wired as NEO_RGB
+  bright[0] = r;
+  bright[1] = g;
+  bright[2] = b;
+}
+
+void sequencerEnable(bool e) {
+  enable = e;
+}
+
+unsigned int sequencerEdges(edge_t *dest, unsigned int max) {
+  // copy the most recent edges, the oldest one first
+  noInterrupts();
+  unsigned int count = (edgeCount < NUMEDGES ? edgeCount : NUMEDGES);
+  if (count > max)
+    count = max;
+  unsigned int first = edgeCount - count;
+  for (unsigned int i = 0; i < count; i++) {
+    unsigned int j = (first + i) % NUMEDGES;
+    dest[i].scheduled = (edge[j].scheduled >> 8) / cyclesPerMicrosecond;
+    dest[i].actual    = (edge[j].actual    >> 8) / cyclesPerMicrosecond;
+    dest[i].step      = edge[j].step;
+    dest[i].level     = edge[j].level;
+  }
+  interrupts();
+  return count;
+}
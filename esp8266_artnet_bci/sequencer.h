@@ -0,0 +1,34 @@
+#ifndef _SEQUENCER_H_
+#define _SEQUENCER_H_
+
+#include <Arduino.h>
+
+#define NUMEDGES 64  // number of edges that are remembered for timing verification
+#define FIFOSIZE 32  // number of intervals that are buffered for sequences that are streamed
+
+// the duration of one unit is expressed in 1/65536 microseconds, which keeps the rounding
+// of a frequency below 1 us after hours
+#define UNIT_SHIFT 16
+#define UNIT_MILLISECOND (1000ULL << UNIT_SHIFT)
+#define UNIT_FREQUENCY(f) ((uint64_t)(500000. * (1UL << UNIT_SHIFT) / (f) + 0.5))  // half a period, i.e. one on or off phase
+
+// the times wrap around after 71 minutes, differences between edges remain valid
+typedef struct {
+  uint32_t scheduled;  // in microseconds since the start of the sequence
+  uint32_t actual;     // in microseconds since the start of the sequence
+  uint16_t step;
+  uint8_t  level;
+} edge_t;
+
+void sequencerBegin(uint8_t);
+void sequencerStart(const unsigned int *, unsigned int, uint64_t);
+void sequencerStream(uint64_t);
+unsigned int sequencerSpace(void);
+void sequencerPush(unsigned int, unsigned int);
+unsigned long sequencerUnderrun(void);
+void sequencerStop(void);
+void sequencerColor(uint8_t, uint8_t, uint8_t);
+void sequencerEnable(bool);
+unsigned int sequencerEdges(edge_t *, unsigned int);
+
+#endif // _SEQUENCER_H_
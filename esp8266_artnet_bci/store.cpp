@@ -0,0 +1,170 @@
+#include "store.h"
+#include "sequencer.h"
+
+// the currently selected sequence is streamed from flash
+static File data;
+static entry_t selected;
+static unsigned int position = 0;
+static uint32_t bitBuffer = 0;
+static uint8_t bitCount = 0;
+
+/***************************************************************************/
+
+static uint8_t bitsNeeded(unsigned int value) {
+  uint8_t bits = 1;
+  while (bits < 16 && (value >> bits))
+    bits++;
+  return bits;
+}
+
+/*
+  The uploaded text file contains one sequence per line. The first number on each
+  line is the step duration in microseconds, which may be fractional; the remaining
+  numbers are the intervals as a multiple of the step duration. The even intervals
+  are on and the odd ones are off, like the sequences that are compiled in.
+
+  This returns the number of sequences that were encoded, or -1 on failure.
+*/
+
+int storeEncode() {
+  // the data file that is currently being streamed is about to be replaced
+  if (data)
+    data.close();
+
+  File in  = SPIFFS.open(STORE_UPLOAD, "r");
+  File dir = SPIFFS.open(STORE_DIRECTORY, "w");
+  File dat = SPIFFS.open(STORE_DATA, "w");
+  if (!in || !dir || !dat) {
+    Serial.println("Failed to open sequence files");
+    return -1;
+  }
+
+  int count = 0;
+  uint32_t offset = 0;
+
+  while (in.available()) {
+    String line = in.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0 || line.startsWith("#"))
+      continue;
+
+    const char *str = line.c_str();
+    char *end;
+    double duration = strtod(str, &end);
+    if (end == str || duration <= 0) {
+      Serial.println("Invalid step duration");
+      continue;
+    }
+
+    // the first pass determines the number of intervals and the largest one
+    unsigned int length = 0, largest = 0;
+    const char *p = end;
+    while (true) {
+      unsigned long value = strtoul(p, &end, 10);
+      if (end == p)
+        break;
+      largest = (value > largest ? value : largest);
+      length++;
+      p = end;
+    }
+    if (length == 0 || length > 0xFFFF || largest > 0xFFFF) {
+      Serial.println("Invalid sequence");
+      continue;
+    }
+
+    entry_t entry;
+    entry.offset   = offset;
+    entry.unit     = duration * 256 + 0.5;
+    entry.length   = length;
+    entry.bits     = bitsNeeded(largest);
+    entry.reserved = 0;
+    dir.write((uint8_t *)&entry, sizeof(entry_t));
+
+    // the second pass packs the intervals, starting with the least significant bit
+    uint32_t buffer = 0;
+    uint8_t nbits = 0;
+    p = str;
+    strtod(p, &end);
+    p = end;
+    for (unsigned int i = 0; i < length; i++) {
+      unsigned long value = strtoul(p, &end, 10);
+      p = end;
+      buffer |= (value << nbits);
+      nbits += entry.bits;
+      while (nbits >= 8) {
+        dat.write((uint8_t)(buffer & 0xFF));
+        buffer >>= 8;
+        nbits -= 8;
+        offset++;
+      }
+    }
+    if (nbits > 0) {
+      dat.write((uint8_t)(buffer & 0xFF));
+      offset++;
+    }
+
+    count++;
+    yield();
+  }
+
+  in.close();
+  dir.close();
+  dat.close();
+  return count;
+}
+
+/***************************************************************************/
+
+unsigned int storeCount() {
+  File dir = SPIFFS.open(STORE_DIRECTORY, "r");
+  if (!dir)
+    return 0;
+  unsigned int count = dir.size() / sizeof(entry_t);
+  dir.close();
+  return count;
+}
+
+static void storeRewind() {
+  data.seek(selected.offset, SeekSet);
+  position = 0;
+  bitBuffer = 0;
+  bitCount = 0;
+}
+
+bool storeSelect(unsigned int index, uint64_t *unit) {
+  // finding a sequence takes a single seek, regardless of the number of sequences
+  File dir = SPIFFS.open(STORE_DIRECTORY, "r");
+  if (!dir)
+    return false;
+  bool status = dir.seek(index * sizeof(entry_t), SeekSet) && dir.read((uint8_t *)&selected, sizeof(entry_t)) == sizeof(entry_t);
+  dir.close();
+  if (!status || selected.length == 0)
+    return false;
+
+  if (!data)
+    data = SPIFFS.open(STORE_DATA, "r");
+  if (!data)
+    return false;
+
+  storeRewind();
+  *unit = (uint64_t)selected.unit << (UNIT_SHIFT - 8);
+  return true;
+}
+
+bool storeNext(unsigned int *interval, unsigned int *step) {
+  // the sequence repeats, just like the ones that are compiled in
+  if (position == selected.length)
+    storeRewind();
+  while (bitCount < selected.bits) {
+    int value = data.read();
+    if (value < 0)
+      return false;  // the data file is truncated or cannot be read
+    bitBuffer |= ((uint32_t)value << bitCount);
+    bitCount += 8;
+  }
+  *interval = bitBuffer & ((1UL << selected.bits) - 1);
+  *step = position++;
+  bitBuffer >>= selected.bits;
+  bitCount -= selected.bits;
+  return true;
+}
@@ -0,0 +1,32 @@
+#ifndef _STORE_H_
+#define _STORE_H_
+
+#include <Arduino.h>
+#include <FS.h>
+
+/*
+  The uploaded sequences are stored in two SPIFFS files. The directory contains one
+  fixed-size entry per sequence, so that any sequence can be found with a single seek.
+  The data file contains the intervals of each sequence, expressed as a multiple of
+  the step duration and bit-packed with the smallest number of bits that fits the
+  largest interval of that sequence.
+*/
+
+#define STORE_DIRECTORY "/sequences.dir"
+#define STORE_DATA      "/sequences.dat"
+#define STORE_UPLOAD    "/sequences.txt"
+
+typedef struct {
+  uint32_t offset;     // in bytes, from the start of the data file
+  uint32_t unit;       // step duration, in 1/256 microseconds to keep the entry small
+  uint16_t length;     // number of intervals
+  uint8_t  bits;       // number of bits per interval
+  uint8_t  reserved;
+} entry_t;
+
+int storeEncode(void);
+unsigned int storeCount(void);
+bool storeSelect(unsigned int, uint64_t *);
+bool storeNext(unsigned int *, unsigned int *);
+
+#endif // _STORE_H_
@@ -0,0 +1,67 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the ESP8266 Arduino core for the host tests, it
+// only provides what the modules of this sketch use. The cycle counter and the
+// hardware timer are simulated by the test.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define IRAM_ATTR
+
+#define TIM_DIV16  1
+#define TIM_EDGE   0
+#define TIM_SINGLE 0
+
+// the cycle counter and the time at which the timer fires are advanced by the test
+extern uint32_t mockCycles;
+extern uint32_t mockCpuFreq;
+extern uint32_t mockTimerTicks;    // in timer ticks at 5 MHz, 0 when the timer is not armed
+extern void (*mockTimerISR)(void);
+
+class MockESP {
+  public:
+    uint32_t getCycleCount() { return mockCycles; }
+    uint8_t getCpuFreqMHz() { return mockCpuFreq; }
+};
+
+extern MockESP ESP;
+
+inline void timer1_isr_init() {}
+inline void timer1_attachInterrupt(void (*isr)(void)) { mockTimerISR = isr; }
+inline void timer1_enable(uint8_t, uint8_t, uint8_t) {}
+inline void timer1_write(uint32_t ticks) { mockTimerTicks = ticks; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void yield() {}
+
+class String : public std::string {
+  public:
+    String() {}
+    String(const char *s) : std::string(s) {}
+    String(const std::string &s) : std::string(s) {}
+    bool startsWith(const char *s) const { return compare(0, strlen(s), s) == 0; }
+    void trim() {
+      size_t first = find_first_not_of(" \t\r\n");
+      size_t last = find_last_not_of(" \t\r\n");
+      *this = (first == npos ? String() : String(substr(first, last - first + 1)));
+    }
+};
+
+class MockSerial {
+  public:
+    template <typename T> void print(T) {}
+    template <typename T> void println(T) {}
+    void println() {}
+};
+
+extern MockSerial Serial;
+
+#endif // _ARDUINO_H_
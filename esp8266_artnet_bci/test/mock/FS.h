@@ -0,0 +1,67 @@
+#ifndef _FS_H_
+#define _FS_H_
+
+// This is a minimal replacement of the SPIFFS filesystem for the host tests, the
+// files are kept in memory.
+
+#include <Arduino.h>
+#include <map>
+#include <vector>
+
+enum SeekMode { SeekSet, SeekCur, SeekEnd };
+
+typedef std::vector<uint8_t> MockContent;
+
+class File {
+  public:
+    File() : content(NULL), position(0) {}
+    File(MockContent *c) : content(c), position(0) {}
+    operator bool() const { return content != NULL; }
+    size_t size() const { return content->size(); }
+    int available() const { return content->size() - position; }
+    int read() { return (position < content->size() ? (*content)[position++] : -1); }
+    size_t read(uint8_t *buf, size_t len) {
+      size_t n = 0;
+      while (n < len && position < content->size())
+        buf[n++] = (*content)[position++];
+      return n;
+    }
+    size_t write(uint8_t c) { content->push_back(c); return 1; }
+    size_t write(const uint8_t *buf, size_t len) { content->insert(content->end(), buf, buf + len); return len; }
+    bool seek(uint32_t pos, SeekMode mode) {
+      if (mode != SeekSet || pos > content->size())
+        return false;
+      position = pos;
+      return true;
+    }
+    String readStringUntil(char terminator) {
+      String s;
+      int c;
+      while ((c = read()) >= 0 && c != terminator)
+        s += (char)c;
+      return s;
+    }
+    void close() { content = NULL; }
+
+  private:
+    MockContent *content;
+    size_t position;
+};
+
+class MockFS {
+  public:
+    File open(const char *path, const char *mode) {
+      if (mode[0] == 'w')
+        files[path].clear();
+      else if (files.find(path) == files.end())
+        return File();
+      return File(&files[path]);
+    }
+    bool exists(const char *path) { return files.find(path) != files.end(); }
+    bool remove(const char *path) { return files.erase(path) > 0; }
+    std::map<std::string, MockContent> files;
+};
+
+extern MockFS SPIFFS;
+
+#endif // _FS_H_
@@ -0,0 +1,160 @@
+// Host simulation of the stimulus timing with the hardware timer
+//
+// The CPU cycle counter and timer1 are simulated. Whenever the timer fires the
+// cycle counter is advanced by the programmed number of ticks plus a random
+// interrupt latency, after which the interrupt service routine is called.
+
+#include "check.h"
+#include "sequencer.h"
+
+uint32_t mockCycles = 0;
+uint32_t mockCpuFreq = 80;
+uint32_t mockTimerTicks = 0;
+void (*mockTimerISR)(void) = NULL;
+MockESP ESP;
+MockSerial Serial;
+
+// the pixel that is written from the interrupt
+static uint8_t pixel[3];
+static unsigned long shown = 0;
+
+extern "C" void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+  memcpy(pixel, pixels, 3);
+  shown++;
+}
+
+static uint64_t elapsed = 0;       // in CPU cycles since the start of the simulation
+static unsigned long fired = 0;    // the number of timer interrupts
+
+// run the timer until the given number of edges has been shown, or until it is no longer armed
+static void simulate(unsigned long edges, uint32_t maxLatency) {
+  while (mockTimerTicks && shown < edges) {
+    uint32_t cycles = mockTimerTicks * (mockCpuFreq / 5) + (maxLatency ? rand() % maxLatency : 0);
+    mockTimerTicks = 0;
+    mockCycles += cycles;
+    elapsed += cycles;
+    fired++;
+    mockTimerISR();
+  }
+}
+
+static void begin(uint32_t freq, uint32_t cycles) {
+  mockCpuFreq = freq;
+  mockCycles = cycles;
+  mockTimerTicks = 0;
+  elapsed = 0;
+  shown = 0;
+  fired = 0;
+  sequencerBegin(0);
+  sequencerColor(255, 255, 255);
+  sequencerEnable(true);
+}
+
+static void testTiming(uint32_t freq) {
+  // the cycle counter wraps around half a second after the start
+  begin(freq, 0xFFFFFFFFUL - freq * 500000UL);
+  static const unsigned int interval[] = {3, 1, 2, 0, 4};
+  sequencerStart(interval, 5, UNIT_MILLISECOND);
+
+  // the interrupt latency is up to 5 microseconds
+  simulate(NUMEDGES, 5 * freq);
+  CHECK_EQUAL(shown, NUMEDGES);
+
+  edge_t edge[NUMEDGES];
+  CHECK_EQUAL(sequencerEdges(edge, NUMEDGES), NUMEDGES);
+
+  // the steps with a zero interval are skipped, the even steps are on and the odd ones off
+  static const unsigned int order[] = {0, 1, 2, 4};
+  uint32_t scheduled = 0;
+  for (unsigned int k = 0; k < NUMEDGES; k++) {
+    unsigned int step = order[k % 4];
+    CHECK_EQUAL(edge[k].step, step);
+    CHECK_EQUAL(edge[k].level, !(step % 2));
+    CHECK_EQUAL(edge[k].scheduled, scheduled);
+
+    // the edge is at most 2 us early and at most the interrupt latency late, this does not accumulate
+    int32_t error = edge[k].actual - edge[k].scheduled;
+    CHECK(error >= -3 && error <= 6);
+    scheduled += interval[step] * 1000;
+  }
+}
+
+static void testLong() {
+  // intervals that are longer than the timer can count are done in multiple parts
+  begin(80, 0);
+  static const unsigned int interval[] = {2500, 500};
+  sequencerStart(interval, 2, UNIT_MILLISECOND);
+  simulate(3, 80);
+
+  edge_t edge[3];
+  CHECK_EQUAL(sequencerEdges(edge, 3), 3);
+  CHECK_EQUAL(edge[1].scheduled, 2500000);
+  CHECK_EQUAL(edge[2].scheduled, 3000000);
+  CHECK(edge[1].actual - edge[1].scheduled <= 2);
+  CHECK(fired > 3);
+}
+
+static void testFraction(uint32_t freq) {
+  // a step duration that is not a whole number of cycles does not drift, the cycle counter
+  // wraps around a second after the start and the times in microseconds after 71 minutes
+  begin(freq, 0xFFFFFFFFUL - freq * 1000000UL);
+  static const unsigned int interval[] = {1};
+  uint64_t unit = UNIT_FREQUENCY(7);  // 7 Hz, i.e. 71428.57 us per phase
+  sequencerStart(interval, 1, unit);
+
+  edge_t edge[2];
+  simulate(1001, freq);
+  CHECK_EQUAL(sequencerEdges(edge, 1), 1);
+  CHECK_EQUAL(edge[0].scheduled, (uint32_t)(1000 * unit >> UNIT_SHIFT));
+  CHECK_CLOSE(edge[0].scheduled, 1000 * 1e6 / 14, 2);
+
+  // simulate two and a half hours
+  const unsigned long edges = 14UL * 9000 + 1;
+  simulate(edges, freq);
+  CHECK_EQUAL(shown, edges);
+  CHECK_EQUAL(sequencerEdges(edge, 2), 2);
+
+  // the times in microseconds wrapped around, differences between edges remain valid
+  uint64_t last = (edges - 1) * 1000000ULL / 14;
+  CHECK(last > 0xFFFFFFFFULL);
+  CHECK_CLOSE(edge[1].scheduled, (uint32_t)last, 1);
+  CHECK_CLOSE(edge[1].scheduled - edge[0].scheduled, 1e6 / 14, 1);
+  int32_t error = edge[1].actual - edge[1].scheduled;
+  CHECK(error >= -2 && error <= 2);
+
+  // the edge was shown at the right moment of the simulated time, after 9000 seconds
+  double late = elapsed / (double)freq - 9000e6;
+  printf("after 9000 s at %u MHz the last edge is %.2f us late\n", freq, late);
+  CHECK(late >= -2 && late <= 2);
+}
+
+static void testStop() {
+  // a sequence without any non-zero interval shows nothing and stops the timer
+  begin(80, 0);
+  static const unsigned int zero[] = {0, 0};
+  sequencerStart(zero, 2, UNIT_MILLISECOND);
+  simulate(10, 0);
+  CHECK_EQUAL(shown, 0);
+  CHECK_EQUAL(mockTimerTicks, 0);
+
+  // a stopped sequence does not show any more edges
+  static const unsigned int interval[] = {1};
+  sequencerStart(interval, 1, UNIT_MILLISECOND);
+  simulate(5, 0);
+  CHECK_EQUAL(shown, 5);
+  sequencerStop();
+  simulate(10, 0);
+  CHECK_EQUAL(shown, 5);  // the interrupt that was already armed fires once more, without an edge
+  CHECK_EQUAL(mockTimerTicks, 0);
+}
+
+int main() {
+  srand(1);
+  testTiming(80);
+  testTiming(160);
+  testLong();
+  testFraction(80);
+  testFraction(160);
+  testStop();
+  return report("test_sequencer");
+}
@@ -0,0 +1,136 @@
+// Host test of the bit-packed sequence store, and of streaming a stored sequence to the timer
+
+#include "check.h"
+#include "sequencer.h"
+#include "store.h"
+
+uint32_t mockCycles = 0;
+uint32_t mockCpuFreq = 80;
+uint32_t mockTimerTicks = 0;
+void (*mockTimerISR)(void) = NULL;
+MockESP ESP;
+MockSerial Serial;
+MockFS SPIFFS;
+
+static unsigned long shown = 0;
+
+extern "C" void espShow(uint8_t pin, uint8_t *pixels, uint32_t numBytes, boolean is800KHz) {
+  shown++;
+}
+
+static void upload(const char *text) {
+  File f = SPIFFS.open(STORE_UPLOAD, "w");
+  f.write((const uint8_t *)text, strlen(text));
+  f.close();
+}
+
+static void testEncode() {
+  upload(
+    "# step duration in us, followed by the intervals\n"
+    "1000 3 1 2\n"
+    "\n"
+    "12.5 1 65535 7\r\n"
+    "0 1 2 3\n"
+    "100\n"
+    "8 70000\n"
+    "1 1\n");
+
+  // the lines without a valid duration, without intervals or with a too large interval are skipped
+  CHECK_EQUAL(storeEncode(), 3);
+  CHECK_EQUAL(storeCount(), 3);
+  CHECK_EQUAL(SPIFFS.files[STORE_DIRECTORY].size(), 3 * sizeof(entry_t));
+
+  // 3 intervals of 2 bits, 3 intervals of 16 bits and 1 interval of 1 bit take 1 + 6 + 1 bytes
+  CHECK_EQUAL(SPIFFS.files[STORE_DATA].size(), 8);
+
+  uint64_t unit;
+  unsigned int interval, step;
+  CHECK(storeSelect(0, &unit));
+  CHECK_EQUAL(unit, UNIT_MILLISECOND);
+  static const unsigned int first[] = {3, 1, 2, 3, 1, 2, 3};
+  for (unsigned int k = 0; k < 7; k++) {
+    CHECK(storeNext(&interval, &step));
+    CHECK_EQUAL(interval, first[k]);
+    CHECK_EQUAL(step, k % 3);
+  }
+
+  // the step duration keeps its fractional part
+  CHECK(storeSelect(1, &unit));
+  CHECK_EQUAL(unit, 12.5 * (1 << UNIT_SHIFT));
+  static const unsigned int second[] = {1, 65535, 7, 1};
+  for (unsigned int k = 0; k < 4; k++) {
+    CHECK(storeNext(&interval, &step));
+    CHECK_EQUAL(interval, second[k]);
+  }
+
+  CHECK(storeSelect(2, &unit));
+  CHECK(storeNext(&interval, &step));
+  CHECK_EQUAL(interval, 1);
+
+  // there is no fourth sequence
+  CHECK(!storeSelect(3, &unit));
+}
+
+static void testTruncated() {
+  upload("1000 300 200 100 50\n");
+  CHECK_EQUAL(storeEncode(), 1);
+
+  // the data file is damaged after it was encoded, reading beyond the end fails instead of returning 0xFF
+  SPIFFS.files[STORE_DATA].resize(2);
+  uint64_t unit;
+  unsigned int interval, step;
+  CHECK(storeSelect(0, &unit));
+  CHECK(storeNext(&interval, &step));
+  CHECK_EQUAL(interval, 300);
+  CHECK(!storeNext(&interval, &step));
+}
+
+static void testStream() {
+  // the intervals of 1 ms are streamed through the FIFO from the main loop
+  upload("1000 1 1 1 1 1 1 1 1\n");
+  CHECK_EQUAL(storeEncode(), 1);
+
+  uint64_t unit;
+  unsigned int interval, step;
+  sequencerBegin(0);
+  sequencerEnable(true);
+  CHECK(storeSelect(0, &unit));
+  sequencerStream(unit);
+
+  for (unsigned int loop = 0; loop < 100; loop++) {
+    // the main loop runs every 10 ms, which is well within the FIFO size
+    for (unsigned int n = sequencerSpace(); n > 0; n--) {
+      CHECK(storeNext(&interval, &step));
+      sequencerPush(interval, step);
+    }
+    uint64_t until = 80000UL * 10;
+    while (mockTimerTicks && until > 0) {
+      uint32_t cycles = mockTimerTicks * 16;
+      mockTimerTicks = 0;
+      mockCycles += cycles;
+      until = (cycles < until ? until - cycles : 0);
+      mockTimerISR();
+    }
+  }
+  CHECK_EQUAL(sequencerUnderrun(), 0);
+  CHECK(shown >= 990 && shown <= 1000);
+
+  // without the main loop the FIFO runs empty
+  unsigned long before = shown;
+  for (unsigned int k = 0; k < 2 * FIFOSIZE; k++) {
+    uint32_t cycles = mockTimerTicks * 16;
+    mockTimerTicks = 0;
+    mockCycles += cycles;
+    mockTimerISR();
+  }
+  CHECK(shown - before <= FIFOSIZE);
+  CHECK(sequencerUnderrun() > 0);
+  sequencerStop();
+}
+
+int main() {
+  testEncode();
+  testTruncated();
+  testStream();
+  return report("test_store");
+}
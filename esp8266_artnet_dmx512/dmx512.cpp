@@ -0,0 +1,144 @@
+/*
+  This sends DMX512 frames over UART1, which is transmit-only and available on GPIO2 (D4).
+
+  The timing is done by hardware timer 1, independent of the rate at which Art-Net
+  packets arrive over WiFi. The break is generated by the UART itself, which holds its
+  output low while the break bit is set. After the mark-after-break the start code and
+  channels are written into the 128-byte transmit FIFO of the UART, which is topped up
+  from the timer interrupt while the frame is being sent.
+
+  The channels are double buffered: new values are written to the back buffer, which
+  is swapped with the front buffer at the start of the next frame.
+*/
+
+#include "dmx512.h"
+
+#define UART_DMX        1
+#define UART_FIFO_SIZE  128
+#define TIMER_TICKS(us) ((us) * 5)   // the timer runs at 5 MHz
+#define TIMER_REFILL    3000         // in microseconds, 128 slots take 5.6 ms
+#define SLOT_TIME       44           // in microseconds, for 11 bits at 250 kbaud
+
+enum {
+  STATE_BREAK,
+  STATE_MAB,
+  STATE_DATA,
+  STATE_DRAIN,
+};
+
+static uint8_t buffer[2][DMX_CHANNELS];
+static uint8_t * volatile front = buffer[0];
+static uint8_t * volatile back  = buffer[1];
+static volatile bool pending = false;
+
+static volatile uint8_t state = STATE_BREAK;
+static volatile unsigned int slot = 0;
+static volatile unsigned long frames = 0;
+static volatile uint32_t period = 0, nextFrame = 0;   // in CPU cycles
+static uint32_t cyclesPerMicrosecond = 80;
+
+/***************************************************************************/
+
+static inline void IRAM_ATTR fill() {
+  // slot 0 is the start code, the other slots are the channels
+  while (slot <= DMX_CHANNELS && ((USS(UART_DMX) >> USTXC) & 0xff) < UART_FIFO_SIZE) {
+    USF(UART_DMX) = (slot == 0 ? 0 : front[slot - 1]);
+    slot++;
+  }
+}
+
+static void IRAM_ATTR dmxISR() {
+  switch (state) {
+
+    case STATE_BREAK: {
+        // start a new frame with the most recent channel values
+        if (pending) {
+          uint8_t *swap = front;
+          front = back;
+          back = swap;
+          pending = false;
+        }
+        nextFrame = ESP.getCycleCount() + period;
+        USC0(UART_DMX) |= (1 << UCBRK);
+        state = STATE_MAB;
+        timer1_write(TIMER_TICKS(DMX_BREAK));
+        break;
+      }
+
+    case STATE_MAB:
+      USC0(UART_DMX) &= ~(1 << UCBRK);
+      slot = 0;
+      state = STATE_DATA;
+      timer1_write(TIMER_TICKS(DMX_MAB));
+      break;
+
+    case STATE_DATA:
+      fill();
+      if (slot > DMX_CHANNELS)
+        state = STATE_DRAIN;
+      timer1_write(TIMER_TICKS(TIMER_REFILL));
+      break;
+
+    case STATE_DRAIN: {
+        if ((USS(UART_DMX) >> USTXC) & 0xff) {
+          // wait for the FIFO to be empty
+          timer1_write(TIMER_TICKS(SLOT_TIME));
+          break;
+        }
+        frames++;
+        // the last slot is still in the shift register, the next break can start after it
+        int32_t remaining = (int32_t)(nextFrame - ESP.getCycleCount()) / (int32_t)cyclesPerMicrosecond;
+        if (remaining < SLOT_TIME)
+          remaining = SLOT_TIME;
+        else if (remaining > 1000000 / DMX_MINRATE)
+          remaining = 1000000 / DMX_MINRATE;
+        state = STATE_BREAK;
+        timer1_write(TIMER_TICKS(remaining));
+        break;
+      }
+  }
+}
+
+/***************************************************************************/
+
+void dmxBegin(unsigned int rate) {
+  memset(buffer, 0, sizeof(buffer));
+  pending = false;
+  state = STATE_BREAK;   // the first frame starts when the timer fires
+  // DMX512 uses 250 kbaud with 8 data bits, no parity and 2 stop bits
+  Serial1.begin(250000, SERIAL_8N2);
+  cyclesPerMicrosecond = ESP.getCpuFreqMHz();
+  dmxRate(rate);
+  timer1_isr_init();
+  timer1_attachInterrupt(dmxISR);
+  timer1_enable(TIM_DIV16, TIM_EDGE, TIM_SINGLE);
+  timer1_write(TIMER_TICKS(1000));
+}
+
+void dmxRate(unsigned int rate) {
+  rate = constrain(rate, DMX_MINRATE, DMX_MAXRATE);
+  period = cyclesPerMicrosecond * (1000000UL / rate);
+}
+
+void dmxWrite(const uint8_t *data, unsigned int length) {
+  // the timer interrupt should not swap the buffers halfway through the copy
+  length = (length < DMX_CHANNELS ? length : DMX_CHANNELS);
+  noInterrupts();
+  // channels beyond the length of the packet keep their most recent value
+  if (!pending && length < DMX_CHANNELS)
+    memcpy(back, front, DMX_CHANNELS);
+  memcpy(back, data, length);
+  pending = true;
+  interrupts();
+}
+
+void dmxBlackout() {
+  noInterrupts();
+  memset(back, 0, DMX_CHANNELS);
+  pending = true;
+  interrupts();
+}
+
+unsigned long dmxFrames() {
+  return frames;
+}
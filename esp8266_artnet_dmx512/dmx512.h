@@ -0,0 +1,18 @@
+#ifndef _DMX512_H_
+#define _DMX512_H_
+
+#include <Arduino.h>
+
+#define DMX_CHANNELS  512
+#define DMX_BREAK     176   // in microseconds, the standard requires at least 92
+#define DMX_MAB       12    // in microseconds, the standard requires at least 12
+#define DMX_MINRATE   20    // in frames per second
+#define DMX_MAXRATE   44    // in frames per second, which is the maximum for 512 channels
+
+void dmxBegin(unsigned int);
+void dmxRate(unsigned int);
+void dmxWrite(const uint8_t *, unsigned int);
+void dmxBlackout(void);
+unsigned long dmxFrames(void);
+
+#endif // _DMX512_H_
@@ -0,0 +1,174 @@
+/*
+  This sketch receives a DMX universe via Artnet and sends it out as DMX512 over a
+  MAX485 module. It uses the same Art-Net receive code as esp8266_artnet_neopixel.
+
+  https://github.com/rstephan/ArtnetWifi
+
+  The DMX512 output runs at a fixed refresh rate that is independent of the rate at
+  which the Art-Net packets arrive. When no packets arrive for longer than the timeout,
+  the output either holds the last look or goes to black.
+
+  Wiring scheme
+  - connect 3.3V and GND from the ESP8266 to Vcc and GND of the MAX485 module
+  - connect pin DE (data enable) and RE (receive enable) of the MAX485 module to 3.3V
+  - connect pin D4 (GPIO2, UART1 TX) of the ESP8266 to the DI (data in) pin of the MAX485
+  - connect pin A to XLR 3
+  - connect pin B to XLR 2
+  - connect GND   to XLR 1
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>         // https://github.com/esp8266/Arduino
+#include <ESP8266WebServer.h>
+#include <ESP8266mDNS.h>
+#include <WiFiManager.h>         // https://github.com/tzapu/WiFiManager
+#include <ArtnetWifi.h>          // https://github.com/rstephan/ArtnetWifi
+
+#include "webinterface.h"
+#include "dmx512.h"
+
+ESP8266WebServer server(80);
+const char* host = "ARTNET-DMX";
+const char* version = __DATE__ " / " __TIME__;
+
+// Artnet settings
+ArtnetWifi artnet;
+unsigned long packetCounter = 0;
+
+// keep track of the statistics
+long tic_packet = 0, tic_stats = 0;
+unsigned long packetPrevious = 0, framePrevious = 0;
+float packetRate = 0, frameRate = 0;
+bool timedOut = false;
+
+//this will be called for each UDP packet received
+void onDmxPacket(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
+  if (universe != config.universe)
+    return;
+  packetCounter++;
+  tic_packet = millis();
+  timedOut = false;
+  dmxWrite(data, length);
+} // onDmxpacket
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {
+    ;
+  }
+  Serial.println("setup starting");
+
+  SPIFFS.begin();
+
+  if (!loadConfig()) {
+    defaultConfig();
+    saveConfig();
+  }
+
+  dmxBegin(config.rate);
+
+  WiFiManager wifiManager;
+  wifiManager.setAPStaticIPConfig(IPAddress(192, 168, 1, 1), IPAddress(192, 168, 1, 1), IPAddress(255, 255, 255, 0));
+  wifiManager.autoConnect(host);
+  Serial.println("connected");
+
+  server.onNotFound(handleNotFound);
+
+  server.on("/", HTTP_GET, []() {
+    server.send(200, "text/plain", host);
+  });
+
+  server.on("/version", HTTP_GET, []() {
+    server.send(200, "text/plain", version);
+  });
+
+  server.on("/defaults", HTTP_GET, []() {
+    Serial.println("handleDefaults");
+    defaultConfig();
+    saveConfig();
+    server.send(200, "text/plain", "OK");
+    dmxRate(config.rate);
+  });
+
+  server.on("/restart", HTTP_GET, []() {
+    Serial.println("handleRestart");
+    server.send(200, "text/plain", "OK");
+    server.close();
+    server.stop();
+    SPIFFS.end();
+    delay(1000);
+    ESP.restart();
+  });
+
+  server.on("/json", HTTP_PUT, [] {
+    handleJSON();
+    dmxRate(config.rate);
+  });
+
+  server.on("/json", HTTP_POST, [] {
+    handleJSON();
+    dmxRate(config.rate);
+  });
+
+  server.on("/json", HTTP_GET, [] {
+    StaticJsonBuffer<300> jsonBuffer;
+    JsonObject& root = jsonBuffer.createObject();
+    N_CONFIG_TO_JSON(universe, "universe");
+    N_CONFIG_TO_JSON(rate, "rate");
+    N_CONFIG_TO_JSON(timeout, "timeout");
+    N_CONFIG_TO_JSON(hold, "hold");
+    root["version"]    = version;
+    root["uptime"]     = long(millis() / 1000);
+    root["packets"]    = packetCounter;
+    root["frames"]     = dmxFrames();
+    root["packetrate"] = packetRate;
+    root["framerate"]  = frameRate;
+    root["timedout"]   = timedOut;
+    String str;
+    root.printTo(str);
+    server.send(200, "application/json", str);
+  });
+
+  // start the web server
+  server.begin();
+
+  // announce the hostname and web server through zeroconf
+  MDNS.begin(host);
+  MDNS.addService("http", "tcp", 80);
+
+  artnet.begin();
+  artnet.setArtDmxCallback(onDmxPacket);
+
+  tic_packet = millis();
+  tic_stats  = millis();
+
+  Serial.println("setup done");
+} // setup
+
+void loop() {
+  server.handleClient();
+  artnet.read();
+
+  // apply the policy for when the Art-Net packets stop
+  if (!timedOut && config.timeout > 0 && (millis() - tic_packet) > config.timeout) {
+    Serial.println("timeout");
+    timedOut = true;
+    if (!config.hold)
+      dmxBlackout();
+  }
+
+  // update the statistics once per second
+  if ((millis() - tic_stats) >= 1000) {
+    float elapsed = (millis() - tic_stats) / 1000.;
+    unsigned long frameCounter = dmxFrames();
+    packetRate = (packetCounter - packetPrevious) / elapsed;
+    frameRate  = (frameCounter - framePrevious) / elapsed;
+    packetPrevious = packetCounter;
+    framePrevious  = frameCounter;
+    tic_stats = millis();
+    Serial.print("packets/s = ");
+    Serial.print(packetRate);
+    Serial.print(", frames/s = ");
+    Serial.println(frameRate);
+  }
+} // loop
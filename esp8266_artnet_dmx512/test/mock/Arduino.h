@@ -0,0 +1,130 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the ESP8266 Arduino core for the host tests, it
+// only provides what dmx512.cpp uses. The cycle counter and the hardware timer are
+// advanced by the test. The transmit FIFO and shift register of UART1 are simulated
+// on the same timeline, every byte that leaves the FIFO and every change of the
+// break bit is recorded with the cycle count at which it happens.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <vector>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define IRAM_ATTR
+
+#define TIM_DIV16  1
+#define TIM_EDGE   0
+#define TIM_SINGLE 0
+
+#define SERIAL_8N2 0x3c
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// the cycle counter and the time at which the timer fires are advanced by the test
+extern uint32_t mockCycles;
+extern uint32_t mockCpuFreq;
+extern uint32_t mockTimerTicks;    // in timer ticks at 5 MHz, 0 when the timer is not armed
+extern void (*mockTimerISR)(void);
+
+class MockESP {
+  public:
+    uint32_t getCycleCount() { return mockCycles; }
+    uint8_t getCpuFreqMHz() { return mockCpuFreq; }
+};
+
+extern MockESP ESP;
+
+inline void timer1_isr_init() {}
+inline void timer1_attachInterrupt(void (*isr)(void)) { mockTimerISR = isr; }
+inline void timer1_enable(uint8_t, uint8_t, uint8_t) {}
+inline void timer1_write(uint32_t ticks) { mockTimerTicks = ticks; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+/***************************************************************************/
+
+#define USTXC 16   // the number of bytes in the transmit FIFO, in the status register
+#define UCBRK 8    // the break bit, in the configuration register
+
+struct MockEvent {
+  uint32_t time;   // in CPU cycles
+  int value;       // the byte that is sent, or -1 and -2 for the start and end of the break
+};
+
+class MockUart {
+  public:
+    unsigned long baud = 0;
+    uint32_t config = 0;
+    std::deque<MockEvent> fifo;     // with the time at which the byte was written
+    std::vector<MockEvent> line;    // what is sent on the line
+    uint32_t busyUntil = 0;         // the shift register is sending until then
+    bool started = false;
+
+    // the time that one byte with start bit, 8 data bits and 2 stop bits takes
+    uint32_t slotCycles() { return mockCpuFreq * 44; }
+
+    // move the bytes from the FIFO to the line until the current time
+    void advance() {
+      while (!fifo.empty()) {
+        uint32_t start = fifo.front().time;
+        if (started && (int32_t)(busyUntil - start) > 0)
+          start = busyUntil;
+        if ((int32_t)(start - mockCycles) > 0)
+          break;
+        line.push_back({start, fifo.front().value});
+        fifo.pop_front();
+        busyUntil = start + slotCycles();
+        started = true;
+      }
+    }
+
+    uint32_t status() { advance(); return (uint32_t)fifo.size() << USTXC; }
+
+    void write(uint8_t c) {
+      advance();
+      if (fifo.size() >= 128)
+        printf("MockUart: transmit FIFO overflow\n");
+      else
+        fifo.push_back({mockCycles, c});
+    }
+
+    void setConfig(uint32_t value) {
+      advance();
+      if ((value ^ config) & (1 << UCBRK))
+        line.push_back({mockCycles, (value & (1 << UCBRK)) ? -1 : -2});
+      config = value;
+    }
+};
+
+extern MockUart mockUart;
+
+// the registers of the UART are replaced by proxies that operate on the simulated UART
+struct MockFifoRegister {
+  void operator=(uint32_t c) { mockUart.write(c & 0xff); }
+};
+
+struct MockConfigRegister {
+  operator uint32_t() { return mockUart.config; }
+  void operator|=(uint32_t bits) { mockUart.setConfig(mockUart.config | bits); }
+  void operator&=(uint32_t bits) { mockUart.setConfig(mockUart.config & bits); }
+};
+
+#define USS(u)  (mockUart.status())
+#define USF(u)  (MockFifoRegister())
+#define USC0(u) (MockConfigRegister())
+
+class MockSerial1 {
+  public:
+    void begin(unsigned long baud, uint32_t config) { mockUart.baud = baud; mockUart.config = config; }
+};
+
+extern MockSerial1 Serial1;
+
+#endif // _ARDUINO_H_
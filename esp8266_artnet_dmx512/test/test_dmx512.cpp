@@ -0,0 +1,181 @@
+// Host simulation of the DMX512 output on a UART timeline
+//
+// The timer interrupt is called whenever the simulated timer fires, the UART
+// shifts the bytes out of its FIFO at 250 kbaud. The recorded line is split in
+// frames, of which the break, the mark-after-break and the slot timing are checked.
+
+#include "check.h"
+#include "dmx512.h"
+
+uint32_t mockCycles = 0;
+uint32_t mockCpuFreq = 80;
+uint32_t mockTimerTicks = 0;
+void (*mockTimerISR)(void) = NULL;
+MockESP ESP;
+MockUart mockUart;
+MockSerial1 Serial1;
+
+struct Frame {
+  uint32_t breakStart, breakEnd;   // in CPU cycles
+  std::vector<MockEvent> slot;
+};
+
+// run the timer for the given number of microseconds, with a random interrupt latency
+static void simulate(uint32_t duration, uint32_t maxLatency) {
+  uint64_t until = (uint64_t)duration * mockCpuFreq;
+  while (mockTimerTicks) {
+    uint32_t cycles = mockTimerTicks * (mockCpuFreq / 5) + (maxLatency ? rand() % (maxLatency * mockCpuFreq) : 0);
+    if (cycles > until)
+      break;
+    mockTimerTicks = 0;
+    mockCycles += cycles;
+    until -= cycles;
+    mockTimerISR();
+  }
+  mockCycles += until;
+  mockUart.advance();
+}
+
+// split the line in complete frames, the bytes before the first break are skipped
+static std::vector<Frame> frames() {
+  std::vector<Frame> result;
+  for (const MockEvent &e : mockUart.line) {
+    if (e.value == -1) {
+      Frame f = {e.time, 0};
+      result.push_back(f);
+    }
+    else if (e.value == -2 && !result.empty())
+      result.back().breakEnd = e.time;
+    else if (!result.empty())
+      result.back().slot.push_back(e);
+  }
+  // the last frame is probably incomplete
+  if (!result.empty())
+    result.pop_back();
+  return result;
+}
+
+static void begin(uint32_t freq, unsigned int rate) {
+  mockCpuFreq = freq;
+  mockCycles = 0xFFFFFFFFUL - freq * 100000UL;   // the cycle counter wraps around after 100 ms
+  mockUart = MockUart();
+  ESP = MockESP();
+  dmxBegin(rate);
+}
+
+static void testTiming(uint32_t freq, unsigned int rate) {
+  begin(freq, rate);
+  CHECK_EQUAL(mockUart.baud, 250000);
+  CHECK_EQUAL(mockUart.config & ~(1 << UCBRK), SERIAL_8N2);
+
+  uint8_t data[DMX_CHANNELS];
+  for (int i = 0; i < DMX_CHANNELS; i++)
+    data[i] = i & 0xff;
+  dmxWrite(data, DMX_CHANNELS);
+
+  // the interrupt latency is up to 2 microseconds
+  simulate(1000000, 2);
+  std::vector<Frame> frame = frames();
+
+  // the frame rate does not depend on anything else than the timer, 512 channels take at most 44 Hz
+  unsigned int expected = (rate > 43 ? 43 : rate);
+  CHECK(frame.size() >= expected - 1 && frame.size() <= expected);
+  CHECK(dmxFrames() >= frame.size());
+
+  for (unsigned int k = 0; k < frame.size(); k++) {
+    const Frame &f = frame[k];
+    double breakTime = (double)(uint32_t)(f.breakEnd - f.breakStart) / freq;
+    CHECK(breakTime >= 92 && breakTime <= DMX_BREAK + 5);
+
+    // the start code and all channels are sent, with the mark-after-break before the start code
+    CHECK_EQUAL(f.slot.size(), DMX_CHANNELS + 1);
+    if (f.slot.size() != DMX_CHANNELS + 1)
+      continue;
+    double mab = (double)(uint32_t)(f.slot[0].time - f.breakEnd) / freq;
+    CHECK(mab >= 12 && mab <= DMX_MAB + 5);
+    CHECK_EQUAL(f.slot[0].value, 0);
+    CHECK_EQUAL(f.slot[1].value, 0);
+    CHECK_EQUAL(f.slot[DMX_CHANNELS].value, (DMX_CHANNELS - 1) & 0xff);
+
+    // the FIFO is topped up in time, hence the slots follow each other without a gap
+    uint32_t maxGap = 0;
+    for (unsigned int i = 1; i < f.slot.size(); i++) {
+      uint32_t gap = f.slot[i].time - f.slot[i - 1].time;
+      maxGap = (gap > maxGap ? gap : maxGap);
+    }
+    CHECK_EQUAL(maxGap, 44 * freq);
+
+    if (k + 1 < frame.size()) {
+      // the next break does not cut off the last slot, and starts one period after this one
+      CHECK((int32_t)(frame[k + 1].breakStart - f.slot.back().time) >= (int32_t)(44 * freq));
+      double period = (double)(uint32_t)(frame[k + 1].breakStart - f.breakStart) / freq;
+      if (rate <= 43)
+        CHECK_CLOSE(period, 1e6 / rate, 5);
+      else
+        CHECK(period >= 1e6 / DMX_MAXRATE && period <= 1e6 / 43);
+    }
+  }
+}
+
+static void testDoubleBuffer() {
+  begin(80, 40);
+  uint8_t one[DMX_CHANNELS], two[4] = {2, 2, 2, 2};
+  memset(one, 1, sizeof(one));
+  dmxWrite(one, sizeof(one));
+
+  // the new values are written halfway through a frame, that frame still has the old values
+  simulate(10000, 0);
+  dmxWrite(two, sizeof(two));
+  simulate(100000, 0);
+  std::vector<Frame> frame = frames();
+  CHECK(frame.size() >= 3);
+  CHECK_EQUAL(frame[0].slot[1].value, 1);
+  CHECK_EQUAL(frame[0].slot[4].value, 1);
+
+  // a shorter packet only replaces the first channels
+  CHECK_EQUAL(frame[1].slot[1].value, 2);
+  CHECK_EQUAL(frame[1].slot[4].value, 2);
+  CHECK_EQUAL(frame[1].slot[5].value, 1);
+  CHECK_EQUAL(frame[1].slot[DMX_CHANNELS].value, 1);
+
+  // two packets within one frame are combined, the most recent one wins
+  dmxWrite(one, sizeof(one));
+  dmxWrite(two, 2);
+  mockUart.line.clear();
+  simulate(100000, 0);
+  frame = frames();
+  CHECK(frame.size() >= 2);
+  CHECK_EQUAL(frame[1].slot[1].value, 2);
+  CHECK_EQUAL(frame[1].slot[3].value, 1);
+
+  // the blackout takes effect at the next frame
+  dmxBlackout();
+  mockUart.line.clear();
+  simulate(100000, 0);
+  frame = frames();
+  CHECK(frame.size() >= 2);
+  CHECK_EQUAL(frame[1].slot[1].value, 0);
+  CHECK_EQUAL(frame[1].slot[DMX_CHANNELS].value, 0);
+}
+
+static void testRate() {
+  // the rate is limited to what the standard allows
+  begin(80, 100);
+  simulate(1000000, 0);
+  CHECK(frames().size() >= 42 && frames().size() <= 43);
+  dmxRate(1);
+  mockUart.line.clear();
+  simulate(1000000, 0);
+  CHECK(frames().size() >= 19 && frames().size() <= 20);
+}
+
+int main() {
+  srand(1);
+  testTiming(80, 20);
+  testTiming(80, 40);
+  testTiming(160, 40);
+  testTiming(80, 44);
+  testDoubleBuffer();
+  testRate();
+  return report("test_dmx512");
+}
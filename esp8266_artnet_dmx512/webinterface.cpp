@@ -0,0 +1,114 @@
+#include "webinterface.h"
+
+Config config;
+extern ESP8266WebServer server;
+
+/***************************************************************************/
+
+bool defaultConfig() {
+  Serial.println("defaultConfig");
+
+  config.universe = 1;
+  config.rate = 40;
+  config.timeout = 0;
+  config.hold = 1;
+  return true;
+}
+
+bool loadConfig() {
+  Serial.println("loadConfig");
+
+  File configFile = SPIFFS.open("/config.json", "r");
+  if (!configFile) {
+    Serial.println("Failed to open config file");
+    return false;
+  }
+
+  size_t size = configFile.size();
+  if (size > 1024) {
+    Serial.println("Config file size is too large");
+    return false;
+  }
+
+  std::unique_ptr<char[]> buf(new char[size + 1]);
+  configFile.readBytes(buf.get(), size);
+  configFile.close();
+  buf[size] = 0;
+
+  StaticJsonBuffer<300> jsonBuffer;
+  JsonObject& root = jsonBuffer.parseObject(buf.get());
+
+  if (!root.success()) {
+    Serial.println("Failed to parse config file");
+    return false;
+  }
+
+  N_JSON_TO_CONFIG(universe, "universe");
+  N_JSON_TO_CONFIG(rate, "rate");
+  N_JSON_TO_CONFIG(timeout, "timeout");
+  N_JSON_TO_CONFIG(hold, "hold");
+
+  return true;
+}
+
+bool saveConfig() {
+  Serial.println("saveConfig");
+  StaticJsonBuffer<300> jsonBuffer;
+  JsonObject& root = jsonBuffer.createObject();
+
+  N_CONFIG_TO_JSON(universe, "universe");
+  N_CONFIG_TO_JSON(rate, "rate");
+  N_CONFIG_TO_JSON(timeout, "timeout");
+  N_CONFIG_TO_JSON(hold, "hold");
+
+  File configFile = SPIFFS.open("/config.json", "w");
+  if (!configFile) {
+    Serial.println("Failed to open config file for writing");
+    return false;
+  }
+  else {
+    Serial.println("Writing to config file");
+    root.printTo(configFile);
+    configFile.close();
+    return true;
+  }
+}
+
+void handleNotFound() {
+  Serial.print("handleNotFound: ");
+  Serial.println(server.uri());
+  server.send(404, "text/plain", "not found");
+}
+
+void handleJSON() {
+  // this gets called in response to either a PUT or a POST
+  Serial.println("handleJSON");
+
+  if (server.hasArg("universe") || server.hasArg("rate") || server.hasArg("timeout") || server.hasArg("hold")) {
+    // the body is key1=val1&key2=val2&key3=val3 and the ESP8266Webserver has already parsed it
+    N_KEYVAL_TO_CONFIG(universe, "universe");
+    N_KEYVAL_TO_CONFIG(rate, "rate");
+    N_KEYVAL_TO_CONFIG(timeout, "timeout");
+    N_KEYVAL_TO_CONFIG(hold, "hold");
+  }
+  else if (server.hasArg("plain")) {
+    // parse the body as JSON object
+    StaticJsonBuffer<300> jsonBuffer;
+    JsonObject& root = jsonBuffer.parseObject(server.arg("plain"));
+    if (!root.success()) {
+      server.send(400, "text/plain", "invalid JSON");
+      return;
+    }
+    N_JSON_TO_CONFIG(universe, "universe");
+    N_JSON_TO_CONFIG(rate, "rate");
+    N_JSON_TO_CONFIG(timeout, "timeout");
+    N_JSON_TO_CONFIG(hold, "hold");
+  }
+  else {
+    server.send(400, "text/plain", "no settings");
+    return; // do not save the configuration
+  }
+
+  server.send(200, "text/plain", "OK");
+  saveConfig();
+}
@@ -16,6 +16,8 @@
 
 #include "webinterface.h"
 #include "neopixel_mode.h"
+#include "textscroll.h"
+#include "segment.h"
 
 ESP8266WebServer server(80);
 const char* host = "ARTNET";
@@ -97,6 +99,7 @@ void setup() {
 
   SPIFFS.begin();
   strip.begin();
+  textInit();
 
   if (loadConfig()) {
     updateNeopixelStrip();
@@ -105,6 +108,7 @@ void setup() {
     delay(1000);
   }
   else {
+    resolveSegments();
     updateNeopixelStrip();
     strip.setBrightness(255);
     singleRed();
@@ -193,7 +197,7 @@ void setup() {
   server.on("/json", HTTP_GET, [] {
     Serial.println("HTTP_GET /json");
     tic_web = millis();
-    StaticJsonBuffer<300> jsonBuffer;
+    DynamicJsonBuffer jsonBuffer;
     JsonObject& root = jsonBuffer.createObject();
     N_CONFIG_TO_JSON(universe, "universe");
     N_CONFIG_TO_JSON(offset, "offset");
@@ -206,6 +210,10 @@ void setup() {
     N_CONFIG_TO_JSON(reverse, "reverse");
     N_CONFIG_TO_JSON(speed, "speed");
     N_CONFIG_TO_JSON(split, "split");
+    N_CONFIG_TO_JSON(panels, "panels");
+    N_CONFIG_TO_JSON(layout, "layout");
+    S_CONFIG_TO_JSON(text, "text");
+    segmentsToJSON(root);
     root["version"] = version;
     root["uptime"]  = long(millis() / 1000);
     root["packets"] = packetCounter;
@@ -216,6 +224,21 @@ void setup() {
     server.send(200, "application/json", str);
   });
 
+  server.on("/text", HTTP_GET, [] {
+    Serial.println("HTTP_GET /text");
+    server.send(200, "text/plain", config.text);
+  });
+
+  server.on("/text", HTTP_PUT, [] {
+    Serial.println("HTTP_PUT /text");
+    handleText();
+  });
+
+  server.on("/text", HTTP_POST, [] {
+    Serial.println("HTTP_POST /text");
+    handleText();
+  });
+
   server.on("/update", HTTP_GET, [] {
     tic_web = millis();
     handleStaticFile("/update.html");
@@ -260,12 +283,16 @@ void loop() {
 
     // this section gets executed at a maximum rate of around 100Hz
     if ((millis() - tic_loop) > 9) {
-      if (config.mode >= 0 && config.mode < (sizeof(mode) / 4)) {
-        // call the function corresponding to the current mode
-        (*mode[config.mode]) (global.universe, global.length, global.sequence, global.data);
-        tic_loop = millis();
-        frameCounter++;
+      for (int i = 0; i < nsegment; i++) {
+        seg = &segment[i];
+        if (seg->mode >= 0 && seg->mode < (sizeof(mode) / 4)) {
+          // call the function corresponding to the mode of this segment
+          (*mode[seg->mode]) (global.universe, global.length, global.sequence, global.data);
+        }
       }
+      strip.show();
+      tic_loop = millis();
+      frameCounter++;
     }
   }
 
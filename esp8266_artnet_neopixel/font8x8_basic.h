@@ -22,7 +22,7 @@
 
 // Constant: font8x8_basic
 // Contains an 8x8 font map for unicode points U+0000 - U+007F (basic latin)
-char font8x8_basic[128][8] = {
+const uint8_t font8x8_basic[128][8] = {
     { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   // U+0000 (nul)
     { B00110110, B01111111, B01111111, B01111111, B00111110, B00011100, B00001000, B00000000}, // U+2764 (heart, see https://en.wikipedia.org/wiki/Dingbat)
     { B00000000, B00000000, B00000000, B00000000, B00000000, B00000000, B00000000, B00000000},   // U+0002
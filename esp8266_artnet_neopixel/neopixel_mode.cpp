@@ -1,11 +1,12 @@
 #include "neopixel_mode.h"
 #include "webinterface.h"
 #include "colorspace.h"
-#include "font8x8_basic.h"
+#include "textscroll.h"
+#include "segment.h"
 
 extern Adafruit_NeoPixel strip;
 extern long tic_frame;
-float prev;
+float prev[MAXSEGMENT];  // the phase of the previous frame, for each segment
 
 int gamma_l[] = {
   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
@@ -40,31 +41,30 @@ int gamma_l[] = {
 */
 
 void mode0(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+  int i = 0, r, g, b, w = 0;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 3 * strip.numPixels() + 1)
+  if (RGB && (length - seg->offset) < 3 * seg->numPixels() + 1)
     return;
-  if (RGBW && (length - config.offset) < 4 * strip.numPixels() + 1)
+  if (RGBW && (length - seg->offset) < 4 * seg->numPixels() + 1)
     return;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    r         = data[config.offset + i++];
-    g         = data[config.offset + i++];
-    b         = data[config.offset + i++];
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    r         = data[seg->offset + i++];
+    g         = data[seg->offset + i++];
+    b         = data[seg->offset + i++];
     if (RGBW)
-      w       = data[config.offset + i++];
+      w       = data[seg->offset + i++];
 
     if (config.hsv)
       map_hsv_to_rgb(&r, &g, &b);
 
     if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
+      seg->setPixelColor(pixel, r, g, b);
     else if (RGBW)
-      strip.setPixelColor(pixel, r, g, b, w);
+      seg->setPixelColor(pixel, r, g, b, w);
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -77,20 +77,20 @@ void mode0(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode1(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+  int i = 0, r, g, b, w = 0;
   float intensity;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 3 + 1)
+  if (RGB && (length - seg->offset) < 3 + 1)
     return;
-  if (RGBW && (length - config.offset) < 4 + 1)
+  if (RGBW && (length - seg->offset) < 4 + 1)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
+    w       = data[seg->offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
@@ -101,14 +101,13 @@ void mode1(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   b = intensity * b;
   w = intensity * w;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
     if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
+      seg->setPixelColor(pixel, r, g, b);
     else if (RGBW)
-      strip.setPixelColor(pixel, r, g, b, w);
+      seg->setPixelColor(pixel, r, g, b, w);
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -126,26 +125,26 @@ void mode1(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode2(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
   float balance, intensity;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 2 * 3 + 2)
+  if (RGB && (length - seg->offset) < 2 * 3 + 2)
     return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 2)
+  if (RGBW && (length - seg->offset) < 2 * 4 + 2)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  r2        = data[config.offset + i++];
-  g2        = data[config.offset + i++];
-  b2        = data[config.offset + i++];
+    w       = data[seg->offset + i++];
+  r2        = data[seg->offset + i++];
+  g2        = data[seg->offset + i++];
+  b2        = data[seg->offset + i++];
   if (RGBW)
-    w2      = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  balance   = 1. * data[config.offset + i++] / 255.;
+    w2      = data[seg->offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
+  balance   = 1. * data[seg->offset + i++] / 255.;
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -164,14 +163,13 @@ void mode2(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   b = intensity * b;
   w = intensity * w;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
     if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
+      seg->setPixelColor(pixel, r, g, b);
     else if (RGBW)
-      strip.setPixelColor(pixel, r, g, b, w);
+      seg->setPixelColor(pixel, r, g, b, w);
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -187,26 +185,26 @@ void mode2(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+  int i = 0, r, g, b, w = 0;
   float intensity, speed, ramp, duty, phase, balance;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < (3 + 4) * config.split)
+  if (RGB && (length - seg->offset) < (3 + 4) * config.split)
     return;
-  if (RGBW && (length - config.offset) < (4 + 4) * config.split)
+  if (RGBW && (length - seg->offset) < (4 + 4) * config.split)
     return;
 
-  // the code that takes care of the blinking repeats for each of the segments
-  for (int segment = 0; segment < config.split; segment++) {
-    r         = data[config.offset + i++];
-    g         = data[config.offset + i++];
-    b         = data[config.offset + i++];
+  // the code that takes care of the blinking repeats for each of the parts
+  for (int part = 0; part < config.split; part++) {
+    r         = data[seg->offset + i++];
+    g         = data[seg->offset + i++];
+    b         = data[seg->offset + i++];
     if (RGBW)
-      w       = data[config.offset + i++];
-    intensity = data[config.offset + i++] / 255.;
-    speed     = 1. * data[config.offset + i++] / config.speed;
-    ramp      = 1. * data[config.offset + i++] * 360. / 255.;
-    duty      = 1. * data[config.offset + i++] * 360. / 255.;
+      w       = data[seg->offset + i++];
+    intensity = data[seg->offset + i++] / 255.;
+    speed     = 1. * data[seg->offset + i++] / config.speed;
+    ramp      = 1. * data[seg->offset + i++] * 360. / 255.;
+    duty      = 1. * data[seg->offset + i++] * 360. / 255.;
 
     if (config.hsv)
       map_hsv_to_rgb(&r, &g, &b);
@@ -221,11 +219,11 @@ void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
     phase = (speed * millis()) * 360. / 1000.;
 
     // prevent rolling back
-    // only feasible with a single segment
-    if (config.split == 1 && WRAP180(phase - prev) < 0)
-      phase = prev;
+    // only feasible when the segment is not split in parts
+    if (config.split == 1 && WRAP180(phase - prev[seg - segment]) < 0)
+      phase = prev[seg - segment];
     else
-      prev = phase;
+      prev[seg - segment] = phase;
 
     phase = WRAP180(phase);
     phase = ABS(phase);
@@ -234,7 +232,7 @@ void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
       balance = 1;
     else if (phase >= (duty / 2 + ramp / 4))
       balance = 0;
-    else if (ramp > 0)
+    else
       balance = ((duty / 2 + ramp / 4) - phase) / ( ramp / 2 );
 
     // scale with the intensity
@@ -249,17 +247,16 @@ void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
     b *= balance;
     w *= balance;
 
-    int begpixel = MAX((segment + 0) * strip.numPixels() / config.split, 0);
-    int endpixel = MIN((segment + 1) * strip.numPixels() / config.split, strip.numPixels());
+    int begpixel = MAX((part + 0) * seg->numPixels() / config.split, 0);
+    int endpixel = MIN((part + 1) * seg->numPixels() / config.split, seg->numPixels());
     for (int pixel = begpixel; pixel < endpixel; pixel++) {
       if (RGB)
-        strip.setPixelColor(pixel, r, g, b);
+        seg->setPixelColor(pixel, r, g, b);
       else if (RGBW)
-        strip.setPixelColor(pixel, r, g, b, w);
+        seg->setPixelColor(pixel, r, g, b, w);
       yield();
     }
   }
-  strip.show();
 }
 
 /*
@@ -279,28 +276,28 @@ void mode3(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
   float intensity, speed, ramp, duty, phase, balance;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 2 * 3 + 4)
+  if (RGB && (length - seg->offset) < 2 * 3 + 4)
     return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 4)
+  if (RGBW && (length - seg->offset) < 2 * 4 + 4)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  r2        = data[config.offset + i++];
-  g2        = data[config.offset + i++];
-  b2        = data[config.offset + i++];
+    w       = data[seg->offset + i++];
+  r2        = data[seg->offset + i++];
+  g2        = data[seg->offset + i++];
+  b2        = data[seg->offset + i++];
   if (RGBW)
-    w2      = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  speed     = 1. * data[config.offset + i++] / config.speed;
-  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
-  duty      = 1. * data[config.offset + i++] * 360. / 255.;
+    w2      = data[seg->offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
+  speed     = 1. * data[seg->offset + i++] / config.speed;
+  ramp      = 1. * data[seg->offset + i++] * 360. / 255.;
+  duty      = 1. * data[seg->offset + i++] * 360. / 255.;
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -317,10 +314,10 @@ void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   phase = (speed * millis()) * 360. / 1000.;
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
-    phase = prev;
+  if (WRAP180(phase - prev[seg - segment]) < 0)
+    phase = prev[seg - segment];
   else
-    prev = phase;
+    prev[seg - segment] = phase;
 
   phase = WRAP180(phase);
   phase = ABS(phase);
@@ -329,7 +326,7 @@ void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
     balance = 1;
   else if (phase >= (duty / 2 + ramp / 4))
     balance = 0;
-  else if (ramp > 0)
+  else
     balance = ((duty / 2 + ramp / 4) - phase) / ( ramp / 2 );
 
   // apply the balance between the two colors
@@ -344,14 +341,13 @@ void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   b = intensity * b;
   w = intensity * w;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
     if (RGB)
-      strip.setPixelColor(pixel, r, g, b);
+      seg->setPixelColor(pixel, r, g, b);
     else if (RGBW)
-      strip.setPixelColor(pixel, r, g, b, w);
+      seg->setPixelColor(pixel, r, g, b, w);
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -366,22 +362,22 @@ void mode4(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+  int i = 0, r, g, b, w = 0;
   float intensity, width, position;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 3 + 3)
+  if (RGB && (length - seg->offset) < 3 + 3)
     return;
-  if (RGBW && (length - config.offset) < 4 + 3)
+  if (RGBW && (length - seg->offset) < 4 + 3)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * (strip.numPixels() - 1) / 255.;
-  width     = data[config.offset + i++] * (strip.numPixels() - 0) / 255.;
+    w       = data[seg->offset + i++];
+  intensity = data[seg->offset + i++] / 255.;
+  position  = data[seg->offset + i++] * (seg->numPixels() - 1) / 255.;
+  width     = data[seg->offset + i++] * (seg->numPixels() - 0) / 255.;
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
@@ -393,20 +389,20 @@ void mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   w = intensity * w;
 
   // the position needs to be corrected for the width
-  position -= strip.numPixels() / 2;
-  position /= strip.numPixels() / 2;
-  position *= (strip.numPixels() - width) / 2;
-  position += strip.numPixels() / 2;
+  position -= seg->numPixels() / 2;
+  position /= seg->numPixels() / 2;
+  position *= (seg->numPixels() - width) / 2;
+  position += seg->numPixels() / 2;
 
   // express the position and with as phase along the strip
-  position *= 360. / strip.numPixels();
-  width    *= 360. / strip.numPixels();
+  position *= 360. / seg->numPixels();
+  width    *= 360. / seg->numPixels();
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
     float phase, balance;
 
-    phase = WRAP180((360. * flip * pixel / strip.numPixels()) * config.split - position);
+    phase = WRAP180((360. * flip * pixel / seg->numPixels()) * config.split - position);
     phase = ABS(phase);
 
     if (width == 0)
@@ -417,12 +413,11 @@ void mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
       balance = 0;
 
     if (RGB)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b);
+      seg->setPixelColor(pixel, balance * r, balance * g, balance * b);
     else if (RGBW)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
+      seg->setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -441,27 +436,27 @@ void mode5(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
   float intensity, width, position;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 2 * 3 + 3)
+  if (RGB && (length - seg->offset) < 2 * 3 + 3)
     return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 3)
+  if (RGBW && (length - seg->offset) < 2 * 4 + 3)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  r2        = data[config.offset + i++];
-  g2        = data[config.offset + i++];
-  b2        = data[config.offset + i++];
+    w       = data[seg->offset + i++];
+  r2        = data[seg->offset + i++];
+  g2        = data[seg->offset + i++];
+  b2        = data[seg->offset + i++];
   if (RGBW)
-    w2      = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * (strip.numPixels() - 1) / 255.;
-  width     = data[config.offset + i++] * (strip.numPixels() - 0) / 255.;
+    w2      = data[seg->offset + i++];
+  intensity = data[seg->offset + i++] / 255.;
+  position  = data[seg->offset + i++] * (seg->numPixels() - 1) / 255.;
+  width     = data[seg->offset + i++] * (seg->numPixels() - 0) / 255.;
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -469,20 +464,20 @@ void mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   }
 
   // the position needs to be corrected for the width
-  position -= strip.numPixels() / 2;
-  position /= strip.numPixels() / 2;
-  position *= (strip.numPixels() - width) / 2;
-  position += strip.numPixels() / 2;
+  position -= seg->numPixels() / 2;
+  position /= seg->numPixels() / 2;
+  position *= (seg->numPixels() - width) / 2;
+  position += seg->numPixels() / 2;
 
   // express the position and with as phase along the strip
-  position *= 360. / strip.numPixels();
-  width    *= 360. / strip.numPixels();
+  position *= 360. / seg->numPixels();
+  width    *= 360. / seg->numPixels();
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
     float phase, balance;
 
-    phase = WRAP180((360. * flip * pixel / (strip.numPixels() - 1)) * config.split - position);
+    phase = WRAP180((360. * flip * pixel / (seg->numPixels() - 1)) * config.split - position);
     phase = ABS(phase);
 
     if (width == 0)
@@ -493,12 +488,11 @@ void mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
       balance = 0;
 
     if (RGB)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
+      seg->setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
     else if (RGBW)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
+      seg->setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -514,23 +508,23 @@ void mode6(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode7(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+  int i = 0, r, g, b, w = 0;
   float intensity, position, width, ramp;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 3 + 4)
+  if (RGB && (length - seg->offset) < 3 + 4)
     return;
-  if (RGBW && (length - config.offset) < 4 + 4)
+  if (RGBW && (length - seg->offset) < 4 + 4)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * 360. / 255.;
-  width     = data[config.offset + i++] * 360. / 255.;
-  ramp      = data[config.offset + i++] * 360. / 255.;
+    w       = data[seg->offset + i++];
+  intensity = data[seg->offset + i++] / 255.;
+  position  = data[seg->offset + i++] * 360. / 255.;
+  width     = data[seg->offset + i++] * 360. / 255.;
+  ramp      = data[seg->offset + i++] * 360. / 255.;
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
@@ -547,29 +541,28 @@ void mode7(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   b = intensity * b;
   w = intensity * w;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
     float phase, balance;
 
-    phase = WRAP180(360. * flip * pixel / (strip.numPixels() - 1) * config.split - position);
+    phase = WRAP180(360. * flip * pixel / (seg->numPixels() - 1) * config.split - position);
     phase = ABS(phase);
 
     if (width == 0)
       balance = 0;
-    else if (phase < (width / 2. - ramp / 2.))
+    else if (phase <= (width / 2. - ramp / 2.))
       balance = 1;
     else if (phase > (width / 2. + ramp / 2.))
       balance = 0;
-    else if (ramp > 0)
+    else
       balance = ((width / 2. + ramp / 2.) - phase) / ramp;
 
     if (RGB)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b);
+      seg->setPixelColor(pixel, balance * r, balance * g, balance * b);
     else if (RGBW)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
+      seg->setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -589,28 +582,28 @@ void mode7(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
   float intensity, position, width, ramp;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 2 * 3 + 4)
+  if (RGB && (length - seg->offset) < 2 * 3 + 4)
     return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 4)
+  if (RGBW && (length - seg->offset) < 2 * 4 + 4)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  r2        = data[config.offset + i++];
-  g2        = data[config.offset + i++];
-  b2        = data[config.offset + i++];
+    w       = data[seg->offset + i++];
+  r2        = data[seg->offset + i++];
+  g2        = data[seg->offset + i++];
+  b2        = data[seg->offset + i++];
   if (RGBW)
-    w2      = data[config.offset + i++];
-  intensity = data[config.offset + i++] / 255.;
-  position  = data[config.offset + i++] * 360. / 255.;
-  width     = data[config.offset + i++] * 360. / 255.;
-  ramp      = data[config.offset + i++] * 360. / 255.;
+    w2      = data[seg->offset + i++];
+  intensity = data[seg->offset + i++] / 255.;
+  position  = data[seg->offset + i++] * 360. / 255.;
+  width     = data[seg->offset + i++] * 360. / 255.;
+  ramp      = data[seg->offset + i++] * 360. / 255.;
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -623,29 +616,28 @@ void mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   else
     ramp = (ramp < (360 - width) ? ramp : (360 - width));
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
     float phase, balance;
 
-    phase = WRAP180(360. * flip * pixel / (strip.numPixels() - 1) * config.split - position);
+    phase = WRAP180(360. * flip * pixel / (seg->numPixels() - 1) * config.split - position);
     phase = ABS(phase);
 
     if (width == 0)
       balance = 0;
-    else if (phase < (width / 2. - ramp / 2.))
+    else if (phase <= (width / 2. - ramp / 2.))
       balance = 1;
     else if (phase > (width / 2. + ramp / 2.))
       balance = 0;
-    else if (ramp > 0)
+    else
       balance = ((width / 2. + ramp / 2.) - phase) / ramp;
 
     if (RGB)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
+      seg->setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
     else if (RGBW)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
+      seg->setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
     yield();
   }
-  strip.show();
 }
 
 /*
@@ -661,23 +653,23 @@ void mode8(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode9(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w;
+  int i = 0, r, g, b, w = 0;
   float intensity, speed, width, ramp, phase;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 3 + 4)
+  if (RGB && (length - seg->offset) < 3 + 4)
     return;
-  if (RGBW && (length - config.offset) < 4 + 4)
+  if (RGBW && (length - seg->offset) < 4 + 4)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  speed     = 1. * data[config.offset + i++] / config.speed;
-  width     = 1. * data[config.offset + i++] * 360. / 255.;
-  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+    w       = data[seg->offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
+  speed     = 1. * data[seg->offset + i++] / config.speed;
+  width     = 1. * data[seg->offset + i++] * 360. / 255.;
+  ramp      = 1. * data[seg->offset + i++] * 360. / 255.;
 
   if (config.hsv)
     map_hsv_to_rgb(&r, &g, &b);
@@ -698,34 +690,33 @@ void mode9(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
   phase = (speed * millis()) * 360. / 1000.;
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
-    phase = prev;
+  if (WRAP180(phase - prev[seg - segment]) < 0)
+    phase = prev[seg - segment];
   else
-    prev = phase;
+    prev[seg - segment] = phase;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
     float position, balance;
 
-    position = WRAP180(360. * flip * pixel / (strip.numPixels() - 1) * config.split - phase);
+    position = WRAP180(360. * flip * pixel / (seg->numPixels() - 1) * config.split - phase);
     position = ABS(position);
 
     if (width == 0)
       balance = 0;
-    else if (position < (width / 2. - ramp / 2.))
+    else if (position <= (width / 2. - ramp / 2.))
       balance = 1;
     else if (position > (width / 2. + ramp / 2.))
       balance = 0;
-    else if (position > 0)
+    else
       balance = ((width / 2. + ramp / 2.) - position) / ramp;
 
     if (RGB)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b);
+      seg->setPixelColor(pixel, balance * r, balance * g, balance * b);
     else if (RGBW)
-      strip.setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
+      seg->setPixelColor(pixel, balance * r, balance * g, balance * b, balance * w);
     yield();
   }
-  strip.show();
 };
 
 /*
@@ -745,28 +736,28 @@ void mode9(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data)
 */
 
 void mode10(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r, g, b, w, r2, g2, b2, w2;
+  int i = 0, r, g, b, w = 0, r2, g2, b2, w2 = 0;
   float intensity, speed, width, ramp, phase;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 2 * 3 + 4)
+  if (RGB && (length - seg->offset) < 2 * 3 + 4)
     return;
-  if (RGBW && (length - config.offset) < 2 * 4 + 4)
+  if (RGBW && (length - seg->offset) < 2 * 4 + 4)
     return;
-  r         = data[config.offset + i++];
-  g         = data[config.offset + i++];
-  b         = data[config.offset + i++];
+  r         = data[seg->offset + i++];
+  g         = data[seg->offset + i++];
+  b         = data[seg->offset + i++];
   if (RGBW)
-    w       = data[config.offset + i++];
-  r2        = data[config.offset + i++];
-  g2        = data[config.offset + i++];
-  b2        = data[config.offset + i++];
+    w       = data[seg->offset + i++];
+  r2        = data[seg->offset + i++];
+  g2        = data[seg->offset + i++];
+  b2        = data[seg->offset + i++];
   if (RGBW)
-    w2      = data[config.offset + i++];
-  intensity = 1. * data[config.offset + i++] / 255.;
-  speed     = 1. * data[config.offset + i++] / config.speed;
-  width     = 1. * data[config.offset + i++] * 360. / 255.;
-  ramp      = 1. * data[config.offset + i++] * 360. / 255.;
+    w2      = data[seg->offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
+  speed     = 1. * data[seg->offset + i++] / config.speed;
+  width     = 1. * data[seg->offset + i++] * 360. / 255.;
+  ramp      = 1. * data[seg->offset + i++] * 360. / 255.;
 
   if (config.hsv) {
     map_hsv_to_rgb(&r, &g, &b);
@@ -783,34 +774,33 @@ void mode10(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
   phase = (speed * millis()) * 360. / 1000.;
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
-    phase = prev;
+  if (WRAP180(phase - prev[seg - segment]) < 0)
+    phase = prev[seg - segment];
   else
-    prev = phase;
+    prev[seg - segment] = phase;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
     float position, balance;
 
-    position = WRAP180((360. * flip * pixel / (strip.numPixels() - 1)) * config.split - phase);
+    position = WRAP180((360. * flip * pixel / (seg->numPixels() - 1)) * config.split - phase);
     position = ABS(position);
 
     if (width == 0)
       balance = 0;
-    else if (position < (width / 2. - ramp / 2.))
+    else if (position <= (width / 2. - ramp / 2.))
       balance = 1;
     else if (position > (width / 2. + ramp / 2.))
       balance = 0;
-    else if (position > 0)
+    else
       balance = ((width / 2. + ramp / 2.) - position) / ramp;
 
     if (RGB)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
+      seg->setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2));
     else if (RGBW)
-      strip.setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
+      seg->setPixelColor(pixel, intensity * BALANCE(balance, r, r2), intensity * BALANCE(balance, g, g2), intensity * BALANCE(balance, b, b2), intensity * BALANCE(balance, w, w2));
     yield();
   }
-  strip.show();
 };
 
 /*
@@ -826,15 +816,15 @@ void mode11(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
 
   if (universe != config.universe)
     return;
-  if ((length - config.offset) < 3)
+  if ((length - seg->offset) < 3)
     return;
-  saturation = 1. * data[config.offset + i++];
-  value      = 1. * data[config.offset + i++] ;
-  position   = 1. * data[config.offset + i++] * 360. / 255.;
+  saturation = 1. * data[seg->offset + i++];
+  value      = 1. * data[seg->offset + i++] ;
+  position   = 1. * data[seg->offset + i++] * 360. / 255.;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float phase = WRAP360((360. * flip * pixel / strip.numPixels()) * config.split - position);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
+    float phase = WRAP360((360. * flip * pixel / seg->numPixels()) * config.split - position);
 
     int r, g, b;
     r = phase;           // hue, between 0-360
@@ -842,10 +832,9 @@ void mode11(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
     b = value;           // value, between 0-255
     map_hsv_to_rgb(&r, &g, &b);
 
-    strip.setPixelColor(pixel, r, g, b);
+    seg->setPixelColor(pixel, r, g, b);
     yield();
   }
-  strip.show();
 };
 
 /*
@@ -861,24 +850,24 @@ void mode12(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
 
   if (universe != config.universe)
     return;
-  if ((length - config.offset) < 3)
+  if ((length - seg->offset) < 3)
     return;
-  saturation = 1. * data[config.offset + i++];
-  value      = 1. * data[config.offset + i++] ;
-  speed      = 1. * data[config.offset + i++] / config.speed;
+  saturation = 1. * data[seg->offset + i++];
+  value      = 1. * data[seg->offset + i++] ;
+  speed      = 1. * data[seg->offset + i++] / config.speed;
 
   // determine the current phase in the temporal cycle
   phase = (speed * millis()) * 360. / 1000.;
 
   // prevent rolling back
-  if (WRAP180(phase - prev) < 0)
-    phase = prev;
+  if (WRAP180(phase - prev[seg - segment]) < 0)
+    phase = prev[seg - segment];
   else
-    prev = phase;
+    prev[seg - segment] = phase;
 
-  for (int pixel = 0; pixel < strip.numPixels(); pixel++) {
-    int flip = (config.reverse ? -1 : 1);
-    float position = WRAP360((360. * flip * pixel / strip.numPixels()) * config.split - phase);
+  for (int pixel = 0; pixel < seg->numPixels(); pixel++) {
+    int flip = (seg->reverse ? -1 : 1);
+    float position = WRAP360((360. * flip * pixel / seg->numPixels()) * config.split - phase);
 
     int r, g, b;
     r = position;        // hue, between 0-360
@@ -886,10 +875,9 @@ void mode12(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
     b = value;           // value, between 0-255
     map_hsv_to_rgb(&r, &g, &b);
 
-    strip.setPixelColor(pixel, r, g, b);
+    seg->setPixelColor(pixel, r, g, b);
     yield();
   }
-  strip.show();
 };
 
 /*
@@ -907,28 +895,28 @@ void mode12(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
 */
 
 void mode13(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
-  int i = 0, r1, g1, b1, w1, r2, g2, b2, w2;
+  int i = 0, r1, g1, b1, w1 = 0, r2, g2, b2, w2 = 0;
   byte glyph;
   float intensity;
   if (universe != config.universe)
     return;
-  if (RGB && (length - config.offset) < 3 + 1)
+  if (RGB && (length - seg->offset) < 3 + 1)
     return;
-  if (RGBW && (length - config.offset) < 4 + 1)
+  if (RGBW && (length - seg->offset) < 4 + 1)
     return;
-  r1         = data[config.offset + i++];
-  g1         = data[config.offset + i++];
-  b1         = data[config.offset + i++];
+  r1         = data[seg->offset + i++];
+  g1         = data[seg->offset + i++];
+  b1         = data[seg->offset + i++];
   if (RGBW)
-    w1       = data[config.offset + i++];
-  r2         = data[config.offset + i++];
-  g2         = data[config.offset + i++];
-  b2         = data[config.offset + i++];
+    w1       = data[seg->offset + i++];
+  r2         = data[seg->offset + i++];
+  g2         = data[seg->offset + i++];
+  b2         = data[seg->offset + i++];
   if (RGBW)
-    w2       = data[config.offset + i++];
+    w2       = data[seg->offset + i++];
 
-  intensity = 1. * data[config.offset + i++] / 255.;
-  glyph     =      data[config.offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
+  glyph     =      data[seg->offset + i++];
 
   if (glyph > 127)
     return;
@@ -948,30 +936,120 @@ void mode13(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data
   b2 = intensity * b2;
   w2 = intensity * w2;
 
-  int pixel = 0;
-  for (int row = 0; row < 8; row++) {
-    for (int col = 0; col < 8; col++) {
-      bool toggle = font8x8_basic[glyph][row] & (0x01 << col);
+  for (int row = 0; row < PANEL_HEIGHT; row++) {
+    for (int col = 0; col < PANEL_WIDTH; col++) {
+      int pixel = panelPixel(col, row);
+      bool toggle = glyphColumn[glyph][col] & (0x01 << row);
       if (RGB && toggle)
-        strip.setPixelColor(pixel, r1, g1, b1);
+        seg->setPixelColor(pixel, r1, g1, b1);
       else if (RGBW && toggle)
-        strip.setPixelColor(pixel, r1, g1, b1, w1);
+        seg->setPixelColor(pixel, r1, g1, b1, w1);
       else if (RGB && !toggle)
-        strip.setPixelColor(pixel, r2, g2, b2);
+        seg->setPixelColor(pixel, r2, g2, b2);
       else if (RGBW && !toggle)
-        strip.setPixelColor(pixel, r2, g2, b2, w2);
-      pixel++;
+        seg->setPixelColor(pixel, r2, g2, b2, w2);
     }
     yield();
   }
-  strip.show();
 };
 
 /************************************************************************************/
 /************************************************************************************/
 /************************************************************************************/
 
-void mode14(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
+/*
+  mode 14: dual color scrolling text for a chain of 8x8 RGBW neopixel arrays
+  channel 1  = color 1 red
+  channel 2  = color 1 green
+  channel 3  = color 1 blue
+  channel 4  = color 1 white
+  channel 5  = color 2 red
+  channel 6  = color 2 green
+  channel 7  = color 2 blue
+  channel 8  = color 2 white
+  channel 9  = intensity
+  channel 10 = speed (number of columns per unit of time)
+  channel 11 and further = ASCII codes, terminated with a zero
+
+  If channel 11 is zero, the text from the configuration is shown instead.
+*/
+
+void mode14(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {
+  int i = 0, r1, g1, b1, w1 = 0, r2, g2, b2, w2 = 0;
+  float intensity, speed;
+  char str[TEXT_MAXLEN];
+  text_t *t = &text[seg - segment];
+
+  if (universe != config.universe)
+    return;
+  if (RGB && (length - seg->offset) < 2 * 3 + 2)
+    return;
+  if (RGBW && (length - seg->offset) < 2 * 4 + 2)
+    return;
+  r1         = data[seg->offset + i++];
+  g1         = data[seg->offset + i++];
+  b1         = data[seg->offset + i++];
+  if (RGBW)
+    w1       = data[seg->offset + i++];
+  r2         = data[seg->offset + i++];
+  g2         = data[seg->offset + i++];
+  b2         = data[seg->offset + i++];
+  if (RGBW)
+    w2       = data[seg->offset + i++];
+  intensity = 1. * data[seg->offset + i++] / 255.;
+  speed     = 1. * data[seg->offset + i++] / config.speed;
+
+  // the text comes from the DMX channels, or otherwise from the configuration
+  int n = 0;
+  while ((seg->offset + i + n) < length && n < TEXT_MAXLEN - 1 && data[seg->offset + i + n]) {
+    str[n] = data[seg->offset + i + n];
+    n++;
+  }
+  str[n] = 0;
+  if (n == 0)
+    strncpy(str, config.text, TEXT_MAXLEN);
+
+  // only render the glyphs again when the text changes
+  if (strncmp(str, t->message, TEXT_MAXLEN) != 0)
+    textSet(t, str);
+
+  if (config.hsv) {
+    map_hsv_to_rgb(&r1, &g1, &b1);
+    map_hsv_to_rgb(&r2, &g2, &b2);
+  }
+
+  int width  = MIN(config.panels * PANEL_WIDTH, seg->numPixels() / PANEL_HEIGHT);
+  int period = t->length + width;
+  if (period <= 0)
+    return;
+
+  // the position is expressed in columns, the fractional part allows for smooth sub-pixel scrolling
+  unsigned long toc = millis();
+  t->position += speed * (toc - t->tic) / 1000.;
+  if (t->position >= period)
+    t->position = fmod(t->position, period);
+  t->tic = toc;
+
+  int column   = t->position;
+  int fraction = 256 * (t->position - column);
+
+  for (int x = 0; x < width; x++) {
+    // the text enters from the right edge of the display
+    uint8_t left  = textColumn(t, column + x - width);
+    uint8_t right = textColumn(t, column + x - width + 1);
+    for (int y = 0; y < PANEL_HEIGHT; y++) {
+      // blend between the two columns that overlap with this pixel
+      float balance = (((left >> y) & 0x01) * (256 - fraction) + ((right >> y) & 0x01) * fraction) / 256.;
+      int pixel = panelPixel(x, y);
+      if (RGB)
+        seg->setPixelColor(pixel, intensity * BALANCE(balance, r2, r1), intensity * BALANCE(balance, g2, g1), intensity * BALANCE(balance, b2, b1));
+      else if (RGBW)
+        seg->setPixelColor(pixel, intensity * BALANCE(balance, r2, r1), intensity * BALANCE(balance, g2, g1), intensity * BALANCE(balance, b2, b1), intensity * BALANCE(balance, w2, w1));
+    }
+    yield();
+  }
+};
+
 void mode15(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
 void mode16(uint16_t universe, uint16_t length, uint8_t sequence, uint8_t * data) {};
 
@@ -0,0 +1,62 @@
+#include "segment.h"
+#include "webinterface.h"
+#include <Adafruit_NeoPixel.h>
+
+extern Adafruit_NeoPixel strip;
+
+Segment segment[MAXSEGMENT];
+int nsegment = 0;
+Segment *seg = &segment[0];
+
+uint16_t Segment::numPixels() {
+  return length;
+}
+
+void Segment::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+  if (n < length)
+    strip.setPixelColor(start + n, r, g, b);
+}
+
+void Segment::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+  if (n < length)
+    strip.setPixelColor(start + n, r, g, b, w);
+}
+
+/*
+  This checks the segment table from the configuration against the length of the
+  strip and the DMX universe, so that this does not have to be done for every frame.
+  Segments are rendered in the order in which they are specified; where they overlap,
+  the later segment wins. Without a segment table the whole strip is a single segment
+  that runs the global mode.
+*/
+
+void resolveSegments() {
+  nsegment = 0;
+
+  if (config.nsegment == 0) {
+    segment[0].start   = 0;
+    segment[0].length  = config.pixels;
+    segment[0].mode    = config.mode;
+    segment[0].offset  = config.offset;
+    segment[0].reverse = config.reverse;
+    nsegment = 1;
+    return;
+  }
+
+  for (int i = 0; i < config.nsegment && i < MAXSEGMENT; i++) {
+    Segment s = config.segment[i];
+    if (s.start < 0) {
+      s.length += s.start;
+      s.start = 0;
+    }
+    if (s.start + s.length > config.pixels)
+      s.length = config.pixels - s.start;
+    if (s.length <= 0) {
+      Serial.print("Skipping empty segment ");
+      Serial.println(i);
+      continue;
+    }
+    s.offset = constrain(s.offset, 0, 511);
+    segment[nsegment++] = s;
+  }
+}
@@ -0,0 +1,35 @@
+#ifndef _SEGMENT_H_
+#define _SEGMENT_H_
+
+#include <Arduino.h>
+
+#define MAXSEGMENT 8
+
+/*
+  A segment is a consecutive range of pixels along the strip that runs its own
+  mode, with its own DMX channel offset and direction. The mode functions only
+  see the pixels of the segment, numbered from 0 to numPixels()-1.
+*/
+
+struct Segment {
+  int start;
+  int length;
+  int mode;
+  int offset;
+  int reverse;
+
+  uint16_t numPixels(void);
+  void setPixelColor(uint16_t, uint8_t, uint8_t, uint8_t);
+  void setPixelColor(uint16_t, uint8_t, uint8_t, uint8_t, uint8_t);
+};
+
+// the segments as they are to be rendered, after checking them against the strip
+extern Segment segment[MAXSEGMENT];
+extern int nsegment;
+
+// the segment that is currently being rendered
+extern Segment *seg;
+
+void resolveSegments(void);
+
+#endif // _SEGMENT_H_
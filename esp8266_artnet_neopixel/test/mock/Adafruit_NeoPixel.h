@@ -0,0 +1,28 @@
+#ifndef _ADAFRUIT_NEOPIXEL_H_
+#define _ADAFRUIT_NEOPIXEL_H_
+
+#include <Arduino.h>
+
+#define NEO_GRBW    0
+#define NEO_KHZ800  0
+
+// the pixels are kept in memory, so that the test can compare them to the expected frame
+class Adafruit_NeoPixel {
+  public:
+    Adafruit_NeoPixel(uint16_t n = 0, uint8_t = 0, int = 0) { updateLength(n); }
+    void updateLength(uint16_t n) { length = (n < sizeof(pixel) / sizeof(pixel[0]) ? n : sizeof(pixel) / sizeof(pixel[0])); memset(pixel, 0, sizeof(pixel)); }
+    uint16_t numPixels() { return length; }
+    void setPixelColor(uint16_t n, uint32_t c) { if (n < length) pixel[n] = c; }
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) { setPixelColor(n, Color(r, g, b)); }
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) { setPixelColor(n, Color(r, g, b, w)); }
+    uint32_t getPixelColor(uint16_t n) { return (n < length ? pixel[n] : 0); }
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w = 0) { return ((uint32_t)w << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+    void show() {}
+    void begin() {}
+
+  private:
+    uint16_t length;
+    uint32_t pixel[1024];
+};
+
+#endif // _ADAFRUIT_NEOPIXEL_H_
@@ -0,0 +1,50 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the Arduino core for the host tests, it only
+// provides what the modules of this sketch use.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define constrain(x, lo, hi) ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+// the binary constants that are used in the font
+#define B00000000 0x00
+#define B00001000 0x08
+#define B00011100 0x1C
+#define B00110110 0x36
+#define B00111110 0x3E
+#define B01111111 0x7F
+
+// the time is advanced by the test
+extern unsigned long mockMillis;
+inline unsigned long millis() { return mockMillis; }
+inline void yield() {}
+inline void delay(unsigned long ms) { mockMillis += ms; }
+
+class String : public std::string {
+  public:
+    String() {}
+    String(const char *s) : std::string(s) {}
+    String(const std::string &s) : std::string(s) {}
+};
+
+class MockSerial {
+  public:
+    void begin(unsigned long) {}
+    template <typename T> void print(T) {}
+    template <typename T> void println(T) {}
+    void println() {}
+};
+
+extern MockSerial Serial;
+
+#endif // _ARDUINO_H_
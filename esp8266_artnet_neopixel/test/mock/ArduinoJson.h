@@ -0,0 +1,10 @@
+#ifndef _ARDUINOJSON_H_
+#define _ARDUINOJSON_H_
+
+// the modules under test only need the declarations
+#define ARDUINOJSON_VERSION       "5.13.5"
+#define ARDUINOJSON_VERSION_MAJOR 5
+
+class JsonObject;
+
+#endif // _ARDUINOJSON_H_
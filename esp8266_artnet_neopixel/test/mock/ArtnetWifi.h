@@ -0,0 +1,6 @@
+#ifndef _ARTNETWIFI_H_
+#define _ARTNETWIFI_H_
+
+// the modules under test do not use this
+
+#endif // _ARTNETWIFI_H_
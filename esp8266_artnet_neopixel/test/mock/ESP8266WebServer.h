@@ -0,0 +1,6 @@
+#ifndef _ESP8266WEBSERVER_H_
+#define _ESP8266WEBSERVER_H_
+
+// the modules under test do not use this
+
+#endif // _ESP8266WEBSERVER_H_
@@ -0,0 +1,6 @@
+#ifndef _ESP8266WIFI_H_
+#define _ESP8266WIFI_H_
+
+// the modules under test do not use this
+
+#endif // _ESP8266WIFI_H_
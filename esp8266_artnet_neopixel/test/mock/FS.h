@@ -0,0 +1,6 @@
+#ifndef _FS_H_
+#define _FS_H_
+
+// the modules under test do not use this
+
+#endif // _FS_H_
@@ -0,0 +1,6 @@
+#ifndef _WIFIUDP_H_
+#define _WIFIUDP_H_
+
+// the modules under test do not use this
+
+#endif // _WIFIUDP_H_
@@ -0,0 +1,195 @@
+// Host test of the segment table, and of two segments that run their own mode on the same strip
+
+#include <string>
+#include "check.h"
+#include "neopixel_mode.h"
+#include "webinterface.h"
+
+unsigned long mockMillis = 0;
+MockSerial Serial;
+Adafruit_NeoPixel strip;
+long tic_frame = 0;
+Config config;
+
+static void setup(int pixels) {
+  memset(&config, 0, sizeof(config));
+  config.universe = 1;
+  config.pixels = pixels;
+  config.leds = 3;
+  config.speed = 1;
+  config.panels = 1;
+  config.layout = LAYOUT_ROWMAJOR;
+  strip.updateLength(pixels);
+  textInit();
+  mockMillis = 0;
+}
+
+static void addSegment(int start, int length, int mode, int offset) {
+  Segment s = {start, length, mode, offset, 0};
+  config.segment[config.nsegment++] = s;
+}
+
+// this renders all segments like the main loop does
+static void render(uint8_t *data, uint16_t length) {
+  for (int i = 0; i < nsegment; i++) {
+    seg = &segment[i];
+    if (seg->mode == 1)
+      mode1(1, length, 0, data);
+    else if (seg->mode == 4)
+      mode4(1, length, 0, data);
+    else if (seg->mode == 14)
+      mode14(1, length, 0, data);
+  }
+}
+
+static void testResolve() {
+  setup(100);
+
+  // without a segment table the whole strip runs the global mode
+  config.mode = 3;
+  config.offset = 7;
+  resolveSegments();
+  CHECK_EQUAL(nsegment, 1);
+  CHECK_EQUAL(segment[0].start, 0);
+  CHECK_EQUAL(segment[0].length, 100);
+  CHECK_EQUAL(segment[0].mode, 3);
+  CHECK_EQUAL(segment[0].offset, 7);
+
+  // segments are clipped to the strip, empty ones are skipped and the offset is limited to the universe
+  addSegment(-5, 20, 1, 0);
+  addSegment(90, 20, 1, 600);
+  addSegment(120, 10, 1, 0);
+  addSegment(30, 10, 1, -1);
+  resolveSegments();
+  CHECK_EQUAL(nsegment, 3);
+  CHECK_EQUAL(segment[0].start, 0);
+  CHECK_EQUAL(segment[0].length, 15);
+  CHECK_EQUAL(segment[1].start, 90);
+  CHECK_EQUAL(segment[1].length, 10);
+  CHECK_EQUAL(segment[1].offset, 511);
+  CHECK_EQUAL(segment[2].start, 30);
+  CHECK_EQUAL(segment[2].offset, 0);
+
+  // the pixels are numbered within the segment and do not spill over into the next one
+  seg = &segment[2];
+  seg->setPixelColor(0, 1, 2, 3);
+  seg->setPixelColor(10, 1, 2, 3);
+  CHECK_EQUAL(strip.getPixelColor(30), Adafruit_NeoPixel::Color(1, 2, 3));
+  CHECK_EQUAL(strip.getPixelColor(40), 0);
+}
+
+static void testOffset() {
+  // two segments with a uniform color, each reads its own DMX channels
+  setup(20);
+  addSegment(0, 10, 1, 0);
+  addSegment(10, 10, 1, 4);
+  resolveSegments();
+  uint8_t data[8] = {255, 0, 0, 255, 0, 0, 255, 255};
+  render(data, sizeof(data));
+  CHECK_EQUAL(strip.getPixelColor(0), Adafruit_NeoPixel::Color(255, 0, 0));
+  CHECK_EQUAL(strip.getPixelColor(9), Adafruit_NeoPixel::Color(255, 0, 0));
+  CHECK_EQUAL(strip.getPixelColor(10), Adafruit_NeoPixel::Color(0, 0, 255));
+  CHECK_EQUAL(strip.getPixelColor(19), Adafruit_NeoPixel::Color(0, 0, 255));
+}
+
+// the strip as a string with one character per pixel, for comparing it to the golden frames
+static std::string frame() {
+  std::string str;
+  for (int i = 0; i < strip.numPixels(); i++) {
+    uint32_t c = strip.getPixelColor(i);
+    str += (c == Adafruit_NeoPixel::Color(255, 0, 0) ? 'R' : c == Adafruit_NeoPixel::Color(0, 255, 0) ? 'G' : c == Adafruit_NeoPixel::Color(0, 0, 255) ? 'B' : c == 0 ? '.' : '?');
+  }
+  return str;
+}
+
+static void testOverlap() {
+  // segments with a uniform color that overlap, the later segment wins; the DMX channels
+  // start with red at offset 0, green at offset 4 and blue at offset 8
+  struct {
+    Segment segment[3];
+    const char *golden;
+  } layout[] = {
+    {{{0, 20, 1, 0, 0}, {5, 5, 1, 4, 0}},                     "RRRRRGGGGGRRRRRRRRRR"},
+    {{{5, 5, 1, 4, 0}, {0, 20, 1, 0, 0}},                     "RRRRRRRRRRRRRRRRRRRR"},
+    {{{0, 12, 1, 0, 0}, {8, 12, 1, 4, 0}, {10, 4, 1, 8, 0}},  "RRRRRRRRGGBBBBGGGGGG"},
+    {{{-3, 6, 1, 4, 0}, {15, 10, 1, 8, 0}},                   "GGG............BBBBB"},
+    {{{0, 20, 1, 8, 0}, {19, 1, 1, 0, 0}, {0, 1, 1, 4, 0}},   "GBBBBBBBBBBBBBBBBBBR"},
+  };
+  uint8_t data[12] = {255, 0, 0, 255, 0, 255, 0, 255, 0, 0, 255, 255};
+  for (unsigned int k = 0; k < sizeof(layout) / sizeof(layout[0]); k++) {
+    setup(20);
+    for (int i = 0; i < 3 && layout[k].segment[i].length; i++)
+      config.segment[config.nsegment++] = layout[k].segment[i];
+    resolveSegments();
+    render(data, sizeof(data));
+    if (frame() != layout[k].golden)
+      printf("layout %u: %s instead of %s\n", k, frame().c_str(), layout[k].golden);
+    CHECK(frame() == layout[k].golden);
+  }
+}
+
+static void testPhase() {
+  // two segments that blink between red and blue at a different speed do not hold back
+  // each other's phase, with a duty cycle of one half the second color shows within 90 degrees of zero
+  setup(20);
+  addSegment(0, 10, 4, 0);
+  addSegment(10, 10, 4, 10);
+  resolveSegments();
+  uint8_t data[20] = {
+    255, 0, 0, 0, 0, 255, 255, 1, 0, 128,
+    255, 0, 0, 0, 0, 255, 255, 2, 0, 128
+  };
+  for (mockMillis = 30; mockMillis < 3000; mockMillis += 100) {
+    render(data, sizeof(data));
+    for (int i = 0; i < 2; i++) {
+      float phase = fmod((i + 1) * mockMillis * 0.36, 360);
+      char expected = (phase < 90 || phase > 270 ? 'B' : 'R');
+      CHECK_EQUAL(frame()[10 * i], expected);
+      CHECK_EQUAL(frame()[10 * i + 9], expected);
+    }
+  }
+}
+
+static void testText() {
+  // two panels that scroll a different text at a different speed, the text comes from the DMX channels
+  setup(2 * PANEL_PIXELS);
+  addSegment(0, PANEL_PIXELS, 14, 0);
+  addSegment(PANEL_PIXELS, PANEL_PIXELS, 14, 16);
+  resolveSegments();
+  uint8_t data[32] = {
+    255, 0, 0, 0, 0, 255, 255, 8, 'A', 'B', 0, 0, 0, 0, 0, 0,
+    0, 255, 0, 0, 0, 0, 255, 4, 'C', 0
+  };
+
+  // the segments are rendered in turn, like in the main loop
+  for (int i = 0; i < 3; i++) {
+    render(data, sizeof(data));
+    mockMillis += 500;
+  }
+
+  CHECK(strcmp(text[0].message, "AB") == 0);
+  CHECK(strcmp(text[1].message, "C") == 0);
+  CHECK_CLOSE(text[0].position, 8, 1e-3);
+  CHECK_CLOSE(text[1].position, 4, 1e-3);
+
+  // after one second the first panel shows the first character completely, the second panel half of it
+  for (int x = 0; x < PANEL_WIDTH; x++)
+    for (int y = 0; y < PANEL_HEIGHT; y++) {
+      uint8_t column = glyphColumn['A'][x];
+      uint32_t expected = ((column >> y) & 0x01 ? Adafruit_NeoPixel::Color(255, 0, 0) : Adafruit_NeoPixel::Color(0, 0, 255));
+      CHECK_EQUAL(strip.getPixelColor(panelPixel(x, y)), expected);
+
+      column = (x < 4 ? 0 : glyphColumn['C'][x - 4]);
+      expected = ((column >> y) & 0x01 ? Adafruit_NeoPixel::Color(0, 255, 0) : Adafruit_NeoPixel::Color(0, 0, 0));
+      CHECK_EQUAL(strip.getPixelColor(PANEL_PIXELS + panelPixel(x, y)), expected);
+    }
+}
+
+int main() {
+  testResolve();
+  testOffset();
+  testOverlap();
+  testPhase();
+  testText();
+  return report("test_segment");
+}
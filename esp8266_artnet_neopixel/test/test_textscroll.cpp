@@ -0,0 +1,156 @@
+// Host test of the pre-rendered glyph columns, the panel layout and the scrolling of mode 14
+
+#include <time.h>
+#include "check.h"
+#include "neopixel_mode.h"
+#include "webinterface.h"
+
+unsigned long mockMillis = 0;
+MockSerial Serial;
+Adafruit_NeoPixel strip;
+long tic_frame = 0;
+Config config;
+
+// a single segment of RGB pixels with the text from the configuration
+static void setup(int pixels, int panels, const char *str) {
+  memset(&config, 0, sizeof(config));
+  config.universe = 1;
+  config.pixels = pixels;
+  config.leds = 3;
+  config.mode = 14;
+  config.speed = 1;
+  config.panels = panels;
+  config.layout = LAYOUT_ROWMAJOR;
+  snprintf(config.text, sizeof(config.text), "%s", str);
+  strip.updateLength(pixels);
+  resolveSegments();
+  seg = &segment[0];
+  textInit();
+  mockMillis = 0;
+}
+
+// red text on a blue background at full intensity, scrolling with the given number of columns per second
+static void frame(uint8_t speed) {
+  uint8_t data[16] = {255, 0, 0, 0, 0, 255, 255, speed, 0};
+  mode14(1, sizeof(data), 0, data);
+}
+
+static void testGlyphs() {
+  textInit();
+  // the heart is stored per row, with the leftmost pixel in the least significant bit
+  CHECK_EQUAL(glyphColumn[1][0], 0x0E);
+  CHECK_EQUAL(glyphColumn[1][3], 0x7E);
+  CHECK_EQUAL(glyphColumn[1][7], 0x00);
+  for (int col = 0; col < PANEL_WIDTH; col++)
+    CHECK_EQUAL(glyphColumn[' '][col], 0);
+}
+
+static void testMessage() {
+  text_t t;
+  textSet(&t, "Hi");
+  CHECK_EQUAL(t.length, 2 * PANEL_WIDTH);
+  CHECK(strcmp(t.message, "Hi") == 0);
+  for (int col = 0; col < PANEL_WIDTH; col++) {
+    CHECK_EQUAL(textColumn(&t, col), glyphColumn['H'][col]);
+    CHECK_EQUAL(textColumn(&t, col + PANEL_WIDTH), glyphColumn['i'][col]);
+  }
+
+  // columns outside of the message are blank
+  CHECK_EQUAL(textColumn(&t, -1), 0);
+  CHECK_EQUAL(textColumn(&t, 2 * PANEL_WIDTH), 0);
+
+  // characters outside the basic latin range are shown as a space
+  textSet(&t, "\xe9");
+  CHECK_EQUAL(t.length, PANEL_WIDTH);
+  for (int col = 0; col < PANEL_WIDTH; col++)
+    CHECK_EQUAL(textColumn(&t, col), 0);
+
+  // a long message is truncated
+  char str[2 * TEXT_MAXLEN];
+  memset(str, 'x', sizeof(str) - 1);
+  str[sizeof(str) - 1] = 0;
+  textSet(&t, str);
+  CHECK_EQUAL(strlen(t.message), TEXT_MAXLEN - 1);
+  CHECK_EQUAL(t.length, (TEXT_MAXLEN - 1) * PANEL_WIDTH);
+}
+
+static void testLayout() {
+  config.layout = LAYOUT_ROWMAJOR;
+  CHECK_EQUAL(panelPixel(0, 0), 0);
+  CHECK_EQUAL(panelPixel(9, 2), PANEL_PIXELS + 2 * PANEL_WIDTH + 1);
+  CHECK_EQUAL(panelPixel(9, 3), PANEL_PIXELS + 3 * PANEL_WIDTH + 1);
+  config.layout = LAYOUT_SERPENTINE;
+  CHECK_EQUAL(panelPixel(9, 2), PANEL_PIXELS + 2 * PANEL_WIDTH + 1);
+  CHECK_EQUAL(panelPixel(9, 3), PANEL_PIXELS + 3 * PANEL_WIDTH + 6);
+}
+
+static void testScroll() {
+  setup(2 * PANEL_PIXELS, 2, "Hi");
+  int width = 2 * PANEL_WIDTH;
+
+  // the text enters from the right, hence the display is blank at the start
+  frame(width);
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++)
+    CHECK_EQUAL(strip.getPixelColor(pixel), Adafruit_NeoPixel::Color(0, 0, 255));
+
+  // after one second the text fills the display
+  mockMillis += 1000;
+  frame(width);
+  CHECK_CLOSE(text[0].position, width, 1e-3);
+  for (int x = 0; x < width; x++)
+    for (int y = 0; y < PANEL_HEIGHT; y++) {
+      uint8_t column = (x < PANEL_WIDTH ? glyphColumn['H'][x] : glyphColumn['i'][x - PANEL_WIDTH]);
+      uint32_t expected = ((column >> y) & 0x01 ? Adafruit_NeoPixel::Color(255, 0, 0) : Adafruit_NeoPixel::Color(0, 0, 255));
+      CHECK_EQUAL(strip.getPixelColor(panelPixel(x, y)), expected);
+    }
+
+  // the position wraps around once the text has left the display on the left
+  mockMillis += 1500;
+  frame(width);
+  CHECK_CLOSE(text[0].position, 0.5 * width, 1e-3);
+}
+
+static void testEmpty() {
+  // without text and without panels there is nothing to scroll
+  setup(PANEL_PIXELS, 0, "");
+  frame(8);
+  mockMillis += 1000;
+  frame(8);
+  CHECK(isfinite(text[0].position));
+  for (int pixel = 0; pixel < strip.numPixels(); pixel++)
+    CHECK_EQUAL(strip.getPixelColor(pixel), 0);
+
+  // the text can still be set afterwards
+  snprintf(config.text, sizeof(config.text), "%s", "A");
+  config.panels = 1;
+  frame(8);
+  mockMillis += 1000;
+  frame(8);
+  CHECK_CLOSE(text[0].position, 8, 1e-3);
+}
+
+static void benchmark() {
+  // the time that one frame takes on this computer, only as a relative measure between the number of panels
+  const unsigned long repeat = 20000;
+  for (int panels = 1; panels <= 8; panels++) {
+    setup(panels * PANEL_PIXELS, panels, "Hello world");
+    unsigned long sum = 0;
+    clock_t start = clock();
+    for (unsigned long k = 0; k < repeat; k++) {
+      mockMillis += 20;
+      frame(2 * PANEL_WIDTH);
+      sum += strip.getPixelColor(k % strip.numPixels());
+    }
+    printf("%d panels, %4d pixels: %6.2f us per frame on this computer (%lu)\n", panels, strip.numPixels(), 1e6 * (clock() - start) / CLOCKS_PER_SEC / repeat, sum & 1);
+  }
+}
+
+int main() {
+  testGlyphs();
+  testMessage();
+  testLayout();
+  testScroll();
+  testEmpty();
+  benchmark();
+  return report("test_textscroll");
+}
@@ -0,0 +1,62 @@
+#include "textscroll.h"
+#include "webinterface.h"
+#include "font8x8_basic.h"
+
+uint8_t glyphColumn[128][PANEL_WIDTH];
+text_t text[MAXSEGMENT];
+
+/*
+  The font8x8_basic table is organized as one byte per row, with the leftmost
+  pixel in the least significant bit. For rendering and scrolling it is more
+  convenient to have one byte per column, so that is computed once here.
+*/
+
+void textInit() {
+  for (int glyph = 0; glyph < 128; glyph++) {
+    for (int col = 0; col < PANEL_WIDTH; col++) {
+      uint8_t mask = 0;
+      for (int row = 0; row < PANEL_HEIGHT; row++)
+        if (font8x8_basic[glyph][row] & (0x01 << col))
+          mask |= (0x01 << row);
+      glyphColumn[glyph][col] = mask;
+    }
+  }
+  for (int i = 0; i < MAXSEGMENT; i++)
+    textSet(&text[i], "");
+}
+
+void textSet(text_t *t, const char *str) {
+  int i;
+  for (i = 0; i < TEXT_MAXLEN - 1 && str[i]; i++) {
+    // characters outside the basic latin range are shown as a space
+    uint8_t glyph = (str[i] & 0x80 ? ' ' : str[i]);
+    t->message[i] = str[i];
+    memcpy(t->column + i * PANEL_WIDTH, glyphColumn[glyph], PANEL_WIDTH);
+  }
+  t->message[i] = 0;
+  t->length = i * PANEL_WIDTH;
+  t->position = 0;
+}
+
+uint8_t textColumn(const text_t *t, int col) {
+  // columns outside of the message are blank
+  if (col < 0 || col >= (int)t->length)
+    return 0;
+  else
+    return t->column[col];
+}
+
+/*
+  Map a horizontal and vertical position on a chain of 8x8 panels to the pixel
+  index along the strip. The panels are chained from left to right; within each
+  panel the rows go from top to bottom and are either all wired from left to
+  right, or alternate direction (serpentine).
+*/
+
+int panelPixel(int x, int y) {
+  int panel = x / PANEL_WIDTH;
+  int col   = x % PANEL_WIDTH;
+  if (config.layout == LAYOUT_SERPENTINE && (y & 0x01))
+    col = PANEL_WIDTH - 1 - col;
+  return panel * PANEL_PIXELS + y * PANEL_WIDTH + col;
+}
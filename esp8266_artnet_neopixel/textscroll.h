@@ -0,0 +1,35 @@
+#ifndef _TEXTSCROLL_H_
+#define _TEXTSCROLL_H_
+
+#include <Arduino.h>
+#include "segment.h"
+
+#define TEXT_MAXLEN  64   // including the terminating zero
+#define PANEL_WIDTH  8
+#define PANEL_HEIGHT 8
+#define PANEL_PIXELS (PANEL_WIDTH * PANEL_HEIGHT)
+
+// pixel layout within each 8x8 panel
+#define LAYOUT_ROWMAJOR   0
+#define LAYOUT_SERPENTINE 1
+
+// the font, expanded once into one bitmask per column, bit N corresponds to row N
+extern uint8_t glyphColumn[128][PANEL_WIDTH];
+
+// each segment scrolls its own message, pre-rendered as one column bitmask per horizontal pixel
+typedef struct {
+  char message[TEXT_MAXLEN];
+  uint8_t column[TEXT_MAXLEN * PANEL_WIDTH];
+  unsigned int length;   // number of columns
+  float position;        // in columns, the fractional part allows for smooth sub-pixel scrolling
+  unsigned long tic;     // in milliseconds, the time of the previous frame
+} text_t;
+
+extern text_t text[MAXSEGMENT];
+
+void textInit(void);
+void textSet(text_t *, const char *);
+uint8_t textColumn(const text_t *, int);
+int panelPixel(int, int);
+
+#endif // _TEXTSCROLL_H_
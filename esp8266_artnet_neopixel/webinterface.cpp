@@ -42,6 +42,11 @@ bool defaultConfig() {
   config.reverse = 0;
   config.speed = 8;
   config.split = 1;
+  config.panels = 1;
+  config.layout = LAYOUT_ROWMAJOR;
+  strcpy(config.text, "Hello");
+  config.nsegment = 0;
+  resolveSegments();
   return true;
 }
 
@@ -55,16 +60,17 @@ bool loadConfig() {
   }
 
   size_t size = configFile.size();
-  if (size > 1024) {
+  if (size > 2048) {
     Serial.println("Config file size is too large");
     return false;
   }
 
-  std::unique_ptr<char[]> buf(new char[size]);
+  std::unique_ptr<char[]> buf(new char[size + 1]);
   configFile.readBytes(buf.get(), size);
   configFile.close();
+  buf[size] = 0;
 
-  StaticJsonBuffer<300> jsonBuffer;
+  DynamicJsonBuffer jsonBuffer;
   JsonObject& root = jsonBuffer.parseObject(buf.get());
 
   if (!root.success()) {
@@ -83,13 +89,21 @@ bool loadConfig() {
   N_JSON_TO_CONFIG(reverse, "reverse");
   N_JSON_TO_CONFIG(speed, "speed");
   N_JSON_TO_CONFIG(split, "split");
+  N_JSON_TO_CONFIG(panels, "panels");
+  N_JSON_TO_CONFIG(layout, "layout");
+  S_JSON_TO_CONFIG(text, "text");
+  segmentsFromJSON(root);
 
+  // an older config file does not specify the number of panels
+  config.panels = (config.panels > 0 ? config.panels : 1);
+
+  resolveSegments();
   return true;
 }
 
 bool saveConfig() {
   Serial.println("saveConfig");
-  StaticJsonBuffer<300> jsonBuffer;
+  DynamicJsonBuffer jsonBuffer;
   JsonObject& root = jsonBuffer.createObject();
 
   N_CONFIG_TO_JSON(universe, "universe");
@@ -103,6 +117,10 @@ bool saveConfig() {
   N_CONFIG_TO_JSON(reverse, "reverse");
   N_CONFIG_TO_JSON(speed, "speed");
   N_CONFIG_TO_JSON(split, "split");
+  N_CONFIG_TO_JSON(panels, "panels");
+  N_CONFIG_TO_JSON(layout, "layout");
+  S_CONFIG_TO_JSON(text, "text");
+  segmentsToJSON(root);
 
   File configFile = SPIFFS.open("/config.json", "w");
   if (!configFile) {
@@ -117,6 +135,40 @@ bool saveConfig() {
   }
 }
 
+void segmentsFromJSON(JsonObject& root) {
+  if (!root.containsKey("segments"))
+    return;
+  // an empty list means that the whole strip runs the global mode
+  JsonArray& list = root["segments"];
+  config.nsegment = 0;
+  for (JsonObject& item : list) {
+    if (config.nsegment == MAXSEGMENT) {
+      Serial.println("Too many segments");
+      break;
+    }
+    Segment &s = config.segment[config.nsegment++];
+    s.start   = item["start"].as<int>();
+    s.length  = item["length"].as<int>();
+    s.mode    = item.containsKey("mode")    ? item["mode"].as<int>()    : config.mode;
+    s.offset  = item.containsKey("offset")  ? item["offset"].as<int>()  : config.offset;
+    s.reverse = item.containsKey("reverse") ? item["reverse"].as<int>() : config.reverse;
+  }
+}
+
+void segmentsToJSON(JsonObject& root) {
+  JsonArray& list = root.createNestedArray("segments");
+  for (int i = 0; i < config.nsegment; i++) {
+    JsonObject& item = list.createNestedObject();
+    item["start"]   = config.segment[i].start;
+    item["length"]  = config.segment[i].length;
+    item["mode"]    = config.segment[i].mode;
+    item["offset"]  = config.segment[i].offset;
+    item["reverse"] = config.segment[i].reverse;
+  }
+}
+
+/***************************************************************************/
+
 void printRequest() {
   String message = "HTTP Request\n\n";
   message += "URI: ";
@@ -240,7 +292,7 @@ void handleJSON() {
   Serial.println("handleJSON");
   printRequest();
 
-  if (server.hasArg("universe") || server.hasArg("offset") || server.hasArg("pixels") || server.hasArg("leds") || server.hasArg("white") || server.hasArg("brightness") || server.hasArg("hsv") || server.hasArg("mode") || server.hasArg("reverse") || server.hasArg("speed") || server.hasArg("split")) {
+  if (server.hasArg("universe") || server.hasArg("offset") || server.hasArg("pixels") || server.hasArg("leds") || server.hasArg("white") || server.hasArg("brightness") || server.hasArg("hsv") || server.hasArg("mode") || server.hasArg("reverse") || server.hasArg("speed") || server.hasArg("split") || server.hasArg("panels") || server.hasArg("layout") || server.hasArg("text")) {
     // the body is key1=val1&key2=val2&key3=val3 and the ESP8266Webserver has already parsed it
     N_KEYVAL_TO_CONFIG(universe, "universe");
     N_KEYVAL_TO_CONFIG(offset, "offset");
@@ -253,12 +305,15 @@ void handleJSON() {
     N_KEYVAL_TO_CONFIG(reverse, "reverse");
     N_KEYVAL_TO_CONFIG(speed, "speed");
     N_KEYVAL_TO_CONFIG(split, "split");
+    N_KEYVAL_TO_CONFIG(panels, "panels");
+    N_KEYVAL_TO_CONFIG(layout, "layout");
+    S_KEYVAL_TO_CONFIG(text, "text");
 
     handleStaticFile("/reload_success.html");
   }
   else if (server.hasArg("plain")) {
     // parse the body as JSON object
-    StaticJsonBuffer<300> jsonBuffer;
+    DynamicJsonBuffer jsonBuffer;
     JsonObject& root = jsonBuffer.parseObject(server.arg("plain"));
     if (!root.success()) {
       handleStaticFile("/reload_failure.html");
@@ -275,13 +330,40 @@ void handleJSON() {
     N_JSON_TO_CONFIG(reverse, "reverse");
     N_JSON_TO_CONFIG(speed, "speed");
     N_JSON_TO_CONFIG(split, "split");
-    
+    N_JSON_TO_CONFIG(panels, "panels");
+    N_JSON_TO_CONFIG(layout, "layout");
+    S_JSON_TO_CONFIG(text, "text");
+    segmentsFromJSON(root);
+
     handleStaticFile("/reload_success.html");
   }
   else {
     handleStaticFile("/reload_failure.html");
     return; // do not save the configuration
   }
-  
+
+  resolveSegments();
+  saveConfig();
+}
+
+void handleText() {
+  // this gets called in response to either a PUT or a POST
+  Serial.println("handleText");
+
+  if (server.hasArg("text")) {
+    // the body is text=value and the ESP8266Webserver has already parsed it
+    S_KEYVAL_TO_CONFIG(text, "text");
+  }
+  else if (server.hasArg("plain")) {
+    // the body is the text itself
+    String str = server.arg("plain");
+    snprintf(config.text, sizeof(config.text), "%s", str.c_str());
+  }
+  else {
+    server.send(400, "text/plain", "missing text");
+    return; // do not save the configuration
+  }
+
+  server.send(200, "text/plain", config.text);
   saveConfig();
 }
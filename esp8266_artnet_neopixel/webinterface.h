@@ -8,6 +8,9 @@
 #include <WiFiUdp.h>
 #include <FS.h>
 
+#include "textscroll.h"
+#include "segment.h"
+
 #ifndef ARDUINOJSON_VERSION
 #error ArduinoJson version 5 not found, please include ArduinoJson.h in your .ino file
 #endif
@@ -22,9 +25,9 @@
 #define N_KEYVAL_TO_CONFIG(x, y) { if (server.hasArg(y))    { String str = server.arg(y); config.x = str.toFloat(); } }
 
 /* these are for strings */
-#define S_JSON_TO_CONFIG(x, y)   { if (root.containsKey(y)) { strcpy(config.x, root[y]); } }
+#define S_JSON_TO_CONFIG(x, y)   { if (root.containsKey(y)) { snprintf(config.x, sizeof(config.x), "%s", (const char *)root[y]); } }
 #define S_CONFIG_TO_JSON(x, y)   { root.set(y, config.x); }
-#define S_KEYVAL_TO_CONFIG(x, y) { if (server.hasArg(y))    { String str = server.arg(y); strcpy(config.x, str.c_str()); } }
+#define S_KEYVAL_TO_CONFIG(x, y) { if (server.hasArg(y))    { String str = server.arg(y); snprintf(config.x, sizeof(config.x), "%s", str.c_str()); } }
 
 struct Config {
   int universe;
@@ -38,6 +41,11 @@ struct Config {
   int reverse;
   int speed;
   int split;
+  int panels;
+  int layout;
+  char text[TEXT_MAXLEN];
+  int nsegment;
+  Segment segment[MAXSEGMENT];
 };
 
 extern Config config;
@@ -55,5 +63,8 @@ void handleRedirect(const char *);
 bool handleStaticFile(String);
 bool handleStaticFile(const char *);
 void handleJSON();
+void segmentsFromJSON(JsonObject&);
+void segmentsToJSON(JsonObject&);
+void handleText();
 
 #endif // _WEBINTERFACE_H_
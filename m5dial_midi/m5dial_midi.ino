@@ -1,57 +1,108 @@
 #include <M5Dial.h>
-//#include <Control_Surface.h>
+#include <Control_Surface.h>  // https://github.com/tttapa/Control-Surface
 #include "colormap.h"
+#include "midiqueue.h"
+#include "parameter.h"
 
 #define clip(x, lo, hi) (x < lo ? lo : (x > hi ? hi : x))
+#define SCREEN_INTERVAL 16   // in milliseconds, the panel refreshes at about 60 Hz
+#define SCREEN_BAND     48   // in pixels, the height of the band in which the text is drawn
 
-long chan = 0;
-const int NCHAN = 16;
-long value[NCHAN];
+long chan = 0;  // the MIDI channel, zero-based
+long ctrl = 0;  // the controller number
 long oldPosition;
+unsigned long lastTurn = 0;
 
-//USBMIDI_Interface midi;
+// the text is drawn off-screen in a sprite, which is pushed to the display by DMA
+M5Canvas canvas(&M5Dial.Display);
+String text, shown;
+int shownWidth = 0;
+unsigned long lastRender = 0;
+unsigned long loopLongest = 0, lastReport = 0;
+
+BluetoothMIDI_Interface midi;
 
 enum { CHAN,
+       CTRL,
        VALUE } mode = CHAN;
 
 void updateMIDI() {
-//    MIDIAddress controller = {chan, Channel_1};
-//    midi.sendControlChange(controller, value[chan]);
+  // the message is sent from the queue, only the latest value of each parameter goes out
+  queueControl(chan, ctrl, parameterGet(chan, ctrl), 1);
+}
+
+void sendControl(uint8_t channel, uint8_t control, uint16_t value, uint32_t latency) {
+  MIDIAddress controller = { control, Channel_1 + channel };
+  midi.sendControlChange(controller, value);
 }
 
 void updateScreen() {
   String s;
   if (mode == CHAN) {
-    s = String("c ") + String(chan);
+    s = String("ch ") + String(chan + 1);
+  } else if (mode == CTRL) {
+    s = String("cc ") + String(ctrl);
   } else {
-    s = String("v ") + String(value[chan]);
+    s = String("v ") + String(parameterGet(chan, ctrl));
   }
   Serial.println(s);
-  M5Dial.Display.clear();
-  M5Dial.Display.drawString(s,
-                            M5Dial.Display.width() / 2,
-                            M5Dial.Display.height() / 2);
+  // the display is updated from the loop, at most at the refresh rate of the panel
+  text = s;
+}
+
+void renderScreen() {
+  if (text == shown || millis() - lastRender < SCREEN_INTERVAL)
+    return;
+  lastRender = millis();
+
+  // the previous transfer must be finished before the sprite is drawn again
+  M5Dial.Display.waitDMA();
+  canvas.fillSprite(BLACK);
+  canvas.drawString(text, canvas.width() / 2, canvas.height() / 2);
+
+  // only the part that is covered by the old or the new text is pushed to the display
+  int width = canvas.textWidth(text);
+  int dirty = max(width, shownWidth) + 2;
+  int x = (canvas.width() - dirty) / 2;
+  int y = (M5Dial.Display.height() - canvas.height()) / 2;
+  M5Dial.Display.setClipRect(x, y, dirty, canvas.height());
+  M5Dial.Display.pushImageDMA(0, y, canvas.width(), canvas.height(), (lgfx::swap565_t *)canvas.getBuffer());
+  M5Dial.Display.clearClipRect();
+
+  shown = text;
+  shownWidth = width;
 }
 
 void setup() {
   auto cfg = M5.config();
   Control_Surface.begin();  // Initialize the Control Surface
+  queueBegin(sendControl);
+  parameterBegin();
   M5Dial.begin(cfg, true, false);
-  M5Dial.Display.setTextColor(GREEN);
-  M5Dial.Display.setTextDatum(middle_center);
-  M5Dial.Display.setTextFont(&fonts::Orbitron_Light_32);
-  M5Dial.Display.setTextSize(1);
+  M5Dial.Display.fillScreen(BLACK);
+  canvas.setColorDepth(16);
+  canvas.createSprite(M5Dial.Display.width(), SCREEN_BAND);
+  canvas.setTextColor(GREEN);
+  canvas.setTextDatum(middle_center);
+  canvas.setTextFont(&fonts::Orbitron_Light_32);
+  canvas.setTextSize(1);
+  // the write transaction stays open, so that the DMA transfers run in the background
+  M5Dial.Display.startWrite();
   oldPosition = M5Dial.Encoder.read();
-  for (int chan = 0; chan < NCHAN; chan++)
-    value[chan] = 0;
+  updateScreen();
 }
 
 void loop() {
+  unsigned long loopStart = micros();
   M5Dial.update();
   Control_Surface.loop();  // Update the Control Surface
+  queueUpdate();
+  parameterStore();
 
   if (M5Dial.BtnA.wasPressed()) {
     if (mode == CHAN)
+      mode = CTRL;
+    else if (mode == CTRL)
       mode = VALUE;
     else
       mode = CHAN;
@@ -60,15 +111,32 @@ void loop() {
 
   long newPosition = M5Dial.Encoder.read();
   if (newPosition != oldPosition) {
+    long delta = newPosition - oldPosition;
     if (mode == CHAN) {
-      chan += (newPosition - oldPosition);
-      chan = clip(chan, 0, NCHAN - 1);
+      chan += delta;
+      chan = clip(chan, 0, PARAM_CHANNELS - 1);
+    } else if (mode == CTRL) {
+      ctrl += delta;
+      ctrl = clip(ctrl, 0, PARAM_CONTROLS - 1);
     } else {
-      value[chan] += (newPosition - oldPosition);
-      value[chan] = clip(value[chan], 0, 127);
-      updateMIDI();
+      // turning the encoder faster makes larger steps
+      if (parameterChange(chan, ctrl, parameterAccelerate(delta, millis() - lastTurn)))
+        updateMIDI();
     }
     updateScreen();
     oldPosition = newPosition;
+    lastTurn = millis();
+  }
+
+  renderScreen();
+
+  // keep track of the longest loop duration, which determines the latency of the encoder
+  loopLongest = max(loopLongest, micros() - loopStart);
+  if (millis() - lastReport > 10000) {
+    Serial.print("loop ");
+    Serial.print(loopLongest);
+    Serial.println(" us");
+    loopLongest = 0;
+    lastReport = millis();
   }
 }
\ No newline at end of file
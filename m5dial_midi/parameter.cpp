@@ -0,0 +1,74 @@
+#include <Preferences.h>
+#include "parameter.h"
+
+static Preferences preferences;
+static uint8_t value[PARAM_CHANNELS][PARAM_CONTROLS];
+static uint8_t dirty[PARAM_CHANNELS];  // one bit per page
+static bool pending = false;
+static unsigned long lastChange = 0;
+
+/***************************************************************************/
+
+static void pageKey(char *key, uint8_t channel, uint8_t page) {
+  // the keys in the NVS can be at most 15 characters
+  sprintf(key, "c%dp%d", channel, page);
+}
+
+void parameterBegin() {
+  memset(value, 0, sizeof(value));
+  memset(dirty, 0, sizeof(dirty));
+  preferences.begin(PARAM_NAMESPACE, false);
+
+  char key[16];
+  for (uint8_t channel = 0; channel < PARAM_CHANNELS; channel++)
+    for (uint8_t page = 0; page < PARAM_PAGES; page++) {
+      pageKey(key, channel, page);
+      if (preferences.isKey(key))
+        preferences.getBytes(key, &value[channel][page * PARAM_PAGESIZE], PARAM_PAGESIZE);
+    }
+}
+
+uint8_t parameterGet(uint8_t channel, uint8_t control) {
+  return value[channel][control];
+}
+
+bool parameterChange(uint8_t channel, uint8_t control, long delta) {
+  // this returns true if the value changed
+  long newvalue = value[channel][control] + delta;
+  newvalue = (newvalue < 0 ? 0 : (newvalue > 127 ? 127 : newvalue));
+  if (newvalue == value[channel][control])
+    return false;
+  value[channel][control] = newvalue;
+  dirty[channel] |= (1 << (control / PARAM_PAGESIZE));
+  pending = true;
+  lastChange = millis();
+  return true;
+}
+
+void parameterStore() {
+  if (!pending || millis() - lastChange < PARAM_DELAY)
+    return;
+
+  char key[16];
+  for (uint8_t channel = 0; channel < PARAM_CHANNELS; channel++)
+    for (uint8_t page = 0; page < PARAM_PAGES; page++)
+      if (dirty[channel] & (1 << page)) {
+        pageKey(key, channel, page);
+        preferences.putBytes(key, &value[channel][page * PARAM_PAGESIZE], PARAM_PAGESIZE);
+      }
+  memset(dirty, 0, sizeof(dirty));
+  pending = false;
+}
+
+long parameterAccelerate(long delta, unsigned long interval) {
+  // the interval since the previous change is in milliseconds
+  long speed = abs(delta) * 1000 / (interval > 0 ? interval : 1);
+  long gain;
+  if (speed <= ACCEL_SLOW)
+    gain = 1;
+  else if (speed >= ACCEL_FAST)
+    gain = ACCEL_MAX;
+  else
+    gain = 1 + (ACCEL_MAX - 1) * (speed - ACCEL_SLOW) / (ACCEL_FAST - ACCEL_SLOW);
+  return delta * gain;
+}
@@ -0,0 +1,34 @@
+#ifndef _PARAMETER_H_
+#define _PARAMETER_H_
+
+#include <Arduino.h>
+
+/*
+  The parameters are the control change values on all MIDI channels. The controllers on
+  each channel are organized in pages, which is also the unit in which they are stored
+  in the non-volatile storage (NVS). Changes are written behind: a page is only written
+  once the parameters have not been changed for a while, which limits the wear on the
+  flash memory while the encoder is being turned.
+
+  The encoder is accelerated: when it is turned faster, each count results in a larger
+  step of the parameter value.
+*/
+
+#define PARAM_CHANNELS  16
+#define PARAM_PAGES     8
+#define PARAM_PAGESIZE  16
+#define PARAM_CONTROLS  (PARAM_PAGES * PARAM_PAGESIZE)
+#define PARAM_DELAY     5000         // in milliseconds, after the last change
+#define PARAM_NAMESPACE "m5dial"
+
+#define ACCEL_SLOW      20           // in counts per second, below this the step is 1
+#define ACCEL_FAST      200          // in counts per second, above this the step is ACCEL_MAX
+#define ACCEL_MAX       8
+
+void parameterBegin(void);
+uint8_t parameterGet(uint8_t, uint8_t);
+bool parameterChange(uint8_t, uint8_t, long);
+void parameterStore(void);
+long parameterAccelerate(long, unsigned long);
+
+#endif // _PARAMETER_H_
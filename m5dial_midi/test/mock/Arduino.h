@@ -0,0 +1,16 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the ESP32 Arduino core for the host tests, it
+// only provides what the modules of this sketch use. The time is set by the test.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern uint32_t mockMillis;
+
+inline uint32_t millis() { return mockMillis; }
+
+#endif // _ARDUINO_H_
@@ -0,0 +1,46 @@
+#ifndef _PREFERENCES_H_
+#define _PREFERENCES_H_
+
+// This replaces the NVS library with a map that survives a restart of the modules,
+// the number of writes and the keys that were written are counted.
+
+#include <map>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+
+extern std::map<std::string, std::vector<uint8_t> > mockNVS;
+extern std::vector<std::string> mockWrites;
+
+class Preferences {
+ public:
+  bool begin(const char *name, bool readOnly = false) {
+    space = name;
+    return true;
+  }
+
+  bool isKey(const char *key) {
+    return mockNVS.count(space + "/" + key) > 0;
+  }
+
+  size_t getBytes(const char *key, void *buffer, size_t length) {
+    std::vector<uint8_t> &data = mockNVS[space + "/" + key];
+    length = (data.size() < length ? data.size() : length);
+    memcpy(buffer, data.data(), length);
+    return length;
+  }
+
+  size_t putBytes(const char *key, const void *buffer, size_t length) {
+    // the keys in the NVS can be at most 15 characters
+    if (strlen(key) > 15)
+      return 0;
+    mockNVS[space + "/" + key].assign((const uint8_t *)buffer, (const uint8_t *)buffer + length);
+    mockWrites.push_back(key);
+    return length;
+  }
+
+ private:
+  std::string space;
+};
+
+#endif // _PREFERENCES_H_
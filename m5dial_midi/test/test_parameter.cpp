@@ -0,0 +1,122 @@
+// Host test of the acceleration curve of the encoder and the write-behind of the
+// parameters to the non-volatile storage
+
+#include "check.h"
+#include "parameter.h"
+#include <Preferences.h>
+
+uint32_t mockMillis = 0;
+std::map<std::string, std::vector<uint8_t> > mockNVS;
+std::vector<std::string> mockWrites;
+
+// turn the encoder by the given number of counts at a constant speed, with the main loop running every ms
+static void turn(uint8_t channel, uint8_t control, int counts, unsigned int speed) {
+  unsigned long interval = 1000 / speed;
+  unsigned long lastTurn = mockMillis - interval;
+  for (int k = 0; k < abs(counts); k++) {
+    for (unsigned long t = 0; t < interval; t++) {
+      mockMillis++;
+      parameterStore();
+    }
+    parameterChange(channel, control, parameterAccelerate(counts > 0 ? 1 : -1, mockMillis - lastTurn));
+    lastTurn = mockMillis;
+  }
+}
+
+static void wait(unsigned long ms) {
+  for (unsigned long t = 0; t < ms; t++) {
+    mockMillis++;
+    parameterStore();
+  }
+}
+
+static void testAccelerate() {
+  // slow turning moves the value by one per count, fast turning by the maximum step
+  CHECK_EQUAL(parameterAccelerate(1, 1000), 1);
+  CHECK_EQUAL(parameterAccelerate(1, 1000 / ACCEL_SLOW), 1);
+  CHECK_EQUAL(parameterAccelerate(1, 1000 / ACCEL_FAST), ACCEL_MAX);
+  CHECK_EQUAL(parameterAccelerate(-1, 1), -ACCEL_MAX);
+  CHECK_EQUAL(parameterAccelerate(3, 0), 3 * ACCEL_MAX);
+
+  // the gain increases with the speed and is symmetric
+  long previous = 1;
+  for (unsigned long interval = 1000 / ACCEL_SLOW; interval >= 1000 / ACCEL_FAST; interval--) {
+    long step = parameterAccelerate(1, interval);
+    CHECK(step >= previous);
+    CHECK(step >= 1 && step <= ACCEL_MAX);
+    CHECK_EQUAL(parameterAccelerate(-1, interval), -step);
+    previous = step;
+  }
+
+  // several counts in one loop are a higher speed
+  CHECK_EQUAL(parameterAccelerate(4, 40), 4 * parameterAccelerate(1, 10));
+}
+
+static void testSweep() {
+  mockNVS.clear();
+  parameterBegin();
+
+  // a slow sweep takes a step for every count, a fast one covers the full range in a few turns
+  turn(0, 0, 127, ACCEL_SLOW / 2);
+  CHECK_EQUAL(parameterGet(0, 0), 127);
+  turn(0, 0, -126, ACCEL_SLOW / 2);
+  CHECK_EQUAL(parameterGet(0, 0), 1);
+
+  turn(0, 1, 127 / ACCEL_MAX + 1, 2 * ACCEL_FAST);
+  CHECK_EQUAL(parameterGet(0, 1), 127);
+  turn(0, 1, -(127 / ACCEL_MAX + 1), 2 * ACCEL_FAST);
+  CHECK_EQUAL(parameterGet(0, 1), 0);
+
+  // the value is clamped, a change beyond the end is no change
+  CHECK(!parameterChange(0, 1, -5));
+  CHECK(parameterChange(0, 1, 500));
+  CHECK_EQUAL(parameterGet(0, 1), 127);
+  CHECK(!parameterChange(0, 1, 1));
+}
+
+static void testWriteBehind() {
+  mockNVS.clear();
+  parameterBegin();
+  wait(2 * PARAM_DELAY);
+  mockWrites.clear();
+
+  // nothing is written while the encoder is being turned, also not when it takes long
+  turn(3, 20, 100, 5);
+  turn(3, 21, -10, 5);
+  turn(3, 100, 50, 5);
+  CHECK_EQUAL(mockWrites.size(), 0);
+  wait(PARAM_DELAY - 1);
+  CHECK_EQUAL(mockWrites.size(), 0);
+
+  // after a pause only the pages that were changed are written, each page once
+  wait(1);
+  CHECK_EQUAL(mockWrites.size(), 2);
+  CHECK(mockWrites[0] == "c3p1");
+  CHECK(mockWrites[1] == "c3p6");
+  wait(10 * PARAM_DELAY);
+  CHECK_EQUAL(mockWrites.size(), 2);
+
+  // a change that does not change the value does not cause a write
+  CHECK(!parameterChange(3, 21, -1));
+  wait(2 * PARAM_DELAY);
+  CHECK_EQUAL(mockWrites.size(), 2);
+
+  // the values are restored after a restart, including the highest channel and page
+  parameterChange(PARAM_CHANNELS - 1, PARAM_CONTROLS - 1, 77);
+  wait(PARAM_DELAY);
+  CHECK_EQUAL(mockWrites.size(), 3);
+  CHECK(mockWrites[2] == "c15p7");
+  parameterBegin();
+  CHECK_EQUAL(parameterGet(3, 20), 100);
+  CHECK_EQUAL(parameterGet(3, 21), 0);
+  CHECK_EQUAL(parameterGet(3, 100), 50);
+  CHECK_EQUAL(parameterGet(PARAM_CHANNELS - 1, PARAM_CONTROLS - 1), 77);
+  CHECK_EQUAL(parameterGet(0, 0), 0);
+}
+
+int main() {
+  testAccelerate();
+  testSweep();
+  testWriteBehind();
+  return report("test_parameter");
+}
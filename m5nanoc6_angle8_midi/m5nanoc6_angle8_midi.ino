@@ -6,9 +6,11 @@
 */
 
 #include <M5Unified.h>        // https://github.com/m5stack/M5Unified
-#include <M5_ANGLE8.h>        // https://github.com/m5stack/M5Unit-8Angle
 #include <Control_Surface.h>  // https://github.com/tttapa/Control-Surface
 #include "colormap.h"
+#include "midiqueue.h"
+#include "smoothing.h"
+#include "scanner.h"
 
 // #define I2C_SDA G13 // for the M5Dial
 // #define I2C_SCL G15
@@ -16,38 +18,53 @@
 #define I2C_SCL 1
 #define I2C_ADDR 0x43
 #define I2C_SPEED 4000000L
-#define MIDI_DELAY 10  // do not send the MIDI messages too fast/frequent
+
+#define OUTPUT_CC7  0  // 7-bit control change
+#define OUTPUT_CC14 1  // 14-bit control change, the MSB on controller N and the LSB on controller N+32
+#define OUTPUT_NRPN 2  // non-registered parameter number N with a 14-bit data entry
+#define OUTPUT_MODE OUTPUT_CC7
 
 BluetoothMIDI_Interface midi;
-M5_ANGLE8 angle8;
 
 bool sw;
-uint16_t value[8];
+uint16_t value[8];  // in 7 or 14 bits, depending on the output mode
+uint32_t lastReport = 0;
 
 void updateSwitch(bool sw) {
   uint32_t rgb = 0x0000FF00 * sw;  // green or black
-  angle8.setLEDColor(8, rgb, 64);
+  scannerColor(8, rgb, 64);
 }
 
-void updateValue(bool sw, uint8_t knob, uint8_t value) {
-  uint32_t rgb = (r[value] << 16) | (g[value] << 8) | (b[value] << 0);
-  angle8.setLEDColor(knob, rgb, 64);
-
-  // the switch allows selecting MIDI channel 1 or 2
-  if (sw == 0) {
-    MIDIAddress controller = { knob, Channel_1 };
-    midi.sendControlChange(controller, value);
-  } else {
-    MIDIAddress controller = { knob, Channel_2 };
-    midi.sendControlChange(controller, value);
+void updateValue(bool sw, uint8_t knob, uint16_t value) {
+  uint8_t color = (OUTPUT_MODE == OUTPUT_CC7 ? value : value >> 7);
+  uint32_t rgb = (r[color] << 16) | (g[color] << 8) | (b[color] << 0);
+  scannerColor(knob, rgb, 64);  // this is only written to the unit when it changes
+
+  // the switch allows selecting MIDI channel 1 or 2, the message is sent from the queue
+  queueControl(sw, knob, value, (OUTPUT_MODE == OUTPUT_CC7 ? 1 : (OUTPUT_MODE == OUTPUT_CC14 ? 2 : 4)));
+}
+
+void sendControl(uint8_t channel, uint8_t control, uint16_t value, uint32_t latency) {
+  Channel ch = Channel_1 + channel;
+  if (OUTPUT_MODE == OUTPUT_CC7) {
+    midi.sendControlChange({ control, ch }, value);
+  } else if (OUTPUT_MODE == OUTPUT_CC14) {
+    midi.sendControlChange({ control, ch }, value >> 7);
+    midi.sendControlChange({ control + 32, ch }, value & 0x7F);
+  } else if (OUTPUT_MODE == OUTPUT_NRPN) {
+    midi.sendControlChange({ 99, ch }, 0);  // parameter number MSB
+    midi.sendControlChange({ 98, ch }, control);  // parameter number LSB
+    midi.sendControlChange({ 6, ch }, value >> 7);  // data entry MSB
+    midi.sendControlChange({ 38, ch }, value & 0x7F);  // data entry LSB
   }
 
-  Serial.print(sw);
+  Serial.print(channel);
+  Serial.print(" ");
+  Serial.print(control);
   Serial.print(" ");
-  Serial.print(knob);
+  Serial.print(value);
   Serial.print(" ");
-  Serial.println(value);
-  delay(MIDI_DELAY);
+  Serial.println(latency);
 }
 
 void setup() {
@@ -56,20 +73,28 @@ void setup() {
   M5.begin();
   Serial.println("setup start");
 
-  while (!angle8.begin(I2C_ADDR, I2C_SDA, I2C_SCL, I2C_SPEED)) {
+  while (!scannerBegin(I2C_ADDR, I2C_SDA, I2C_SCL, I2C_SPEED)) {
     Serial.println("angle8 connect error");
     delay(100);
   }
   Serial.println("angle8 connect OK");
 
   Control_Surface.begin();
+  queueBegin(sendControl);
   esp_log_level_set("i2c.master", ESP_LOG_NONE);  // see https://github.com/espressif/arduino-esp32/issues/11787
 
-  sw = angle8.getDigitalInput();
+  snapshot_t snapshot;
+  scannerSnapshot(&snapshot);
+  sw = snapshot.sw;
   updateSwitch(sw);
 
+  // the 14-bit output modes get the full 12-bit resolution of the pots
+  smoothingBegin(OUTPUT_MODE == OUTPUT_CC7 ? 7 : 12);
+
   for (uint8_t knob = 0; knob < 8; knob++) {
-    value[knob] = (255 - angle8.getAnalogInput(knob, _8bit)) / 2;
+    smoothingUpdate(knob, snapshot.value[knob], &value[knob]);
+    if (OUTPUT_MODE != OUTPUT_CC7)
+      value[knob] <<= 2;
     updateValue(sw, knob, value[knob]);
   }
 
@@ -79,17 +104,27 @@ void setup() {
 void loop() {
   M5.update();
   Control_Surface.loop();
+  queueUpdate();
+
+  if (millis() - lastReport > 10000) {
+    Serial.print("scan rate ");
+    Serial.println(scannerRate());
+    lastReport = millis();
+  }
+
+  snapshot_t snapshot;
+  if (!scannerSnapshot(&snapshot))
+    return;
 
-  bool newsw = angle8.getDigitalInput();
-  if (newsw != sw) {
-    updateSwitch(newsw);
-    sw = newsw;
+  if (snapshot.sw != sw) {
+    updateSwitch(snapshot.sw);
+    sw = snapshot.sw;
   }
 
-  for (uint8_t knob = 0; knob < ANGLE8_TOTAL_ADC; knob++) {
-    uint16_t newvalue = (255 - angle8.getAnalogInput(knob, _8bit)) / 2;
-    if (value[knob] != newvalue) {
-      value[knob] = newvalue;
+  for (uint8_t knob = 0; knob < SCAN_CHANNELS; knob++) {
+    uint16_t newvalue;
+    if (smoothingUpdate(knob, snapshot.value[knob], &newvalue)) {
+      value[knob] = (OUTPUT_MODE == OUTPUT_CC7 ? newvalue : newvalue << 2);
       updateValue(sw, knob, value[knob]);
     }
   }
@@ -0,0 +1,88 @@
+#include "midiqueue.h"
+
+typedef struct {
+  uint8_t channel;     // zero-based
+  uint8_t control;
+  uint16_t value;      // 7 or 14 bits
+  uint8_t cost;        // the number of MIDI messages, this is also the number of tokens
+  uint32_t time;       // in microseconds, when the control first changed
+} entry_t;
+
+// the entries that are waiting are kept in order, the oldest one is at the start
+static entry_t entry[QUEUE_SIZE];
+static unsigned int waiting = 0;
+
+static queue_callback_t callback = NULL;
+static unsigned int tokens = QUEUE_BURST;
+static uint32_t refill = 0;
+static uint32_t latency = 0;
+
+/***************************************************************************/
+
+void queueBegin(queue_callback_t cb) {
+  callback = cb;
+  waiting = 0;
+  tokens = QUEUE_BURST;
+  refill = micros();
+  latency = 0;
+}
+
+void queueControl(uint8_t channel, uint8_t control, uint16_t value, uint8_t cost) {
+  // an entry that costs more than the bucket can hold would never be sent
+  cost = constrain(cost, 1, QUEUE_BURST);
+
+  // the latest value wins, the entry keeps its place in the queue
+  for (unsigned int i = 0; i < waiting; i++) {
+    if (entry[i].channel == channel && entry[i].control == control) {
+      entry[i].value = value;
+      return;
+    }
+  }
+  if (waiting == QUEUE_SIZE) {
+    // this should not happen with a handful of knobs, send the oldest one to make space
+    tokens += entry[0].cost;
+    queueUpdate();
+  }
+  entry[waiting].channel = channel;
+  entry[waiting].control = control;
+  entry[waiting].value = value;
+  entry[waiting].cost = cost;
+  entry[waiting].time = micros();
+  waiting++;
+}
+
+void queueUpdate() {
+  uint32_t now = micros();
+  uint32_t elapsed = now - refill;
+  if (elapsed >= QUEUE_INTERVAL) {
+    // the bucket does not hold more than one connection interval worth of tokens
+    refill += (elapsed / QUEUE_INTERVAL) * QUEUE_INTERVAL;
+    tokens = QUEUE_BURST;
+  }
+
+  unsigned int sent = 0;
+  while (sent < waiting && tokens >= entry[sent].cost) {
+    uint32_t delay = now - entry[sent].time;
+    latency = (delay > latency ? delay : latency);
+    if (callback)
+      callback(entry[sent].channel, entry[sent].control, entry[sent].value, delay);
+    tokens -= entry[sent].cost;
+    sent++;
+  }
+
+  if (sent) {
+    waiting -= sent;
+    memmove(entry, entry + sent, waiting * sizeof(entry_t));
+  }
+}
+
+unsigned int queueWaiting() {
+  return waiting;
+}
+
+uint32_t queueLatency() {
+  // this returns the largest latency in microseconds since the previous call
+  uint32_t value = latency;
+  latency = 0;
+  return value;
+}
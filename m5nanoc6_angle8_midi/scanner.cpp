@@ -0,0 +1,146 @@
+#include <Wire.h>
+#include "scanner.h"
+
+#define ANALOG_INPUT_12B_REG 0x00  // 8 x uint16, little endian
+#define DIGITAL_INPUT_REG    0x20  // uint8
+#define RGB_24B_REG          0x30  // 9 x RGB and brightness
+
+static uint8_t address;
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+static snapshot_t latest;
+static uint32_t consumed = 0;
+
+// these are shared with the scan task and protected by the mutex
+static uint32_t color[SCAN_LEDS];
+static uint16_t dirtyColor = 0;
+
+// these are only used by the scan task
+static uint32_t written[SCAN_LEDS];
+static uint16_t history[SCAN_AVERAGE][SCAN_CHANNELS];
+static uint32_t sum[SCAN_CHANNELS];
+static uint8_t oldest = 0;
+static uint32_t rateCount = 0, rateTime = 0;
+static unsigned int rate = 0;
+
+/***************************************************************************/
+
+static bool readRegister(uint8_t reg, uint8_t *buffer, uint8_t length) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0)
+    return false;
+  if (Wire.requestFrom(address, length) != length)
+    return false;
+  for (uint8_t i = 0; i < length; i++)
+    buffer[i] = Wire.read();
+  return true;
+}
+
+static void writeRegister(uint8_t reg, const uint8_t *buffer, uint8_t length) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.write(buffer, length);
+  Wire.endTransmission();
+}
+
+static void flush() {
+  uint32_t newcolor[SCAN_LEDS];
+  uint16_t colors;
+
+  portENTER_CRITICAL(&mux);
+  colors = dirtyColor;
+  memcpy(newcolor, color, sizeof(color));
+  dirtyColor = 0;
+  portEXIT_CRITICAL(&mux);
+
+  // the color is stored as RGB in the lower and the brightness in the upper byte
+  for (uint8_t i = 0; i < SCAN_LEDS; i++) {
+    if ((colors & (1 << i)) && newcolor[i] != written[i]) {
+      uint8_t rgb[4] = { (uint8_t)(newcolor[i] >> 16), (uint8_t)(newcolor[i] >> 8), (uint8_t)(newcolor[i]), (uint8_t)(newcolor[i] >> 24) };
+      writeRegister(RGB_24B_REG + i * 4, rgb, 4);
+      written[i] = newcolor[i];
+    }
+  }
+}
+
+static void scan() {
+  uint8_t analog[SCAN_CHANNELS * 2], sw;
+  if (!readRegister(ANALOG_INPUT_12B_REG, analog, sizeof(analog)) || !readRegister(DIGITAL_INPUT_REG, &sw, 1))
+    return;
+
+  snapshot_t snapshot;
+  snapshot.time = micros();
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++) {
+    // keep a running sum over the most recent scans, the pots are inverted
+    uint16_t reading = 4095 - (analog[i * 2] | (analog[i * 2 + 1] << 8));
+    sum[i] += reading - history[oldest][i];
+    history[oldest][i] = reading;
+    snapshot.value[i] = sum[i] / SCAN_AVERAGE;
+  }
+  oldest = (oldest + 1) % SCAN_AVERAGE;
+  snapshot.sw = sw;
+
+  portENTER_CRITICAL(&mux);
+  snapshot.count = latest.count + 1;
+  latest = snapshot;
+  portEXIT_CRITICAL(&mux);
+
+  rateCount++;
+  if (snapshot.time - rateTime >= 1000000UL) {
+    rate = rateCount;
+    rateCount = 0;
+    rateTime = snapshot.time;
+  }
+}
+
+static void scanTask(void *) {
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    flush();
+    scan();
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(1000 / SCAN_RATE));
+  }
+}
+
+/***************************************************************************/
+
+bool scannerBegin(uint8_t addr, int sda, int scl, uint32_t speed) {
+  address = addr;
+  Wire.begin(sda, scl, speed);
+  Wire.beginTransmission(address);
+  if (Wire.endTransmission() != 0)
+    return false;
+
+  // the averages are filled with the first scans before the task starts
+  memset(&latest, 0, sizeof(latest));
+  memset(written, 0xFF, sizeof(written));
+  memset(history, 0, sizeof(history));
+  memset(sum, 0, sizeof(sum));
+  for (uint8_t i = 0; i < SCAN_AVERAGE; i++)
+    scan();
+  xTaskCreate(scanTask, "scan", 4096, NULL, 2, NULL);
+  return true;
+}
+
+bool scannerSnapshot(snapshot_t *snapshot) {
+  // this returns true if there is a new snapshot since the previous call
+  portENTER_CRITICAL(&mux);
+  *snapshot = latest;
+  portEXIT_CRITICAL(&mux);
+  bool fresh = (snapshot->count != consumed);
+  consumed = snapshot->count;
+  return fresh;
+}
+
+void scannerColor(uint8_t led, uint32_t rgb, uint8_t brightness) {
+  portENTER_CRITICAL(&mux);
+  color[led] = (rgb & 0x00FFFFFF) | ((uint32_t)brightness << 24);
+  dirtyColor |= (1 << led);
+  portEXIT_CRITICAL(&mux);
+}
+
+unsigned int scannerRate() {
+  // the number of scans in the most recent second
+  return rate;
+}
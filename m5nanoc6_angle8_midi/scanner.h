@@ -0,0 +1,33 @@
+#ifndef _SCANNER_H_
+#define _SCANNER_H_
+
+#include <Arduino.h>
+
+/*
+  The 8Angle unit is scanned by a separate task at a fixed rate. The 12-bit readings of
+  all pots are read with a single I2C transaction, rather than with one transaction per
+  channel, and the switch with a second one. The readings are averaged over the most
+  recent scans and published as a timestamped snapshot.
+
+  All I2C communication takes place in the scan task. The LED colors are written by the
+  task before the next scan, and only when they have changed.
+*/
+
+#define SCAN_RATE     500   // in Hz
+#define SCAN_AVERAGE  4     // number of scans that are averaged
+#define SCAN_CHANNELS 8
+#define SCAN_LEDS     9     // the ninth LED is next to the switch
+
+typedef struct {
+  uint32_t time;           // in microseconds, when the scan was done
+  uint32_t count;          // incremented on every scan
+  uint16_t value[SCAN_CHANNELS];  // in 12 bits, averaged
+  bool sw;
+} snapshot_t;
+
+bool scannerBegin(uint8_t, int, int, uint32_t);
+bool scannerSnapshot(snapshot_t *);
+void scannerColor(uint8_t, uint32_t, uint8_t);
+unsigned int scannerRate(void);
+
+#endif // _SCANNER_H_
@@ -0,0 +1,43 @@
+#include "smoothing.h"
+
+static uint8_t shift = 5;       // from the 12-bit reading to the output resolution
+static int32_t level[SMOOTHING_CHANNELS];
+
+/***************************************************************************/
+
+void smoothingBegin(uint8_t bits) {
+  // the output cannot have more resolution than the 12-bit input
+  shift = (bits < 12 ? 12 - bits : 0);
+  for (uint8_t i = 0; i < SMOOTHING_CHANNELS; i++)
+    level[i] = -1;
+}
+
+bool smoothingUpdate(uint8_t channel, uint16_t reading, uint16_t *value) {
+  // the reading is in 12 bits, the value is returned in the output resolution
+  int32_t step = 1 << shift;
+  int32_t lower = level[channel] * step;      // the range of readings of the current output step
+  int32_t upper = lower + step - 1;
+  int32_t newlevel = level[channel];
+
+  // the reading is stretched by the deadband on both sides, so that the ends of the range can be reached
+  int32_t stretched = ((int32_t)reading * (4095 + 2 * SMOOTHING_DEADBAND) + 2047) / 4095 - SMOOTHING_DEADBAND;
+
+  if (level[channel] < 0) {
+    newlevel = reading >> shift;
+  }
+  else if (stretched > upper + SMOOTHING_DEADBAND) {
+    // the new step trails the reading by the deadband, the noise cannot take it back
+    newlevel = (stretched - SMOOTHING_DEADBAND) >> shift;
+  }
+  else if (stretched < lower - SMOOTHING_DEADBAND) {
+    newlevel = (stretched + SMOOTHING_DEADBAND) >> shift;
+  }
+  newlevel = constrain(newlevel, 0, 4095 >> shift);
+
+  if (newlevel != level[channel]) {
+    level[channel] = newlevel;
+    *value = newlevel;
+    return true;
+  }
+  return false;
+}
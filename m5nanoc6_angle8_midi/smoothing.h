@@ -0,0 +1,22 @@
+#ifndef _SMOOTHING_H_
+#define _SMOOTHING_H_
+
+#include <Arduino.h>
+
+/*
+  The potentiometers are read with the full 12-bit resolution of the 8Angle unit and
+  averaged over a number of scans. The averaged reading is reduced to the resolution of
+  the output with hysteresis: the output only changes once the reading is more than the
+  deadband away from the current output step, and then moves to the step that trails
+  the reading by the deadband. This prevents the noise on a pot that sits on the edge
+  between two steps from producing a stream of messages, also at 12 bits where a step
+  is smaller than the noise.
+*/
+
+#define SMOOTHING_CHANNELS   8
+#define SMOOTHING_DEADBAND   4    // in 12-bit steps, beyond the edge of the current output step
+
+void smoothingBegin(uint8_t);
+bool smoothingUpdate(uint8_t, uint16_t, uint16_t *);
+
+#endif // _SMOOTHING_H_
@@ -0,0 +1,63 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This is a minimal replacement of the ESP32 Arduino core for the host tests, it
+// only provides what the modules of this sketch use. The time is set by the test.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern uint32_t mockMicros;
+
+inline uint32_t micros() { return mockMicros; }
+inline uint32_t millis() { return mockMicros / 1000; }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// FreeRTOS, a task is run by mockTask() for a number of cycles, after which vTaskDelayUntil
+// ends it with an exception; each cycle advances the time by the delay of the task
+
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void *);
+typedef struct {
+  int depth;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(mux) ((mux)->depth++)
+#define portEXIT_CRITICAL(mux) ((mux)->depth--)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+extern TaskFunction_t mockTaskFunction;
+extern unsigned int mockTaskCycles;
+
+struct MockTaskStop {};
+
+inline int xTaskCreate(TaskFunction_t function, const char *, uint32_t, void *, unsigned int, void *) {
+  mockTaskFunction = function;
+  return 1;
+}
+
+inline TickType_t xTaskGetTickCount() {
+  return mockMicros / 1000;
+}
+
+inline void vTaskDelayUntil(TickType_t *wake, TickType_t ticks) {
+  *wake += ticks;
+  mockMicros = *wake * 1000;
+  if (--mockTaskCycles == 0)
+    throw MockTaskStop();
+}
+
+inline void mockTask(unsigned int cycles) {
+  mockTaskCycles = cycles;
+  try {
+    mockTaskFunction(NULL);
+  }
+  catch (MockTaskStop &) {
+  }
+}
+
+#endif // _ARDUINO_H_
@@ -0,0 +1,199 @@
+// Host test of the MIDI queue, the coalescing of control changes and the token bucket
+// that limits the messages per BLE connection interval
+
+#include <vector>
+#include "check.h"
+#include "midiqueue.h"
+
+uint32_t mockMicros = 0;
+
+struct Sent {
+  uint8_t channel, control;
+  uint16_t value;
+  uint32_t latency;
+  uint32_t time;
+};
+
+static std::vector<Sent> sent;
+
+static void callback(uint8_t channel, uint8_t control, uint16_t value, uint32_t latency) {
+  Sent s = {channel, control, value, latency, mockMicros};
+  sent.push_back(s);
+}
+
+static void begin() {
+  mockMicros = 1000000;
+  sent.clear();
+  queueBegin(callback);
+}
+
+// advance the time in steps of 1 ms, with an update of the queue at every step like the main loop
+static void run(uint32_t ms) {
+  for (uint32_t k = 0; k < ms; k++) {
+    mockMicros += 1000;
+    queueUpdate();
+  }
+}
+
+static void testCoalesce() {
+  begin();
+
+  // a control that changes while it is waiting is sent once, with the latest value
+  queueControl(0, 1, 10, 1);
+  queueControl(0, 2, 20, 1);
+  queueControl(0, 1, 11, 1);
+  queueControl(0, 1, 12, 1);
+  CHECK_EQUAL(queueWaiting(), 2);
+
+  // the same controller on another channel is another entry
+  queueControl(1, 1, 30, 1);
+  CHECK_EQUAL(queueWaiting(), 3);
+
+  queueUpdate();
+  CHECK_EQUAL(sent.size(), 3);
+  CHECK_EQUAL(queueWaiting(), 0);
+
+  // the entry keeps the place of the first change
+  CHECK_EQUAL(sent[0].control, 1);
+  CHECK_EQUAL(sent[0].value, 12);
+  CHECK_EQUAL(sent[1].control, 2);
+  CHECK_EQUAL(sent[1].value, 20);
+  CHECK_EQUAL(sent[2].channel, 1);
+  CHECK_EQUAL(sent[2].value, 30);
+}
+
+static void testRate() {
+  begin();
+
+  // a fast sweep of 8 knobs for 300 ms, each knob changes every millisecond
+  uint32_t start = mockMicros;
+  unsigned int changes = 0;
+  for (int k = 0; k < 300; k++) {
+    for (int knob = 0; knob < 8; knob++) {
+      queueControl(0, knob, (k + knob) & 0x7F, 1);
+      changes++;
+    }
+    run(1);
+  }
+  run(100);
+  CHECK_EQUAL(queueWaiting(), 0);
+  printf("%u changes resulted in %u messages\n", changes, (unsigned int)sent.size());
+
+  // no connection interval carries more than a burst of messages
+  std::vector<unsigned int> interval(1000);
+  for (size_t i = 0; i < sent.size(); i++)
+    interval[(sent[i].time - start) / QUEUE_INTERVAL]++;
+  for (size_t i = 0; i < interval.size(); i++)
+    CHECK(interval[i] <= QUEUE_BURST);
+  CHECK_CLOSE(sent.size(), (300.0 * 1000 / QUEUE_INTERVAL) * QUEUE_BURST, 2 * QUEUE_BURST);
+
+  // with 8 knobs and 4 messages per interval each knob waits at most two intervals
+  uint32_t longest = 0;
+  for (size_t i = 0; i < sent.size(); i++)
+    longest = (sent[i].latency > longest ? sent[i].latency : longest);
+  CHECK(longest <= 2 * QUEUE_INTERVAL + 1000);
+  CHECK_EQUAL(queueLatency(), longest);
+  CHECK_EQUAL(queueLatency(), 0);
+
+  // all knobs end at their last value
+  for (int knob = 0; knob < 8; knob++) {
+    uint16_t last = 0xFFFF;
+    for (size_t i = 0; i < sent.size(); i++)
+      if (sent[i].control == knob)
+        last = sent[i].value;
+    CHECK_EQUAL(last, (299 + knob) & 0x7F);
+  }
+}
+
+static void testIdle() {
+  begin();
+
+  // after a long pause the bucket holds no more than one burst
+  run(1000);
+  for (int knob = 0; knob < 10; knob++)
+    queueControl(0, knob, knob, 1);
+  queueUpdate();
+  CHECK_EQUAL(sent.size(), QUEUE_BURST);
+  CHECK_EQUAL(queueWaiting(), 10 - QUEUE_BURST);
+  run(8);
+  CHECK_EQUAL(sent.size(), 2 * QUEUE_BURST);
+  run(8);
+  CHECK_EQUAL(sent.size(), 10);
+  for (int i = 0; i < 10; i++)
+    CHECK_EQUAL(sent[i].control, i);
+}
+
+static void testFull() {
+  begin();
+
+  // the tokens are used up, the queue fills up
+  for (int k = 0; k < QUEUE_BURST; k++)
+    queueControl(0, 100 + k, 0, 1);
+  queueUpdate();
+  sent.clear();
+  for (int k = 0; k < QUEUE_SIZE; k++)
+    queueControl(0, k, k, 1);
+  CHECK_EQUAL(queueWaiting(), QUEUE_SIZE);
+  CHECK_EQUAL(sent.size(), 0);
+
+  // one more control sends the oldest entry to make space, nothing is lost
+  queueControl(1, 0, 99, 1);
+  CHECK_EQUAL(sent.size(), 1);
+  CHECK_EQUAL(sent[0].control, 0);
+  CHECK_EQUAL(queueWaiting(), QUEUE_SIZE);
+  run(100);
+  CHECK_EQUAL(sent.size(), QUEUE_SIZE + 1);
+  CHECK_EQUAL(sent.back().channel, 1);
+  CHECK_EQUAL(sent.back().value, 99);
+}
+
+static void testCost() {
+  begin();
+
+  // a 14-bit control change takes two messages and an NRPN four, they share the same bucket
+  queueControl(0, 1, 1000, 2);
+  queueControl(0, 2, 2000, 4);
+  queueControl(0, 3, 3000, 2);
+  queueUpdate();
+  CHECK_EQUAL(sent.size(), 1);
+  run(8);
+  CHECK_EQUAL(sent.size(), 2);
+  CHECK_EQUAL(sent[1].value, 2000);
+  run(8);
+  CHECK_EQUAL(sent.size(), 3);
+
+  // the order is kept, a cheap entry does not overtake an expensive one that waits for tokens
+  sent.clear();
+  queueControl(0, 4, 0, 3);
+  queueControl(0, 5, 0, 4);
+  queueControl(0, 6, 0, 1);
+  queueUpdate();
+  CHECK_EQUAL(sent.size(), 0);
+  run(8);
+  CHECK_EQUAL(sent.size(), 1);
+  run(8);
+  CHECK_EQUAL(sent.size(), 2);
+  run(8);
+  CHECK_EQUAL(sent.size(), 3);
+  CHECK_EQUAL(sent[2].control, 6);
+
+  // the cost is clamped to the size of the bucket, otherwise the entry would never be sent
+  sent.clear();
+  run(8);
+  queueControl(0, 7, 0, 10);
+  queueControl(0, 8, 0, 0);
+  queueUpdate();
+  CHECK_EQUAL(sent.size(), 1);
+  run(8);
+  CHECK_EQUAL(sent.size(), 2);
+  CHECK_EQUAL(queueWaiting(), 0);
+}
+
+int main() {
+  testCoalesce();
+  testRate();
+  testIdle();
+  testFull();
+  testCost();
+  return report("test_midiqueue");
+}
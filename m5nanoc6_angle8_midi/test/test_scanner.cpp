@@ -0,0 +1,143 @@
+// Host test of the scan task, with a model of the I2C registers of the 8Angle unit
+// that counts the transactions
+
+#include "check.h"
+#include "scanner.h"
+#include <Wire.h>
+
+uint32_t mockMicros = 0;
+TaskFunction_t mockTaskFunction = NULL;
+unsigned int mockTaskCycles = 0;
+MockWire Wire;
+
+#define ADDRESS 0x43
+
+// the pots are inverted, a reading of zero is at the end of the range
+static void pot(uint8_t channel, uint16_t reading) {
+  uint16_t raw = 4095 - reading;
+  Wire.reg[channel * 2] = raw & 0xFF;
+  Wire.reg[channel * 2 + 1] = raw >> 8;
+}
+
+static void testBegin() {
+  // a unit that does not respond is reported, the task is not started
+  Wire.nack = true;
+  CHECK(!scannerBegin(ADDRESS, 2, 1, 400000));
+  CHECK(mockTaskFunction == NULL);
+  Wire.nack = false;
+
+  // the averages are filled with the first scans, the snapshot is valid right away
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++)
+    pot(i, i * 500);
+  Wire.reg[0x20] = 1;
+  Wire.transactions = 0;
+  CHECK(scannerBegin(ADDRESS, 2, 1, 400000));
+  CHECK(mockTaskFunction != NULL);
+  CHECK_EQUAL(Wire.transactions, 1 + SCAN_AVERAGE * 2);
+
+  snapshot_t snapshot;
+  CHECK(scannerSnapshot(&snapshot));
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++)
+    CHECK_EQUAL(snapshot.value[i], i * 500);
+  CHECK(snapshot.sw);
+  CHECK(!scannerSnapshot(&snapshot));
+}
+
+static void testTransactions() {
+  // every scan reads all pots in one transaction and the switch in another
+  Wire.transactions = 0;
+  Wire.writes.clear();
+  mockTask(SCAN_RATE);
+  CHECK_EQUAL(Wire.transactions, 2 * SCAN_RATE);
+  CHECK_EQUAL(Wire.writes.size(), 0);
+
+  // the rate is updated once per second, it includes the initial scans
+  mockTask(1);
+  CHECK_CLOSE(scannerRate(), SCAN_RATE, SCAN_AVERAGE + 1);
+
+  // a scan takes place every 2 ms
+  snapshot_t first, second;
+  scannerSnapshot(&first);
+  mockTask(1);
+  CHECK(scannerSnapshot(&second));
+  CHECK_EQUAL(second.count, first.count + 1);
+  CHECK_EQUAL(second.time - first.time, 1000000 / SCAN_RATE);
+}
+
+static void testAverage() {
+  // a step of a pot is followed over the averaged scans
+  pot(3, 4000);
+  snapshot_t snapshot;
+  uint16_t previous = 1500;
+  for (int k = 1; k <= SCAN_AVERAGE; k++) {
+    mockTask(1);
+    CHECK(scannerSnapshot(&snapshot));
+    CHECK_EQUAL(snapshot.value[3], (1500 * (SCAN_AVERAGE - k) + 4000 * k) / SCAN_AVERAGE);
+    CHECK(snapshot.value[3] > previous);
+    previous = snapshot.value[3];
+  }
+  CHECK_EQUAL(snapshot.value[3], 4000);
+
+  // the full range is reached and the alternating noise of a pot is averaged out
+  for (int k = 0; k < 100; k++) {
+    pot(0, 0);
+    pot(7, 4095);
+    pot(5, 2000 + (k % 2 ? 3 : -3));
+    mockTask(1);
+    scannerSnapshot(&snapshot);
+    if (k >= SCAN_AVERAGE)
+      CHECK_EQUAL(snapshot.value[5], 2000);
+  }
+  CHECK_EQUAL(snapshot.value[0], 0);
+  CHECK_EQUAL(snapshot.value[7], 4095);
+
+  // a failed read leaves the snapshot as it is
+  Wire.nack = true;
+  mockTask(10);
+  CHECK(!scannerSnapshot(&snapshot));
+  Wire.nack = false;
+}
+
+static void testColor() {
+  // a color is written in the next cycle of the task, with the brightness after the RGB values
+  Wire.transactions = 0;
+  Wire.writes.clear();
+  scannerColor(2, 0x112233, 64);
+  scannerColor(8, 0x00FF00, 10);
+  mockTask(1);
+  CHECK_EQUAL(Wire.writes.size(), 2);
+  CHECK_EQUAL(Wire.transactions, 2 + 2);
+  CHECK_EQUAL(Wire.writes[0].reg, 0x30 + 2 * 4);
+  CHECK_EQUAL(Wire.writes[0].data.size(), 4);
+  CHECK_EQUAL(Wire.writes[0].data[0], 0x11);
+  CHECK_EQUAL(Wire.writes[0].data[2], 0x33);
+  CHECK_EQUAL(Wire.writes[0].data[3], 64);
+  CHECK_EQUAL(Wire.writes[1].reg, 0x30 + 8 * 4);
+
+  // the same color is not written again, also when it is set many times in between
+  Wire.writes.clear();
+  for (int k = 0; k < 100; k++) {
+    for (uint8_t led = 0; led < SCAN_LEDS; led++)
+      scannerColor(led, (led == 2 ? 0x112233 : 0), (led == 2 ? 64 : 0));
+    mockTask(1);
+  }
+  CHECK_EQUAL(Wire.writes.size(), SCAN_LEDS - 1);
+
+  // only the most recent of several changes between two cycles is written
+  Wire.writes.clear();
+  scannerColor(4, 0x0000FF, 1);
+  scannerColor(4, 0xFF0000, 1);
+  scannerColor(2, 0x112233, 128);
+  mockTask(1);
+  CHECK_EQUAL(Wire.writes.size(), 2);
+  CHECK_EQUAL(Wire.writes[0].reg, 0x30 + 2 * 4);
+  CHECK_EQUAL(Wire.writes[1].data[0], 0xFF);
+}
+
+int main() {
+  testBegin();
+  testTransactions();
+  testAverage();
+  testColor();
+  return report("test_scanner");
+}
@@ -0,0 +1,118 @@
+// Host test of the reduction of the 12-bit pot readings to 7 or 12 bits with hysteresis
+
+#include <stdlib.h>
+#include "check.h"
+#include "smoothing.h"
+
+uint32_t mockMicros = 0;
+
+// the number of changes and the last value while a channel is fed with the readings
+static int changes;
+static uint16_t value;
+
+static void feed(uint8_t channel, int reading) {
+  uint16_t v;
+  reading = constrain(reading, 0, 4095);
+  if (smoothingUpdate(channel, reading, &v)) {
+    changes++;
+    value = v;
+  }
+}
+
+static void testFirst() {
+  // the first reading always gives a value, also when it is zero
+  smoothingBegin(7);
+  uint16_t v = 0xFFFF;
+  CHECK(smoothingUpdate(0, 0, &v));
+  CHECK_EQUAL(v, 0);
+  CHECK(smoothingUpdate(1, 4095, &v));
+  CHECK_EQUAL(v, 127);
+  CHECK(!smoothingUpdate(1, 4095, &v));
+
+  // the output resolution is at most 12 bits
+  smoothingBegin(14);
+  CHECK(smoothingUpdate(0, 4095, &v));
+  CHECK_EQUAL(v, 4095);
+}
+
+static void testSweep(uint8_t bits, int noise) {
+  // a slow sweep up and down with noise on the reading covers the full range without going back
+  smoothingBegin(bits);
+  uint16_t top = (1 << bits) - 1;
+  changes = 0;
+  value = 0xFFFF;
+  feed(0, 0);
+  CHECK_EQUAL(value, 0);
+  uint16_t previous = value;
+  bool monotonic = true;
+  for (int k = 0; k <= 4095 + 2 * noise; k++) {
+    feed(0, k - noise + rand() % (2 * noise + 1));
+    monotonic = monotonic && value >= previous;
+    previous = value;
+  }
+  CHECK(monotonic);
+  CHECK_EQUAL(value, top);
+  int up = changes;
+  for (int k = 4095; k >= -2 * noise; k--) {
+    feed(0, k - noise + rand() % (2 * noise + 1));
+    monotonic = monotonic && value <= previous;
+    previous = value;
+  }
+  CHECK(monotonic);
+  CHECK_EQUAL(value, 0);
+  printf("%d bits with noise of %d: %d changes up, %d down\n", bits, noise, up, changes - up);
+
+  // at 7 bits every step is sent, at 12 bits the deadband skips some steps
+  if (bits == 7)
+    CHECK_EQUAL(up, top + 1);
+  else
+    CHECK(up >= 4096 / (2 * SMOOTHING_DEADBAND + 2));
+}
+
+// feed a reading with noise of the given amplitude and return the number of changes after it settled
+static int rest(uint8_t channel, int reading, int noise) {
+  for (int k = 0; k < 100; k++)
+    feed(channel, reading - noise + rand() % (2 * noise + 1));
+  changes = 0;
+  for (int k = 0; k < 10000; k++)
+    feed(channel, reading - noise + rand() % (2 * noise + 1));
+  return changes;
+}
+
+static void testEdge() {
+  // a pot that rests on the edge between two steps does not chatter
+  smoothingBegin(7);
+  CHECK_EQUAL(rest(2, 64 * 32, SMOOTHING_DEADBAND), 0);
+  smoothingBegin(12);
+  CHECK_EQUAL(rest(3, 2000, SMOOTHING_DEADBAND), 0);
+  CHECK_EQUAL(rest(3, 4093, SMOOTHING_DEADBAND), 0);
+
+  // a real move is followed right away
+  rest(3, 2000, 0);
+  changes = 0;
+  uint16_t previous = value;
+  feed(3, 2000 + 2 * SMOOTHING_DEADBAND + 2);
+  CHECK_EQUAL(changes, 1);
+  CHECK(value > previous);
+}
+
+static void testChannels() {
+  // the channels are independent
+  smoothingBegin(7);
+  for (uint8_t ch = 0; ch < SMOOTHING_CHANNELS; ch++) {
+    uint16_t v;
+    CHECK(smoothingUpdate(ch, ch * 512, &v));
+    CHECK_EQUAL(v, ch * 16);
+  }
+}
+
+int main() {
+  srand(1);
+  testFirst();
+  testSweep(7, 3);
+  testSweep(12, 3);
+  testSweep(12, SMOOTHING_DEADBAND);
+  testEdge();
+  testChannels();
+  return report("test_smoothing");
+}
@@ -6,9 +6,10 @@
 */
 
 #include <M5Unified.h>        // https://github.com/m5stack/M5Unified
-#include <UNIT_8ENCODER.h>    // https://github.com/m5stack/M5Unit-8Encoder
 #include <Control_Surface.h>  // https://github.com/tttapa/Control-Surface
 #include "colormap.h"
+#include "midiqueue.h"
+#include "scanner.h"
 
 // #define I2C_SDA G13 // for the M5Dial
 // #define I2C_SCL G15
@@ -16,42 +17,39 @@
 #define I2C_SCL 1
 #define I2C_ADDR 0x41
 #define I2C_SPEED 4000000L
-#define MIDI_DELAY 10  // do not send the MIDI messages too fast/frequent
 
 BluetoothMIDI_Interface midi;
-UNIT_8ENCODER encoder8;
 
 bool sw;
 int32_t value[8];
 bool button[8];
+uint32_t lastReport = 0;
 
 void updateSwitch(bool sw) {
   uint32_t rgb = 0x0000FF00 * sw;  // green or black
-  encoder8.setLEDColor(8, rgb);
+  scannerColor(8, rgb);
 }
 
 void updateValue(bool sw, uint8_t knob, int32_t value, bool button) {
   uint8_t rb = (r[value] / 4), gb = g[value] / 4, bb = b[value] / 4;  // reduce the brightness
   uint32_t rgb = (rb << 16) | (gb << 8) | (bb << 0);
-  encoder8.setLEDColor(knob, rgb);
-
-  // the switch allows selecting MIDI channel 1 or 2
-  if (sw == 0) {
-    MIDIAddress controller = { knob, Channel_1 };
-    midi.sendControlChange(controller, value);
-  } else {
-    MIDIAddress controller = { knob, Channel_2 };
-    midi.sendControlChange(controller, value);
-  }
+  scannerColor(knob, rgb);  // this is only written to the unit when it changes
+
+  // the switch allows selecting MIDI channel 1 or 2, the message is sent from the queue
+  queueControl(sw, knob, value, 1);
+}
+
+void sendControl(uint8_t channel, uint8_t control, uint16_t value, uint32_t latency) {
+  MIDIAddress controller = { control, Channel_1 + channel };
+  midi.sendControlChange(controller, value);
 
-  Serial.print(sw);
+  Serial.print(channel);
   Serial.print(" ");
-  Serial.print(knob);
+  Serial.print(control);
   Serial.print(" ");
   Serial.print(value);
   Serial.print(" ");
-  Serial.println(button);
-  delay(MIDI_DELAY);
+  Serial.println(latency);
 }
 
 void setup() {
@@ -60,55 +58,71 @@ void setup() {
   M5.begin();
 
   Serial.println("setup start");
-  while (!encoder8.begin(&Wire, I2C_ADDR, I2C_SDA, I2C_SCL, I2C_SPEED)) {
+  while (!scannerBegin(I2C_ADDR, I2C_SDA, I2C_SCL, I2C_SPEED)) {
     Serial.println("encoder8 connect error");
     delay(100);
   }
   Serial.println("encoder8 connect OK");
 
   Control_Surface.begin();
+  queueBegin(sendControl);
   esp_log_level_set("i2c.master", ESP_LOG_NONE);  // see https://github.com/espressif/arduino-esp32/issues/11787
 
-  sw = encoder8.getSwitchStatus();
+  snapshot_t snapshot;
+  scannerSnapshot(&snapshot);
+  sw = snapshot.sw;
   updateSwitch(sw);
 
   for (uint8_t knob = 0; knob < 8; knob++) {
     value[knob] = 0;
     button[knob] = false;
-    encoder8.setEncoderValue(knob, value[knob]);
+    scannerValue(knob, value[knob]);
     updateValue(sw, knob, value[knob], button[knob]);
   }
 
+  // discard the snapshots that were made before the scan task reset the encoder values
+  delay(4 * 1000 / SCAN_RATE);
+  scannerSnapshot(&snapshot);
+
   Serial.println("setup done");
 }
 
 void loop() {
   M5.update();
   Control_Surface.loop();
+  queueUpdate();
+
+  if (millis() - lastReport > 10000) {
+    Serial.print("scan rate ");
+    Serial.println(scannerRate());
+    lastReport = millis();
+  }
+
+  snapshot_t snapshot;
+  if (!scannerSnapshot(&snapshot))
+    return;
 
-  bool newsw = encoder8.getSwitchStatus();
-  if (newsw != sw) {
-    updateSwitch(newsw);
-    sw = newsw;
+  if (snapshot.sw != sw) {
+    updateSwitch(snapshot.sw);
+    sw = snapshot.sw;
   }
 
   for (uint8_t knob = 0; knob < 8; knob++) {
-    bool newbutton = !encoder8.getButtonStatus(knob);  // the pushbutton seems to be inverted
-    if (button[knob] != newbutton) {
-      button[knob] = newbutton;
+    if (button[knob] != snapshot.button[knob]) {
+      button[knob] = snapshot.button[knob];
       updateValue(sw, knob, value[knob], button[knob]);
     }
   }
 
   for (uint8_t knob = 0; knob < 8; knob++) {
-    int32_t newvalue = encoder8.getEncoderValue(knob);
+    int32_t newvalue = snapshot.value[knob];
     if (value[knob] != newvalue) {
       if (newvalue < 0) {
         newvalue = 0;
-        encoder8.setEncoderValue(knob, newvalue);
+        scannerValue(knob, newvalue);
       } else if (newvalue > 127) {
         newvalue = 127;
-        encoder8.setEncoderValue(knob, newvalue);
+        scannerValue(knob, newvalue);
       }
       value[knob] = newvalue;
       updateValue(sw, knob, value[knob], button[knob]);
@@ -0,0 +1,30 @@
+#ifndef _MIDIQUEUE_H_
+#define _MIDIQUEUE_H_
+
+#include <Arduino.h>
+
+/*
+  Control change messages are not sent right away but are queued. There is at most one
+  entry per channel and controller, a newer value replaces the value that is still
+  waiting, so that only the latest value of each control goes out.
+
+  The queue is drained by a token bucket that matches the BLE MIDI connection interval:
+  every interval a number of tokens is added and each entry that is sent takes as many
+  tokens as the number of MIDI messages that it puts on the wire, e.g. 2 for a 14-bit
+  control change or 4 for an NRPN. Entries are sent in the order in which the control
+  first changed.
+*/
+
+#define QUEUE_SIZE     32     // number of different controls that can be waiting at the same time
+#define QUEUE_INTERVAL 7500   // in microseconds, the BLE connection interval
+#define QUEUE_BURST    4      // number of messages that can be sent per connection interval
+
+typedef void (*queue_callback_t)(uint8_t channel, uint8_t control, uint16_t value, uint32_t latency);
+
+void queueBegin(queue_callback_t);
+void queueControl(uint8_t, uint8_t, uint16_t, uint8_t);
+void queueUpdate(void);
+unsigned int queueWaiting(void);
+uint32_t queueLatency(void);
+
+#endif // _MIDIQUEUE_H_
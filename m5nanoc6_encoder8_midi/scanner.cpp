@@ -0,0 +1,154 @@
+#include <Wire.h>
+#include "scanner.h"
+
+#define ENCODER_REG 0x00  // 8 x int32, little endian
+#define BUTTON_REG  0x50  // 8 x uint8
+#define SWITCH_REG  0x60  // uint8
+#define RGB_LED_REG 0x70  // 9 x RGB
+
+static uint8_t address;
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+static snapshot_t latest;
+static uint32_t consumed = 0;
+
+// these are shared with the scan task and protected by the mutex
+static uint32_t color[SCAN_LEDS];
+static int32_t setvalue[SCAN_CHANNELS];
+static uint16_t dirtyColor = 0, dirtyValue = 0;
+
+// these are only used by the scan task
+static uint32_t written[SCAN_LEDS];
+static uint32_t rateCount = 0, rateTime = 0;
+static unsigned int rate = 0;
+
+/***************************************************************************/
+
+static bool readRegister(uint8_t reg, uint8_t *buffer, uint8_t length) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  if (Wire.endTransmission(false) != 0)
+    return false;
+  if (Wire.requestFrom(address, length) != length)
+    return false;
+  for (uint8_t i = 0; i < length; i++)
+    buffer[i] = Wire.read();
+  return true;
+}
+
+static void writeRegister(uint8_t reg, const uint8_t *buffer, uint8_t length) {
+  Wire.beginTransmission(address);
+  Wire.write(reg);
+  Wire.write(buffer, length);
+  Wire.endTransmission();
+}
+
+static void flush() {
+  uint32_t newcolor[SCAN_LEDS];
+  int32_t newvalue[SCAN_CHANNELS];
+  uint16_t colors, values;
+
+  portENTER_CRITICAL(&mux);
+  colors = dirtyColor;
+  values = dirtyValue;
+  memcpy(newcolor, color, sizeof(color));
+  memcpy(newvalue, setvalue, sizeof(setvalue));
+  dirtyColor = dirtyValue = 0;
+  portEXIT_CRITICAL(&mux);
+
+  for (uint8_t i = 0; i < SCAN_LEDS; i++) {
+    if ((colors & (1 << i)) && newcolor[i] != written[i]) {
+      uint8_t rgb[3] = { (uint8_t)(newcolor[i] >> 16), (uint8_t)(newcolor[i] >> 8), (uint8_t)(newcolor[i]) };
+      writeRegister(RGB_LED_REG + i * 3, rgb, 3);
+      written[i] = newcolor[i];
+    }
+  }
+
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++) {
+    if (values & (1 << i)) {
+      uint8_t data[4] = { (uint8_t)(newvalue[i]), (uint8_t)(newvalue[i] >> 8), (uint8_t)(newvalue[i] >> 16), (uint8_t)(newvalue[i] >> 24) };
+      writeRegister(ENCODER_REG + i * 4, data, 4);
+    }
+  }
+}
+
+static void scan() {
+  uint8_t encoders[SCAN_CHANNELS * 4], buttons[SCAN_CHANNELS], sw;
+  if (!readRegister(ENCODER_REG, encoders, sizeof(encoders)) || !readRegister(BUTTON_REG, buttons, sizeof(buttons)) || !readRegister(SWITCH_REG, &sw, 1))
+    return;
+
+  snapshot_t snapshot;
+  snapshot.time = micros();
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++) {
+    snapshot.value[i] = (int32_t)(encoders[i * 4] | (encoders[i * 4 + 1] << 8) | (encoders[i * 4 + 2] << 16) | ((uint32_t)encoders[i * 4 + 3] << 24));
+    snapshot.button[i] = !buttons[i];  // the pushbutton is inverted
+  }
+  snapshot.sw = sw;
+
+  portENTER_CRITICAL(&mux);
+  snapshot.count = latest.count + 1;
+  latest = snapshot;
+  portEXIT_CRITICAL(&mux);
+
+  rateCount++;
+  if (snapshot.time - rateTime >= 1000000UL) {
+    rate = rateCount;
+    rateCount = 0;
+    rateTime = snapshot.time;
+  }
+}
+
+static void scanTask(void *) {
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    flush();
+    scan();
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(1000 / SCAN_RATE));
+  }
+}
+
+/***************************************************************************/
+
+bool scannerBegin(uint8_t addr, int sda, int scl, uint32_t speed) {
+  address = addr;
+  Wire.begin(sda, scl, speed);
+  Wire.beginTransmission(address);
+  if (Wire.endTransmission() != 0)
+    return false;
+
+  // the first snapshot is made before the task starts, so that it is valid right away
+  memset(&latest, 0, sizeof(latest));
+  memset(written, 0xFF, sizeof(written));
+  scan();
+  xTaskCreate(scanTask, "scan", 4096, NULL, 2, NULL);
+  return true;
+}
+
+bool scannerSnapshot(snapshot_t *snapshot) {
+  // this returns true if there is a new snapshot since the previous call
+  portENTER_CRITICAL(&mux);
+  *snapshot = latest;
+  portEXIT_CRITICAL(&mux);
+  bool fresh = (snapshot->count != consumed);
+  consumed = snapshot->count;
+  return fresh;
+}
+
+void scannerColor(uint8_t led, uint32_t rgb) {
+  portENTER_CRITICAL(&mux);
+  color[led] = rgb;
+  dirtyColor |= (1 << led);
+  portEXIT_CRITICAL(&mux);
+}
+
+void scannerValue(uint8_t channel, int32_t value) {
+  portENTER_CRITICAL(&mux);
+  setvalue[channel] = value;
+  dirtyValue |= (1 << channel);
+  portEXIT_CRITICAL(&mux);
+}
+
+unsigned int scannerRate() {
+  // the number of scans in the most recent second
+  return rate;
+}
@@ -0,0 +1,33 @@
+#ifndef _SCANNER_H_
+#define _SCANNER_H_
+
+#include <Arduino.h>
+
+/*
+  The 8Encoder unit is scanned by a separate task at a fixed rate. Each register block
+  (encoders, buttons and switch) is read with a single I2C transaction, rather than with
+  one transaction per channel. The result is published as a timestamped snapshot.
+
+  All I2C communication takes place in the scan task. The LED colors and encoder values
+  are written by the task before the next scan, and only when they have changed.
+*/
+
+#define SCAN_RATE     500   // in Hz
+#define SCAN_CHANNELS 8
+#define SCAN_LEDS     9     // the ninth LED is next to the switch
+
+typedef struct {
+  uint32_t time;           // in microseconds, when the scan was done
+  uint32_t count;          // incremented on every scan
+  int32_t value[SCAN_CHANNELS];
+  bool button[SCAN_CHANNELS];
+  bool sw;
+} snapshot_t;
+
+bool scannerBegin(uint8_t, int, int, uint32_t);
+bool scannerSnapshot(snapshot_t *);
+void scannerColor(uint8_t, uint32_t);
+void scannerValue(uint8_t, int32_t);
+unsigned int scannerRate(void);
+
+#endif // _SCANNER_H_
@@ -0,0 +1,78 @@
+#ifndef _WIRE_H_
+#define _WIRE_H_
+
+// This replaces the I2C library with a model of the registers of the M5 unit. Every
+// beginTransmission starts a transaction; the register pointer is set by the first byte
+// that is written, the following bytes are written to the registers and also logged.
+
+#include <vector>
+#include <Arduino.h>
+
+struct MockWrite {
+  uint8_t reg;
+  std::vector<uint8_t> data;
+};
+
+class MockWire {
+ public:
+  uint8_t reg[256];
+  bool nack;                          // the unit does not respond
+  unsigned int transactions;
+  std::vector<MockWrite> writes;
+
+  MockWire() : nack(false), transactions(0), pointer(0), rx(0) {
+    memset(reg, 0, sizeof(reg));
+  }
+
+  bool begin(int, int, uint32_t) {
+    return true;
+  }
+
+  void beginTransmission(uint8_t) {
+    transactions++;
+    tx.clear();
+  }
+
+  size_t write(uint8_t value) {
+    tx.push_back(value);
+    return 1;
+  }
+
+  size_t write(const uint8_t *buffer, size_t length) {
+    tx.insert(tx.end(), buffer, buffer + length);
+    return length;
+  }
+
+  uint8_t endTransmission(bool stop = true) {
+    if (nack)
+      return 2;
+    if (tx.size() > 0)
+      pointer = tx[0];
+    if (tx.size() > 1) {
+      MockWrite w = {pointer, std::vector<uint8_t>(tx.begin() + 1, tx.end())};
+      writes.push_back(w);
+      for (size_t i = 1; i < tx.size(); i++)
+        reg[(uint8_t)(pointer + i - 1)] = tx[i];
+    }
+    return 0;
+  }
+
+  uint8_t requestFrom(uint8_t, uint8_t length) {
+    if (nack)
+      return 0;
+    rx = pointer;
+    return length;
+  }
+
+  int read() {
+    return reg[rx++];
+  }
+
+ private:
+  uint8_t pointer, rx;
+  std::vector<uint8_t> tx;
+};
+
+extern MockWire Wire;
+
+#endif // _WIRE_H_
@@ -0,0 +1,110 @@
+// Host test of the scan task, with a model of the I2C registers of the 8Encoder unit
+// that counts the transactions
+
+#include "check.h"
+#include "scanner.h"
+#include <Wire.h>
+
+uint32_t mockMicros = 0;
+TaskFunction_t mockTaskFunction = NULL;
+unsigned int mockTaskCycles = 0;
+MockWire Wire;
+
+#define ADDRESS 0x41
+
+static void encoder(uint8_t channel, int32_t value) {
+  for (int k = 0; k < 4; k++)
+    Wire.reg[channel * 4 + k] = ((uint32_t)value >> (8 * k)) & 0xFF;
+}
+
+static void testBegin() {
+  Wire.nack = true;
+  CHECK(!scannerBegin(ADDRESS, 2, 1, 400000));
+  CHECK(mockTaskFunction == NULL);
+  Wire.nack = false;
+
+  // the buttons are inverted, a register value of zero means pressed
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++) {
+    encoder(i, i * 1000 - 3000);
+    Wire.reg[0x50 + i] = (i == 5 ? 0 : 1);
+  }
+  Wire.reg[0x60] = 1;
+  Wire.transactions = 0;
+  CHECK(scannerBegin(ADDRESS, 2, 1, 400000));
+  CHECK(mockTaskFunction != NULL);
+  CHECK_EQUAL(Wire.transactions, 1 + 3);
+
+  snapshot_t snapshot;
+  CHECK(scannerSnapshot(&snapshot));
+  for (uint8_t i = 0; i < SCAN_CHANNELS; i++) {
+    CHECK_EQUAL(snapshot.value[i], i * 1000 - 3000);
+    CHECK_EQUAL(snapshot.button[i], i == 5);
+  }
+  CHECK(snapshot.sw);
+  CHECK(!scannerSnapshot(&snapshot));
+}
+
+static void testTransactions() {
+  // every scan reads the encoders, the buttons and the switch, each in one transaction
+  Wire.transactions = 0;
+  Wire.writes.clear();
+  mockTask(SCAN_RATE);
+  CHECK_EQUAL(Wire.transactions, 3 * SCAN_RATE);
+  CHECK_EQUAL(Wire.writes.size(), 0);
+  mockTask(1);
+  CHECK_CLOSE(scannerRate(), SCAN_RATE, 2);
+
+  snapshot_t first, second;
+  scannerSnapshot(&first);
+  encoder(2, 123456);
+  mockTask(1);
+  CHECK(scannerSnapshot(&second));
+  CHECK_EQUAL(second.count, first.count + 1);
+  CHECK_EQUAL(second.time - first.time, 1000000 / SCAN_RATE);
+  CHECK_EQUAL(second.value[2], 123456);
+
+  // a failed read leaves the snapshot as it is
+  Wire.nack = true;
+  mockTask(10);
+  CHECK(!scannerSnapshot(&second));
+  Wire.nack = false;
+}
+
+static void testWrite() {
+  // a color is written as three bytes in the next cycle of the task
+  Wire.writes.clear();
+  Wire.transactions = 0;
+  scannerColor(1, 0x445566);
+  mockTask(1);
+  CHECK_EQUAL(Wire.writes.size(), 1);
+  CHECK_EQUAL(Wire.transactions, 1 + 3);
+  CHECK_EQUAL(Wire.writes[0].reg, 0x70 + 1 * 3);
+  CHECK_EQUAL(Wire.writes[0].data.size(), 3);
+  CHECK_EQUAL(Wire.writes[0].data[0], 0x44);
+  CHECK_EQUAL(Wire.writes[0].data[2], 0x66);
+
+  // the same color is not written again
+  Wire.writes.clear();
+  for (int k = 0; k < 100; k++) {
+    scannerColor(1, 0x445566);
+    mockTask(1);
+  }
+  CHECK_EQUAL(Wire.writes.size(), 0);
+
+  // an encoder value is written to the unit and read back in the same cycle
+  encoder(6, 5);
+  scannerValue(6, -70000);
+  mockTask(1);
+  CHECK_EQUAL(Wire.writes.size(), 1);
+  CHECK_EQUAL(Wire.writes[0].reg, 6 * 4);
+  snapshot_t snapshot;
+  scannerSnapshot(&snapshot);
+  CHECK_EQUAL(snapshot.value[6], -70000);
+}
+
+int main() {
+  testBegin();
+  testTransactions();
+  testWrite();
+  return report("test_scanner");
+}
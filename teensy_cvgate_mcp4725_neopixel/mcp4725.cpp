@@ -0,0 +1,32 @@
+#include <Wire.h>
+#include "mcp4725.h"
+
+void mcp4725Begin(mcp4725_t *dac, uint8_t address) {
+  dac->address = address;
+  dac->written = -1;
+}
+
+bool mcp4725Update(mcp4725_t *dac, uint16_t value) {
+  // returns true if the DAC holds the value, either already or after writing it
+  if (value == dac->written)
+    return true;
+  // after a failed write it is not known what the DAC holds
+  bool ok = mcp4725Write(dac->address, MCP4726_CMD_FASTWRITE, value);
+  dac->written = (ok ? value : -1);
+  return ok;
+}
+
+bool mcp4725Write(uint8_t address, uint8_t cmd, uint16_t value) {
+  Wire.beginTransmission(address);
+  if (cmd == MCP4726_CMD_FASTWRITE) {
+    Wire.write(cmd | ((value >> 8) & 0x0F));  // the 4 most significant bits...
+    Wire.write(value & 0xFF);                 // the 8 least significant bits...
+  }
+  else {
+    Wire.write(cmd);                          // cmd to update the DAC
+    Wire.write((value >> 4) & 0xFF);          // the 8 most significant bits...
+    Wire.write((value & 0x0F) << 4);          // the 4 least significant bits...
+  }
+  // this returns zero if the DAC acknowledged all bytes
+  return Wire.endTransmission() == 0;
+}
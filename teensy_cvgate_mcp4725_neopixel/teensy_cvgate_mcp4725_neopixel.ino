@@ -8,6 +8,9 @@
 *   *c1v1024#  control 1 voltage 5*1024/4095 = 1.25 V
 *   *g1v1#     gate 1 value ON
 *
+* Besides these ASCII commands, it accepts binary frames that update
+* both control voltages and gates at once, see protocol.h
+*
 * This work is licensed under a Creative Commons Attribution-ShareAlike 4.0 International License.
 * See http://creativecommons.org/licenses/by-sa/4.0/
 *
@@ -18,6 +21,8 @@
 #include <Adafruit_NeoPixel.h>
 
 #include "colormap.h"
+#include "protocol.h"
+#include "mcp4725.h"
 
 #define NEOPIXEL_PIN 14
 #define GATE1_PIN    15
@@ -31,20 +36,13 @@
 #define address1 0x60
 #define address2 0x61
 
-#define MCP4726_CMD_WRITEDAC            (0x40)  // Writes data to the DAC
-#define MCP4726_CMD_WRITEDACEEPROM      (0x60)  // Writes data to the DAC and the EEPROM (persisting the assigned value after reset)
+// the MCP4725 supports fast mode, the high-speed mode requires a master code that the Wire library does not send
+#define WIRE_CLOCK   400000
 
 // the values of the DAC range from 0 to 4095 (12 bits)
 #define MAXVALUE  4095.
 
-// these are used to interpret the commands over the serial interface
-#define NONE      0
-#define VOLTAGE   1
-#define GATE      2
-
-// this is the status after parsing the commands over the serial interface
-#define OK       0
-#define ERROR   -1
+#define NUMCHANNEL 2
 
 #define NUMPIXELS 4
 #define BRIGHTNESS 0.3
@@ -55,6 +53,13 @@ Adafruit_NeoPixel pixels(NUMPIXELS, NEOPIXEL_PIN, NEO_GRB + NEO_KHZ800);
 int voltage1 = 0, voltage2 = 0;
 int gate1 = 0, gate2 = 0;
 
+// these remember the values that the DACs hold and that are shown on the Neopixels
+mcp4725_t dac1, dac2;
+int shown[NUMPIXELS] = {-1, -1, -1, -1};
+
+parser_t parser;
+command_t command;
+
 void setColor(int led, float value) {
   byte r, g, b;
   int index = value*255.;
@@ -63,20 +68,25 @@ void setColor(int led, float value) {
   g = 255*G[index]*BRIGHTNESS;
   b = 255*B[index]*BRIGHTNESS;
   pixels.setPixelColor(led, pixels.Color(r, g, b));
-  pixels.show();
   return;
 }
 
-void setValue(uint16_t address, uint16_t value) {
-  uint8_t msb, lsb;
-  msb = (value / 16);
-  lsb = (value % 16) << 4;
-  Wire.beginTransmission(address);
-  Wire.write(MCP4726_CMD_WRITEDAC);   // cmd to update the DAC
-  Wire.write(msb);                    // the 8 most significant bits...
-  Wire.write(lsb);                    // the 4 least significant bits...
-  Wire.endTransmission();
-  return;
+byte applyCommand(const command_t *command) {
+  if (command->type != FRAME_SET)
+    return STATUS_ERROR;
+  // update the internal state of all output channels
+  if (command->cvmask & 0x01)
+    voltage1 = command->cv[0];
+  if (command->cvmask & 0x02)
+    voltage2 = command->cv[1];
+  if (command->gatemask & 0x01)
+    gate1 = (command->gates & 0x01) != 0;
+  if (command->gatemask & 0x02)
+    gate2 = (command->gates & 0x02) != 0;
+  // it is an error to address a channel that does not exist
+  if ((command->cvmask >> NUMCHANNEL) || (command->gatemask >> NUMCHANNEL))
+    return STATUS_ERROR;
+  return STATUS_OK;
 }
 
 void setup() {
@@ -88,11 +98,13 @@ void setup() {
   Serial.print(" / ");
   Serial.print(__TIME__);
   Serial.println("]");
-  Serial.setTimeout(1000);
 
   Wire.begin();
   Wire.setSDA(WIRE_SDAPIN);
   Wire.setSCL(WIRE_SCLPIN);
+  Wire.setClock(WIRE_CLOCK);
+  mcp4725Begin(&dac1, address1);
+  mcp4725Begin(&dac2, address2);
 
   // initialize the gate pins as output:
   pinMode(GATE1_PIN, OUTPUT);
@@ -119,106 +131,63 @@ void setup() {
   pixels.show();
   delay(250);
 
+  protocolReset(&parser);
+
   Serial.println("Setup done.");
   return;
 }
 
 void loop() {
-  byte b, channel = 0, command = NONE, status = OK;
-  int value = 0;
-
-  if (Serial.available()) {
-
-    // parse the input over the serial connection
-    b = Serial.read();
-    if (b == '*') {
-      Serial.readBytes(&b, 1);
-      if (b == 'c') {
-        command = VOLTAGE;
-        value = 0;
-        Serial.readBytes(&b, 1); channel = b - 48; // character '1' is ascii value 49
-        Serial.readBytes(&b, 1); // 'v'
-        Serial.readBytes(&b, 1); value  = (b - 48) * 1000;
-        Serial.readBytes(&b, 1); value += (b - 48) * 100;
-        Serial.readBytes(&b, 1); value += (b - 48) * 10;
-        Serial.readBytes(&b, 1); value += (b - 48) * 1;
-        Serial.readBytes(&b, 1); command = (b == '#' ? command : NONE);
-      }
-      else if (b == 'g') {
-        command = GATE;
-        Serial.readBytes(&b, 1); channel = b - 48; // character '1' is ascii value 49
-        Serial.readBytes(&b, 1); // 'v'
-        Serial.readBytes(&b, 1); value  = (b == '1');
-        Serial.readBytes(&b, 1); command = (b == '#' ? command : NONE);
-      }
-      else {
-        command = NONE;
-      }
-    }
-    else {
-      command = NONE;
+  byte buf[8], status;
+  int result;
+
+  // parse the input over the serial connection, this does not wait for incomplete commands
+  while (Serial.available()) {
+    result = protocolParse(&parser, Serial.read(), &command);
+    if (result == PARSE_ASCII) {
+      status = applyCommand(&command);
+      Serial.println(status == STATUS_OK ? "OK" : "error");
     }
-
-    // update the internal state of all output channels
-    if (command == VOLTAGE) {
-      switch (channel) {
-        case 1:
-          voltage1 = (value > MAXVALUE ? MAXVALUE : value);
-          status = OK;
-          break;
-        case 2:
-          voltage2 = (value > MAXVALUE ? MAXVALUE : value);
-          status = OK;
-          break;
-        default:
-          status = ERROR;
-      }
-
-    }
-    else if (command == GATE) {
-      switch (channel) {
-        case 1:
-          gate1 = (value != 0);
-          status = OK;
-          break;
-        case 2:
-          gate2 = (value != 0);
-          status = OK;
-          break;
-        default:
-          status = ERROR;
-      }
-    }
-    else {
-      status = ERROR;
+    else if (result == PARSE_FRAME) {
+      status = applyCommand(&command);
+      if (command.ack)
+        Serial.write(buf, protocolAck(buf, command.type, status));
     }
-    if (status == OK)
-      Serial.println("OK");
-    else if (status == ERROR)
+    else if (result == PARSE_ERROR) {
       Serial.println("error");
-  }
-  else {
-    // update the output cointrol voltages and gates
-      setValue(address1, voltage1);
-      setValue(address2, voltage2);
-      digitalWrite(GATE1_PIN, gate1);
-      digitalWrite(GATE2_PIN, gate2);
-
-    // update the Neopixels by mapping a value between 0 and 1 onto the colormap
-    // note that they are mounted in the opposite order than the 3.5 mm jacks
-
-    if (!Serial) {
-      // switch all pixels off when there is no serial connection
-      pixels.clear(); 
-      pixels.show(); 
     }
-    else {
-      // the integer representation of the control voltage is represented between 0 and 4095
-      setColor(3, voltage1/MAXVALUE);
-      setColor(2, voltage2/MAXVALUE); 
-      // the integer representation of the gate voltage is either 0 or 1
-      setColor(1, gate1); 
-      setColor(0, gate2); 
+  }
+
+  // update the output control voltages, only the DACs whose value changed are written
+  mcp4725Update(&dac1, voltage1);
+  mcp4725Update(&dac2, voltage2);
+  digitalWrite(GATE1_PIN, gate1);
+  digitalWrite(GATE2_PIN, gate2);
+
+  // update the Neopixels by mapping a value between 0 and 1 onto the colormap
+  // note that they are mounted in the opposite order than the 3.5 mm jacks
+  // the pixels are only updated when something changed, since that takes more time than the DACs
+
+  if (!Serial) {
+    // switch all pixels off when there is no serial connection
+    if (shown[0] >= 0) {
+      pixels.clear();
+      pixels.show();
+      for (int i = 0; i < NUMPIXELS; i++)
+        shown[i] = -1;
     }
   }
+  else if (shown[3] != voltage1 || shown[2] != voltage2 || shown[1] != gate1 || shown[0] != gate2) {
+    // the integer representation of the control voltage is represented between 0 and 4095
+    setColor(3, voltage1/MAXVALUE);
+    setColor(2, voltage2/MAXVALUE);
+    // the integer representation of the gate voltage is either 0 or 1
+    setColor(1, gate1);
+    setColor(0, gate2);
+    pixels.show();
+    shown[3] = voltage1;
+    shown[2] = voltage2;
+    shown[1] = gate1;
+    shown[0] = gate2;
+  }
 } //main
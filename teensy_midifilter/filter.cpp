@@ -0,0 +1,224 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "filter.h"
+
+static rule_t rule[FILTER_MAXRULES];
+static unsigned int nrule = 0;
+
+// these are the lookup tables, the channels are indexed from 0 to 15
+static uint16_t blocked[32];            // bit N is set if the message type is blocked on channel N+1
+static uint8_t channelMap[16];
+static uint8_t noteMap[16][128];        // FILTER_DROP if the note falls outside the MIDI range
+static uint8_t noteChannel[16][128];
+static uint8_t velocityMap[16][128];
+static uint8_t ccNumber[16][128];
+static uint8_t ccMin[16][128];
+static uint8_t ccMax[16][128];
+
+static const char *name[] = {"none", "block", "channel", "split", "transpose", "velocity", "cc"};
+
+/***************************************************************************/
+
+static uint8_t typeIndex(uint8_t status) {
+  // channel messages are between 0x80 and 0xEF, system messages between 0xF0 and 0xFF
+  return (status < 0xF0 ? (status >> 4) : 16 + (status & 0x0F));
+}
+
+static uint16_t channelMask(uint8_t channel) {
+  return (channel == 0 ? 0xFFFF : (1 << (channel - 1)));
+}
+
+static uint8_t clip(int value) {
+  return (value < 0 ? 0 : (value > 127 ? 127 : value));
+}
+
+static uint8_t curve(uint8_t type, uint8_t min, uint8_t max, uint8_t velocity) {
+  float x = velocity / 127.;
+  switch (type) {
+    case CURVE_SOFT:
+      x = sqrtf(x);
+      break;
+    case CURVE_HARD:
+      x = x * x;
+      break;
+    case CURVE_FIXED:
+      x = 1;
+      break;
+  }
+  return clip(min + (max - min) * x + 0.5);
+}
+
+/***************************************************************************/
+
+void filterClear() {
+  nrule = 0;
+  filterCompile();
+}
+
+static bool valid(const rule_t *r) {
+  // the tables are indexed with the notes and channels, hence these must be within range
+  switch (r->type) {
+    case RULE_BLOCK:
+      return (r->a >= 0x80 && r->a <= 0xFF);
+    case RULE_CHANNEL:
+      return (r->a >= 1 && r->a <= 16);
+    case RULE_SPLIT:
+      return (r->a >= 0 && r->a <= r->b && r->b <= 127 && r->c >= 1 && r->c <= 16);
+    case RULE_TRANSPOSE:
+      return (r->a >= 0 && r->a <= r->b && r->b <= 127);
+    case RULE_VELOCITY:
+      return (r->a >= CURVE_LINEAR && r->a <= CURVE_FIXED);
+    case RULE_CC:
+      return (r->a >= 0 && r->a <= 127 && r->b >= 0 && r->b <= 127);
+  }
+  return false;
+}
+
+bool filterAdd(const rule_t *r) {
+  if (nrule == FILTER_MAXRULES || r->channel > 16 || !valid(r))
+    return false;
+  rule[nrule++] = *r;
+  return true;
+}
+
+unsigned int filterCount() {
+  return nrule;
+}
+
+const rule_t *filterRule(unsigned int i) {
+  return (i < nrule ? &rule[i] : NULL);
+}
+
+void filterCompile() {
+  // start with tables that pass all messages unchanged
+  memset(blocked, 0, sizeof(blocked));
+  for (uint8_t ch = 0; ch < 16; ch++) {
+    channelMap[ch] = ch;
+    for (uint8_t i = 0; i < 128; i++) {
+      noteMap[ch][i] = i;
+      noteChannel[ch][i] = ch;
+      velocityMap[ch][i] = i;
+      ccNumber[ch][i] = i;
+      ccMin[ch][i] = 0;
+      ccMax[ch][i] = 127;
+    }
+  }
+
+  for (unsigned int k = 0; k < nrule; k++) {
+    const rule_t *r = &rule[k];
+    uint16_t mask = channelMask(r->channel);
+    for (uint8_t ch = 0; ch < 16; ch++) {
+      if (!(mask & (1 << ch)))
+        continue;
+      switch (r->type) {
+        case RULE_BLOCK:
+          blocked[typeIndex(r->a)] |= (1 << ch);
+          break;
+        case RULE_CHANNEL:
+          channelMap[ch] = r->a - 1;
+          for (uint8_t i = 0; i < 128; i++)
+            noteChannel[ch][i] = channelMap[ch];
+          break;
+        case RULE_SPLIT:
+          for (int i = r->a; i <= r->b; i++)
+            noteChannel[ch][i] = r->c - 1;
+          break;
+        case RULE_TRANSPOSE:
+          for (int i = r->a; i <= r->b; i++)
+            if (noteMap[ch][i] != FILTER_DROP)
+              noteMap[ch][i] = (noteMap[ch][i] + r->c < 0 || noteMap[ch][i] + r->c > 127 ? FILTER_DROP : noteMap[ch][i] + r->c);
+          break;
+        case RULE_VELOCITY:
+          // a note-on with velocity zero is a note-off, that should not change
+          for (uint8_t i = 1; i < 128; i++)
+            velocityMap[ch][i] = curve(r->a, r->b, r->c, i);
+          break;
+        case RULE_CC:
+          ccNumber[ch][r->a] = r->b;
+          ccMin[ch][r->a] = clip(r->c);
+          ccMax[ch][r->a] = clip(r->d);
+          break;
+      }
+    }
+  }
+}
+
+/***************************************************************************/
+
+int filterSysEx(const uint8_t *data, unsigned int size) {
+  // the message is F0 7D 52 followed by 6 bytes per rule and F7
+  // the message types are encoded as status-128, the transpositions as semitones+64
+  // this returns the number of rules, or -1 if the message is not for the filter
+  if (size < 4 || data[0] != 0xF0 || data[1] != FILTER_SYSEX_ID || data[2] != FILTER_SYSEX_SUB || data[size - 1] != 0xF7)
+    return -1;
+  if ((size - 4) % 6)
+    return -1;
+  nrule = 0;
+  for (const uint8_t *p = data + 3; p < data + size - 1; p += 6) {
+    rule_t r = {p[0], p[1], p[2], p[3], p[4], p[5]};
+    if (r.type == RULE_BLOCK)
+      r.a += 128;
+    else if (r.type == RULE_TRANSPOSE)
+      r.c -= 64;
+    filterAdd(&r);
+  }
+  filterCompile();
+  return nrule;
+}
+
+bool filterParse(const char *line, rule_t *r) {
+  // the line contains the name of the rule, the channel and up to four numbers
+  char word[16];
+  int value[5] = {0, 0, 0, 0, 0};
+  int n = sscanf(line, "%15s %d %d %d %d %d", word, &value[0], &value[1], &value[2], &value[3], &value[4]);
+  if (n < 2)
+    return false;
+  memset(r, 0, sizeof(rule_t));
+  for (uint8_t i = 1; i < sizeof(name) / sizeof(name[0]); i++)
+    if (strcmp(word, name[i]) == 0)
+      r->type = i;
+  r->channel = value[0];
+  r->a = value[1];
+  r->b = value[2];
+  r->c = value[3];
+  r->d = value[4];
+  return (r->type != RULE_NONE && value[0] >= 0 && value[0] <= 16);
+}
+
+void filterFormat(const rule_t *r, char *str, unsigned int len) {
+  snprintf(str, len, "%s %d %d %d %d %d", name[r->type < RULE_CC + 1 ? r->type : 0], r->channel, r->a, r->b, r->c, r->d);
+}
+
+/***************************************************************************/
+
+bool filterBlocked(uint8_t status, uint8_t channel) {
+  // the channel is between 1 and 16, it is ignored for system messages
+  return blocked[typeIndex(status)] & (status < 0xF0 ? (1 << ((channel - 1) & 0x0F)) : 0xFFFF);
+}
+
+bool filterNote(uint8_t *channel, uint8_t *note, uint8_t *velocity, bool on) {
+  // this applies to note-on, note-off and polyphonic aftertouch and returns false if the note is dropped
+  uint8_t ch = (*channel - 1) & 0x0F, n = *note & 0x7F;
+  if (noteMap[ch][n] == FILTER_DROP)
+    return false;
+  *channel = noteChannel[ch][n] + 1;
+  *note = noteMap[ch][n];
+  if (on)
+    *velocity = velocityMap[ch][*velocity & 0x7F];
+  return true;
+}
+
+void filterControl(uint8_t *channel, uint8_t *number, uint8_t *value) {
+  uint8_t ch = (*channel - 1) & 0x0F, n = *number & 0x7F;
+  *channel = channelMap[ch] + 1;
+  *number = ccNumber[ch][n];
+  // the range is negative if the scale is inverted, the rounding should then also be towards the minimum
+  int range = ccMax[ch][n] - ccMin[ch][n];
+  *value = ccMin[ch][n] + (range * (*value & 0x7F) + (range < 0 ? -63 : 63)) / 127;
+}
+
+void filterChannel(uint8_t *channel) {
+  *channel = channelMap[(*channel - 1) & 0x0F] + 1;
+}
@@ -0,0 +1,67 @@
+#ifndef _FILTER_H_
+#define _FILTER_H_
+
+#include <stdint.h>
+
+/*
+  The MIDI filter is configured with a list of rules. The rules are compiled into
+  lookup tables, so that each message is processed with a few table lookups that do
+  not depend on the number of rules. Later rules are applied on top of earlier ones.
+
+  Channels are numbered from 1 to 16, channel 0 means that the rule applies to all.
+
+    RULE_BLOCK      a=status    block all messages with this status, e.g. 144 for note-on or 248 for clock
+    RULE_CHANNEL    a=channel   send the messages of this channel to another channel
+    RULE_SPLIT      a=low, b=high, c=channel    send the notes in this range to another channel
+    RULE_TRANSPOSE  a=low, b=high, c=semitones  transpose the notes in this range, between -64 and 63
+    RULE_VELOCITY   a=curve, b=min, c=max       map the note velocity onto a curve between min and max
+    RULE_CC         a=number, b=number, c=min, d=max  renumber a control change and scale its value
+
+  The velocity curve is CURVE_LINEAR, CURVE_SOFT, CURVE_HARD or CURVE_FIXED. A fixed
+  curve always returns the maximum.
+
+  A rule with a value outside its range, such as a note outside 0-127 or a channel
+  outside 1-16, is rejected by filterAdd.
+*/
+
+#define RULE_NONE       0
+#define RULE_BLOCK      1
+#define RULE_CHANNEL    2
+#define RULE_SPLIT      3
+#define RULE_TRANSPOSE  4
+#define RULE_VELOCITY   5
+#define RULE_CC         6
+
+#define CURVE_LINEAR    0
+#define CURVE_SOFT      1
+#define CURVE_HARD      2
+#define CURVE_FIXED     3
+
+#define FILTER_MAXRULES 32
+#define FILTER_DROP     0xFF
+
+// the rules can be sent as a SysEx message with the ID for non-commercial use
+#define FILTER_SYSEX_ID  0x7D
+#define FILTER_SYSEX_SUB 0x52   // 'R'
+
+typedef struct {
+  uint8_t type;
+  uint8_t channel;
+  int16_t a, b, c, d;
+} rule_t;
+
+void filterClear(void);
+bool filterAdd(const rule_t *);
+unsigned int filterCount(void);
+const rule_t *filterRule(unsigned int);
+void filterCompile(void);
+int filterSysEx(const uint8_t *, unsigned int);
+bool filterParse(const char *, rule_t *);
+void filterFormat(const rule_t *, char *, unsigned int);
+
+bool filterBlocked(uint8_t, uint8_t);
+bool filterNote(uint8_t *, uint8_t *, uint8_t *, bool);
+void filterControl(uint8_t *, uint8_t *, uint8_t *);
+void filterChannel(uint8_t *);
+
+#endif // _FILTER_H_
@@ -0,0 +1,108 @@
+#include "latency.h"
+#include "filter.h"
+
+typedef struct {
+  unsigned long count;
+  unsigned long total;    // in microseconds
+  unsigned long maximum;  // in microseconds
+  unsigned long bin[LATENCY_BINS];
+} histogram_t;
+
+static histogram_t histogram[TYPE_NUM];
+static unsigned int rxHighWater = 0, txHighWater = 0;
+static unsigned long arrival = 0;
+
+static const char *name[TYPE_NUM] = {"NoteOff", "NoteOn", "PolyPressure", "ControlChange", "ProgramChange", "AfterTouch", "PitchBend", "SystemExclusive", "SystemCommon", "RealTime"};
+
+/***************************************************************************/
+
+void latencyReset() {
+  memset(histogram, 0, sizeof(histogram));
+  rxHighWater = 0;
+  txHighWater = 0;
+}
+
+void latencyReceive(unsigned int waiting) {
+  // this should be called at the start of each handler, the bytes that are waiting arrived after the message
+  arrival = micros() - waiting * LATENCY_BYTE;
+  rxHighWater = (waiting > rxHighWater ? waiting : rxHighWater);
+}
+
+void latencySend(uint8_t type, unsigned int waiting) {
+  // this should be called just before the message is sent, it only starts after the bytes that are waiting
+  unsigned long departure = micros() + waiting * LATENCY_BYTE;
+  unsigned long latency = departure - arrival;
+  txHighWater = (waiting > txHighWater ? waiting : txHighWater);
+  if (type >= TYPE_NUM)
+    return;
+
+  histogram_t *h = &histogram[type];
+  uint8_t k = 0;
+  for (unsigned long limit = 16; latency >= limit && k < LATENCY_BINS - 1; limit <<= 1)
+    k++;
+  h->bin[k]++;
+  h->count++;
+  h->total += latency;
+  h->maximum = (latency > h->maximum ? latency : h->maximum);
+}
+
+void latencyPrint(Print &out) {
+  out.print("rx highwater = ");
+  out.print(rxHighWater);
+  out.print(", tx highwater = ");
+  out.println(txHighWater);
+  for (uint8_t type = 0; type < TYPE_NUM; type++) {
+    histogram_t *h = &histogram[type];
+    if (h->count == 0)
+      continue;
+    out.print(name[type]);
+    out.print(": count = ");
+    out.print(h->count);
+    out.print(", mean = ");
+    out.print(h->total / h->count);
+    out.print(" us, max = ");
+    out.print(h->maximum);
+    out.print(" us, histogram =");
+    for (uint8_t k = 0; k < LATENCY_BINS; k++) {
+      out.print(" ");
+      out.print(h->bin[k]);
+    }
+    out.println();
+  }
+}
+
+/***************************************************************************/
+
+bool latencyQuery(const uint8_t *data, unsigned int size) {
+  return (size == 4 && data[0] == 0xF0 && data[1] == FILTER_SYSEX_ID && data[2] == LATENCY_SYSEX_SUB && data[3] == 0xF7);
+}
+
+static uint8_t *encode(uint8_t *p, unsigned long value) {
+  // each number is sent as three 7-bit bytes, least significant first
+  value = (value > 0x1FFFFF ? 0x1FFFFF : value);
+  p[0] = value & 0x7F;
+  p[1] = (value >> 7) & 0x7F;
+  p[2] = (value >> 14) & 0x7F;
+  return p + 3;
+}
+
+unsigned int latencyDump(uint8_t *buf, unsigned int size) {
+  // the reply contains the high-water marks, followed by the count, maximum and histogram for each type
+  unsigned int length = 3 + 2 * 3 + TYPE_NUM * (2 + LATENCY_BINS) * 3 + 1;
+  if (size < length)
+    return 0;
+  uint8_t *p = buf;
+  *p++ = 0xF0;
+  *p++ = FILTER_SYSEX_ID;
+  *p++ = LATENCY_SYSEX_SUB;
+  p = encode(p, rxHighWater);
+  p = encode(p, txHighWater);
+  for (uint8_t type = 0; type < TYPE_NUM; type++) {
+    p = encode(p, histogram[type].count);
+    p = encode(p, histogram[type].maximum);
+    for (uint8_t k = 0; k < LATENCY_BINS; k++)
+      p = encode(p, histogram[type].bin[k]);
+  }
+  *p++ = 0xF7;
+  return length;
+}
@@ -0,0 +1,41 @@
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <Arduino.h>
+
+/*
+  This measures the delay that the filter adds to each message. The arrival of a
+  message is the moment its last byte was received; it is estimated from the number
+  of bytes that are still waiting in the receive buffer when the message is handled.
+  The departure is the moment its first byte starts to be transmitted; it is estimated
+  from the number of bytes that are still waiting in the transmit buffer.
+
+  The latencies are kept per message type in a histogram with logarithmic bins, the
+  first bin is below 16 us and each next bin is twice as wide. The largest number of
+  bytes waiting in the receive and transmit buffers are kept as well.
+*/
+
+#define LATENCY_BYTE      320     // in microseconds, for one byte at 31250 baud
+#define LATENCY_BINS      16
+#define LATENCY_SYSEX_SUB 0x53    // 'S', the query is F0 7D 53 F7
+
+#define TYPE_NOTEOFF      0
+#define TYPE_NOTEON       1
+#define TYPE_POLYPRESSURE 2
+#define TYPE_CONTROL      3
+#define TYPE_PROGRAM      4
+#define TYPE_AFTERTOUCH   5
+#define TYPE_PITCHBEND    6
+#define TYPE_SYSEX        7
+#define TYPE_COMMON       8
+#define TYPE_REALTIME     9
+#define TYPE_NUM          10
+
+void latencyReset(void);
+void latencyReceive(unsigned int);
+void latencySend(uint8_t, unsigned int);
+void latencyPrint(Print &);
+bool latencyQuery(const uint8_t *, unsigned int);
+unsigned int latencyDump(uint8_t *, unsigned int);
+
+#endif // _LATENCY_H_
@@ -0,0 +1,144 @@
+#include "midiclock.h"
+
+static IntervalTimer timer;
+static void (*emit)(void) = NULL;
+
+// these are shared between the main loop and the timer interrupt
+static volatile bool locked = false, busy = false;
+static volatile unsigned int pending = 0;
+static volatile uint32_t predicted = 0;   // the moment of the next incoming clock, in microseconds
+static volatile float period = 0;         // in microseconds
+static volatile long inCount = 0, outCount = 0;
+static volatile unsigned long previous = 0;       // the moment of the previous incoming clock
+static volatile unsigned int settled = 0;         // the number of clocks since tracking started
+
+static unsigned int lockin = CLOCK_LOCKIN;
+static float alpha, beta, jitter = 0;
+
+/***************************************************************************/
+
+static void send() {
+  // this is called from the timer interrupt
+  if (busy)
+    pending++;
+  else
+    emit();
+}
+
+static void clockISR() {
+  if (!locked)
+    return;
+  uint32_t now = micros();
+  if ((long)(now - previous) > 4 * period) {
+    // the incoming clock stopped, it will be passed on directly when it resumes
+    locked = false;
+    settled = 0;
+    return;
+  }
+  // the next outgoing clock belongs to incoming clock number outCount+1, which is expected at this moment
+  uint32_t target = predicted + (long)((outCount - inCount) * period);
+  if ((int32_t)(now - target) >= 0 && outCount <= inCount) {
+    // the outgoing clock is allowed to run at most one clock ahead
+    send();
+    outCount++;
+  }
+}
+
+/***************************************************************************/
+
+void clockBegin(void (*callback)(void)) {
+  emit = callback;
+  clockLockin(CLOCK_LOCKIN);
+  timer.begin(clockISR, CLOCK_RESOLUTION);
+}
+
+void clockLockin(unsigned int clocks) {
+  // these coefficients give a critically damped alpha-beta filter
+  float r = 1. - 1. / (clocks > 1 ? clocks : 2);
+  alpha = 1. - r * r;
+  beta = (1. - r) * (1. - r);
+  lockin = clocks;
+}
+
+void clockInput(unsigned long t) {
+  unsigned long interval = t - previous;
+  previous = t;
+
+  noInterrupts();
+  long error = (long)(t - predicted);
+  if (!locked && settled == 0) {
+    // the first clock after a pause, the interval since the previous one means nothing
+    period = 0;
+    predicted = t;
+    settled = 1;
+  }
+  else if (period == 0) {
+    // start tracking with the first interval, this is corrected as more clocks arrive
+    period = interval;
+    predicted = t + interval;
+    settled = 2;
+  }
+  else if (labs(error) > period / 2) {
+    // the incoming clock changed too much, start over from the most recent interval
+    locked = false;
+    period = interval;
+    predicted = t + interval;
+    settled = 2;
+  }
+  else {
+    // initially the gains give a least-squares fit through all clocks so far, they
+    // decrease with every clock until they reach those of the critically damped filter
+    float k = settled + 1;
+    float a = 2. * (2. * k - 1.) / (k * (k + 1.));
+    float b = 6. / (k * (k + 1.));
+    a = (a > alpha ? a : alpha);
+    b = (b > beta ? b : beta);
+    period = period + b * error;
+    predicted = predicted + (long)(a * error + period);
+    settled++;
+    jitter = 0.99 * jitter + 0.01 * labs(error);
+  }
+  inCount++;
+  bool direct = !locked;
+  if (direct) {
+    // the incoming clock is passed on directly, including the one at which it locks
+    outCount = inCount;
+    if (settled >= lockin)
+      locked = true;
+  }
+  interrupts();
+
+  if (direct)
+    emit();
+}
+
+void clockRestart() {
+  // after start or continue, the next outgoing clock should coincide with the next incoming clock
+  noInterrupts();
+  outCount = inCount;
+  interrupts();
+}
+
+void clockBusy(bool flag) {
+  noInterrupts();
+  unsigned int n = (flag ? 0 : pending);
+  busy = flag;
+  pending = 0;
+  interrupts();
+  while (n--)
+    emit();
+}
+
+bool clockLocked() {
+  return locked;
+}
+
+float clockTempo() {
+  // in beats per minute
+  return (period > 0 ? 60e6 / (period * CLOCK_PPQN) : 0);
+}
+
+float clockJitter() {
+  // the mean absolute deviation of the incoming clock from the prediction, in microseconds
+  return jitter;
+}
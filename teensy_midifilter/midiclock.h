@@ -0,0 +1,31 @@
+#ifndef _MIDICLOCK_H_
+#define _MIDICLOCK_H_
+
+#include <Arduino.h>
+
+/*
+  This locks onto the incoming MIDI clock and generates a new clock with less jitter.
+  The phase and period of the incoming clock are tracked with an alpha-beta filter,
+  which starts as a least-squares fit through the first clocks and then continues
+  critically damped, it settles within the lock-in time. Once locked, the
+  outgoing clock is generated from a timer interrupt at the filtered moments. Until
+  then, and after the incoming clock stops, the incoming clock is passed on directly.
+
+  The timer interrupt does not write to the serial port while the main loop is busy
+  writing a message, in that case the clock is sent as soon as the main loop is done.
+*/
+
+#define CLOCK_RESOLUTION  50     // in microseconds, this is the period of the timer
+#define CLOCK_LOCKIN      48     // in clocks, i.e. two beats
+#define CLOCK_PPQN        24
+
+void clockBegin(void (*)(void));
+void clockLockin(unsigned int);
+void clockInput(unsigned long);
+void clockRestart(void);
+void clockBusy(bool);
+bool clockLocked(void);
+float clockTempo(void);
+float clockJitter(void);
+
+#endif // _MIDICLOCK_H_
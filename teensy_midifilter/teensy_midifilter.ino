@@ -1,4 +1,23 @@
+/*
+  This sketch receives MIDI on Serial1 and sends it on Serial2. The messages are
+  filtered and transformed according to a list of rules, see filter.h
+
+  The rules can be loaded with a SysEx message, or one at a time over the USB serial
+  connection with lines like "split 1 0 59 2", "transpose 1 0 59 -12" or "block 0 248".
+  Furthermore, "list" prints the rules and "clear" removes all of them.
+
+  The latency that the filter adds is measured continuously, see latency.h. The
+  statistics are printed with "latency" and cleared with "reset", or returned in
+  response to the SysEx message F0 7D 53 F7.
+
+  The incoming MIDI clock is regenerated with less jitter, see midiclock.h. The
+  tempo is printed with "tempo" and the lock-in time is set with "lockin 48".
+*/
+
 #include <MIDI.h>
+#include "filter.h"
+#include "latency.h"
+#include "midiclock.h"
 
 // select "tools"->"usb type"->"serial + MIDI" to instantiate the usbMIDI device
 MIDI_CREATE_INSTANCE(HardwareSerial, Serial1, inMIDI);
@@ -9,75 +28,254 @@ MIDI_CREATE_INSTANCE(HardwareSerial, Serial2, outMIDI);
 
 /************************************************************************************************************/
 
+char line[64];
+unsigned int nline = 0;
+unsigned int txCapacity = 0;
+uint8_t dump[600];
+
+void received(void) {
+  latencyReceive(Serial1.available());
+};
+
+void sending(uint8_t type) {
+  latencySend(type, txCapacity - Serial2.availableForWrite());
+};
+
+void allNotesOff(void) {
+  // the notes that are sounding might not be switched off after the rules change
+  for (byte channel = 1; channel <= 16; channel++)
+    outMIDI.sendControlChange(123, 0, channel);
+};
+
+void handleCommand(const char *command) {
+  rule_t rule;
+  char str[64];
+  if (strcmp(command, "list") == 0) {
+    for (unsigned int i = 0; i < filterCount(); i++) {
+      filterFormat(filterRule(i), str, sizeof(str));
+      Serial.println(str);
+    }
+  }
+  else if (strcmp(command, "latency") == 0) {
+    latencyPrint(Serial);
+  }
+  else if (strcmp(command, "reset") == 0) {
+    latencyReset();
+    Serial.println("ok");
+  }
+  else if (strcmp(command, "tempo") == 0) {
+    Serial.print("tempo = ");
+    Serial.print(clockTempo());
+    Serial.print(" bpm, jitter = ");
+    Serial.print(clockJitter());
+    Serial.println(clockLocked() ? " us, locked" : " us, not locked");
+  }
+  else if (strncmp(command, "lockin ", 7) == 0 && atoi(command + 7) > 0) {
+    clockLockin(atoi(command + 7));
+    Serial.println("ok");
+  }
+  else if (strcmp(command, "clear") == 0) {
+    filterClear();
+    allNotesOff();
+    Serial.println("ok");
+  }
+  else if (filterParse(command, &rule) && filterAdd(&rule)) {
+    filterCompile();
+    allNotesOff();
+    Serial.println("ok");
+  }
+  else {
+    Serial.println("error");
+  }
+};
+
+void handleSerial(void) {
+  // the commands over the USB serial connection are terminated by a newline
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      line[nline] = 0;
+      if (nline)
+        handleCommand(line);
+      nline = 0;
+    }
+    else if (nline < sizeof(line) - 1) {
+      line[nline++] = c;
+    }
+  }
+};
+
+bool readMIDI(void) {
+  // the timer interrupt does not send the clock while a message is being written
+  clockBusy(true);
+  bool result = inMIDI.read();
+  clockBusy(false);
+  return result;
+};
+
+/************************************************************************************************************/
+
 void handleNoteOff(byte Channel, byte NoteNumber, byte Velocity) {
+  received();
+  if (filterBlocked(midi::NoteOff, Channel) || !filterNote(&Channel, &NoteNumber, &Velocity, false))
+    return;
+  sending(TYPE_NOTEOFF);
   outMIDI.sendNoteOff(NoteNumber, Velocity, Channel);
 };
 
 void handleNoteOn(byte Channel, byte NoteNumber, byte Velocity) {
+  received();
+  if (filterBlocked(midi::NoteOn, Channel) || !filterNote(&Channel, &NoteNumber, &Velocity, true))
+    return;
+  sending(TYPE_NOTEON);
   outMIDI.sendNoteOn(NoteNumber, Velocity, Channel);
 };
 
 void handleAfterTouchPoly(byte Channel, byte NoteNumber, byte Pressure) {
+  received();
+  if (filterBlocked(midi::AfterTouchPoly, Channel) || !filterNote(&Channel, &NoteNumber, &Pressure, false))
+    return;
+  sending(TYPE_POLYPRESSURE);
   outMIDI.sendPolyPressure(NoteNumber, Pressure, Channel);
 };
 
 void handleControlChange(byte Channel, byte ControlNumber, byte ControlValue) {
+  received();
+  if (filterBlocked(midi::ControlChange, Channel))
+    return;
+  filterControl(&Channel, &ControlNumber, &ControlValue);
+  sending(TYPE_CONTROL);
   outMIDI.sendControlChange(ControlNumber, ControlValue, Channel);
 };
 
 void handleProgramChange(byte Channel, byte ProgramNumber) {
+  received();
+  if (filterBlocked(midi::ProgramChange, Channel))
+    return;
+  filterChannel(&Channel);
+  sending(TYPE_PROGRAM);
   outMIDI.sendProgramChange(ProgramNumber, Channel);
 };
 
 void handleAfterTouchChannel(byte Channel, byte Pressure) {
+  received();
+  if (filterBlocked(midi::AfterTouchChannel, Channel))
+    return;
+  filterChannel(&Channel);
+  sending(TYPE_AFTERTOUCH);
   outMIDI.sendAfterTouch(Pressure, Channel);
 };
 
 void handlePitchBend(byte Channel, int PitchValue) {
+  received();
+  if (filterBlocked(midi::PitchBend, Channel))
+    return;
+  filterChannel(&Channel);
+  sending(TYPE_PITCHBEND);
   outMIDI.sendPitchBend(PitchValue, Channel);
 };
 
 void handleSystemExclusive(byte* Array, unsigned Size) {
+  received();
+  // a SysEx message with rules is not passed on
+  if (filterSysEx(Array, Size) >= 0) {
+    allNotesOff();
+    return;
+  }
+  // the latency statistics are sent back to where the query came from
+  if (latencyQuery(Array, Size)) {
+    inMIDI.sendSysEx(latencyDump(dump, sizeof(dump)), dump, true);
+    return;
+  }
+  if (filterBlocked(midi::SystemExclusive, 0))
+    return;
+  sending(TYPE_SYSEX);
   outMIDI.sendSysEx(Size, Array);
 };
 
 void handleTimeCodeQuarterFrame(byte Data) {
+  received();
+  if (filterBlocked(midi::TimeCodeQuarterFrame, 0))
+    return;
+  sending(TYPE_COMMON);
   outMIDI.sendTimeCodeQuarterFrame(Data);
 };
 
 void handleSongPosition(unsigned int Beats) {
+  received();
+  if (filterBlocked(midi::SongPosition, 0))
+    return;
+  sending(TYPE_COMMON);
   outMIDI.sendSongPosition(Beats);
 };
 
 void handleSongSelect(byte SongNumber) {
+  received();
+  if (filterBlocked(midi::SongSelect, 0))
+    return;
+  sending(TYPE_COMMON);
   outMIDI.sendSongSelect(SongNumber);
 };
 
 void handleTuneRequest(void) {
+  received();
+  if (filterBlocked(midi::TuneRequest, 0))
+    return;
+  sending(TYPE_COMMON);
   outMIDI.sendTuneRequest();
 };
 
 void handleClock(void) {
+  received();
+  if (filterBlocked(midi::Clock, 0))
+    return;
+  // the clock is not passed on directly, but regenerated with less jitter
+  clockInput(micros() - Serial1.available() * LATENCY_BYTE);
+};
+
+void sendClock(void) {
   outMIDI.sendRealTime(midi::Clock);
 };
 
 void handleStart(void) {
+  received();
+  if (filterBlocked(midi::Start, 0))
+    return;
+  sending(TYPE_REALTIME);
   outMIDI.sendRealTime(midi::Start);
+  clockRestart();
 };
 
 void handleContinue(void) {
+  received();
+  if (filterBlocked(midi::Continue, 0))
+    return;
+  sending(TYPE_REALTIME);
   outMIDI.sendRealTime(midi::Continue);
+  clockRestart();
 };
 
 void handleStop(void) {
+  received();
+  if (filterBlocked(midi::Stop, 0))
+    return;
+  sending(TYPE_REALTIME);
   outMIDI.sendRealTime(midi::Stop);
 };
 
 void handleActiveSensing(void) {
+  received();
+  if (filterBlocked(midi::ActiveSensing, 0))
+    return;
+  sending(TYPE_REALTIME);
   outMIDI.sendRealTime(midi::ActiveSensing);
 };
 
 void handleSystemReset(void) {
+  received();
+  if (filterBlocked(midi::SystemReset, 0))
+    return;
+  sending(TYPE_REALTIME);
   outMIDI.sendRealTime(midi::SystemReset);
 };
 
@@ -104,9 +302,18 @@ void setup() {
     
   pinMode(led, OUTPUT);
 
+  // start without rules, all messages are passed on unchanged
+  filterClear();
+
   outMIDI.begin(MIDI_CHANNEL_OMNI);
   inMIDI.begin(MIDI_CHANNEL_OMNI);
 
+  // this is used to determine the number of bytes that are waiting to be transmitted
+  txCapacity = Serial2.availableForWrite();
+  latencyReset();
+
+  clockBegin(sendClock);
+
   inMIDI.setHandleNoteOff(handleNoteOff);
   inMIDI.setHandleNoteOn(handleNoteOn);
   inMIDI.setHandleAfterTouchPoly(handleAfterTouchPoly);
@@ -120,9 +327,9 @@ void setup() {
   inMIDI.setHandleSongSelect(handleSongSelect);
   inMIDI.setHandleTuneRequest(handleTuneRequest);
   inMIDI.setHandleClock(handleClock);
-  //inMIDI.setHandleStart(handleStart);
-  //inMIDI.setHandleContinue(handleContinue);
-  //inMIDI.setHandleStop(handleStop);
+  inMIDI.setHandleStart(handleStart);
+  inMIDI.setHandleContinue(handleContinue);
+  inMIDI.setHandleStop(handleStop);
   inMIDI.setHandleActiveSensing(handleActiveSensing);
   inMIDI.setHandleSystemReset(handleSystemReset);
 }
@@ -142,7 +349,11 @@ void loop() {
     prev = millis();
   }
 
-  while (inMIDI.read()) {
+  clockBusy(true);
+  handleSerial();
+  clockBusy(false);
+
+  while (readMIDI()) {
 #ifdef DEBUG_SERIAL
     Serial.print(inMIDI.getType());
     Serial.print(" ");
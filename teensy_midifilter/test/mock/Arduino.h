@@ -0,0 +1,60 @@
+#ifndef _ARDUINO_H_
+#define _ARDUINO_H_
+
+// This replaces the Teensy core with the parts that the latency and clock modules use.
+// The time only advances when the test sets it, the interval timer does not run by
+// itself: mockRun() calls its interrupt at every period until the given moment.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+extern uint32_t mockMicros;
+
+inline uint32_t micros() { return mockMicros; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// the printed text is collected, so that the test can check it
+class Print {
+ public:
+  std::string text;
+  void print(const char *str) { text += str; }
+  void print(int value) { text += std::to_string(value); }
+  void print(unsigned int value) { text += std::to_string(value); }
+  void print(long value) { text += std::to_string(value); }
+  void print(unsigned long value) { text += std::to_string(value); }
+  void print(double value) { text += std::to_string(value); }
+  template <typename T> void println(T value) { print(value); println(); }
+  void println() { text += "\n"; }
+};
+
+class IntervalTimer;
+extern IntervalTimer *mockTimer;
+
+class IntervalTimer {
+ public:
+  void (*isr)(void) = NULL;
+  uint32_t period = 0;   // in microseconds
+  uint32_t next = 0;     // the moment of the next interrupt
+  bool begin(void (*function)(void), uint32_t microseconds) {
+    isr = function;
+    period = microseconds;
+    next = mockMicros + microseconds;
+    mockTimer = this;
+    return true;
+  }
+};
+
+// advance the time to the given moment, the timer interrupt is called on the way
+inline void mockRun(uint32_t until) {
+  while (mockTimer && mockTimer->period && (int32_t)(until - mockTimer->next) >= 0) {
+    mockMicros = mockTimer->next;
+    mockTimer->next += mockTimer->period;
+    mockTimer->isr();
+  }
+  mockMicros = until;
+}
+
+#endif // _ARDUINO_H_
@@ -0,0 +1,176 @@
+// Host simulation of the clock regeneration, a 24 ppqn clock with random jitter is fed
+// into the PLL while the timer interrupt runs every CLOCK_RESOLUTION microseconds
+//
+// The moments of the outgoing clocks are compared to the ideal moments of the incoming
+// clock, i.e. without the jitter that was added to them.
+
+#include <math.h>
+#include <vector>
+#include "check.h"
+#include "midiclock.h"
+
+uint32_t mockMicros = 0;
+IntervalTimer *mockTimer = NULL;
+
+#define JITTER 1000   // in microseconds, the incoming clocks are up to this much early or late
+
+static std::vector<uint32_t> output;   // the moments of the outgoing clocks
+static uint32_t ideal = 0;             // the moment of the next incoming clock without jitter
+static unsigned long inputs = 0;
+
+static void emit() {
+  output.push_back(mockMicros);
+}
+
+static uint32_t period(float bpm) {
+  return 60e6 / (bpm * CLOCK_PPQN);
+}
+
+// feed the given number of clocks at the given tempo, the jitter is uniformly distributed
+static void feed(unsigned int clocks, float bpm, uint32_t jitter = JITTER) {
+  for (unsigned int k = 0; k < clocks; k++) {
+    uint32_t t = ideal + (jitter ? rand() % (2 * jitter + 1) - jitter : 0);
+    mockRun(t);
+    clockInput(t);
+    inputs++;
+    ideal += period(bpm);
+  }
+  mockRun(ideal - period(bpm) / 2);
+}
+
+// the largest deviation of the intervals between the last outgoing clocks from the given period
+static uint32_t deviation(unsigned int clocks, uint32_t expected) {
+  uint32_t largest = 0;
+  for (size_t i = output.size() - clocks; i < output.size(); i++) {
+    uint32_t interval = output[i] - output[i - 1];
+    uint32_t d = (interval > expected ? interval - expected : expected - interval);
+    largest = (d > largest ? d : largest);
+  }
+  return largest;
+}
+
+static void start() {
+  // the incoming clock starts after a pause, hence it is first passed on directly
+  mockRun(mockMicros + 1000000);
+  output.clear();
+  inputs = 0;
+  ideal = mockMicros + 1000;
+}
+
+/***************************************************************************/
+
+static void testLockin() {
+  clockBegin(emit);
+  start();
+
+  // until the filter has settled the incoming clock is passed on at once, jitter included
+  feed(CLOCK_LOCKIN - 1, 120);
+  CHECK(!clockLocked());
+  CHECK_EQUAL(output.size(), CLOCK_LOCKIN - 1);
+  feed(1, 120);
+  CHECK(clockLocked());
+  CHECK_EQUAL(output.size(), CLOCK_LOCKIN);
+  CHECK_CLOSE(clockTempo(), 120, 0.5);
+}
+
+static void testJitter() {
+  // once locked, the outgoing clock has much less jitter than the incoming one
+  feed(10 * CLOCK_LOCKIN, 120);
+  uint32_t d = deviation(5 * CLOCK_LOCKIN, period(120));
+  printf("largest deviation of the interval with %d us jitter: %u us\n", JITTER, d);
+  CHECK(d <= JITTER / 4);
+  CHECK_CLOSE(clockTempo(), 120, 0.1);
+  CHECK(clockJitter() > JITTER / 4 && clockJitter() < JITTER);
+
+  // the outgoing clock neither runs ahead nor falls behind
+  CHECK(output.size() == inputs || output.size() == inputs + 1);
+
+  // and it follows the ideal moments of the incoming clock, not the moments with jitter
+  uint32_t expected = ideal - period(120);
+  uint32_t last = output.back();
+  CHECK_CLOSE((int32_t)(last - expected), 0, JITTER / 2);
+}
+
+static void testTempo() {
+  // a small change of the tempo is followed without losing the lock
+  feed(5 * CLOCK_LOCKIN, 120);
+  unsigned int lag = 0;
+  for (; lag < 10 * CLOCK_LOCKIN && fabs(clockTempo() - 121) > 0.1; lag++) {
+    feed(1, 121);
+    CHECK(clockLocked());
+  }
+  printf("tempo step from 120 to 121 BPM is followed within 0.1 BPM after %u clocks\n", lag);
+  CHECK(lag <= 4 * CLOCK_LOCKIN);
+  feed(5 * CLOCK_LOCKIN, 121);
+  CHECK(clockLocked());
+  CHECK(deviation(2 * CLOCK_LOCKIN, period(121)) <= JITTER / 4);
+  CHECK(output.size() == inputs || output.size() == inputs + 1);
+
+  // a large change starts over, the clock is passed on directly until it is locked again
+  size_t before = output.size();
+  feed(CLOCK_LOCKIN / 2, 60);
+  CHECK(!clockLocked());
+  CHECK(output.size() - before >= CLOCK_LOCKIN / 2 && output.size() - before <= CLOCK_LOCKIN / 2 + 1);
+  feed(CLOCK_LOCKIN, 60);
+  CHECK(clockLocked());
+  CHECK_CLOSE(clockTempo(), 60, 1);
+}
+
+static void testStop() {
+  // when the incoming clock stops, the outgoing clock stops as well
+  feed(5 * CLOCK_LOCKIN, 120);
+  size_t before = output.size();
+  mockRun(mockMicros + 10 * period(120));
+  CHECK(!clockLocked());
+  CHECK(output.size() - before <= 1);
+
+  // when it resumes it is passed on directly, also with another tempo
+  start();
+  feed(10, 90);
+  CHECK(!clockLocked());
+  CHECK_EQUAL(output.size(), 10);
+  feed(CLOCK_LOCKIN, 90);
+  CHECK(clockLocked());
+}
+
+static void testRestart() {
+  // after a start or continue, the next outgoing clock coincides with the next incoming one
+  feed(10 * CLOCK_LOCKIN, 120);
+  mockRun(ideal - period(120) / 4);
+  clockRestart();
+  size_t before = output.size();
+  feed(1, 120, 0);
+  CHECK_EQUAL(output.size() - before, 1);
+  CHECK_CLOSE((int32_t)(output.back() - (ideal - period(120))), 0, JITTER / 4);
+
+  // the outgoing clocks that were not yet sent are skipped
+  feed(2 * CLOCK_LOCKIN, 120);
+  long ahead = output.size() - inputs;
+  clockRestart();
+  feed(CLOCK_LOCKIN, 120);
+  CHECK((long)(output.size() - inputs) - ahead >= -1 && (long)(output.size() - inputs) - ahead <= 1);
+}
+
+static void testBusy() {
+  // while the main loop writes a message the clock is held back, and sent right after
+  feed(10 * CLOCK_LOCKIN, 120);
+  size_t before = output.size();
+  clockBusy(true);
+  feed(3, 120, 0);
+  CHECK_EQUAL(output.size(), before);
+  clockBusy(false);
+  CHECK(output.size() - before >= 2 && output.size() - before <= 4);
+  feed(1, 120, 0);
+  CHECK(output.size() == inputs || output.size() == inputs + 1);
+}
+
+int main() {
+  srand(1);
+  testLockin();
+  testJitter();
+  testTempo();
+  testStop();
+  testRestart();
+  testBusy();
+  return report("test_clock");
+}
@@ -0,0 +1,255 @@
+// Host test of the filter rules and their lookup tables, with a benchmark of the messages per second
+
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "filter.h"
+
+#define NOTEOFF        0x80
+#define NOTEON         0x90
+#define CONTROLCHANGE  0xB0
+#define CLOCK          0xF8
+
+static void add(const char *line) {
+  rule_t r;
+  CHECK(filterParse(line, &r));
+  CHECK(filterAdd(&r));
+  filterCompile();
+}
+
+// apply the filter to a note-on and return the channel, note and velocity in one number
+static int note(uint8_t channel, uint8_t number, uint8_t velocity) {
+  if (filterBlocked(NOTEON, channel) || !filterNote(&channel, &number, &velocity, true))
+    return -1;
+  return channel * 100000 + number * 1000 + velocity;
+}
+
+static int control(uint8_t channel, uint8_t number, uint8_t value) {
+  if (filterBlocked(CONTROLCHANGE, channel))
+    return -1;
+  filterControl(&channel, &number, &value);
+  return channel * 100000 + number * 1000 + value;
+}
+
+static void testPassthrough() {
+  filterClear();
+  CHECK_EQUAL(filterCount(), 0);
+  for (int ch = 1; ch <= 16; ch++)
+    for (int n = 0; n < 128; n++) {
+      CHECK_EQUAL(note(ch, n, n), ch * 100000 + n * 1000 + n);
+      CHECK_EQUAL(control(ch, n, 127 - n), ch * 100000 + n * 1000 + 127 - n);
+    }
+  CHECK(!filterBlocked(CLOCK, 0));
+}
+
+static void testBlock() {
+  filterClear();
+  add("block 2 144");
+  add("block 0 248");
+  CHECK_EQUAL(note(1, 60, 100), 160100);
+  CHECK_EQUAL(note(2, 60, 100), -1);
+  CHECK(!filterBlocked(NOTEOFF, 2));
+  CHECK(filterBlocked(CLOCK, 0));
+
+  // system messages have no channel, hence a block rule for any channel applies to them
+  filterClear();
+  add("block 3 248");
+  CHECK(filterBlocked(CLOCK, 0));
+}
+
+static void testChannel() {
+  filterClear();
+  add("channel 1 10");
+  CHECK_EQUAL(note(1, 60, 100), 1060100);
+  CHECK_EQUAL(control(1, 7, 64), 1007064);
+  uint8_t channel = 1;
+  filterChannel(&channel);
+  CHECK_EQUAL(channel, 10);
+  CHECK_EQUAL(note(2, 60, 100), 260100);
+
+  // a split on top of the remap only affects the notes in its range
+  add("split 1 0 59 11");
+  CHECK_EQUAL(note(1, 59, 100), 1159100);
+  CHECK_EQUAL(note(1, 60, 100), 1060100);
+
+  // a later remap of the whole channel overrides the split
+  add("channel 1 12");
+  CHECK_EQUAL(note(1, 59, 100), 1259100);
+}
+
+static void testTranspose() {
+  filterClear();
+  add("transpose 0 0 127 12");
+  CHECK_EQUAL(note(5, 60, 100), 572100);
+
+  // notes that are transposed outside the MIDI range are dropped, the note-off as well
+  CHECK_EQUAL(note(5, 115, 100), 627100);
+  CHECK_EQUAL(note(5, 116, 100), -1);
+  uint8_t channel = 5, number = 116, velocity = 0;
+  CHECK(!filterNote(&channel, &number, &velocity, false));
+
+  // transpositions add up, a range can be transposed back
+  add("transpose 5 0 59 -24");
+  CHECK_EQUAL(note(5, 59, 100), 547100);
+  CHECK_EQUAL(note(5, 60, 100), 572100);
+  CHECK_EQUAL(note(5, 11, 100), -1);
+}
+
+static void testVelocity() {
+  filterClear();
+  add("velocity 0 0 20 100");
+  CHECK_EQUAL(note(1, 60, 127) % 1000, 100);
+  CHECK_EQUAL(note(1, 60, 1) % 1000, 21);
+
+  // a note-on with velocity zero remains a note-off
+  CHECK_EQUAL(note(1, 60, 0) % 1000, 0);
+
+  // the soft curve is above and the hard curve below the linear one
+  filterClear();
+  add("velocity 1 1 0 127");
+  add("velocity 2 2 0 127");
+  CHECK(note(1, 64, 64) % 1000 > 64);
+  CHECK(note(2, 64, 64) % 1000 < 64);
+  CHECK_EQUAL(note(1, 64, 127) % 1000, 127);
+  CHECK_EQUAL(note(2, 64, 127) % 1000, 127);
+
+  add("velocity 3 3 0 90");
+  CHECK_EQUAL(note(3, 64, 1) % 1000, 90);
+
+  // the velocity of a note-off is not changed
+  uint8_t channel = 3, number = 64, velocity = 10;
+  CHECK(filterNote(&channel, &number, &velocity, false));
+  CHECK_EQUAL(velocity, 10);
+}
+
+static void testControl() {
+  filterClear();
+  add("cc 0 1 74 0 127");
+  CHECK_EQUAL(control(1, 1, 100), 174100);
+  CHECK_EQUAL(control(1, 2, 100), 102100);
+
+  // the value is scaled onto the range
+  add("cc 0 7 7 32 96");
+  CHECK_EQUAL(control(1, 7, 0), 107032);
+  CHECK_EQUAL(control(1, 7, 127), 107096);
+  CHECK_EQUAL(control(1, 7, 64), 107064);
+
+  // an inverted range reaches both ends
+  add("cc 0 11 11 127 0");
+  for (int v = 0; v < 128; v++)
+    CHECK_EQUAL(control(1, 11, v), 111000 + 127 - v);
+}
+
+static void testRules() {
+  filterClear();
+  rule_t r;
+  char str[64];
+  CHECK(!filterParse("bogus 1 2 3", &r));
+  CHECK(!filterParse("split 17 0 10 2", &r));
+  CHECK(!filterParse("split", &r));
+  CHECK(filterParse("transpose 3 0 64 -12", &r));
+  filterFormat(&r, str, sizeof(str));
+  CHECK(strcmp(str, "transpose 3 0 64 -12 0") == 0);
+
+  // the number of rules is limited
+  for (int k = 0; k < FILTER_MAXRULES; k++)
+    CHECK(filterAdd(&r));
+  CHECK(!filterAdd(&r));
+  CHECK_EQUAL(filterCount(), FILTER_MAXRULES);
+  CHECK(filterRule(FILTER_MAXRULES) == NULL);
+}
+
+static void testRange() {
+  // a rule outside the range of the notes or channels is rejected, the tables remain as they were
+  filterClear();
+  rule_t r;
+  static const char *invalid[] = {
+    "transpose 0 -10 20 5", "transpose 0 100 128 5", "transpose 0 20 10 5",
+    "split 0 -1 20 2", "split 0 0 200 2", "split 0 0 20 0", "split 0 0 20 17",
+    "channel 0 0", "channel 0 17", "block 0 100", "velocity 0 4 0 127", "cc 0 -1 7 0 127", "cc 0 1 128 0 127"
+  };
+  for (unsigned int i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+    CHECK(filterParse(invalid[i], &r));
+    CHECK(!filterAdd(&r));
+  }
+  CHECK_EQUAL(filterCount(), 0);
+  filterCompile();
+  for (int ch = 1; ch <= 16; ch++)
+    for (int n = 0; n < 128; n++)
+      CHECK_EQUAL(note(ch, n, 64), ch * 100000 + n * 1000 + 64);
+
+  // the ends of the ranges are valid
+  add("transpose 0 0 127 1");
+  add("split 0 0 127 16");
+  add("channel 5 1");
+  CHECK_EQUAL(note(1, 0, 64), 1601064);
+  CHECK_EQUAL(note(1, 127, 64), -1);
+  CHECK_EQUAL(control(5, 7, 64), 107064);
+
+  // a rule in a SysEx message with a channel of zero is skipped as well
+  const uint8_t dump[] = {0xF0, FILTER_SYSEX_ID, FILTER_SYSEX_SUB, RULE_CHANNEL, 0, 0, 0, 0, 0, 0xF7};
+  CHECK_EQUAL(filterSysEx(dump, sizeof(dump)), 0);
+}
+
+static void testSysEx() {
+  // a block of note-on on channel 2 and a transposition of -12 on all channels
+  const uint8_t dump[] = {0xF0, FILTER_SYSEX_ID, FILTER_SYSEX_SUB,
+                          RULE_BLOCK, 2, 144 - 128, 0, 0, 0,
+                          RULE_TRANSPOSE, 0, 0, 127, 64 - 12, 0,
+                          0xF7
+                         };
+  CHECK_EQUAL(filterSysEx(dump, sizeof(dump)), 2);
+  CHECK_EQUAL(filterRule(0)->a, 144);
+  CHECK_EQUAL(filterRule(1)->c, -12);
+  CHECK_EQUAL(note(2, 60, 100), -1);
+  CHECK_EQUAL(note(1, 60, 100), 148100);
+
+  // other SysEx messages are passed on and do not change the rules
+  const uint8_t other[] = {0xF0, 0x7E, 0x7F, 0x06, 0x01, 0xF7};
+  CHECK_EQUAL(filterSysEx(other, sizeof(other)), -1);
+  const uint8_t truncated[] = {0xF0, FILTER_SYSEX_ID, FILTER_SYSEX_SUB, RULE_BLOCK, 2, 0xF7};
+  CHECK_EQUAL(filterSysEx(truncated, sizeof(truncated)), -1);
+  CHECK_EQUAL(filterCount(), 2);
+}
+
+static void benchmark() {
+  // a MIDI byte takes 320 us at 31250 baud, the filter should take only a small fraction of that
+  filterClear();
+  for (int k = 0; k < FILTER_MAXRULES / 4; k++) {
+    add("split 0 0 40 2");
+    add("transpose 0 20 100 3");
+    add("velocity 0 1 10 120");
+    add("cc 0 1 2 0 100");
+  }
+  const unsigned long repeat = 10000000;
+  unsigned long sum = 0;
+  clock_t start = clock();
+  for (unsigned long k = 0; k < repeat; k++) {
+    uint8_t channel = (k & 0x0F) + 1, number = k & 0x7F, value = (k >> 7) & 0x7F;
+    if (k & 0x100) {
+      if (!filterBlocked(NOTEON, channel) && filterNote(&channel, &number, &value, true))
+        sum += number;
+    }
+    else if (!filterBlocked(CONTROLCHANGE, channel)) {
+      filterControl(&channel, &number, &value);
+      sum += value;
+    }
+  }
+  double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("%.0f messages per second on this computer with %u rules, %.1f ns per message (%lu)\n", repeat / elapsed, filterCount(), 1e9 * elapsed / repeat, sum & 1);
+  CHECK(1e6 * elapsed / repeat < 320);
+}
+
+int main() {
+  testPassthrough();
+  testBlock();
+  testChannel();
+  testTranspose();
+  testVelocity();
+  testControl();
+  testRules();
+  testRange();
+  testSysEx();
+  benchmark();
+  return report("test_filter");
+}
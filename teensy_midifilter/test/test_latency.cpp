@@ -0,0 +1,243 @@
+// Host replay of timed MIDI streams through the latency measurement, with a mock transport
+// that receives and transmits the bytes at 31250 baud
+//
+// The main loop handles one message at a time and can be held up, the mock transport knows
+// when each byte actually arrived and when the reply actually starts to be transmitted. The
+// statistics are read back through the SysEx dump, like the host computer does.
+
+#include <vector>
+#include "check.h"
+#include "latency.h"
+#include "filter.h"
+
+uint32_t mockMicros = 0;
+IntervalTimer *mockTimer = NULL;
+
+#define DUMP_LENGTH (3 + 2 * 3 + TYPE_NUM * (2 + LATENCY_BINS) * 3 + 1)
+
+// a message in the replayed stream, the time is when its last byte arrives
+struct Message {
+  uint32_t time;
+  uint8_t type;
+  uint8_t bytes;
+};
+
+// the statistics as decoded from the SysEx dump
+struct Stats {
+  unsigned long rx, tx;
+  unsigned long count[TYPE_NUM], maximum[TYPE_NUM], bin[TYPE_NUM][LATENCY_BINS];
+};
+
+// these are known to the mock transport, for comparing them to the estimates
+static unsigned long actualMaximum[TYPE_NUM];
+static unsigned int actualTx;
+
+/***************************************************************************/
+
+// replay the stream, the main loop takes cost us for each message and is held up once by a stall
+static void replay(const std::vector<Message> &stream, uint32_t cost, size_t stallAt = 0, uint32_t stall = 0) {
+  uint32_t now = 0, txEnd = 0;   // the transmit buffer is empty from txEnd onwards
+  memset(actualMaximum, 0, sizeof(actualMaximum));
+  actualTx = 0;
+
+  for (size_t i = 0; i < stream.size(); i++) {
+    const Message &m = stream[i];
+    now = (m.time > now ? m.time : now);
+    if (i == stallAt)
+      now += stall;
+
+    // the bytes of the following messages that arrived in the mean time are waiting in the receive buffer
+    unsigned int waiting = 0;
+    for (size_t j = i + 1; j < stream.size(); j++)
+      for (unsigned int b = 0; b < stream[j].bytes; b++)
+        if (stream[j].time - (stream[j].bytes - 1 - b) * LATENCY_BYTE <= now)
+          waiting++;
+    mockMicros = now;
+    latencyReceive(waiting);
+
+    now += cost;
+    mockMicros = now;
+    unsigned int txWaiting = (txEnd > now ? (txEnd - now + LATENCY_BYTE - 1) / LATENCY_BYTE : 0);
+    latencySend(m.type, txWaiting);
+
+    // the first byte of the reply is transmitted once the bytes before it are out
+    uint32_t departure = (txEnd > now ? txEnd : now);
+    txEnd = departure + m.bytes * LATENCY_BYTE;
+    actualMaximum[m.type] = (departure - m.time > actualMaximum[m.type] ? departure - m.time : actualMaximum[m.type]);
+    actualTx = (txWaiting > actualTx ? txWaiting : actualTx);
+  }
+}
+
+static unsigned long decode(const uint8_t *p) {
+  return p[0] | (p[1] << 7) | ((unsigned long)p[2] << 14);
+}
+
+static Stats dump() {
+  uint8_t buf[DUMP_LENGTH];
+  Stats s;
+  CHECK_EQUAL(latencyDump(buf, sizeof(buf)), DUMP_LENGTH);
+  const uint8_t *p = buf + 3;
+  s.rx = decode(p);
+  s.tx = decode(p + 3);
+  p += 6;
+  for (int type = 0; type < TYPE_NUM; type++) {
+    s.count[type] = decode(p);
+    s.maximum[type] = decode(p + 3);
+    p += 6;
+    for (int k = 0; k < LATENCY_BINS; k++, p += 3)
+      s.bin[type][k] = decode(p);
+  }
+  return s;
+}
+
+/***************************************************************************/
+
+static void testSingle() {
+  // a note-on that is handled at once takes as long as the filter
+  latencyReset();
+  std::vector<Message> stream = {{10000, TYPE_NOTEON, 3}};
+  replay(stream, 70);
+  Stats s = dump();
+  CHECK_EQUAL(s.count[TYPE_NOTEON], 1);
+  CHECK_EQUAL(s.maximum[TYPE_NOTEON], 70);
+  CHECK_EQUAL(s.bin[TYPE_NOTEON][3], 1);    // between 64 and 128 us
+  CHECK_EQUAL(s.rx, 0);
+  CHECK_EQUAL(s.tx, 0);
+}
+
+static void testBins() {
+  // the first bin is below 16 us, each next bin is twice as wide and the last one takes the rest
+  static const struct {
+    uint32_t latency;
+    int bin;
+  } edge[] = {{0, 0}, {15, 0}, {16, 1}, {31, 1}, {32, 2}, {1000, 6}, {16 << 13, 14}, {(16 << 14) - 1, 14}, {16 << 14, 15}, {10000000, 15}};
+  for (unsigned int i = 0; i < sizeof(edge) / sizeof(edge[0]); i++) {
+    latencyReset();
+    std::vector<Message> stream = {{10000, TYPE_CONTROL, 3}};
+    replay(stream, edge[i].latency);
+    Stats s = dump();
+    for (int k = 0; k < LATENCY_BINS; k++)
+      CHECK_EQUAL(s.bin[TYPE_CONTROL][k], k == edge[i].bin);
+  }
+}
+
+static void testTypes() {
+  // messages of different types that are far apart, each type is counted separately
+  latencyReset();
+  static const uint8_t type[] = {TYPE_NOTEOFF, TYPE_NOTEON, TYPE_CONTROL, TYPE_PROGRAM, TYPE_REALTIME, TYPE_PITCHBEND};
+  static const uint8_t bytes[] = {3, 3, 3, 2, 1, 3};
+  std::vector<Message> stream;
+  for (int k = 0; k < 60; k++)
+    stream.push_back({10000 + 2000u * k, type[k % 6], bytes[k % 6]});
+  for (size_t i = 0; i < stream.size(); i++) {
+    std::vector<Message> one(1, stream[i]);
+    replay(one, 20 + 10 * (i % 6) + i / 6);
+  }
+  Stats s = dump();
+  for (int k = 0; k < 6; k++) {
+    CHECK_EQUAL(s.count[type[k]], 10);
+    CHECK_EQUAL(s.maximum[type[k]], 20 + 10 * k + 9);
+  }
+  CHECK_EQUAL(s.count[TYPE_SYSEX], 0);
+  CHECK_EQUAL(s.count[TYPE_AFTERTOUCH], 0);
+
+  // messages that are not counted still update the high-water mark of the transmit buffer
+  mockMicros += 1000;
+  latencyReceive(0);
+  latencySend(TYPE_NUM, 7);
+  s = dump();
+  CHECK_EQUAL(s.tx, 7);
+}
+
+static void testBurst() {
+  // a dense stream of notes, the main loop is held up for 5 ms halfway
+  latencyReset();
+  std::vector<Message> stream;
+  for (int k = 0; k < 100; k++)
+    stream.push_back({10000 + 3u * LATENCY_BYTE * k, (uint8_t)(k % 2 ? TYPE_NOTEOFF : TYPE_NOTEON), 3});
+  replay(stream, 50, 20, 5000);
+  Stats s = dump();
+
+  // 15 bytes arrived during the stall, after which the replies queue up in the transmit buffer
+  CHECK_EQUAL(s.rx, 15);
+  CHECK_EQUAL(s.tx, actualTx);
+  CHECK(s.tx >= 9);
+  CHECK_EQUAL(s.count[TYPE_NOTEON] + s.count[TYPE_NOTEOFF], 100);
+
+  // the estimates of the arrival and departure are accurate to one byte
+  printf("largest latency during a burst: %lu us estimated, %lu us actual\n", s.maximum[TYPE_NOTEON], actualMaximum[TYPE_NOTEON]);
+  CHECK(s.maximum[TYPE_NOTEON] > 4500);
+  CHECK_CLOSE(s.maximum[TYPE_NOTEON], actualMaximum[TYPE_NOTEON], LATENCY_BYTE);
+  CHECK_CLOSE(s.maximum[TYPE_NOTEOFF], actualMaximum[TYPE_NOTEOFF], LATENCY_BYTE);
+
+  // without the stall the stream passes with the delay of the filter only
+  latencyReset();
+  replay(stream, 50);
+  s = dump();
+  CHECK_EQUAL(s.rx, 0);
+  CHECK_EQUAL(s.tx, 0);
+  CHECK_EQUAL(s.maximum[TYPE_NOTEON], 50);
+  CHECK_EQUAL(s.bin[TYPE_NOTEON][2], 50);
+}
+
+static void testDump() {
+  uint8_t buf[DUMP_LENGTH + 10];
+  memset(buf, 0xAA, sizeof(buf));
+
+  // the reply is a SysEx message of fixed length, which does not fit in a smaller buffer
+  latencyReset();
+  CHECK_EQUAL(latencyDump(buf, DUMP_LENGTH - 1), 0);
+  CHECK_EQUAL(buf[0], 0xAA);
+  CHECK_EQUAL(latencyDump(buf, sizeof(buf)), DUMP_LENGTH);
+  CHECK_EQUAL(buf[0], 0xF0);
+  CHECK_EQUAL(buf[1], FILTER_SYSEX_ID);
+  CHECK_EQUAL(buf[2], LATENCY_SYSEX_SUB);
+  CHECK_EQUAL(buf[DUMP_LENGTH - 1], 0xF7);
+  CHECK_EQUAL(buf[DUMP_LENGTH], 0xAA);
+
+  // all numbers are 7-bit bytes, large values are limited to 21 bits
+  std::vector<Message> stream = {{10000, TYPE_SYSEX, 100}};
+  replay(stream, 3000000);
+  mockMicros += 1000;
+  latencyReceive(300);
+  CHECK_EQUAL(latencyDump(buf, sizeof(buf)), DUMP_LENGTH);
+  for (int i = 1; i < DUMP_LENGTH - 1; i++)
+    CHECK(buf[i] < 0x80);
+  Stats s = dump();
+  CHECK_EQUAL(s.rx, 300);
+  CHECK_EQUAL(s.maximum[TYPE_SYSEX], 0x1FFFFF);
+  CHECK_EQUAL(s.count[TYPE_SYSEX], 1);
+
+  // the dump is requested with a SysEx query
+  const uint8_t query[] = {0xF0, FILTER_SYSEX_ID, LATENCY_SYSEX_SUB, 0xF7};
+  const uint8_t other[] = {0xF0, FILTER_SYSEX_ID, FILTER_SYSEX_SUB, 0xF7};
+  CHECK(latencyQuery(query, sizeof(query)));
+  CHECK(!latencyQuery(other, sizeof(other)));
+  CHECK(!latencyQuery(query, 3));
+
+  // the reset clears everything
+  latencyReset();
+  s = dump();
+  CHECK_EQUAL(s.rx, 0);
+  CHECK_EQUAL(s.count[TYPE_SYSEX], 0);
+  CHECK_EQUAL(s.maximum[TYPE_SYSEX], 0);
+}
+
+static void testPrint() {
+  latencyReset();
+  std::vector<Message> stream = {{10000, TYPE_NOTEON, 3}, {20000, TYPE_NOTEON, 3}};
+  replay(stream, 100);
+  Print out;
+  latencyPrint(out);
+  CHECK(out.text == "rx highwater = 0, tx highwater = 0\nNoteOn: count = 2, mean = 100 us, max = 100 us, histogram = 0 0 0 2 0 0 0 0 0 0 0 0 0 0 0 0\n");
+}
+
+int main() {
+  testSingle();
+  testBins();
+  testTypes();
+  testBurst();
+  testDump();
+  testPrint();
+  return report("test_latency");
+}